@@ -1,9 +1,11 @@
 #include <iostream>
 #include "potential_factory.h"
 #include "utils_config.h"
+#include <string>
+#include <stdexcept>
 
 potential::PtrPotential pot;  // single instance of potential
-particles::PointMassArray<coord::PosCar> points;  // array of particles that are used to compute potential
+particles::ParticleArray<coord::PosCar> points;  // array of particles that are used to compute potential
 
 /// store particle positions and masses used to initialize potential
 int set_particles(double x[], double y[], double z[], double m[], int n)
@@ -46,30 +48,64 @@ int cleanup_code()
     return 0;
 }
 
-/// compute accelerations at given points: x,y,z are input coordinates, ax,ay,az are output accelerations 
-int get_gravity_at_point(double /*eps*/[],
-    double x[], double y[], double z[],
-    double ax[], double ay[], double az[], int npoints)
+/// compute potential and/or accelerations at many points in parallel;
+/// any of the output arrays may be NULL if the corresponding quantity is not needed
+int evalPotentialAtPoints(const double x[], const double y[], const double z[],
+    double p[], double ax[], double ay[], double az[], int npoints)
 {
     if(!pot) return -1;
+    if(npoints<=0) return 0;
+    const potential::BasePotential& potential = *pot;
+    const bool needGrad = ax!=NULL && ay!=NULL && az!=NULL;
+    std::string errorMsg;
+    // exceptions must not leave the OpenMP block, so they are caught and reported afterwards
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
     for(int i=0; i<npoints; i++) {
-        coord::GradCar grad;
-        pot->eval(coord::PosCar(x[i], y[i], z[i]), NULL, &grad);
-        ax[i]=-grad.dx;
-        ay[i]=-grad.dy;
-        az[i]=-grad.dz;
+        try{
+            double phi;
+            coord::GradCar grad;
+            potential.eval(coord::PosCar(x[i], y[i], z[i]), p? &phi : NULL, needGrad? &grad : NULL);
+            if(p)
+                p[i] = phi;
+            if(needGrad) {
+                ax[i] = -grad.dx;
+                ay[i] = -grad.dy;
+                az[i] = -grad.dz;
+            }
+        }
+        catch(std::exception& e) {
+            errorMsg = e.what();
+        }
+    }
+    if(!errorMsg.empty()) {
+        std::cerr << errorMsg << '\n';
+        return -1;
     }
     return 0;
 }
 
+/// compute accelerations at given points: x,y,z are input coordinates, ax,ay,az are output accelerations 
+int get_gravity_at_point(double /*eps*/[],
+    double x[], double y[], double z[],
+    double ax[], double ay[], double az[], int npoints)
+{
+    return evalPotentialAtPoints(x, y, z, NULL, ax, ay, az, npoints);
+}
+
 /// compute potential at given points: x,y,z are input coordinates, p is output potential
 int get_potential_at_point(double /*eps*/[],
     double x[], double y[], double z[],
     double p[], int npoints)
 {
-    if(!pot) return -1;
-    for(int i=0; i<npoints; i++) {
-        p[i]=pot->value(coord::PosCar(x[i], y[i], z[i]));
-    }
-    return 0;
+    return evalPotentialAtPoints(x, y, z, p, NULL, NULL, NULL, npoints);
+}
+
+/// compute both potential and accelerations at given points in a single pass
+int get_potential_and_gravity_at_point(double /*eps*/[],
+    double x[], double y[], double z[],
+    double p[], double ax[], double ay[], double az[], int npoints)
+{
+    return evalPotentialAtPoints(x, y, z, p, ax, ay, az, npoints);
 }
@@ -43,6 +43,26 @@ class AgamaInterface(CodeInterface, LiteratureReferencesMixIn, GravityFieldInter
         function.result_type = 'int32'
         return function
 
+    @legacy_function
+    def get_potential_and_gravity_at_point():
+        """
+        Compute the potential and the acceleration at the given points in a single call
+        (cheaper than calling get_potential_at_point and get_gravity_at_point separately)
+        """
+        function = LegacyFunctionSpecification()
+        function.addParameter('eps', dtype='float64', direction=function.IN)
+        function.addParameter('x',   dtype='float64', direction=function.IN)
+        function.addParameter('y',   dtype='float64', direction=function.IN)
+        function.addParameter('z',   dtype='float64', direction=function.IN)
+        function.addParameter('phi', dtype='float64', direction=function.OUT)
+        function.addParameter('ax',  dtype='float64', direction=function.OUT)
+        function.addParameter('ay',  dtype='float64', direction=function.OUT)
+        function.addParameter('az',  dtype='float64', direction=function.OUT)
+        function.addParameter('npoints', dtype='int32', direction=function.LENGTH)
+        function.must_handle_array = True
+        function.result_type = 'int32'
+        return function
+
     @legacy_function
     def cleanup_code():
         function = LegacyFunctionSpecification()
@@ -122,3 +142,19 @@ class Agama(InCodeComponentImplementation, GravityFieldCode):
                 handler.ERROR_CODE
             )
         )
+        handler.add_method(
+            'get_potential_and_gravity_at_point',
+            (
+                nbody_system.length,
+                nbody_system.length,
+                nbody_system.length,
+                nbody_system.length,
+            ),
+            (
+                nbody_system.potential,
+                nbody_system.acceleration,
+                nbody_system.acceleration,
+                nbody_system.acceleration,
+                handler.ERROR_CODE
+            )
+        )
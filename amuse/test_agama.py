@@ -60,3 +60,20 @@ class AgamaInterfaceTests(TestWithMPI):
         expected=-constants.G*scaleM/(r*r+(3*3.1416/16*scaleR)**2)**1.5*x
         self.assertLess(abs(result[0]/expected-1), 0.03)
         self.assertLess(abs(result[2]/result[0]-z/x), 0.03)
+
+    def test3(self):
+        M=10.
+        a=2.
+        instance = Agama(type="Dehnen", mass=M|generic_unit_system.mass, scaleRadius=a|generic_unit_system.length)
+        x=[1., 2., -3., 0.5] |generic_unit_system.length
+        y=[2., -1., 0.5, 4.] |generic_unit_system.length
+        z=[3., 0.5, 2., -1.] |generic_unit_system.length
+        eps=[0., 0., 0., 0.] |generic_unit_system.length
+        pot=instance.get_potential_at_point(eps, x, y, z)
+        acc=instance.get_gravity_at_point(eps, x, y, z)
+        result=instance.get_potential_and_gravity_at_point(eps, x, y, z)
+        for i in range(4):
+            self.assertAlmostEqual(result[0][i], pot[i], places=14)
+            for d in range(3):
+                self.assertAlmostEqual(result[d+1][i], acc[d][i], places=14)
+        instance.stop()
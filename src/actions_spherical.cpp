@@ -13,6 +13,17 @@ namespace {
 /// required tolerance on the value of Jr(E) in the root-finder
 const double ACCURACY_JR = 1e-6;
 
+/// size of the grid in energy and in L/Lcirc(E) for the interpolator of radial action
+const unsigned int ACTION_GRID_SIZE_E = 50;
+const unsigned int ACTION_GRID_SIZE_L = 40;
+
+/// default number of intervals of the energy grid covered by each tile of the interpolator
+const unsigned int ACTION_GRID_TILE = 7;
+
+/// each tile is constructed on the energy grid extended by this number of nodes on both sides,
+/// to reduce the influence of the boundary conditions of splines on the interpolated values
+const unsigned int ACTION_GRID_OVERLAP = 6;
+
 /// order of Gauss-Legendre quadrature for actions, frequencies and angles
 const unsigned int INTEGR_ORDER = 10;
 
@@ -331,125 +342,24 @@ coord::PosVelSphMod derivPointFromActions(
     return p;
 }
 
-/// construct the interpolating spline for scaled radial action X = Jr / (Lcirc-L)
-/// as a function of E and L/Lcirc
-math::CubicSpline2d makeActionInterpolator(const potential::Interpolator2d& interp)
+/// compute the scaled radial action X = Jr / (Lcirc-L) at the nodes of the grid in L/Lcirc
+/// for the given value of energy, which must lie strictly inside the interval (Phi(0), 0)
+void computeActionRow(const potential::Interpolator2d& interp, double E,
+    const std::vector<double>& gridL, std::vector<double>& row)
 {
-    // for computing the asymptotic values at E=Phi(0), we assume a power-law behavior of potential:
-    // Phi = Phi0 + coef * r^s
-    double Phi0, slope = interp.pot.innerSlope(&Phi0);
-    const int sizeE = 50;
-    const int sizeL = 40;
-    
-    // create grids in energy and L/Lcirc(E), same as in Interpolator2d
-    std::vector<double> gridE(sizeE), gridL(sizeL);
-    for(int i=0; i<sizeE; i++) {
-        double x = 1.*i/(sizeE-1);
-        gridE[i] = (1 - pow_3(x) * (10+x*(-15+x*6))) * Phi0;
-    }
-    for(int i=0; i<sizeL; i++) {
-        double x = 1.*i/(sizeL-1);
-        gridL[i] = pow_3(x) * (10+x*(-15+x*6));
-    }
-    // value of Jr/(Lcirc-L) and its derivatives w.r.t. E and L/Lcirc
-    math::Matrix<double> gridJr(sizeE, sizeL), gridJrdE(sizeE, sizeL), gridJrdL(sizeE, sizeL);
-
-    std::string errorMessage;  // store the error text in case of an exception in the openmp block
-    // loop over values of energy strictly inside the interval [Phi0:0];
-    // the boundary values will be treated separately
-#ifdef _OPENMP
-#pragma omp parallel for schedule(static)
-#endif
-    for(int iE=1; iE<sizeE-1; iE++) {
-        try{
-        double E = gridE[iE];
-        double dLcdE, Lc = interp.pot.L_circ(E, &dLcdE);
-        for(int iL=0; iL<sizeL-1; iL++) {
-            double L = gridL[iL] * Lc;
-            double R1, R2;
-            interp.findPlanarOrbitExtent(E, L, R1, R2);
-            double Jr    = integr<MODE_JR>    (interp.pot, E, L, R1, R2) / M_PI;
-            double dJrdE = integr<MODE_OMEGAR>(interp.pot, E, L, R1, R2) / M_PI;
-            double dJrdL =-integr<MODE_OMEGAZ>(interp.pot, E, L, R1, R2) / M_PI;
-            gridJr  (iE, iL) = Jr / (Lc - L);
-            gridJrdE(iE, iL) = (dJrdE + (gridL[iL] * dJrdL - Jr / Lc) * dLcdE) / (Lc - L);
-            gridJrdL(iE, iL) = (dJrdL + gridJr(iE, iL)) / (1 - gridL[iL]);
-        }
-        // limiting values for a nearly circular orbit
-        // Jr = Omega/(2 kappa) * Lcirc * ecc,  where ecc = sqrt(1 - (L/Lcirc)^2).
-        double kappa, nu, Omega;
-        interp.pot.epicycleFreqs(interp.pot.R_circ(E), kappa, nu, Omega);
-        gridJr(iE, sizeL-1) = Omega / kappa;
-        }
-        catch(std::exception& e) {
-            errorMessage = e.what();
-        }
-    }
-    if(!errorMessage.empty())
-        throw std::runtime_error("ActionFinderSpherical: "+errorMessage);
-
-    // asymptotic expressions for E -> Phi(0) assuming a power-law potential near origin
-    for(int iL=0; iL<sizeL-1; iL++) {
-        double R1, R2;   // these are scaled values, normalized to Rcirc
-        interp.findScaledOrbitExtent(Phi0, gridL[iL], R1, R2);
-        // integrations return the scaled value Jr/Lcirc and its derivative w.r.t. (L/Lcirc)
-        double JroverLc = integrPowerLaw<MODE_JR>    (slope, gridL[iL], R1, R2) / M_PI;
-        double dJrdL    =-integrPowerLaw<MODE_OMEGAZ>(slope, gridL[iL], R1, R2) / M_PI;
-        gridJr  (0, iL) = JroverLc / (1 - gridL[iL]);
-        gridJrdL(0, iL) = (dJrdL + gridJr(0, iL)) / (1 - gridL[iL]);
-    }
-    gridJr(0, sizeL-1) = sqrt(1/(slope+2));
-
-    // asymptotic expressions for E -> 0 assuming Newtonian potential at infinity
-    for(int iL=0; iL<sizeL; iL++) {
-        gridJr  (sizeE-1, iL) = 1;
-        gridJrdL(sizeE-1, iL) = 0;
-    }
-    
-    // derivs wrt E for circular orbits cannot be obtained directly (involve 3rd deriv of potential),
-    // thus they are computed by finite-differences (2nd order for interior nodes, 1st order at boundaries)
-    for(int iE=1; iE<sizeE-1; iE++) {
-        double difp = (gridJr(iE+1, sizeL-1) - gridJr(iE  , sizeL-1)) / (gridE[iE+1] - gridE[iE  ]);
-        double difm = (gridJr(iE  , sizeL-1) - gridJr(iE-1, sizeL-1)) / (gridE[iE  ] - gridE[iE-1]);
-        gridJrdE(iE, sizeL-1) = (difp * (gridE[iE] - gridE[iE-1]) + difm * (gridE[iE+1] - gridE[iE])) /
-            (gridE[iE+1] - gridE[iE-1]);  // 2nd order accurate expression for the first derivative
-        if(iE==1)
-            gridJrdE(0, sizeL-1) = difm;  // at the endpoints use a 1st order expression
-        if(iE==sizeE-2)
-            gridJrdE(sizeE-1, sizeL-1) = difp;
-    }
-
-    // derivs wrt E at E=0 and E=Phi0 computed by quardatic interpolation of finite-differences,
-    // using value at the boundary node, and value+deriv at the next-to-boundary node
-    for(int iL=0; iL<sizeL-1; iL++) {
-        gridJrdE(0, iL) = 2 * (gridJr(1, iL) - gridJr(0, iL)) / (gridE[1]-gridE[0]) - gridJrdE(1, iL);
-        gridJrdE(sizeE-1, iL) = -gridJrdE(sizeE-2, iL) +
-            2 * (gridJr(sizeE-1, iL) - gridJr(sizeE-2, iL)) / (gridE[sizeE-1]-gridE[sizeE-2]);
-    }
-
-    // same for derivs wrt (L/Lcirc) at L=Lcirc
-    for(int iE=0; iE<sizeE; iE++)
-        gridJrdL(iE, sizeL-1) = -gridJrdL(iE, sizeL-2) +
-            2 * (gridJr(iE, sizeL-1) - gridJr(iE, sizeL-2)) / (gridL[sizeL-1]-gridL[sizeL-2]);
-
-#if 0   // debugging output
-    std::ofstream strm("filea.dat");
-    strm << std::setprecision(15);
-    for(unsigned int iE=0; iE<sizeE; iE++) {
-        for(unsigned int iL=0; iL<sizeL; iL++) {
-            strm << gridE[iE] << "\t" << gridL[iL] << "\t" << 
-            gridJr  (iE, iL) << "\t" << gridJrdE(iE, iL) << "\t" << gridJrdL(iE, iL) << "\t" <<
-            (iE>0 ? (gridJr(iE, iL)-gridJr(iE-1, iL)) / (gridE[iE]-gridE[iE-1]) : NAN) << "\t" <<
-            (iL>0 ? (gridJr(iE, iL)-gridJr(iE, iL-1)) / (gridL[iL]-gridL[iL-1]) : NAN) << "\n";
-        }
-        strm<<"\n";
+    const unsigned int sizeL = gridL.size();
+    double Lc = interp.pot.L_circ(E);
+    for(unsigned int iL=0; iL<sizeL-1; iL++) {
+        double L = gridL[iL] * Lc;
+        double R1, R2;
+        interp.findPlanarOrbitExtent(E, L, R1, R2);
+        row[iL] = integr<MODE_JR>(interp.pot, E, L, R1, R2) / M_PI / (Lc - L);
     }
-    strm.close();
-#endif
-
-    // disappointingly, the use of derivatives for quintic spline interpolation does not seem
-    // to give better accuracy than cubic interpolation...
-    return math::CubicSpline2d(gridE, gridL, gridJr/*, gridJrdE, gridJrdL*/);
+    // limiting value for a nearly circular orbit
+    // Jr = Omega/(2 kappa) * Lcirc * ecc,  where ecc = sqrt(1 - (L/Lcirc)^2).
+    double kappa, nu, Omega;
+    interp.pot.epicycleFreqs(interp.pot.R_circ(E), kappa, nu, Omega);
+    row[sizeL-1] = Omega / kappa;
 }
 
 }  //internal namespace
@@ -525,8 +435,126 @@ ActionAngles actionAnglesSpherical(
 }
 
 
-ActionFinderSpherical::ActionFinderSpherical(const potential::BasePotential& potential) :
-    interp(potential), intJr(makeActionInterpolator(interp)) {}
+ActionFinderSpherical::ActionFinderSpherical(const potential::BasePotential& potential,
+    unsigned int _tileSize) :
+    interp(potential, _tileSize), gridE(ACTION_GRID_SIZE_E), gridL(ACTION_GRID_SIZE_L),
+    tileSize(_tileSize>0 ? std::min(_tileSize, ACTION_GRID_SIZE_E-1) : ACTION_GRID_TILE),
+    intJr((ACTION_GRID_SIZE_E + tileSize - 2) / tileSize), tileReady(intJr.size(), 0),
+    rows(ACTION_GRID_SIZE_E)
+{
+    // create grids in energy and L/Lcirc(E), same as in Interpolator2d
+    double Phi0;
+    interp.pot.innerSlope(&Phi0);
+    const unsigned int sizeE = gridE.size(), sizeL = gridL.size();
+    for(unsigned int i=0; i<sizeE; i++) {
+        double x = 1.*i/(sizeE-1);
+        gridE[i] = (1 - pow_3(x) * (10+x*(-15+x*6))) * Phi0;
+    }
+    for(unsigned int i=0; i<sizeL; i++) {
+        double x = 1.*i/(sizeL-1);
+        gridL[i] = pow_3(x) * (10+x*(-15+x*6));
+    }
+    // the interpolators for the radial action are constructed in getTile() when needed
+}
+
+void ActionFinderSpherical::computeRow(unsigned int iE) const
+{
+    if(!rows[iE].empty())
+        return;
+    const unsigned int sizeE = gridE.size(), sizeL = gridL.size();
+    std::vector<double> row(sizeL);
+    if(iE == 0) {
+        // asymptotic expressions for E -> Phi(0) assuming a power-law potential near origin:
+        // Phi = Phi0 + coef * r^s
+        double slope = interp.pot.innerSlope();
+        for(unsigned int iL=0; iL<sizeL-1; iL++) {
+            double R1, R2;   // these are scaled values, normalized to Rcirc
+            interp.findScaledOrbitExtent(gridE[0], gridL[iL], R1, R2);
+            // integration returns the scaled value Jr/Lcirc
+            double JroverLc = integrPowerLaw<MODE_JR>(slope, gridL[iL], R1, R2) / M_PI;
+            row[iL] = JroverLc / (1 - gridL[iL]);
+        }
+        row[sizeL-1] = sqrt(1/(slope+2));
+    } else if(iE == sizeE-1) {
+        // asymptotic expressions for E -> 0 assuming Newtonian potential at infinity
+        row.assign(sizeL, 1.);
+    } else
+        computeActionRow(interp, gridE[iE], gridL, row);
+    rows[iE].swap(row);
+}
+
+const math::BaseInterpolator2d* ActionFinderSpherical::getTile(double E) const
+{
+    const unsigned int sizeE = gridE.size(), sizeL = gridL.size();
+    if(!(E >= gridE[0] && E <= gridE[sizeE-1]))
+        return NULL;
+    const unsigned int index = std::min<unsigned int>(intJr.size()-1,
+        math::binSearch(E, &gridE[0], sizeE) / tileSize);
+    // double-checked initialization: each tile is constructed only once,
+    // even if the first access happens simultaneously from several OpenMP threads;
+    // the tile is published by setting its flag after it is complete, and is accessed
+    // outside the critical section only after the flag has been seen to be set
+    int ready;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+    ready = tileReady[index];
+    if(ready) {
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+        return intJr[index].get();
+    }
+    const math::BaseInterpolator2d* ptr = NULL;
+    std::string error;
+    // exceptions must not escape the critical section, so are caught and rethrown afterwards
+#ifdef _OPENMP
+#pragma omp critical(ActionFinderSphericalTiles)
+#endif
+    {
+        if(!intJr[index]) {
+            try{
+                // range of rows of the energy grid covered by this tile, including the overlap
+                const int
+                first = std::max<int>(0, int(index * tileSize) - int(ACTION_GRID_OVERLAP)),
+                last  = std::min<int>(sizeE-1, (index+1) * tileSize + ACTION_GRID_OVERLAP);
+                std::string errorMessage;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+                for(int iE=first; iE<=last; iE++) {
+                    try{
+                        computeRow(iE);
+                    }
+                    catch(std::exception& e) {
+                        errorMessage = e.what();
+                    }
+                }
+                if(!errorMessage.empty())
+                    throw std::runtime_error(errorMessage);
+                const unsigned int size = last-first+1;
+                std::vector<double> tileE(gridE.begin()+first, gridE.begin()+last+1);
+                math::Matrix<double> gridJr(size, sizeL);
+                for(unsigned int i=0; i<size; i++)
+                    for(unsigned int iL=0; iL<sizeL; iL++)
+                        gridJr(i, iL) = rows[i+first][iL];
+                intJr[index].reset(new math::CubicSpline2d(tileE, gridL, gridJr));
+#ifdef _OPENMP
+#pragma omp flush
+#pragma omp atomic write
+#endif
+                tileReady[index] = 1;
+            }
+            catch(std::exception& e) {
+                error = e.what();
+            }
+        }
+        ptr = intJr[index].get();
+    }
+    if(!error.empty())
+        throw std::runtime_error("ActionFinderSpherical: " + error);
+    return ptr;
+}
 
 double ActionFinderSpherical::Jr(double E, double L, double *Omegar, double *Omegaz) const
 {
@@ -538,8 +566,14 @@ double ActionFinderSpherical::Jr(double E, double L, double *Omegar, double *Ome
         if(Omegaz) *Omegaz = NAN;
         return NAN;
     }
+    const math::BaseInterpolator2d* intJr = getTile(E);
+    if(!intJr) {
+        if(Omegar) *Omegar = NAN;
+        if(Omegaz) *Omegaz = NAN;
+        return NAN;
+    }
     double Z  = Lc>0 ? fmin(fabs(L/Lc), 1) : 0;
-    intJr.evalDeriv(E, Z, &val, needDeriv? &derE : NULL, needDeriv? &derZ : NULL);
+    intJr->evalDeriv(E, Z, &val, needDeriv? &derE : NULL, needDeriv? &derZ : NULL);
     if(needDeriv) {
         double dJrdL = derZ * (1-Z) - val;
         double dJrdE = derE * (1-Z) * Lc - (derZ * (1-Z) * Z - val) * dLcdE;
@@ -58,11 +58,19 @@ coord::PosVelCyl mapSpherical(
 
 
 /** Class for performing transformations between action/angle and coordinate/momentum for
-    an arbitrary spherical potential, using 2d interpolation tables */
+    an arbitrary spherical potential, using 2d interpolation tables.
+    The tables are split into several tiles in energy, which are constructed on demand
+    when the corresponding range of energy is accessed for the first time (thread-safely). */
 class ActionFinderSpherical: public BaseActionFinder, public BaseToyMap<coord::SphMod> {
 public:
-    /// Initialize the internal interpolation tables; the potential itself is not used later on
-    explicit ActionFinderSpherical(const potential::BasePotential& potential);
+    /** Initialize the internal 1d interpolator; the potential itself is not used later on.
+        \param[in]  potential  is the instance of a spherical potential;
+        \param[in]  tileSize  is the number of intervals of the energy grid covered by each tile
+        of the interpolation tables (0 means the default value); if it is not smaller than
+        the size of the grid, a single table is constructed on first access.
+    */
+    explicit ActionFinderSpherical(const potential::BasePotential& potential,
+        unsigned int tileSize=0);
 
     virtual Actions actions(const coord::PosVelCyl& point) const;
     virtual ActionAngles actionAngles(const coord::PosVelCyl& point, Frequencies* freq=NULL) const;
@@ -81,7 +89,23 @@ public:
     double E(const Actions& act) const;
 private:
     const potential::Interpolator2d interp;  ///< interpolator for potential and peri/apocenter radii
-    const math::CubicSpline2d intJr;         ///< interpolator for the scaled value of radial action
+    std::vector<double> gridE, gridL;        ///< grids in energy and L/Lcirc(E)
+    const unsigned int tileSize;             ///< number of intervals of the energy grid in each tile
+    /// interpolators for the scaled value of radial action, each covering a range of energies
+    /// and constructed on first access
+    mutable std::vector<math::PtrInterpolator2d> intJr;
+    /// flags indicating that the corresponding interpolator has been constructed
+    /// (accessed atomically; the interpolator is read only after its flag has been set)
+    mutable std::vector<int> tileReady;
+    /// scaled radial action at the nodes of each row of the energy grid, computed on demand
+    mutable std::vector<std::vector<double> > rows;
+
+    /// return the interpolator for the given energy, constructing it if necessary,
+    /// or NULL if the energy is outside the grid
+    const math::BaseInterpolator2d* getTile(double E) const;
+
+    /// compute the values at one row of the energy grid, if it was not already computed
+    void computeRow(unsigned int iE) const;
 };
 
 typedef ActionFinderSpherical ToyMapSpherical;
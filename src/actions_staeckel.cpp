@@ -7,8 +7,10 @@
 #include <cassert>
 #include <cmath>
 
-// debugging output
+// debugging output and on-disk cache
 #include <fstream>
+#include <cstdio>
+#include <unistd.h>
 
 namespace actions{
 
@@ -746,32 +748,41 @@ void createGridFocalDistance(
         throw std::runtime_error(errorMessage);
 }
 
-}  // internal namespace
+/// dimensions of the interpolation tables in ActionFinderAxisymFudge
+static const int sizeE = 50;
+static const int sizeL = 25;
+static const int sizeI = 25;
 
-ActionFinderAxisymFudge::ActionFinderAxisymFudge(
-    const potential::PtrPotential& _pot, const bool interpolate) :
-    pot(_pot), interp(*pot)
-{
-    double Phi0 = pot->value(coord::PosCyl(0,0,0));
-    if(!isFinite(Phi0))
-        throw std::runtime_error(
-            "ActionFinderAxisymFudge: can only deal with potentials that are finite at r->0");
-    const int sizeE = 50;
-    const int sizeL = 25;
-    const int sizeI = 25;
+/// interpolation tables for the focal distance and the actions in ActionFinderAxisymFudge
+struct FudgeTables {
+    std::vector<double> gridE, gridL, gridI;   ///< grids in E, Lz/Lcirc(E), I3/I3max(E,Lz)
+    math::Matrix<double> grid2dD, grid2dI;     ///< focal distance and I3max as functions of (E,Lz)
+    std::vector<double> grid3dJr, grid3dJz;    ///< scaled actions as functions of (E,Lz,I3)
+};
 
-    std::vector<double> gridE = createGrid(sizeE+1);      // grid in energy
+/** compute the interpolation tables for the focal distance and
+    (if interpolate==true) for the actions in the given potential */
+void createFudgeTables(const potential::BasePotential& pot, bool interpolate, FudgeTables& tab)
+{
+    double Phi0 = pot.value(coord::PosCyl(0,0,0));
+    std::vector<double>& gridE = tab.gridE;
+    std::vector<double>& gridL = tab.gridL;
+    std::vector<double>& gridI = tab.gridI;
+    math::Matrix<double>& grid2dD = tab.grid2dD;  // focal distance
+    math::Matrix<double>& grid2dI = tab.grid2dI;  // I3max(E, Lz/Lc)
+    std::vector<double>& grid3dJr = tab.grid3dJr; // Jr(E, Lz/Lc, I3/I3max)
+    std::vector<double>& grid3dJz = tab.grid3dJz; // same for Jz
+
+    gridE = createGrid(sizeE+1);                  // grid in energy
     for(int i=0; i<=sizeE; i++)
         gridE[i] = Phi0 * (1-gridE[i]);
     gridE.erase(gridE.begin());   // the very first node exactly at origin is not used
-    std::vector<double> gridL = createGrid(sizeL);        // grid in L/Lcirc(E)
-    std::vector<double> gridI = createGrid(sizeI);        // grid in I3/I3max(E,L)
+    gridL = createGrid(sizeL);                    // grid in L/Lcirc(E)
+    gridI = createGrid(sizeI);                    // grid in I3/I3max(E,L)
 
     // initialize the interpolator for the focal distance as a function of E and Lz/Lcirc
-    math::Matrix<double> grid2dD;  // focal distance
     math::Matrix<double> grid2dR;  // Rshell / Rcirc(E)
-    createGridFocalDistance(*pot, gridE, gridL, /*output*/ grid2dD, grid2dR);
-    interpD = math::LinearInterpolator2d(gridE, gridL, grid2dD);
+    createGridFocalDistance(pot, gridE, gridL, /*output*/ grid2dD, grid2dR);
 
     if(!interpolate) {
         // nothing more to do, except perhaps writing the debug information
@@ -792,9 +803,9 @@ ActionFinderAxisymFudge::ActionFinderAxisymFudge(
     }
 
     // we're constructing an interpolation grid for Jr and Jz in (E,L,I3)
-    math::Matrix<double> grid2dI(sizeE, sizeL);           // I3max(E, Lz/Lc)
-    std::vector<double> grid3dJr(sizeE * sizeL * sizeI);  // Jr(E, Lz/Lc, I3/I3max)
-    std::vector<double> grid3dJz(sizeE * sizeL * sizeI);  // same for Jz
+    grid2dI = math::Matrix<double>(sizeE, sizeL);
+    grid3dJr.assign(sizeE * sizeL * sizeI, 0.);
+    grid3dJz.assign(sizeE * sizeL * sizeI, 0.);
 
     int sizeEL = (sizeE-1) * (sizeL-1);
     std::string errorMessage;  // store the error text in case of an exception in the openmp block
@@ -806,14 +817,14 @@ ActionFinderAxisymFudge::ActionFinderAxisymFudge(
             int iE      = iEL / (sizeL-1);
             int iL      = iEL % (sizeL-1);
             double E    = gridE[iE];
-            double Rc   = R_circ(*pot, E);
-            double vc   = v_circ(*pot, Rc);
+            double Rc   = R_circ(pot, E);
+            double vc   = v_circ(pot, Rc);
             double Lc   = Rc * vc;
             double Lz   = gridL[iL] * Lc;
             // focal distance: presently can't work when fd=0 exactly
             double fd   = fmax(grid2dD(iE, iL), Rc * 1e-4);
             double Rsh  = grid2dR(iE, iL) * Rc;
-            double Phi0 = pot->value(coord::PosCyl(Rsh,0,0));
+            double Phi0 = pot.value(coord::PosCyl(Rsh,0,0));
             double vphi = Lz>0 ? Lz / Rsh : 0;
             double vmer = sqrt(fmax( 2 * (E - Phi0) - pow_2(vphi), 0));
             double lambda  = pow_2(Rsh) + pow_2(fd);
@@ -830,7 +841,7 @@ ActionFinderAxisymFudge::ActionFinderAxisymFudge(
 
                 const coord::PosProlSph pprol(lambda, 0, 0, coordsys);
                 const AxisymFunctionFudge fnc(coord::PosVelProlSph(pprol, 0, 0, 0),
-                    E, Lz, I3, flambda, 0, *pot);
+                    E, Lz, I3, flambda, 0, pot);
                 AxisymIntLimits lim = findIntegrationLimitsAxisym(fnc);
                 if(iI==0)        // no vertical oscillation for a planar orbit
                     lim.nu_max = lim.nu_min = 0;
@@ -862,8 +873,8 @@ ActionFinderAxisymFudge::ActionFinderAxisymFudge(
         int iL = sizeL-1;
         grid2dR(iE, iL) = 1.;
         grid2dI(iE, iL) = 1.;
-        double kappa, nu, Omega, Rc = R_circ(*pot, gridE[iE]);
-        epicycleFreqs(*pot, Rc, kappa, nu, Omega);
+        double kappa, nu, Omega, Rc = R_circ(pot, gridE[iE]);
+        epicycleFreqs(pot, Rc, kappa, nu, Omega);
         if(kappa>0 && nu>0 && Omega>0) {
             for(int iI=0; iI<sizeI; iI++) {
                 int index = (iE * sizeL + iL) * sizeI + iI;
@@ -919,10 +930,143 @@ ActionFinderAxisymFudge::ActionFinderAxisymFudge(
             strm << '\n';
         }
     }
+}
+
+/// identifier included in the cache keys: it must be incremented whenever the construction
+/// of the interpolation tables changes, so that the previously cached tables are not used
+static const char* CACHE_VERSION = "ActionFinderAxisymFudge v2";
+
+/** A fingerprint of the potential used as a key for the on-disk cache of interpolation tables:
+    its name and symmetry, and the exact binary values of the potential and its gradient
+    at a fixed set of points spanning a wide range of radii and covering the whole sphere
+    (both hemispheres and several azimuthal angles, irrespective of the declared symmetry);
+    two potentials with the same values at all these points are considered identical */
+std::string potentialFingerprint(const potential::BasePotential& pot)
+{
+    std::string result = std::string(CACHE_VERSION) + '\n' + pot.name() + '\n' +
+        utils::toString(static_cast<int>(pot.symmetry())) + '\n';
+    const int NTHETA = 9, NPHI = 5;
+    for(int k=-20; k<=20; k++) {
+        double r = pow(2., k*0.5);
+        for(int t=0; t<NTHETA; t++) {
+            double theta = (t + 0.5) * M_PI / NTHETA;   // polar angle from +z to -z axis
+            for(int p=0; p<NPHI; p++) {
+                double phi = (p + 0.5 * (t & 1)) * 2*M_PI / NPHI, val[4];
+                coord::GradCyl grad;
+                pot.eval(coord::PosCyl(r * sin(theta), r * cos(theta), phi), &val[0], &grad);
+                val[1] = grad.dR;
+                val[2] = grad.dz;
+                val[3] = grad.dphi;
+                result.append(reinterpret_cast<const char*>(val), sizeof(val));
+            }
+        }
+    }
+    return result;
+}
+
+/// write a binary array of doubles into the stream
+inline void writeArray(std::ostream& strm, const double* data, size_t size)
+{
+    strm.write(reinterpret_cast<const char*>(data), size * sizeof(double));
+}
+
+/// read the binary array of doubles from the stream
+inline bool readArray(std::istream& strm, double* data, size_t size)
+{
+    return strm.read(reinterpret_cast<char*>(data), size * sizeof(double)).good();
+}
+
+/// header of the binary file with the cached interpolation tables
+static const char FUDGE_TABLES_HEADER[16] = "AxisymFudge v1\n";
 
-    interpI = math::CubicSpline2d(gridE, gridL, grid2dI);
-    intJr   = math::CubicSpline3d(gridE, gridL, gridI, grid3dJr);
-    intJz   = math::CubicSpline3d(gridE, gridL, gridI, grid3dJz);
+/// load the interpolation tables from the cache file; return false if the file is absent or invalid
+bool readFudgeTables(const std::string& fileName, bool interpolate, FudgeTables& tab)
+{
+    if(fileName.empty())
+        return false;
+    std::ifstream strm(fileName.c_str(), std::ios::in | std::ios::binary);
+    char header[sizeof(FUDGE_TABLES_HEADER)];
+    if(!strm || !strm.read(header, sizeof(header)) ||
+        std::string(header, sizeof(header)) != std::string(FUDGE_TABLES_HEADER, sizeof(header)))
+        return false;
+    tab.gridE.resize(sizeE);
+    tab.gridL.resize(sizeL);
+    tab.gridI.resize(sizeI);
+    tab.grid2dD = math::Matrix<double>(sizeE, sizeL);
+    bool ok = readArray(strm, &tab.gridE[0], sizeE) && readArray(strm, &tab.gridL[0], sizeL) &&
+        readArray(strm, &tab.gridI[0], sizeI) && readArray(strm, tab.grid2dD.data(), sizeE * sizeL);
+    if(interpolate) {
+        tab.grid2dI = math::Matrix<double>(sizeE, sizeL);
+        tab.grid3dJr.resize(sizeE * sizeL * sizeI);
+        tab.grid3dJz.resize(sizeE * sizeL * sizeI);
+        ok &= readArray(strm, tab.grid2dI.data(), sizeE * sizeL) &&
+            readArray(strm, &tab.grid3dJr[0], sizeE * sizeL * sizeI) &&
+            readArray(strm, &tab.grid3dJz[0], sizeE * sizeL * sizeI);
+    }
+    if(ok)
+        utils::msg(utils::VL_DEBUG, "ActionFinderAxisymFudge",
+            "Loaded interpolation tables from "+fileName);
+    return ok;
+}
+
+/// store the interpolation tables in the cache file (first under a temporary name,
+/// then renaming it, so that concurrent processes never see an incomplete file)
+void writeFudgeTables(const std::string& fileName, bool interpolate, const FudgeTables& tab)
+{
+    if(fileName.empty())
+        return;
+    std::string tmpFile = fileName + '.' + utils::toString((long)getpid()) +
+        '.' + utils::toString(&tab) + ".tmp";
+    {
+        std::ofstream strm(tmpFile.c_str(), std::ios::out | std::ios::binary);
+        strm.write(FUDGE_TABLES_HEADER, sizeof(FUDGE_TABLES_HEADER));
+        writeArray(strm, &tab.gridE[0], sizeE);
+        writeArray(strm, &tab.gridL[0], sizeL);
+        writeArray(strm, &tab.gridI[0], sizeI);
+        writeArray(strm, tab.grid2dD.data(), sizeE * sizeL);
+        if(interpolate) {
+            writeArray(strm, tab.grid2dI.data(), sizeE * sizeL);
+            writeArray(strm, &tab.grid3dJr[0], sizeE * sizeL * sizeI);
+            writeArray(strm, &tab.grid3dJz[0], sizeE * sizeL * sizeI);
+        }
+        if(strm.good()) {
+            strm.close();
+            if(std::rename(tmpFile.c_str(), fileName.c_str()) == 0)
+                return;
+        }
+    }
+    utils::msg(utils::VL_WARNING, "ActionFinderAxisymFudge", "Cannot write cache file "+fileName);
+    std::remove(tmpFile.c_str());
+}
+
+}  // internal namespace
+
+ActionFinderAxisymFudge::ActionFinderAxisymFudge(
+    const potential::PtrPotential& _pot, const bool interpolate) :
+    pot(_pot), interp(*pot)
+{
+    double Phi0 = pot->value(coord::PosCyl(0,0,0));
+    if(!isFinite(Phi0))
+        throw std::runtime_error(
+            "ActionFinderAxisymFudge: can only deal with potentials that are finite at r->0");
+
+    // load the interpolation tables from the on-disk cache, if it is enabled and contains them,
+    // otherwise construct the tables and store them in the cache
+    // (the fingerprint of the potential is not cheap, so it is computed only if the cache is enabled)
+    FudgeTables tab;
+    const std::string cacheFile = utils::getCacheDirectory().empty() ? std::string() :
+        utils::getCacheFileName(
+            potentialFingerprint(*pot) + (interpolate ? "interp" : "nointerp"), ".fudge");
+    if(!readFudgeTables(cacheFile, interpolate, tab)) {
+        createFudgeTables(*pot, interpolate, tab);
+        writeFudgeTables(cacheFile, interpolate, tab);
+    }
+    interpD = math::LinearInterpolator2d(tab.gridE, tab.gridL, tab.grid2dD);
+    if(interpolate) {
+        interpI = math::CubicSpline2d(tab.gridE, tab.gridL, tab.grid2dI);
+        intJr   = math::CubicSpline3d(tab.gridE, tab.gridL, tab.gridI, tab.grid3dJr);
+        intJz   = math::CubicSpline3d(tab.gridE, tab.gridL, tab.gridI, tab.grid3dJz);
+    }
 }
 
 Actions ActionFinderAxisymFudge::actions(const coord::PosVelCyl& point) const
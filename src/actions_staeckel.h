@@ -106,6 +106,9 @@ private:
     Additionally, it may set up an interpolation table for actions as functions
     of three integrals of motion, which speeds up the evaluation by another order of magnitude,
     for a moderate decrease in accuracy.
+    If the on-disk cache is enabled (see `utils::getCacheDirectory()`), the interpolation tables
+    are stored there and reloaded when the action finder is constructed again for the same potential
+    (identified by its values at a fixed set of points).
 */
 class ActionFinderAxisymFudge: public BaseActionFinder {
 public:
@@ -5,6 +5,10 @@
 #include "torus/Torus.h"
 #include "torus/Potential.h"
 #include <stdexcept>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <cmath>
 
 namespace actions{
 
@@ -86,4 +90,298 @@ coord::PosVelCyl ActionMapperTorus::map(const ActionAngles& actAng, Frequencies*
     return coord::PosVelCyl(xv[0], xv[1], xv[2], xv[3], xv[4], xv[5]);
 }
 
+// ------ Interpolated grid of tori ------ //
+
+namespace {
+
+/// header of the text file with the grid of tori
+static const char* TORUS_GRID_HEADER = "TorusGrid";
+
+/// number of significant digits needed to restore a double value exactly from the text file
+#if __cplusplus >= 201103L
+static const int FILE_PRECISION = std::numeric_limits<double>::max_digits10;
+#else
+static const int FILE_PRECISION = 17;  // same value for IEEE doubles, in absence of C++11 limits
+#endif
+
+/// check that the grid is sorted in ascending order and has at least two nodes
+void checkGrid(const std::vector<double>& grid, const char* name)
+{
+    if(grid.size() < 2 || grid[0] < 0)
+        throw std::invalid_argument(std::string("ActionMapperTorusGrid: ") + name +
+            " should contain at least two non-negative nodes");
+    for(size_t i=1; i<grid.size(); i++)
+        if(!(grid[i] > grid[i-1]))
+            throw std::invalid_argument(std::string("ActionMapperTorusGrid: ") + name +
+                " should be sorted in ascending order");
+}
+
+/// write the grid of action values as a single line: number of nodes followed by their values
+void writeGrid(std::ostream& strm, const std::vector<double>& grid)
+{
+    strm << grid.size();
+    for(size_t i=0; i<grid.size(); i++)
+        strm << ' ' << grid[i];
+    strm << '\n';
+}
+
+/// read the grid written by `writeGrid`
+void readGrid(std::istream& strm, std::vector<double>& grid, const char* name)
+{
+    size_t size = 0;
+    strm >> size;
+    grid.resize(size);
+    for(size_t i=0; i<size && strm; i++)
+        strm >> grid[i];
+    if(!strm)
+        throw std::runtime_error("ActionMapperTorusGrid: invalid file format");
+    checkGrid(grid, name);
+}
+
+/// write the parameters of a single torus
+void writeTorus(std::ostream& strm, Torus::Torus& torus)
+{
+    Torus::Actions act = torus.actions();
+    Torus::Frequencies om = torus.omega();
+    Torus::vec4 tp = torus.TP();
+    strm << act[0] << ' ' << act[1] << ' ' << act[2] << '\n' <<
+        om[0] << ' ' << om[1] << ' ' << om[2] << '\n' <<
+        tp[0] << ' ' << tp[1] << ' ' << tp[2] << ' ' << tp[3] << '\n';
+    // point transform (usually absent)
+    int numPT = torus.canmap().NumberofParameters();
+    strm << numPT;
+    if(numPT > 0) {
+        std::vector<double> pp(numPT);
+        torus.canmap().parameters(&pp[0]);
+        for(int i=0; i<numPT; i++)
+            strm << ' ' << pp[i];
+    }
+    strm << '\n';
+    // generating function and the angle map
+    Torus::AngPar ap = torus.AP();
+    torus.SN().write(strm);
+    strm << '\n';
+    ap.dSdJ1().write(strm);
+    strm << '\n';
+    ap.dSdJ2().write(strm);
+    strm << '\n';
+    ap.dSdJ3().write(strm);
+    strm << '\n';
+}
+
+/// read the parameters of a single torus written by `writeTorus`
+Torus::PtrTorus readTorus(std::istream& strm)
+{
+    Torus::Actions act;
+    Torus::Frequencies om;
+    Torus::vec4 tp;
+    int numPT = 0;
+    strm >> act[0] >> act[1] >> act[2] >> om[0] >> om[1] >> om[2] >>
+        tp[0] >> tp[1] >> tp[2] >> tp[3] >> numPT;
+    std::vector<double> pp(std::max(numPT, 0));
+    for(int i=0; i<numPT && strm; i++)
+        strm >> pp[i];
+    if(!strm)
+        throw std::runtime_error("ActionMapperTorusGrid: invalid file format");
+    Torus::GenPar sn, s1, s2, s3;
+    sn.read(strm);
+    s1.read(strm);
+    s2.read(strm);
+    s3.read(strm);
+    if(!strm)
+        throw std::runtime_error("ActionMapperTorusGrid: invalid file format");
+    Torus::PtrTorus torus(new Torus::Torus(true));
+    torus->SetActions(act);
+    torus->SetFrequencies(om);
+    torus->SetTP(tp);
+    torus->SetSN(sn);
+    torus->SetAP(Torus::AngPar(s1, s2, s3));
+    if(numPT > 0)
+        torus->SetPP(&pp[0]);
+    else
+        torus->SetPP();
+    return torus;
+}
+
+/// find the grid segment containing the value x and the relative offset of x in this segment;
+/// if clampBelow is true, values between zero and the first node are clamped to this node
+/// (return index=0, frac=0); return false if x is outside the grid otherwise
+bool locate(double x, const std::vector<double>& grid, size_t& index, double& frac,
+    bool clampBelow=false)
+{
+    if(clampBelow && x >= 0 && x < grid[0]) {
+        index = 0;
+        frac  = 0;
+        return true;
+    }
+    ptrdiff_t ind = math::binSearch(x, &grid[0], grid.size());
+    if(ind < 0 || ind >= static_cast<ptrdiff_t>(grid.size())-1)
+        return false;
+    index = ind;
+    frac  = (x - grid[ind]) / (grid[ind+1] - grid[ind]);
+    return true;
+}
+
+}  // internal namespace
+
+ActionMapperTorusGrid::ActionMapperTorusGrid(const potential::BasePotential& poten,
+    const std::vector<double>& _gridJr, const std::vector<double>& _gridJz,
+    const std::vector<double>& _gridJphi, double tol) :
+    gridJr(_gridJr), gridJz(_gridJz), gridJphi(_gridJphi)
+{
+    if(!isAxisymmetric(poten))
+        throw std::invalid_argument("ActionMapperTorusGrid only works for axisymmetric potentials");
+    checkGrid(gridJr,   "gridJr");
+    checkGrid(gridJz,   "gridJz");
+    checkGrid(gridJphi, "gridJphi");
+    const int sizeJr = gridJr.size(), sizeJz = gridJz.size(), sizeJphi = gridJphi.size(),
+        numTori = sizeJr * sizeJz * sizeJphi;
+    tori.resize(numTori);
+    TorusPotentialWrapper potwrap(poten);
+    std::string errorMessage;  // store the error text in case of an exception in the openmp block
+    int numFailed = 0;
+    // each torus takes a substantial and varying amount of time to fit, hence dynamic scheduling
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int n=0; n<numTori; n++) {
+        try{
+            Torus::Actions act;
+            act[0] = gridJr  [n / (sizeJz * sizeJphi)];
+            act[1] = gridJz  [n / sizeJphi % sizeJz];
+            act[2] = gridJphi[n % sizeJphi];
+            Torus::PtrTorus torus(new Torus::Torus(true));
+            int result = torus->AutoFit(act, &potwrap, tol, 600, 150, 12, 3, 16, 200, 12, 0);
+            if(result!=0) {
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+                numFailed++;
+            }
+            tori[n] = torus;
+        }
+        catch(std::exception& ex) {
+            errorMessage = ex.what();
+        }
+    }
+    if(!errorMessage.empty())
+        throw std::runtime_error("ActionMapperTorusGrid: " + errorMessage);
+    if(numFailed>0)
+        utils::msg(utils::VL_WARNING, "ActionMapperTorusGrid", "Fit not converged for "+
+            utils::toString(numFailed)+" out of "+utils::toString(numTori)+" tori");
+}
+
+ActionMapperTorusGrid::ActionMapperTorusGrid(const std::string& fileName)
+{
+    std::ifstream strm(fileName.c_str(), std::ios::in);
+    std::string header;
+    if(!strm || !(strm >> header) || header != TORUS_GRID_HEADER)
+        throw std::runtime_error("ActionMapperTorusGrid: cannot read file " + fileName);
+    readGrid(strm, gridJr,   "gridJr");
+    readGrid(strm, gridJz,   "gridJz");
+    readGrid(strm, gridJphi, "gridJphi");
+    size_t numTori = gridJr.size() * gridJz.size() * gridJphi.size();
+    tori.resize(numTori);
+    for(size_t n=0; n<numTori; n++)
+        tori[n] = readTorus(strm);
+}
+
+bool ActionMapperTorusGrid::save(const std::string& fileName) const
+{
+    std::ofstream strm(fileName.c_str(), std::ios::out);
+    if(!strm)
+        return false;
+    strm << std::setprecision(FILE_PRECISION) << TORUS_GRID_HEADER << '\n';
+    writeGrid(strm, gridJr);
+    writeGrid(strm, gridJz);
+    writeGrid(strm, gridJphi);
+    for(size_t n=0; n<tori.size(); n++)
+        writeTorus(strm, *tori[n]);
+    return strm.good();
+}
+
+bool ActionMapperTorusGrid::contains(const Actions& acts) const
+{
+    size_t ind;
+    double frac;
+    return locate(acts.Jr, gridJr, ind, frac, true) && locate(acts.Jz, gridJz, ind, frac, true) &&
+        locate(fabs(acts.Jphi), gridJphi, ind, frac);
+}
+
+coord::PosVelCyl ActionMapperTorusGrid::map(const ActionAngles& actAng, Frequencies* freq) const
+{
+    const double absJphi = fabs(actAng.Jphi);
+    size_t ind[3];
+    double frac[3];
+    // the parameters of tori are not extrapolated below the first node in Jr and Jz,
+    // but taken from this node (the torus still has the requested actions);
+    // this is not possible in Jphi, since the toy map strongly depends on it
+    if(!locate(actAng.Jr, gridJr, ind[0], frac[0], true) ||
+        !locate(actAng.Jz, gridJz, ind[1], frac[1], true) ||
+        !locate(absJphi, gridJphi, ind[2], frac[2]))
+        throw std::invalid_argument("ActionMapperTorusGrid: actions are outside the grid");
+
+    // interpolate the parameters of the torus between the eight corners of the grid cell;
+    // the generating functions of different tori may have different sets of terms,
+    // but their weighted sum contains the union of these sets
+    Torus::GenPar sn;
+    Torus::AngPar ap;
+    Torus::vec4 tp = 0.;
+    Torus::Frequencies om = 0.;
+    size_t nearest = 0;
+    double maxWeight = -1;
+    for(int c=0; c<8; c++) {
+        int i = c&1, j = (c>>1)&1, k = c>>2;
+        double weight = (i ? frac[0] : 1-frac[0]) * (j ? frac[1] : 1-frac[1]) * (k ? frac[2] : 1-frac[2]);
+        size_t n = ((ind[0]+i) * gridJz.size() + ind[1]+j) * gridJphi.size() + ind[2]+k;
+        if(weight > maxWeight) {
+            maxWeight = weight;
+            nearest = n;
+        }
+        if(weight == 0)
+            continue;
+        const Torus::Torus& node = *tori[n];
+        Torus::AngPar apnode = node.AP();
+        apnode *= weight;
+        sn += node.SN() * weight;
+        ap += apnode;
+        tp += node.TP() * weight;
+        om += node.omega() * weight;
+    }
+
+    // construct the interpolated torus
+    Torus::Torus torus(true);
+    Torus::Actions act;
+    act[0] = actAng.Jr;
+    act[1] = actAng.Jz;
+    act[2] = absJphi;
+    torus.SetActions(act);
+    torus.SetFrequencies(om);
+    torus.SetTP(tp);
+    torus.SetSN(sn);
+    torus.SetAP(ap);
+    Torus::PoiTra& pt = tori[nearest]->canmap();
+    int numPT = pt.NumberofParameters();
+    if(numPT > 0) {
+        std::vector<double> pp(numPT);
+        pt.parameters(&pp[0]);
+        torus.SetPP(&pp[0]);
+    } else
+        torus.SetPP();
+
+    // orbits with negative Jphi are mirror images of those with positive Jphi
+    const double sign = actAng.Jphi < 0 ? -1 : 1;
+    if(freq!=NULL) {
+        freq->Omegar   = om[0];
+        freq->Omegaz   = om[1];
+        freq->Omegaphi = om[2] * sign;
+    }
+    Torus::Angles ang;
+    ang[0] = actAng.thetar;
+    ang[1] = actAng.thetaz;
+    ang[2] = actAng.thetaphi * sign;
+    Torus::PSPT xv = torus.Map3D(ang);
+    return coord::PosVelCyl(xv[0], xv[1], math::wrapAngle(xv[2] * sign), xv[3], xv[4], xv[5] * sign);
+}
+
 }  // namespace actions
@@ -8,6 +8,8 @@
 #include "actions_base.h"
 #include "potential_base.h"
 #include "smart.h"
+#include <vector>
+#include <string>
 
 namespace actions {
 
@@ -27,4 +29,59 @@ private:
     Torus::PtrTorus torus;  ///< hidden implementation details
 };
 
+/** Interpolated grid of tori for fast conversion from action/angle to position/velocity.
+    Tori are fitted at all nodes of a rectangular grid in (Jr, Jz, |Jphi|) at construction
+    (in parallel, if OpenMP is available), which is costly, but then the torus for arbitrary
+    actions inside the grid is obtained by linear interpolation of the parameters of the toy map,
+    the coefficients of the generating function and the angle map, and the frequencies,
+    between the eight surrounding nodes (the point transform, which is used only for a few
+    tori with very low Jr, is taken from the nearest node).
+    Tori with negative Jphi are obtained from those with positive Jphi by reflection in phi.
+    The fitted grid may be saved to a text file and loaded later, bypassing the fitting stage.
+    Unlike `ActionMapperTorus`, the `map()` method may be called for any actions within the grid,
+    and is thread-safe.
+*/
+class ActionMapperTorusGrid: public BaseActionMapper{
+public:
+    /** Construct the grid of tori for the given axisymmetric potential;
+        the potential is not subsequently used.
+        \param[in]  poten  is the potential;
+        \param[in]  gridJr, gridJz, gridJphi  are the grid nodes in each of the three actions
+        (at least two nodes in each dimension, sorted in ascending order, and preferably
+        strictly positive, since tori with zero actions are poorly fitted);
+        \param[in]  tol  is the tolerance parameter of torus fitting.
+        \throw  std::invalid_argument if the potential is not axisymmetric or the grids are invalid,
+        or std::runtime_error if the fitting failed.
+    */
+    ActionMapperTorusGrid(const potential::BasePotential& poten,
+        const std::vector<double>& gridJr, const std::vector<double>& gridJz,
+        const std::vector<double>& gridJphi, double tol=0.003);
+
+    /** Load a previously saved grid of tori from a text file.
+        \throw  std::runtime_error if the file does not exist or has an invalid format. */
+    explicit ActionMapperTorusGrid(const std::string& fileName);
+
+    /** Store the grid of fitted tori in a text file;
+        \return  true if the file was written successfully. */
+    bool save(const std::string& fileName) const;
+
+    /** Map a point in action/angle space to a position/velocity in physical space.
+        For Jr and Jz between zero and the first node of the grid, the parameters of the torus
+        are taken from this node instead of being interpolated (tori with nearly zero actions
+        are poorly fitted anyway); the actual actions of the output point then may differ from
+        the requested ones by up to the value of the action at this node.
+        \throw  std::invalid_argument if Jr or Jz are negative or beyond the last node of the grid,
+        or |Jphi| is outside the grid. */
+    virtual coord::PosVelCyl map(const ActionAngles& actAng, Frequencies* freq=NULL) const;
+
+    /** check if the given actions are within the range covered by the grid
+        (including the region between zero and the first node in Jr and Jz) */
+    bool contains(const Actions& acts) const;
+
+private:
+    std::vector<double> gridJr, gridJz, gridJphi;  ///< grid nodes in each of the three actions
+    /// fitted tori at grid nodes, indexed as [(iJr * gridJz.size() + iJz) * gridJphi.size() + iJphi]
+    std::vector<Torus::PtrTorus> tori;
+};
+
 }  // namespace actions
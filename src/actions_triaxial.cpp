@@ -0,0 +1,551 @@
+#include "actions_triaxial.h"
+#include "actions_focal_distance_finder.h"
+#include "potential_utils.h"
+#include "math_core.h"
+#include "utils.h"
+#include <stdexcept>
+#include <cassert>
+#include <cmath>
+
+namespace actions{
+
+namespace {  // internal routines
+
+/** Accuracy of integrals for computing actions and angles
+    is determined by the number of points in fixed-order Gauss-Legendre scheme */
+static const unsigned int INTEGR_ORDER = 10;
+
+/** relative tolerance in determining the range of variables (nu,mu,lambda) to integrate over */
+static const double ACCURACY_RANGE = 1e-6;
+
+/** minimum range of variation of each coordinate that is considered to be non-zero */
+static const double MINIMUM_RANGE = 1e-10;
+
+/** relative offset from the initial point used to determine the direction of motion
+    when the point is at a turning point in the given coordinate */
+static const double OFFSET_TURNING_POINT = 1e-8;
+
+/** number of Newton iterations for refining the roots of the cubic equation for coordinates */
+static const int NUM_ITER_COORDS = 3;
+
+/// dimension of the interpolation table for the focal distances in ActionFinderTriaxialFudge
+static const int sizeE = 50;
+
+/// number of points in radius and polar angle used to estimate the focal distance for each energy
+static const int NUM_POINTS_FOCAL = 8;
+
+/** Ellipsoidal coordinates and the integrals of motion for the Triaxial Fudge action finder.
+    The coordinates tau[0]=nu, tau[1]=mu, tau[2]=lambda are the roots of the equation
+    x^2/(tau-b) + y^2/(tau-a) + z^2/tau = 1,  with  0 <= nu <= a <= mu <= b <= lambda.
+    The canonical momentum conjugate to each coordinate is given by
+    \f$  p_\tau^2 = N(\tau) / [2 \tau (\tau-a) (\tau-b)]  \f$,  where
+    \f$  N(\tau) = (E-\Phi_0) \tau^2 - I_2 \tau + I_3 - (\tau-\sigma_1) (\tau-\sigma_2)
+         [\Phi(\tau) - \Phi_0]  \f$,
+    sigma_{1,2} are the other two coordinates of the initial point, Phi_0 is the potential
+    at the initial point, and Phi(tau) is the potential along the coordinate line.
+    I2 and I3 are the coefficients of the quadratic polynomial in tau that describes the kinetic
+    energy, which are the classical integrals of motion in a Staeckel potential.
+*/
+struct TriaxialFudgeData {
+    double a, b;             ///< parameters of the coordinate system
+    coord::PosVelCar point;  ///< position/velocity in cartesian coordinates
+    double tau[3];           ///< ellipsoidal coordinates nu, mu, lambda
+    double E, Phi0, I2, I3;  ///< energy, potential at the point, and two other integrals
+};
+
+/// the boundaries of the interval of the given coordinate (0: nu, 1: mu, 2: lambda)
+inline double lowerBound(const TriaxialFudgeData& data, int k) {
+    return k==0 ? 0 : k==1 ? data.a : data.b; }
+inline double upperBound(const TriaxialFudgeData& data, int k) {
+    return k==0 ? data.a : k==1 ? data.b : INFINITY; }
+
+/// the cubic polynomial whose roots are the ellipsoidal coordinates of a given point
+inline double ellipsoidalCubic(double a, double b, double x2, double y2, double z2, double t)
+{
+    return t * (t-a) * (t-b) - x2 * t * (t-a) - y2 * t * (t-b) - z2 * (t-a) * (t-b);
+}
+
+/** compute the ellipsoidal coordinates tau[0..2] for the given cartesian position:
+    the roots of the cubic equation are first found by the trigonometric formula,
+    and then refined by a few Newton iterations, staying within the interval of each coordinate */
+void toEllipsoidal(double a, double b, const coord::PosCar& pos, double tau[3])
+{
+    const double x2 = pow_2(pos.x), y2 = pow_2(pos.y), z2 = pow_2(pos.z);
+    // coefficients of the cubic polynomial  t^3 - c2 t^2 + c1 t - c0
+    const double
+    c2 = a + b + x2 + y2 + z2,
+    c1 = a * b + a * x2 + b * y2 + (a+b) * z2,
+    c0 = a * b * z2,
+    p  = c1 - c2 * c2 / 3,   // depressed cubic  s^3 + p s + q, t = s + c2/3
+    q  = (-2 * pow_3(c2) / 27 + c2 * c1 / 3 - c0),
+    amp= 2 * sqrt(fmax(-p / 3, 0)),
+    arg= p<0 ? fmax(-1, fmin(1, 3 * q / (p * amp))) : 0,
+    phi= acos(arg) / 3;
+    for(int k=0; k<3; k++) {
+        // k=2 is the largest root (lambda), k=0 - the smallest one (nu)
+        double t = c2 / 3 + amp * cos(phi - 2*M_PI/3 * (2-k));
+        double lower = k==0 ? 0 : k==1 ? a : b, upper = k==0 ? a : k==1 ? b : c2;
+        t = fmin(fmax(t, lower), upper);
+        for(int iter=0; iter<NUM_ITER_COORDS; iter++) {
+            double f  = ellipsoidalCubic(a, b, x2, y2, z2, t);
+            double df = (3 * t - 2 * c2) * t + c1;
+            double tnew = t - f / df;
+            if(!(tnew >= lower && tnew <= upper &&
+                fabs(ellipsoidalCubic(a, b, x2, y2, z2, tnew)) < fabs(f)))
+                break;
+            t = tnew;
+        }
+        tau[k] = t;
+    }
+}
+
+/** compute the cartesian position from the ellipsoidal coordinates,
+    taking the signs of x,y,z from the given reference point */
+coord::PosCar fromEllipsoidal(double a, double b, const double tau[3], const coord::PosCar& ref)
+{
+    double
+    x = sqrt(fmax(0, (tau[2]-b) * (b-tau[1]) * (b-tau[0]) / (b * (b-a)) )),
+    y = sqrt(fmax(0, (tau[2]-a) * (tau[1]-a) * (a-tau[0]) / (a * (b-a)) )),
+    z = sqrt(fmax(0, tau[2] * tau[1] * tau[0] / (a * b) ));
+    return coord::PosCar(ref.x<0 ? -x : x, ref.y<0 ? -y : y, ref.z<0 ? -z : z);
+}
+
+/** compute the ellipsoidal coordinates, the energy and the two other integrals of motion
+    for the given point in the given coordinate system */
+TriaxialFudgeData findIntegralsOfMotionTriaxialFudge(
+    const potential::BasePotential& potential,
+    const coord::PosVelCar& point, double a, double b)
+{
+    TriaxialFudgeData data;
+    data.a = a;
+    data.b = b;
+    data.point = point;
+    toEllipsoidal(a, b, point, data.tau);
+    const double
+    Lx = point.y * point.vz - point.z * point.vy,
+    Ly = point.z * point.vx - point.x * point.vz,
+    Lz = point.x * point.vy - point.y * point.vx;
+    data.Phi0 = potential.value(point);
+    data.E  = data.Phi0 + 0.5 * (pow_2(point.vx) + pow_2(point.vy) + pow_2(point.vz));
+    // the kinetic energy multiplied by (tau-sigma_1)(tau-sigma_2) for each coordinate
+    // is a quadratic polynomial in tau:  T tau^2 - I2 tau + I3
+    data.I2 = 0.5 * (a * pow_2(point.vx) + b * pow_2(point.vy) + (a+b) * pow_2(point.vz) +
+        pow_2(Lx) + pow_2(Ly) + pow_2(Lz));
+    data.I3 = 0.5 * (a * b * pow_2(point.vz) + a * pow_2(Ly) + b * pow_2(Lx));
+    return data;
+}
+
+/** The auxiliary function  F(tau) = s N(tau)  for one of the three coordinates, where the sign
+    s=+1 for nu and lambda, and -1 for mu, so that p_tau^2 = F(tau) / (2 |tau (tau-a) (tau-b)|)
+    and the range of motion in each coordinate is where F(tau) >= 0.
+    The potential is evaluated along the coordinate line passing through the initial point.
+*/
+class TriaxialFunctionFudge: public math::IFunctionNoDeriv {
+public:
+    const TriaxialFudgeData& data;          ///< coordinates and integrals of motion
+    const potential::BasePotential& poten;  ///< gravitational potential
+    const int k;                            ///< index of the coordinate (0: nu, 1: mu, 2: lambda)
+    const double sign;                      ///< sign of F(tau) relative to N(tau)
+    TriaxialFunctionFudge(const TriaxialFudgeData& _data,
+        const potential::BasePotential& _poten, int _k) :
+        data(_data), poten(_poten), k(_k), sign(_k==1 ? -1 : 1) {};
+
+    virtual double value(const double t) const {
+        const double sigma1 = data.tau[(k+1)%3], sigma2 = data.tau[(k+2)%3];
+        double dPhi = 0;   // at the initial point the potential is known
+        if(t != data.tau[k]) {
+            double tau[3] = {data.tau[0], data.tau[1], data.tau[2]};
+            tau[k] = t;
+            dPhi = poten.value(fromEllipsoidal(data.a, data.b, tau, data.point)) - data.Phi0;
+        }
+        return sign * ( ((data.E - data.Phi0) * t - data.I2) * t + data.I3
+            - (t-sigma1) * (t-sigma2) * dPhi );
+    }
+};
+
+/** A simple function that facilitates locating the root of auxiliary function on
+    a semi-infinite interval for lambda: instead of F(tau) we consider F(tau)/tau^2,
+    which tends to a finite negative limit (E) as tau tends to infinity. */
+class TriaxialScaledForRootfinder: public math::IFunctionNoDeriv {
+public:
+    const TriaxialFunctionFudge& fnc;
+    explicit TriaxialScaledForRootfinder(const TriaxialFunctionFudge& _fnc) : fnc(_fnc) {};
+    virtual double value(const double t) const {
+        return isFinite(t) ? fnc(t) / pow_2(t) : fnc.data.E;
+    }
+};
+
+/** integrand for the expressions for actions and their derivatives by integrals of motion:
+    the canonical momentum p(tau), or its derivative by one of the integrals of motion (E,I2,I3),
+    if p^2>0, otherwise 0.
+*/
+class TriaxialIntegrand: public math::IFunctionNoDeriv {
+public:
+    const TriaxialFunctionFudge& fnc;   ///< auxiliary function for the given coordinate
+    int n;   ///< -1 for momentum, or 0,1,2 for its derivative by E, I2, I3, respectively
+    explicit TriaxialIntegrand(const TriaxialFunctionFudge& _fnc) : fnc(_fnc), n(-1) {};
+
+    virtual double value(const double t) const {
+        const double A = fabs(t * (t-fnc.data.a) * (t-fnc.data.b)), F = fnc(t);
+        if(!(F>0 && A>0))
+            return 0;
+        const double p = sqrt(F / (2*A));
+        if(n<0)
+            return p;
+        const double dFdI = fnc.sign * (n==0 ? t*t : n==1 ? -t : 1);
+        const double result = dFdI / (4 * A * p);
+        return isFinite(result) ? result : 0;  // fix possible problems at the endpoints
+    }
+};
+
+/** integration intervals for actions and angles for each of the three coordinates;
+    the endpoints are either turning points (where p=0), or the boundaries of the range
+    of the coordinate (where the orbit crosses one of the principal planes) */
+struct TriaxialIntLimits {
+    double tmin[3], tmax[3];
+    bool bmin[3], bmax[3];   ///< whether tmin, tmax are the boundaries of the coordinate range
+};
+
+/** compute the intervals of each coordinate for which p^2(tau)>=0 */
+TriaxialIntLimits findIntegrationLimitsTriaxial(const TriaxialFunctionFudge* fnc[3])
+{
+    TriaxialIntLimits lim;
+    for(int k=0; k<3; k++) {
+        const TriaxialFunctionFudge& F = *fnc[k];
+        const double lower = lowerBound(F.data, k), upper = upperBound(F.data, k);
+        const double t0    = F.data.tau[k];
+        const double scale = k==2 ? t0 : upper-lower;  // characteristic range of variation
+        double tmin = NAN, tmax = NAN, tpos = t0;
+        if(!(F(t0) > 0)) {
+            // we are at the endpoint of the interval where F is positive:
+            // determine the direction in which it increases, or if the interval is degenerate
+            double dt = scale * OFFSET_TURNING_POINT;
+            double tup = fmin(t0+dt, upper), tdn = fmax(t0-dt, lower);
+            if(tup > t0 && F(tup) > 0) {
+                tmin = t0;
+                tpos = tup;
+            } else if(tdn < t0 && F(tdn) > 0) {
+                tmax = t0;
+                tpos = tdn;
+            } else
+                tmin = tmax = t0;
+        }
+        if(!isFinite(tmin))
+            tmin = F(lower) >= 0 ? lower : math::findRoot(F, lower, tpos, ACCURACY_RANGE);
+        if(!isFinite(tmax))
+            tmax = k==2 ?
+                math::findRoot(TriaxialScaledForRootfinder(F), tpos, INFINITY, ACCURACY_RANGE) :
+                F(upper) >= 0 ? upper : math::findRoot(F, tpos, upper, ACCURACY_RANGE);
+        // sanity check
+        if(!isFinite(tmin+tmax) || t0 < tmin || t0 > tmax) {
+            utils::msg(utils::VL_WARNING, "findIntegrationLimitsTriaxial", "failed");
+            if(!isFinite(tmin) || tmin > t0) tmin = t0;
+            if(!isFinite(tmax) || tmax < t0) tmax = t0;
+        }
+        // ignore extremely small intervals
+        if(!(tmax-tmin >= scale * MINIMUM_RANGE))
+            tmin = tmax = tmin==lower ? lower : tmax==upper ? upper : t0;
+        lim.tmin[k] = tmin;
+        lim.tmax[k] = tmax;
+        lim.bmin[k] = tmin == lower;
+        lim.bmax[k] = tmax == upper;
+    }
+    return lim;
+}
+
+/// the number of times the interval of the given coordinate is traversed per half-period
+inline int multiplicity(const TriaxialIntLimits& lim, int k)
+{
+    // if the orbit crosses a principal plane, the interval is traversed twice as many times
+    // during a full oscillation as in the case of an interval between two turning points
+    return lim.bmin[k] || lim.bmax[k] ? 2 : 1;
+}
+
+/// whether the interval of the given coordinate has collapsed to a single point
+inline bool isDegenerate(const TriaxialIntLimits& lim, int k) { return lim.tmin[k] == lim.tmax[k]; }
+
+/** Compute actions by integrating the momentum over the range of each coordinate */
+Actions computeActions(const TriaxialFunctionFudge* fnc[3], const TriaxialIntLimits& lim)
+{
+    double J[3];
+    for(int k=0; k<3; k++) {
+        if(isDegenerate(lim, k)) {
+            J[k] = 0;
+            continue;
+        }
+        TriaxialIntegrand integrand(*fnc[k]);
+        math::ScaledIntegrandEndpointSing transf(integrand, lim.tmin[k], lim.tmax[k]);
+        J[k] = math::integrateGL(transf, 0, 1, INTEGR_ORDER) * multiplicity(lim, k) / M_PI;
+    }
+    // short-axis loop orbit: mu circulates between its boundaries, the sign of J_mu is that of Lz
+    const coord::PosVelCar& p = fnc[0]->data.point;
+    if(lim.bmin[1] && lim.bmax[1] && p.x * p.vy - p.y * p.vx < 0)
+        J[1] *= -1;
+    return Actions(J[2], J[0], J[1]);
+}
+
+/** Compute the integrals of derivatives of momentum by integrals of motion over the entire
+    interval of each coordinate:  fullInt[k][j] = \int_{tmin}^{tmax} dp_k/dI_j d tau_k,
+    and the matrix of derivatives of integrals of motion by actions (its inverse).
+    For a coordinate whose interval has collapsed to a boundary point (e.g., nu=0 for an orbit
+    in the x-y plane), the corresponding row of the matrix dJ/dI is replaced by the gradient of
+    the constraint F(tau)=0 at this point, so that the derivatives w.r.t. other actions are
+    computed on the manifold of such orbits, and the derivatives w.r.t. this action are set to zero.
+*/
+void computeIntDerivatives(const TriaxialFunctionFudge* fnc[3], const TriaxialIntLimits& lim,
+    /*output*/ double fullInt[3][3], double dIdJ[3][3])
+{
+    double dJdI[3][3];
+    bool constrained[3] = {false, false, false};
+    for(int k=0; k<3; k++) {
+        TriaxialIntegrand integrand(*fnc[k]);
+        const double t = lim.tmin[k];
+        if(isDegenerate(lim, k)) {
+            const double A = fabs(t * (t-fnc[k]->data.a) * (t-fnc[k]->data.b));
+            // second derivative of F at the point, estimated by finite differences
+            const double h = (k==2 ? t : upperBound(fnc[k]->data, k) - lowerBound(fnc[k]->data, k))
+                * ROOT3_DBL_EPSILON;
+            const double d2F = lim.bmin[k] || lim.bmax[k] ? NAN :
+                ((*fnc[k])(t+h) - 2 * (*fnc[k])(t) + (*fnc[k])(t-h)) / (h*h);
+            constrained[k] = !(d2F < 0 && A > 0);
+            for(int j=0; j<3; j++) {
+                const double dFdI = fnc[k]->sign * (j==0 ? t*t : j==1 ? -t : 1);
+                fullInt[k][j] = 0;
+                dJdI[k][j] = constrained[k] ?
+                    dFdI :   // gradient of the constraint
+                    dFdI / (2 * sqrt(-A * d2F));   // limiting value for a vanishing interval
+            }
+        } else {
+            math::ScaledIntegrandEndpointSing transf(integrand, lim.tmin[k], lim.tmax[k]);
+            for(int j=0; j<3; j++) {
+                integrand.n = j;
+                fullInt[k][j] = math::integrateGL(transf, 0, 1, INTEGR_ORDER);
+                dJdI[k][j] = fullInt[k][j] * multiplicity(lim, k) / M_PI;
+            }
+        }
+    }
+    // invert the 3x3 matrix
+    double det =
+        dJdI[0][0] * (dJdI[1][1] * dJdI[2][2] - dJdI[1][2] * dJdI[2][1]) -
+        dJdI[0][1] * (dJdI[1][0] * dJdI[2][2] - dJdI[1][2] * dJdI[2][0]) +
+        dJdI[0][2] * (dJdI[1][0] * dJdI[2][1] - dJdI[1][1] * dJdI[2][0]);
+    for(int j=0; j<3; j++)
+        for(int k=0; k<3; k++) {
+            // cofactor of the element (k,j), divided by the determinant
+            int k1 = (k+1)%3, k2 = (k+2)%3, j1 = (j+1)%3, j2 = (j+2)%3;
+            dIdJ[j][k] = constrained[k] || det==0 ? 0 :
+                (dJdI[k1][j1] * dJdI[k2][j2] - dJdI[k1][j2] * dJdI[k2][j1]) / det;
+        }
+}
+
+/** Compute the derivatives of the generating function by integrals of motion:
+    for each coordinate, the integral of dp/dI from the start of the interval to the current point
+    is converted to the phase along the full oscillation in this coordinate, taking into account
+    which side of the principal plane(s) crossed by the orbit the point is on.
+*/
+void computeGenFuncDerivatives(const TriaxialFunctionFudge* fnc[3], const TriaxialIntLimits& lim,
+    const double fullInt[3][3], /*output*/ double dSdI[3])
+{
+    const TriaxialFudgeData& data = fnc[0]->data;
+    const coord::PosVelCar& p = data.point;
+    const double pos[3] = {p.x, p.y, p.z}, vel[3] = {p.vx, p.vy, p.vz};
+    // the coordinate tau equals c[i] when the i-th cartesian coordinate is zero (on its boundary)
+    const double c[3] = {data.b, data.a, 0};
+    dSdI[0] = dSdI[1] = dSdI[2] = 0;
+    for(int k=0; k<3; k++) {
+        if(isDegenerate(lim, k))
+            continue;
+        const double t0 = data.tau[k];
+        // direction of motion in tau: the sign of canonical momentum  p_tau = v . dx/dtau
+        double ptau = 0;
+        for(int i=0; i<3; i++)
+            if(t0 != c[i])
+                ptau += pos[i] * vel[i] / (t0 - c[i]);
+        double dir = t0 == lim.tmin[k] ? 1 : t0 == lim.tmax[k] ? -1 : ptau >= 0 ? 1 : -1;
+        // the side of the principal plane that corresponds to the lower and upper boundary
+        // (if the point is in the plane, the sign of velocity determines the side it moves to)
+        const int ilow = k==0 ? 2 : k==1 ? 1 : 0, iupp = k==0 ? 1 : 0;
+        const double
+        slow = pos[ilow]!=0 ? math::sign(pos[ilow]) : vel[ilow]>=0 ? 1 : -1,
+        supp = pos[iupp]!=0 ? math::sign(pos[iupp]) : vel[iupp]>=0 ? 1 : -1;
+        // the integral is taken from the lower end of the interval, unless it is a turning point
+        // and the upper end is the boundary, in which case the roles of both ends are swapped
+        const bool fromUpper = !lim.bmin[k] && lim.bmax[k];
+        TriaxialIntegrand integrand(*fnc[k]);
+        math::ScaledIntegrandEndpointSing transf(integrand, lim.tmin[k], lim.tmax[k]);
+        const double y0 = transf.y_from_x(t0);
+        for(int j=0; j<3; j++) {
+            integrand.n = j;
+            double u = fromUpper ?
+                math::integrateGL(transf, y0, 1, INTEGR_ORDER) :
+                math::integrateGL(transf, 0, y0, INTEGR_ORDER);
+            double phase;
+            if(!lim.bmin[k] && !lim.bmax[k])   // oscillation between two turning points
+                phase = dir * u;
+            else if(!fromUpper && !lim.bmax[k])  // crossing the plane at the lower boundary
+                phase = dir * u + (slow * dir < 0 ? 2 * fullInt[k][j] : 0);
+            else if(fromUpper)                   // crossing the plane at the upper boundary
+                phase =-dir * u + (supp * dir > 0 ? 2 * fullInt[k][j] : 0);
+            else                                 // circulation between both boundaries
+                phase = dir * u + (supp < 0 ? 2 * fullInt[k][j] : 0);
+            dSdI[j] += phase;
+        }
+    }
+}
+
+/** The sequence of operations needed to compute actions, angles and frequencies */
+ActionAngles computeActionAngles(
+    const TriaxialFunctionFudge* fnc[3], const TriaxialIntLimits& lim, Frequencies* freq)
+{
+    Actions acts = computeActions(fnc, lim);
+    double fullInt[3][3], dIdJ[3][3], dSdI[3];
+    computeIntDerivatives(fnc, lim, fullInt, dIdJ);
+    computeGenFuncDerivatives(fnc, lim, fullInt, dSdI);
+    double theta[3];
+    for(int k=0; k<3; k++)
+        theta[k] = dSdI[0] * dIdJ[0][k] + dSdI[1] * dIdJ[1][k] + dSdI[2] * dIdJ[2][k];
+    // if J_mu is reported with a negative sign, the corresponding angle and frequency are also flipped
+    const double signphi = acts.Jphi < 0 ? -1 : 1;
+    if(freq!=NULL) {
+        freq->Omegar   = dIdJ[0][2];
+        freq->Omegaz   = dIdJ[0][0];
+        freq->Omegaphi = dIdJ[0][1] * signphi;
+    }
+    return ActionAngles(acts, Angles(
+        math::wrapAngle(theta[2]), math::wrapAngle(theta[0]), math::wrapAngle(theta[1] * signphi)));
+}
+
+/// sanitize the focal distances and convert them into the parameters of the coordinate system
+void getCoordSysParams(const coord::PosVelCar& point, double focalDistanceYZ,
+    double focalDistanceXZ, double& a, double& b)
+{
+    // too small or non-monotonic values are replaced by a small positive number
+    double minDelta = fmax(sqrt(pow_2(point.x) + pow_2(point.y) + pow_2(point.z)), 1.) * 1e-4;
+    a = pow_2(fmax(focalDistanceYZ, minDelta));
+    b = fmax(pow_2(focalDistanceXZ), a + pow_2(minDelta));
+}
+
+}  // internal namespace
+
+// -------- THE DRIVER ROUTINES --------
+
+Actions actionsTriaxialFudge(const potential::BasePotential& potential,
+    const coord::PosVelCyl& point, double focalDistanceYZ, double focalDistanceXZ)
+{
+    if(!isTriaxial(potential))
+        throw std::invalid_argument("Triaxial Fudge approximation only works for triaxial potentials");
+    const coord::PosVelCar pcar = coord::toPosVelCar(point);
+    double a, b;
+    getCoordSysParams(pcar, focalDistanceYZ, focalDistanceXZ, a, b);
+    const TriaxialFudgeData data = findIntegralsOfMotionTriaxialFudge(potential, pcar, a, b);
+    if(!isFinite(data.E+data.I2+data.I3) || data.E>=0)
+        return Actions(NAN, NAN, NAN);
+    const TriaxialFunctionFudge fnc0(data, potential, 0), fnc1(data, potential, 1),
+        fnc2(data, potential, 2);
+    const TriaxialFunctionFudge* fnc[3] = {&fnc0, &fnc1, &fnc2};
+    const TriaxialIntLimits lim = findIntegrationLimitsTriaxial(fnc);
+    return computeActions(fnc, lim);
+}
+
+ActionAngles actionAnglesTriaxialFudge(const potential::BasePotential& potential,
+    const coord::PosVelCyl& point, double focalDistanceYZ, double focalDistanceXZ,
+    Frequencies* freq)
+{
+    if(!isTriaxial(potential))
+        throw std::invalid_argument("Triaxial Fudge approximation only works for triaxial potentials");
+    const coord::PosVelCar pcar = coord::toPosVelCar(point);
+    double a, b;
+    getCoordSysParams(pcar, focalDistanceYZ, focalDistanceXZ, a, b);
+    const TriaxialFudgeData data = findIntegralsOfMotionTriaxialFudge(potential, pcar, a, b);
+    if(!isFinite(data.E+data.I2+data.I3) || data.E>=0) {
+        if(freq) freq->Omegar = freq->Omegaz = freq->Omegaphi = NAN;
+        return ActionAngles(Actions(NAN, NAN, NAN), Angles(NAN, NAN, NAN));
+    }
+    const TriaxialFunctionFudge fnc0(data, potential, 0), fnc1(data, potential, 1),
+        fnc2(data, potential, 2);
+    const TriaxialFunctionFudge* fnc[3] = {&fnc0, &fnc1, &fnc2};
+    const TriaxialIntLimits lim = findIntegrationLimitsTriaxial(fnc);
+    return computeActionAngles(fnc, lim, freq);
+}
+
+
+// ----------- INTERPOLATOR ----------- //
+
+ActionFinderTriaxialFudge::ActionFinderTriaxialFudge(const potential::PtrPotential& _pot) :
+    pot(_pot)
+{
+    if(!isTriaxial(*pot))
+        throw std::invalid_argument(
+            "ActionFinderTriaxialFudge: Fudge approximation only works for triaxial potentials");
+    double Phi0 = pot->value(coord::PosCar(0,0,0));
+    if(!isFinite(Phi0))
+        throw std::runtime_error(
+            "ActionFinderTriaxialFudge: can only deal with potentials that are finite at r->0");
+
+    // grid in energy, excluding the endpoints Phi(0) and 0
+    std::vector<double> gridE(sizeE), gridYZ(sizeE), gridXZ(sizeE);
+    for(int i=0; i<sizeE; i++)
+        gridE[i] = Phi0 * (1 - (i+1.) / (sizeE+1));
+    std::string errorMessage;  // store the error text in case of an exception in the openmp block
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int iE=0; iE<sizeE; iE++) {
+        try{
+            // estimate the focal distances from the potential derivatives (eq.9 in Sanders 2012)
+            // at a set of points in the x-z and y-z planes inside the radius of zero-velocity
+            // surface along the major axis
+            double rmax = potential::R_max(*pot, gridE[iE]);
+            std::vector<coord::PosCyl> pointsXZ, pointsYZ;
+            for(int ir=0; ir<NUM_POINTS_FOCAL; ir++) {
+                double r = rmax * (ir+0.5) / NUM_POINTS_FOCAL;
+                for(int it=0; it<NUM_POINTS_FOCAL; it++) {
+                    double theta = M_PI/2 * (it+0.5) / NUM_POINTS_FOCAL;
+                    pointsXZ.push_back(coord::PosCyl(r * sin(theta), r * cos(theta), 0));
+                    pointsYZ.push_back(coord::PosCyl(r * sin(theta), r * cos(theta), M_PI/2));
+                }
+            }
+            gridYZ[iE] = estimateFocalDistancePoints(*pot, pointsYZ);
+            gridXZ[iE] = fmax(estimateFocalDistancePoints(*pot, pointsXZ), gridYZ[iE]);
+        }
+        catch(std::exception& ex) {
+            errorMessage = ex.what();
+        }
+    }
+    if(!errorMessage.empty())
+        throw std::runtime_error("ActionFinderTriaxialFudge: " + errorMessage);
+    if(utils::verbosityLevel >= utils::VL_DEBUG) {
+        std::string text = "Focal distances (E, yz, xz):";
+        for(int iE=0; iE<sizeE; iE++)
+            text += '\n' + utils::pp(gridE[iE], 8) + ' ' +
+                utils::pp(gridYZ[iE], 7) + ' ' + utils::pp(gridXZ[iE], 7);
+        utils::msg(utils::VL_DEBUG, "ActionFinderTriaxialFudge", text);
+    }
+    interpYZ = math::LinearInterpolator(gridE, gridYZ);
+    interpXZ = math::LinearInterpolator(gridE, gridXZ);
+}
+
+void ActionFinderTriaxialFudge::focalDistances(double E,
+    double& focalDistanceYZ, double& focalDistanceXZ) const
+{
+    double Eint = fmin(fmax(E, interpYZ.xmin()), interpYZ.xmax());
+    focalDistanceYZ = fmax(0, interpYZ.value(Eint));
+    focalDistanceXZ = fmax(focalDistanceYZ, interpXZ.value(Eint));
+}
+
+Actions ActionFinderTriaxialFudge::actions(const coord::PosVelCyl& point) const
+{
+    double fdYZ, fdXZ;
+    focalDistances(totalEnergy(*pot, point), fdYZ, fdXZ);
+    return actionsTriaxialFudge(*pot, point, fdYZ, fdXZ);
+}
+
+ActionAngles ActionFinderTriaxialFudge::actionAngles(const coord::PosVelCyl& point,
+    Frequencies* freq) const
+{
+    double fdYZ, fdXZ;
+    focalDistances(totalEnergy(*pot, point), fdYZ, fdXZ);
+    return actionAnglesTriaxialFudge(*pot, point, fdYZ, fdXZ, freq);
+}
+
+}  // namespace actions
@@ -0,0 +1,101 @@
+/** \file    actions_triaxial.h
+    \brief   Action-angle finder for triaxial potentials using the Staeckel fudge
+    \date    2026
+
+Computation of actions and angles for non-axisymmetric potentials with triaxial symmetry
+(reflection about each of the three principal planes), generalizing the axisymmetric
+"Staeckel Fudge" (actions_staeckel.h) to confocal ellipsoidal coordinates (Sanders&Binney 2015).
+
+The ellipsoidal coordinates  nu <= mu <= lambda  of a point (x,y,z) are the three roots of
+the equation  x^2/(tau-b) + y^2/(tau-a) + z^2/tau = 1,  so that  0 <= nu <= a <= mu <= b <= lambda
+(in the notation of de Zeeuw 1985, tau is replaced by tau+gamma, a=gamma-beta, b=gamma-alpha).
+The coordinate system is characterized by two parameters: the focal distances in the y-z plane
+(sqrt(a)) and in the x-z plane (sqrt(b)); the focal distance in the x-y plane is sqrt(b-a).
+The coordinate system is adapted to potentials with the major axis along x and the minor axis
+along z; in the axisymmetric limit a=b it reduces to the prolate spheroidal coordinates.
+
+In the fudge approximation, the canonical momentum conjugate to each coordinate tau
+is computed along the coordinate line passing through the given point, keeping the other
+two coordinates fixed, in the same way as in a Staeckel potential; the resulting expressions
+are exact if the potential is of the Staeckel form in the given coordinate system.
+The three actions are  J_lambda, J_nu, J_mu,  and they are reported in the fields Jr, Jz, Jphi
+of the `Actions` structure, respectively, which corresponds to their meaning in the axisymmetric
+limit; for short-axis loop orbits (circulating around the z axis) the sign of Jphi is that of Lz,
+otherwise all actions are non-negative.
+Figure rotation is not taken into account: the potential is assumed to be static.
+*/
+#pragma once
+#include "actions_base.h"
+#include "potential_base.h"
+#include "math_spline.h"
+#include "smart.h"
+
+namespace actions {
+
+/// \name  ------- Stand-alone driver routines that compute actions for a single point -------
+///@{
+
+/** Find approximate actions in a given triaxial potential, using the Staeckel Fudge method.
+    \param[in]  potential is the arbitrary potential with triaxial symmetry;
+    \param[in]  point     is the position/velocity point;
+    \param[in]  focalDistanceYZ  is the focal distance of the coordinate system in the y-z plane;
+    \param[in]  focalDistanceXZ  is the focal distance in the x-z plane (should be larger than
+    the previous one; too small values of both parameters or of their difference are increased
+    to a small positive value);
+    \return     actions for the given point, or Jr=Jz=Jphi=NAN if the energy is positive;
+    \throw      std::invalid_argument exception if the potential is not triaxial.
+*/
+Actions actionsTriaxialFudge(
+    const potential::BasePotential& potential,
+    const coord::PosVelCyl& point,
+    double focalDistanceYZ, double focalDistanceXZ);
+
+/** Find approximate actions and angles in a given triaxial potential,
+    using the Staeckel Fudge method.
+    \param[in]  potential is the arbitrary potential with triaxial symmetry;
+    \param[in]  point     is the position/velocity point;
+    \param[in]  focalDistanceYZ, focalDistanceXZ  are the parameters of the coordinate system;
+    \param[out] freq      if not NULL, store the frequencies of motion in this variable;
+    \return     actions and angles for the given point, or NAN if the energy is positive;
+    \throw      std::invalid_argument exception if the potential is not triaxial.
+*/
+ActionAngles actionAnglesTriaxialFudge(
+    const potential::BasePotential& potential,
+    const coord::PosVelCyl& point,
+    double focalDistanceYZ, double focalDistanceXZ,
+    Frequencies* freq=NULL);
+
+///@}
+/// \name  ------- Class interface to action/angle finders  -------
+///@{
+
+/** Action/angle finder for a generic triaxial potential, based on Staeckel Fudge approximation.
+    The parameters of the ellipsoidal coordinate system are estimated at initialization
+    on a grid in energy, from the potential derivatives in the x-z and y-z planes
+    (by the same method as `estimateFocalDistancePoints`), and then interpolated
+    for each input point, which is much cheaper than estimating them individually.
+*/
+class ActionFinderTriaxialFudge: public BaseActionFinder {
+public:
+    /** Construct the action finder and the interpolation table for the focal distances.
+        \throw std::invalid_argument if the potential is not triaxial,
+        or std::runtime_error if it is singular at origin.
+    */
+    explicit ActionFinderTriaxialFudge(const potential::PtrPotential& potential);
+
+    virtual Actions actions(const coord::PosVelCyl& point) const;
+
+    virtual ActionAngles actionAngles(const coord::PosVelCyl& point, Frequencies* freq=NULL) const;
+
+    /** return the focal distances in the y-z and x-z planes for the given energy,
+        obtained by interpolation */
+    void focalDistances(double E, double& focalDistanceYZ, double& focalDistanceXZ) const;
+
+private:
+    const potential::PtrPotential pot;   ///< the potential in which actions are computed
+    math::LinearInterpolator interpYZ;   ///< interpolator for the focal distance in y-z plane vs E
+    math::LinearInterpolator interpXZ;   ///< same for the focal distance in x-z plane
+};
+
+///@}
+}  // namespace actions
@@ -1134,8 +1134,12 @@ int hcubature_v(unsigned fdim, integrand_v f, void *fdata,
                 error_norm norm,
                 double *val, double *err)
 {
+     /* use the same sequence of region subdivisions as the non-vectorized
+	version (the "parallel" mode evaluates many regions at once, but changes
+	the adaptive refinement and may reduce the accuracy for a given maxEval);
+	the integrand still receives all points of newly subdivided regions at once */
      return cubature(fdim, f, fdata, dim, xmin, xmax, 
-		     maxEval, reqAbsError, reqRelError, norm, val, err, 1);
+		     maxEval, reqAbsError, reqRelError, norm, val, err, 0);
 }
 
 /* vectorized wrapper around non-vectorized integrands */
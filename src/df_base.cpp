@@ -135,14 +135,15 @@ double totalEntropy(const BaseDistributionFunction& DF, const double reqRelError
 }
 
 void sampleActions(const BaseDistributionFunction& DF, const size_t numSamples,
-    std::vector<actions::Actions>& samples, double* totalMass, double* totalMassErr)
+    std::vector<actions::Actions>& samples, double* totalMass, double* totalMassErr, bool quasiRandom)
 {
     double xlower[3] = {0, 0, 0};  // boundaries of integration region in scaled coordinates
     double xupper[3] = {1, 1, 1};
     math::Matrix<double> result;   // the result array of actions
     ActionSpaceScalingTriangLog transf;
     DFIntegrandNdim<false> fnc(DF, transf);
-    math::sampleNdim(fnc, xlower, xupper, numSamples, result, 0/*NULL*/, totalMass, totalMassErr);
+    math::sampleNdim(fnc, xlower, xupper, numSamples, result, 0/*NULL*/, totalMass, totalMassErr,
+        quasiRandom);
     samples.resize(result.rows());
     for(size_t i=0; i<result.rows(); i++) {
         const double point[3] = {result(i,0), result(i,1), result(i,2)};
@@ -99,8 +99,11 @@ double totalEntropy(const BaseDistributionFunction& DF,
     of the integral of the distribution function (i.e., the same quantity as computed by 
     BaseDistributionFunction::totalMass(), but calculated with a different method).
     \param[out] totalMassErr (optional) if not NULL, will store the error estimate of the integral.
+    \param[in]  quasiRandom (optional) if true, use the quasi-random (scrambled Sobol) sampling,
+    which reduces the noise for the same number of DF evaluations (see `math::sampleNdim`).
  */
 void sampleActions(const BaseDistributionFunction& DF, const std::size_t numSamples,
-    std::vector<actions::Actions>& samples, double* totalMass=NULL, double* totalMassErr=NULL);
+    std::vector<actions::Actions>& samples, double* totalMass=NULL, double* totalMassErr=NULL,
+    bool quasiRandom=false);
 
 }  // namespace df
@@ -12,9 +12,18 @@ One may create a potential in several ways:
      and using it to create a potential approximation with the parameters
      provided in a text string;
 (4)  providing a FORTRAN routine that returns potential and force at a given point,
-     and creating a potential approximation for it in the same way as above.
+     and creating a potential approximation for it in the same way as above;
+(5)  same as (3), but the FORTRAN routine computes the density at many points at once,
+     which reduces the overhead of calling it separately for each point.
 
-There are functions for computing density, potential, force and force derivatives.
+There are functions for computing density, potential, force and force derivatives,
+either at a single point, or at an array of points.
+All functions may be called from several threads concurrently; however, the array routines
+are parallelized internally with OpenMP, so they make full use of all cores only when
+called from a serial context (inside a parallel region they run in the calling thread).
+User-defined single-point routines in variants (3) and (4) are called from several threads
+concurrently while constructing the potential, so they must be thread-safe; by contrast,
+calls to the array routine in variant (5) are serialized, so it need not be reentrant.
 
 Due to the absense of a native pointer type in FORTRAN, the pointer to the C++ object
 should be stored in a placeholder variable of type CHAR*8, which is passed
@@ -22,6 +31,7 @@ as the first argument to all functions in this module.
 See the FORTRAN example for more details.
 */
 #include <cstring>
+#include <stdexcept>
 #include "potential_factory.h"
 #include "utils_config.h"
 #include "utils.h"
@@ -43,6 +53,15 @@ typedef double(*densityfnc)(double* X);
 // END
 typedef double(*potentialfnc)(double* X, double* FORCE);
 
+// routine defined in FORTRAN that computes the density at N points at once:
+// SUBROUTINE DENSITY(N, X, RHO)
+//   INTEGER N
+//   DOUBLE PRECISION X(3,N), RHO(N)
+//   RHO(I) = density at point X(:,I)
+// END
+// It is never called from several threads simultaneously (but may itself use OpenMP).
+typedef void(*densityarrfnc)(int* N, double* X, double* RHO);
+
 // C++-compatible wrapper for the potential defined in FORTRAN
 class DensityWrapper: public potential::BaseDensity{
 public:
@@ -99,6 +118,54 @@ private:
     }
 };
 
+// C++-compatible wrapper for the density defined in FORTRAN, which takes an array of points
+class DensityArrayWrapper: public potential::BaseDensity{
+public:
+    DensityArrayWrapper(densityarrfnc _dens, coord::SymmetryType _sym) :
+        dens(_dens), sym(_sym)
+    {
+        utils::msg(utils::VL_DEBUG, "FortranWrapper",
+            "Created a C++ wrapper for a Fortran array-valued density routine at "+
+            utils::toString((void*)dens));
+    }
+    virtual void evalmanyDensityCyl(const size_t npoints, const coord::PosCyl pos[],
+        double values[]) const
+    {
+        std::vector<double> x(npoints*3);
+        for(size_t i=0; i<npoints; i++) {
+            const coord::PosCar point = toPosCar(pos[i]);
+            x[i*3  ] = point.x;
+            x[i*3+1] = point.y;
+            x[i*3+2] = point.z;
+        }
+        int n = npoints;
+        // call the FORTRAN routine once for all points; the calls are serialized,
+        // since the routine is not required to be reentrant
+#ifdef _OPENMP
+#pragma omp critical(FortranDensityArray)
+#endif
+        dens(&n, &x[0], values);
+    }
+private:
+    densityarrfnc dens;
+    coord::SymmetryType sym;
+    virtual const char* name() const { return "DensityArrayWrapper"; };
+    virtual coord::SymmetryType symmetry() const { return sym; }
+    virtual double densityCyl(const coord::PosCyl &pos) const {
+        return densityCar(toPosCar(pos)); }
+    virtual double densitySph(const coord::PosSph &pos) const {
+        return densityCar(toPosCar(pos)); }
+    virtual double densityCar(const coord::PosCar &pos) const {
+        double x[3] = {pos.x, pos.y, pos.z}, result;
+        int n = 1;
+#ifdef _OPENMP
+#pragma omp critical(FortranDensityArray)
+#endif
+        dens(&n, x, &result);
+        return result;
+    }
+};
+
 /// convert FORTRAN string to C++ string
 static std::string stdstr(char* fortranString, int len)
 {
@@ -110,6 +177,68 @@ static std::string stdstr(char* fortranString, int len)
 /// *smart* pointers that should exist until the end of the program
 std::vector<potential::PtrPotential> potentials;
 
+/// store the pointer to a newly created potential in the array of potentials
+/// and in the FORTRAN placeholder variable (may be called from several threads)
+void storePotential(void* c_obj, const potential::PtrPotential& pot)
+{
+    const potential::BasePotential* ptr = pot.get();
+#ifdef _OPENMP
+#pragma omp critical(FortranWrapper)
+#endif
+    potentials.push_back(pot);
+    memcpy(c_obj, &ptr, sizeof(void*));
+}
+
+/// retrieve the pointer to the C++ potential from the FORTRAN placeholder variable
+inline const potential::BasePotential* getPotential(void* c_obj)
+{
+    const potential::BasePotential* pot;
+    memcpy(&pot, c_obj, sizeof(void*));
+    return pot;
+}
+
+/// compute the potential and optionally force and its derivatives at many points in parallel;
+/// the output arrays FORCE and DERIV may be NULL if not needed
+void evalPotentialArray(void* c_obj, int npoints, const double X[],
+    double POT[], double FORCE[], double DERIV[])
+{
+    const potential::BasePotential* pot = getPotential(c_obj);
+    std::string errorMsg;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for(int i=0; i<npoints; i++) {
+        // exceptions must not leave the OpenMP block, so they are caught and rethrown later
+        try{
+            coord::GradCar grad;
+            coord::HessCar hess;
+            pot->eval(coord::PosCar(X[i*3], X[i*3+1], X[i*3+2]), &POT[i],
+                FORCE? &grad : NULL, DERIV? &hess : NULL);
+            if(FORCE) {
+                FORCE[i*3  ] = -grad.dx;
+                FORCE[i*3+1] = -grad.dy;
+                FORCE[i*3+2] = -grad.dz;
+            }
+            if(DERIV) {
+                DERIV[i*6  ] = -hess.dx2;
+                DERIV[i*6+1] = -hess.dy2;
+                DERIV[i*6+2] = -hess.dz2;
+                DERIV[i*6+3] = -hess.dxdy;
+                DERIV[i*6+4] = -hess.dxdz;
+                DERIV[i*6+5] = -hess.dydz;
+            }
+        }
+        catch(std::exception& e) {
+#ifdef _OPENMP
+#pragma omp critical(FortranWrapper)
+#endif
+            errorMsg = e.what();
+        }
+    }
+    if(!errorMsg.empty())
+        throw std::runtime_error(errorMsg);
+}
+
 } // internal namespace
 
 
@@ -119,9 +248,7 @@ std::vector<potential::PtrPotential> potentials;
 /// OUTPUT: c_obj - the placeholder for storing the pointer to the C++ potential object.
 extern "C" void agama_initfromfile_(void* c_obj, char* inifilename, int, int len)
 {
-    potentials.push_back(potential::createPotential(stdstr(inifilename, len)));
-    const potential::BasePotential* ptr = potentials.back().get();
-    memcpy(c_obj, &ptr, sizeof(void*));
+    storePotential(c_obj, potential::createPotential(stdstr(inifilename, len)));
 }
 
 /// Routine that should be called from FORTRAN to construct a potential specified by
@@ -131,9 +258,7 @@ extern "C" void agama_initfromfile_(void* c_obj, char* inifilename, int, int len
 /// OUTPUT: c_obj - the placeholder for storing the pointer to the C++ potential object.
 extern "C" void agama_initfromparam_(void* c_obj, char* params, int, int len)
 {
-    potentials.push_back(potential::createPotential(utils::KeyValueMap(stdstr(params, len))));
-    const potential::BasePotential* ptr = potentials.back().get();
-    memcpy(c_obj, &ptr, sizeof(void*));
+    storePotential(c_obj, potential::createPotential(utils::KeyValueMap(stdstr(params, len))));
 }
 
 /// Routine that should be called from FORTRAN to construct a potential approximation
@@ -146,9 +271,7 @@ extern "C" void agama_initfrompot_(void* c_obj, char* params, potentialfnc pot,
 {
     utils::KeyValueMap param(stdstr(params, len));
     PotentialWrapper wrapper(pot, potential::getSymmetryTypeByName(param.getString("Symmetry")));
-    potentials.push_back(potential::createPotential(param, wrapper));
-    const potential::BasePotential* ptr = potentials.back().get();
-    memcpy(c_obj, &ptr, sizeof(void*));
+    storePotential(c_obj, potential::createPotential(param, wrapper));
 }
 
 /// same as above, but for a user-defined density function
@@ -156,9 +279,18 @@ extern "C" void agama_initfromdens_(void* c_obj, char* paramstr, densityfnc pot,
 {
     utils::KeyValueMap param(stdstr(paramstr, len));
     DensityWrapper wrapper(pot, potential::getSymmetryTypeByName(param.getString("Symmetry")));
-    potentials.push_back(potential::createPotential(param, wrapper));
-    const potential::BasePotential* ptr = potentials.back().get();
-    memcpy(c_obj, &ptr, sizeof(void*));
+    storePotential(c_obj, potential::createPotential(param, wrapper));
+}
+
+/// same as above, but for a user-defined density routine that takes an array of points
+/// (it is called once with all grid points at which the density is needed when constructing
+/// the potential expansion, and possibly with fewer points at other stages; these calls are
+/// never concurrent, so the routine need not be reentrant, but may be parallelized internally)
+extern "C" void agama_initfromdensarr_(void* c_obj, char* paramstr, densityarrfnc dens, int, int len)
+{
+    utils::KeyValueMap param(stdstr(paramstr, len));
+    DensityArrayWrapper wrapper(dens, potential::getSymmetryTypeByName(param.getString("Symmetry")));
+    storePotential(c_obj, potential::createPotential(param, wrapper));
 }
 
 /// Routine that should be called from FORTRAN to compute the potential at the given point.
@@ -167,8 +299,7 @@ extern "C" void agama_initfromdens_(void* c_obj, char* paramstr, densityfnc pot,
 /// RETURN: the potential at the point Phi(x,y,z).
 extern "C" double agama_potential_(void* c_obj, double* X, int)
 {
-    const potential::BasePotential* pot;
-    memcpy(&pot, c_obj, sizeof(void*));
+    const potential::BasePotential* pot = getPotential(c_obj);
     return pot->value(coord::PosCar(X[0], X[1], X[2]));
 }
 
@@ -179,8 +310,7 @@ extern "C" double agama_potential_(void* c_obj, double* X, int)
 /// RETURN: the potential at the point Phi(x,y,z).
 extern "C" double agama_potforce_(void* c_obj, double* X, double* FORCE, int)
 {
-    const potential::BasePotential* pot;
-    memcpy(&pot, c_obj, sizeof(void*));
+    const potential::BasePotential* pot = getPotential(c_obj);
     coord::GradCar grad;
     double value;
     pot->eval(coord::PosCar(X[0], X[1], X[2]), &value, &grad);
@@ -199,8 +329,7 @@ extern "C" double agama_potforce_(void* c_obj, double* X, double* FORCE, int)
 /// RETURN: the potential at the point Phi(x,y,z).
 extern "C" double agama_potforcederiv_(void* c_obj, double* X, double* FORCE, double* DERIV, int)
 {
-    const potential::BasePotential* pot;
-    memcpy(&pot, c_obj, sizeof(void*));
+    const potential::BasePotential* pot = getPotential(c_obj);
     coord::GradCar grad;
     coord::HessCar hess;
     double value;
@@ -223,7 +352,57 @@ extern "C" double agama_potforcederiv_(void* c_obj, double* X, double* FORCE, do
 // RETURN: the value of density.
 extern "C" double agama_density_(void* c_obj, double* X, int)
 {
-    const potential::BasePotential* pot;
-    memcpy(&pot, c_obj, sizeof(void*));
+    const potential::BasePotential* pot = getPotential(c_obj);
     return pot->density(coord::PosCar(X[0], X[1], X[2]));
 }
+
+/// Routine that should be called from FORTRAN to compute the potential at many points.
+/// INPUT:  c_obj  is the placeholder for the pointer to a previously created potential.
+/// INPUT:  N      is the number of points.
+/// INPUT:  X(3,N) is the array of coordinates (x,y,z) of all points.
+/// OUTPUT: POT(N) will contain the potential at each point.
+extern "C" void agama_potentialarr_(void* c_obj, int* N, double* X, double* POT, int)
+{
+    evalPotentialArray(c_obj, *N, X, POT, NULL, NULL);
+}
+
+/// Routine that should be called from FORTRAN to compute the potential and force at many points.
+/// INPUT:  c_obj  is the placeholder for the pointer to a previously created potential.
+/// INPUT:  N      is the number of points.
+/// INPUT:  X(3,N) is the array of coordinates (x,y,z) of all points.
+/// OUTPUT: POT(N) will contain the potential at each point.
+/// OUTPUT: FORCE(3,N) will contain the force at each point.
+extern "C" void agama_potforcearr_(void* c_obj, int* N, double* X, double* POT, double* FORCE, int)
+{
+    evalPotentialArray(c_obj, *N, X, POT, FORCE, NULL);
+}
+
+/// Routine that should be called from FORTRAN to compute the potential, force and its derivatives
+/// at many points.
+/// INPUT:  c_obj  is the placeholder for the pointer to a previously created potential.
+/// INPUT:  N      is the number of points.
+/// INPUT:  X(3,N) is the array of coordinates (x,y,z) of all points.
+/// OUTPUT: POT(N) will contain the potential at each point.
+/// OUTPUT: FORCE(3,N) will contain the force at each point.
+/// OUTPUT: DERIV(6,N) will contain the force derivatives at each point, in the same order
+/// as in `agama_potforcederiv`.
+extern "C" void agama_potforcederivarr_(void* c_obj, int* N, double* X, double* POT,
+    double* FORCE, double* DERIV, int)
+{
+    evalPotentialArray(c_obj, *N, X, POT, FORCE, DERIV);
+}
+
+// function that should be called from FORTRAN to compute the density at many points.
+// INPUT:  c_obj  is the placeholder for the pointer to a previously created potential.
+// INPUT:  N      is the number of points.
+// INPUT:  X(3,N) is the array of coordinates (x,y,z) of all points.
+// OUTPUT: DENS(N) will contain the density at each point.
+extern "C" void agama_densityarr_(void* c_obj, int* N, double* X, double* DENS, int)
+{
+    const potential::BasePotential* pot = getPotential(c_obj);
+    const int npoints = *N;
+    std::vector<coord::PosCyl> points(npoints);
+    for(int i=0; i<npoints; i++)
+        points[i] = toPosCyl(coord::PosCar(X[i*3], X[i*3+1], X[i*3+2]));
+    pot->evalmanyDensityCyl(npoints, npoints>0 ? &points[0] : NULL, DENS);
+}
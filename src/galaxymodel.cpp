@@ -9,6 +9,7 @@
 #include "utils.h"
 #include <cmath>
 #include <stdexcept>
+#include <algorithm>
 
 namespace galaxymodel{
 
@@ -458,6 +459,64 @@ std::vector<double> solveForAmplitudes(const math::BsplineInterpolator1d<N>& bsp
 }
 
 
+/// value of uniqueIndex assigned to input points with non-finite coordinates
+static const unsigned int NONFINITE_POINT = static_cast<unsigned int>(-1);
+
+/** key for sorting the points of a map, used to find the subset of unique points
+    (after taking into account the symmetries of the model) */
+struct MapPoint {
+    double R, z, phi;    ///< coordinates of the point, reduced by symmetry
+    unsigned int index;  ///< index of the point in the original array
+    bool operator< (const MapPoint& other) const {
+        return R < other.R || (R == other.R && (z < other.z || (z == other.z && phi < other.phi)));
+    }
+    bool operator!=(const MapPoint& other) const {
+        return R != other.R || z != other.z || phi != other.phi;
+    }
+};
+
+/** Find the subset of points at which the moments of DF need to be computed, given the symmetry
+    of the model: in the axisymmetric case the moments do not depend on phi, and in the case of
+    reflection symmetry the moments at -z differ only in the sign of some components.
+    \param[in]  points  is the array of input points;
+    \param[in]  sym  is the symmetry of the potential;
+    \param[out] uniqueIndex  will contain, for each input point, the index of the unique point,
+    or NONFINITE_POINT if any of its coordinates is infinite or NAN (such points are excluded
+    from sorting, since they would break the strict weak ordering required by std::sort);
+    \param[out] flip  will indicate, for each input point, whether it is a mirror image of
+    the unique point in z;
+    \return  the array of unique points.
+*/
+std::vector<coord::PosCyl> findUniquePoints(const std::vector<coord::PosCyl>& points,
+    coord::SymmetryType sym, std::vector<unsigned int>& uniqueIndex, std::vector<bool>& flip)
+{
+    const size_t numPoints = points.size();
+    const bool axisym = isAxisymmetric(sym), zsym = isZReflSymmetric(sym);
+    std::vector<MapPoint> sorted;
+    sorted.reserve(numPoints);
+    uniqueIndex.assign(numPoints, NONFINITE_POINT);
+    flip.assign(numPoints, false);
+    for(size_t i=0; i<numPoints; i++) {
+        if(!isFinite(points[i].R + points[i].z + points[i].phi))
+            continue;
+        MapPoint point;
+        point.R     = points[i].R;
+        point.z     = zsym ? fabs(points[i].z) : points[i].z;
+        point.phi   = axisym ? 0 : points[i].phi;
+        point.index = i;
+        sorted.push_back(point);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<coord::PosCyl> result;
+    for(size_t i=0; i<sorted.size(); i++) {
+        if(i==0 || sorted[i] != sorted[i-1])
+            result.push_back(coord::PosCyl(sorted[i].R, sorted[i].z, sorted[i].phi));
+        uniqueIndex[sorted[i].index] = result.size()-1;
+        flip[sorted[i].index] = zsym && points[sorted[i].index].z < 0;
+    }
+    return result;
+}
+
 }  // unnamed namespace
 
 //------- DRIVER ROUTINES -------//
@@ -540,6 +599,97 @@ void computeMoments(const GalaxyModel& model, const coord::PosCyl& point,
 }
 
 
+void computeMomentsMap(const GalaxyModel& model, const std::vector<coord::PosCyl>& points,
+    double* density, coord::VelCyl* velocityFirstMoment, coord::Vel2Cyl* velocitySecondMoment,
+    double* densityErr, coord::VelCyl* velocityFirstMomentErr, coord::Vel2Cyl* velocitySecondMomentErr,
+    const double reqRelError, const int maxNumEval)
+{
+    std::vector<unsigned int> uniqueIndex;
+    std::vector<bool> flip;
+    std::vector<coord::PosCyl> uniquePoints =
+        findUniquePoints(points, model.potential.symmetry(), uniqueIndex, flip);
+    const unsigned int numCompDF = model.distrFunc.numValues();
+    const int numUnique = uniquePoints.size();
+    const size_t numVal = numUnique * numCompDF;
+    // temporary storage for the results at unique points (error estimates for the density
+    // are only computed alongside the density itself, same as in computeMoments)
+    const bool needDensErr = density!=NULL && densityErr!=NULL;
+    const bool needVel1Err = velocityFirstMoment!=NULL && velocityFirstMomentErr!=NULL;
+    const bool needVel2Err = velocitySecondMoment!=NULL && velocitySecondMomentErr!=NULL;
+    std::vector<double> dens(density!=NULL ? numVal : 0), densErr(needDensErr ? numVal : 0);
+    std::vector<coord::VelCyl> vel1(velocityFirstMoment!=NULL ? numVal : 0), vel1Err(needVel1Err ? numVal : 0);
+    std::vector<coord::Vel2Cyl> vel2(velocitySecondMoment!=NULL ? numVal : 0), vel2Err(needVel2Err ? numVal : 0);
+    std::string errorMessage;  // store the error text in case of an exception in the openmp block
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int i=0; i<numUnique; i++) {
+        try{
+            computeMoments(model, uniquePoints[i],
+                density!=NULL ? &dens[i * numCompDF] : NULL,
+                velocityFirstMoment!=NULL ? &vel1[i * numCompDF] : NULL,
+                velocitySecondMoment!=NULL ? &vel2[i * numCompDF] : NULL,
+                needDensErr ? &densErr[i * numCompDF] : NULL,
+                needVel1Err ? &vel1Err[i * numCompDF] : NULL,
+                needVel2Err ? &vel2Err[i * numCompDF] : NULL,
+                reqRelError, maxNumEval);
+        }
+        catch(std::exception& ex) {
+            errorMessage = ex.what();
+        }
+    }
+    if(!errorMessage.empty())
+        throw std::runtime_error("computeMomentsMap: " + errorMessage);
+
+    // distribute the results to all input points, changing the sign of z-odd moments for mirror points;
+    // points with non-finite coordinates receive NAN in all output values
+    const double nan = NAN;
+    const coord::VelCyl vel1nan(nan, nan, nan);
+    const coord::Vel2Cyl vel2nan = {nan, nan, nan, nan, nan, nan};
+    for(size_t p=0; p<points.size(); p++) {
+        if(uniqueIndex[p] == NONFINITE_POINT) {
+            for(unsigned int ic=0; ic<numCompDF; ic++) {
+                const size_t out = p * numCompDF + ic;
+                if(density!=NULL)
+                    density[out] = nan;
+                if(needDensErr)
+                    densityErr[out] = nan;
+                if(velocityFirstMoment!=NULL)
+                    velocityFirstMoment[out] = vel1nan;
+                if(needVel1Err)
+                    velocityFirstMomentErr[out] = vel1nan;
+                if(velocitySecondMoment!=NULL)
+                    velocitySecondMoment[out] = vel2nan;
+                if(needVel2Err)
+                    velocitySecondMomentErr[out] = vel2nan;
+            }
+            continue;
+        }
+        const double sign = flip[p] ? -1 : 1;
+        for(unsigned int ic=0; ic<numCompDF; ic++) {
+            const size_t out = p * numCompDF + ic, src = uniqueIndex[p] * numCompDF + ic;
+            if(density!=NULL)
+                density[out] = dens[src];
+            if(needDensErr)
+                densityErr[out] = densErr[src];
+            if(velocityFirstMoment!=NULL) {
+                velocityFirstMoment[out] = vel1[src];
+                velocityFirstMoment[out].vz *= sign;
+            }
+            if(needVel1Err)
+                velocityFirstMomentErr[out] = vel1Err[src];
+            if(velocitySecondMoment!=NULL) {
+                velocitySecondMoment[out] = vel2[src];
+                velocitySecondMoment[out].vRvz   *= sign;
+                velocitySecondMoment[out].vzvphi *= sign;
+            }
+            if(needVel2Err)
+                velocitySecondMomentErr[out] = vel2Err[src];
+        }
+    }
+}
+
+
 template <int N>
 double computeVelocityDistribution(const GalaxyModel& model,
     const coord::PosCyl& point, bool projected,
@@ -630,8 +780,58 @@ void computeProjectedMoments(const GalaxyModel& model, const double R,
 }
 
 
+void computeProjectedMomentsMap(const GalaxyModel& model, const std::vector<double>& R,
+    double surfaceDensity[], double losvdisp[], double* surfaceDensityErr, double* losvdispErr,
+    const double reqRelError, const int maxNumEval)
+{
+    // find the unique values of radius, skipping non-finite ones (they would break the sorting)
+    std::vector<double> uniqueR;
+    uniqueR.reserve(R.size());
+    for(size_t p=0; p<R.size(); p++)
+        if(isFinite(R[p]))
+            uniqueR.push_back(R[p]);
+    std::sort(uniqueR.begin(), uniqueR.end());
+    uniqueR.erase(std::unique(uniqueR.begin(), uniqueR.end()), uniqueR.end());
+    const int numUnique = uniqueR.size();
+    std::vector<double> dens(numUnique), disp(numUnique), densErr(numUnique), dispErr(numUnique);
+    std::string errorMessage;  // store the error text in case of an exception in the openmp block
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int i=0; i<numUnique; i++) {
+        try{
+            computeProjectedMoments(model, uniqueR[i], dens[i], disp[i], &densErr[i], &dispErr[i],
+                reqRelError, maxNumEval);
+        }
+        catch(std::exception& ex) {
+            errorMessage = ex.what();
+        }
+    }
+    if(!errorMessage.empty())
+        throw std::runtime_error("computeProjectedMomentsMap: " + errorMessage);
+    for(size_t p=0; p<R.size(); p++) {
+        if(!isFinite(R[p])) {
+            surfaceDensity[p] = losvdisp[p] = NAN;
+            if(surfaceDensityErr)
+                surfaceDensityErr[p] = NAN;
+            if(losvdispErr)
+                losvdispErr[p] = NAN;
+            continue;
+        }
+        size_t i = std::lower_bound(uniqueR.begin(), uniqueR.end(), R[p]) - uniqueR.begin();
+        surfaceDensity[p] = dens[i];
+        losvdisp[p] = disp[i];
+        if(surfaceDensityErr)
+            surfaceDensityErr[p] = densErr[i];
+        if(losvdispErr)
+            losvdispErr[p] = dispErr[i];
+    }
+}
+
+
 particles::ParticleArrayCyl generateActionSamples(
-    const GalaxyModel& model, const size_t nSamp, std::vector<actions::Actions>* actsOutput)
+    const GalaxyModel& model, const size_t nSamp, std::vector<actions::Actions>* actsOutput,
+    bool quasiRandom)
 {
     // first sample points from the action space:
     // we use nAct << nSamp  distinct values for actions, and construct tori for these actions;
@@ -643,7 +843,7 @@ particles::ParticleArrayCyl generateActionSamples(
 
     // do the sampling in actions space
     double totalMass, totalMassErr;
-    df::sampleActions(model.distrFunc, nAct, actions, &totalMass, &totalMassErr);
+    df::sampleActions(model.distrFunc, nAct, actions, &totalMass, &totalMassErr, quasiRandom);
     nAct = actions.size();   // could be different from requested?
     //double totalMass = distrFunc.totalMass();
     double pointMass = totalMass / (nAct*nAng);
@@ -668,15 +868,70 @@ particles::ParticleArrayCyl generateActionSamples(
 }
 
 
+particles::ParticleArrayCyl generateActionSamples(
+    const GalaxyModel& model, const actions::BaseActionMapper& mapper, const size_t nSamp,
+    std::vector<actions::Actions>* actsOutput, bool quasiRandom)
+{
+    // sample actions from the DF, a distinct value for each output point
+    std::vector<actions::Actions> actions;
+    double totalMass, totalMassErr;
+    df::sampleActions(model.distrFunc, nSamp, actions, &totalMass, &totalMassErr, quasiRandom);
+    const int nAct = actions.size();
+    const double pointMass = totalMass / nAct;
+
+    // assign random angles sequentially, so that the results do not depend on the number of threads
+    std::vector<actions::ActionAngles> actAng(nAct);
+    for(int t=0; t<nAct; t++) {
+        actions::Angles ang;
+        ang.thetar   = 2*M_PI*math::random();
+        ang.thetaz   = 2*M_PI*math::random();
+        ang.thetaphi = 2*M_PI*math::random();
+        actAng[t] = actions::ActionAngles(actions[t], ang);
+    }
+
+    // convert action/angles to position/velocity in parallel
+    std::vector<coord::PosVelCyl> posvel(nAct);
+    std::string errorMessage;  // store the error text in case of an exception in the openmp block
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for(int t=0; t<nAct; t++) {
+        try{
+            try{
+                posvel[t] = mapper.map(actAng[t]);
+            }
+            catch(std::invalid_argument&) {
+                // the mapper cannot handle these actions: fit an individual torus
+                posvel[t] = actions::ActionMapperTorus(model.potential, actions[t]).map(actAng[t]);
+            }
+        }
+        catch(std::exception& ex) {
+            errorMessage = ex.what();
+        }
+    }
+    if(!errorMessage.empty())
+        throw std::runtime_error("generateActionSamples: " + errorMessage);
+
+    particles::ParticleArrayCyl points;
+    points.data.reserve(nAct);
+    for(int t=0; t<nAct; t++)
+        points.add(posvel[t], pointMass);
+    if(actsOutput!=NULL)
+        *actsOutput = actions;
+    return points;
+}
+
+
 particles::ParticleArrayCyl generatePosVelSamples(
-    const GalaxyModel& model, const size_t numSamples)
+    const GalaxyModel& model, const size_t numSamples, bool quasiRandom)
 {
     DFIntegrand6dim fnc(model);
     math::Matrix<double> result;      // sampled scaled coordinates/velocities
     double totalMass, errorMass;      // total normalization of the DF and its estimated error
     double xlower[6] = {0,0,0,0,0,0}; // boundaries of sampling region in scaled coordinates
     double xupper[6] = {1,1,1,1,1,1};
-    math::sampleNdim(fnc, xlower, xupper, numSamples, result, NULL, &totalMass, &errorMass);
+    math::sampleNdim(fnc, xlower, xupper, numSamples, result, NULL, &totalMass, &errorMass,
+        quasiRandom);
     const double pointMass = totalMass / result.rows();
     particles::ParticleArrayCyl points;
     points.data.reserve(result.rows());
@@ -35,6 +35,9 @@ public:
 
 /** Compute density, first-order, and second-order moments of velocity in cylindrical coordinates;
     if some of them are not needed, pass NULL as the corresponding argument, and it will not be computed.
+    The integrals over velocity are computed by deterministic adaptive cubature (`math::integrateNdim`),
+    not by Monte Carlo, so the results do not depend on the random seed, and the quasi-random
+    option of the sampling routines below has no counterpart here.
     \tparam     GalaxyModelType  is either GalaxyModel or GalaxyModelMulticomponent,
     in the latter case all non-NULL output arguments must point to arrays of length equal to the
     number of components of the DF, which will be filled with separate values for each DF component.
@@ -59,6 +62,28 @@ void computeMoments(const GalaxyModel& model, const coord::PosCyl& point,
     const double reqRelError=1e-3, const int maxNumEval=1e5);
 
 
+/** Compute density and velocity moments at many points at once (e.g., for constructing a map).
+    The arguments have the same meaning as in `computeMoments`, except that each non-NULL output
+    argument must point to an array of length `points.size() * model.distrFunc.numValues()`,
+    and the values for the i-th point and c-th component of DF are stored at index
+    `i * model.distrFunc.numValues() + c`.
+    Points that are equivalent due to the symmetry of the model (i.e., differ only in phi for
+    an axisymmetric potential, or only in the sign of z for a reflection-symmetric one)
+    are computed only once, and the integrals at the remaining unique points are distributed
+    between OpenMP threads with dynamic load balancing.
+    Points with non-finite coordinates are not computed, and all output values for them are NAN.
+    \throw  std::runtime_error if the computation failed at any point.
+*/
+void computeMomentsMap(const GalaxyModel& model, const std::vector<coord::PosCyl>& points,
+    double* density,
+    coord::VelCyl* velocityFirstMoment,
+    coord::Vel2Cyl* velocitySecondMoment,
+    double* densityErr=NULL,
+    coord::VelCyl* velocityFirstMomentErr=NULL,
+    coord::Vel2Cyl* velocitySecondMomentErr=NULL,
+    const double reqRelError=1e-3, const int maxNumEval=1e5);
+
+
 /** Compute the velocity distribution functions (VDF) in three directions in cylindrical coordinates
     at the given point in space.
     The VDF is represented as a weighted sum of B-splines of degree N:
@@ -150,6 +175,20 @@ void computeProjectedMoments(const GalaxyModel& model, const double R,
     const double reqRelError=1e-3, const int maxNumEval=1e5);
 
 
+/** Compute the projected moments of distribution function at many projected radii at once.
+    The arguments have the same meaning as in `computeProjectedMoments`, but the output arguments
+    are arrays of the same length as the input array of radii (the error arrays may be NULL).
+    Coinciding radii (e.g., for pixels of a map symmetric with respect to the center)
+    are computed only once, and the remaining integrals are distributed between OpenMP threads.
+    Non-finite input radii produce NAN in all output arrays.
+    \throw  std::runtime_error if the computation failed at any point.
+*/
+void computeProjectedMomentsMap(const GalaxyModel& model, const std::vector<double>& R,
+    double surfaceDensity[], double losvdisp[],
+    double* surfaceDensityErr=NULL, double* losvdispErr=NULL,
+    const double reqRelError=1e-3, const int maxNumEval=1e5);
+
+
 /** Generate N-body samples of the distribution function 
     by sampling in action/angle space:
     sample actions directly from DF and angles uniformly from [0:2pi]^3,
@@ -158,12 +197,38 @@ void computeProjectedMoments(const GalaxyModel& model, const double R,
     \param[in]  numPoints  is the required number of samples;
     \param[out] actions (optional) will be filled with values of actions
     corresponding to each point; if not needed may pass NULL as this argument.
+    \param[in]  quasiRandom (optional) if true, sample actions using a quasi-random sequence.
     \returns    a new array of particles (position/velocity/mass)
     sampled from the distribution function;
 */
 particles::ParticleArrayCyl generateActionSamples(
     const GalaxyModel& model, const size_t numPoints,
-    std::vector<actions::Actions>* actions=NULL);
+    std::vector<actions::Actions>* actions=NULL, bool quasiRandom=false);
+
+/** Generate N-body samples of the distribution function by sampling in action/angle space,
+    using a precomputed action mapper (e.g., `actions::ActionMapperTorusGrid`) to convert
+    from action/angles to position/velocity, which is much cheaper than fitting a new torus
+    for each sampled value of actions; hence every output point has distinct actions.
+    The conversion is performed in parallel; points for which the mapper throws
+    a `std::invalid_argument` exception (e.g., actions beyond the last node of the grid of tori)
+    are converted by fitting an individual torus, which is orders of magnitude more expensive,
+    so the grid should cover the range of actions sampled from the DF. Values of Jr and Jz
+    between zero and the first node of the grid are handled by `actions::ActionMapperTorusGrid`
+    using the tori at this node, and do not require a torus fit.
+    \param[in]  model  is the galaxy model;
+    \param[in]  mapper is the action mapper, which should accept arbitrary values of actions
+    and be thread-safe;
+    \param[in]  numPoints  is the required number of samples;
+    \param[out] actions (optional) will be filled with values of actions
+    corresponding to each point; if not needed may pass NULL as this argument.
+    \param[in]  quasiRandom (optional) if true, sample actions using a quasi-random sequence.
+    \returns    a new array of particles (position/velocity/mass)
+    sampled from the distribution function;
+    \throw      std::runtime_error if the conversion failed for some points.
+*/
+particles::ParticleArrayCyl generateActionSamples(
+    const GalaxyModel& model, const actions::BaseActionMapper& mapper, const size_t numPoints,
+    std::vector<actions::Actions>* actions=NULL, bool quasiRandom=false);
 
 
 /** Generate N-body samples of the distribution function 
@@ -172,11 +237,14 @@ particles::ParticleArrayCyl generateActionSamples(
     and evaluate the value of DF at the given actions.
     \param[in]  model  is the galaxy model;
     \param[in]  numPoints  is the required number of samples;
+    \param[in]  quasiRandom (optional) if true, use a quasi-random (scrambled Sobol) sequence
+    for the internal sampling points, which requires fewer DF and action evaluations
+    for the same accuracy (see `math::sampleNdim`).
     \returns    a new array of particles (position/velocity/mass)
     sampled from the distribution function;
 */
 particles::ParticleArrayCyl generatePosVelSamples(
-    const GalaxyModel& model, const size_t numPoints);
+    const GalaxyModel& model, const size_t numPoints, bool quasiRandom=false);
 
 
 /** Sample the density profile by discrete points.
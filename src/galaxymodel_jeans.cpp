@@ -244,6 +244,11 @@ JeansAxi::JeansAxi(const potential::BaseDensity &dens, const potential::BasePote
     }
 #endif
 
+    // compute the second moments of velocity at all grid nodes; this involves azimuthal averaging
+    // of the potential derivatives, which may be expensive for non-axisymmetric potentials
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
     for(int iz=0; iz<gridzsize; iz++) {
         for(int iR=0; iR<gridRsize; iR++) {
             double R = gridR[iR], z = gridz[iz];
@@ -35,6 +35,23 @@ std::vector<GaussianPSF> checkPSF(const std::vector<GaussianPSF>& gaussianPSF)
     return gaussianPSF;
 }
 
+/// convert a dense matrix into a sparse one, dropping the elements that are smaller in magnitude
+/// than the largest element multiplied by the threshold
+math::SparseMatrix<double> toSparseMatrix(const math::Matrix<double>& mat, double threshold=1e-15)
+{
+    const double* data = mat.data();
+    const size_t size = mat.size(), ncols = mat.cols();
+    double maxval = 0.;
+    for(size_t k=0; k<size; k++)
+        maxval = fmax(maxval, fabs(data[k]));
+    threshold *= maxval;
+    std::vector<math::Triplet> values;
+    for(size_t k=0; k<size; k++)
+        if(fabs(data[k]) > threshold)
+            values.push_back(math::Triplet(k / ncols, k % ncols, data[k]));
+    return math::SparseMatrix<double>(mat.rows(), ncols, values);
+}
+
 template<int N>
 math::Matrix<double> getConvolutionMatrix(
     const math::BsplineInterpolator1d<N> &bspl, const GaussianPSF &kernel)
@@ -263,7 +280,7 @@ double GaussHermiteExpansion::norm() const {
 template<int N>
 LOSVDGrid<N>::LOSVDGrid(const LOSVDGridParams& params) :
     bsplx(params.gridx), bsply(params.gridy), bsplv(params.gridv),
-    apertureConvolutionMatrix(params.apertures.size(), bsplx.numValues() * bsply.numValues(), 0.)
+    recordApertures(params.recordApertures)
 {
     const size_t
         numApertures = params.apertures.size(),
@@ -277,24 +294,43 @@ LOSVDGrid<N>::LOSVDGrid(const LOSVDGridParams& params) :
     // intrinsic 3d coordinate system into image plane coordinates and line-of-sight velocity
     math::makeRotationMatrix(params.theta, params.phi, params.chi, transformMatrix);
 
-    // construct the spatial rebinning matrix
-    math::Matrix<double> apertureMatrix(numApertures, numBasisFnc, 0.);
+    // construct the spatial rebinning matrix: each aperture overlaps with only a small fraction
+    // of basis functions, so the integrals over apertures are computed in parallel into
+    // a thread-local dense row, and only the nonzero elements are retained in a sparse matrix
+    std::vector< std::vector<math::Triplet> > apertureValues(numApertures);
     volatile bool outOfBounds = false;
 #ifdef _OPENMP
-#pragma omp parallel for schedule(static)
+#pragma omp parallel
 #endif
-    for(int i = 0; i < (int)numApertures; i++) {
-        bool apOutOfBounds = math::computeBsplineIntegralsOverPolygon(
-            params.apertures[i], bsplx, bsply, &apertureMatrix(i, 0));
-        outOfBounds |= apOutOfBounds;
+    {
+        std::vector<double> row(numBasisFnc);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for(int i = 0; i < (int)numApertures; i++) {
+            std::fill(row.begin(), row.end(), 0.);
+            bool apOutOfBounds = math::computeBsplineIntegralsOverPolygon(
+                params.apertures[i], bsplx, bsply, &row[0]);
+            outOfBounds |= apOutOfBounds;
+            for(size_t j = 0; j < numBasisFnc; j++)
+                if(row[j] != 0)
+                    apertureValues[i].push_back(math::Triplet(i, j, row[j]));
+        }
     }
     if(outOfBounds)
         utils::msg(utils::VL_MESSAGE, "LOSVDGrid", "Datacube does not cover all apertures");
+    std::vector<math::Triplet> values;
+    for(size_t i = 0; i < numApertures; i++)
+        values.insert(values.end(), apertureValues[i].begin(), apertureValues[i].end());
+    const math::SparseMatrix<double> apertureMatrix(numApertures, numBasisFnc, values);
+    apertureValues.clear();
+    values.clear();
 
     // ensure that there is at least one PSF, even with a zero width
     std::vector<GaussianPSF> spatialPSF = checkPSF<N>(params.spatialPSF);
 
-    // construct the combined aperture rebinning + spatial convolution matrix
+    // construct the combined aperture rebinning + spatial convolution matrix (initially dense)
+    math::Matrix<double> convMatrix(numApertures, numBasisFnc, 0.);
     for(size_t g = 0; g < spatialPSF.size(); g++) {
         const math::Matrix<double> convx = getConvolutionMatrix(bsplx, spatialPSF[g]);
         const math::Matrix<double> convy = getConvolutionMatrix(bsply, spatialPSF[g]);
@@ -306,7 +342,7 @@ LOSVDGrid<N>::LOSVDGrid(const LOSVDGridParams& params) :
             math::Matrix<double> block(numBasisFnc, numBasisFncX), tmpprod(numApertures, numBasisFncX);
             // faster access to matrix elements in row-major order through pointers to flattened data
             const double *dconvx = convx.data(), *dprod = tmpprod.data();
-            double *dconva = apertureConvolutionMatrix.data(), *dblock = block.data();
+            double *dconva = convMatrix.data(), *dblock = block.data();
 
             // we need to compute the product Q = A L  of the matrix A (apertureMatrix)
             // having Na (numApertures) rows and Nx * Ny (numBasisFncX * numBasisFncY) columns
@@ -333,7 +369,7 @@ LOSVDGrid<N>::LOSVDGrid(const LOSVDGridParams& params) :
                     for(size_t lk = 0, dest = j * numBasisFncX2; lk < numBasisFncX2; lk++, dest++)
                         dblock[dest] = dconvx[lk] * convYji;
                 }
-                // multiply the matrix A by the block and store the result in temporary product matrix
+                // multiply the (sparse) matrix A by the block and store the result in temporary product matrix
                 math::blas_dgemm(math::CblasNoTrans, math::CblasNoTrans, 1.,
                     apertureMatrix, block, 0., tmpprod);
                 // copy-add the result into the vertical stripe of destination matrix Q,
@@ -349,39 +385,116 @@ LOSVDGrid<N>::LOSVDGrid(const LOSVDGridParams& params) :
         }
     }
 
+    // store only the elements that are not negligibly small compared to the largest one
+    apertureConvolutionMatrix = toSparseMatrix(convMatrix);
+    convMatrix = math::Matrix<double>();
+
     // construct the velocity convolution matrix
-    velocityConvolutionMatrix = getConvolutionMatrix(bsplv, GaussianPSF(params.velocityPSF, 1.));
+    velocityConvolutionMatrix = toSparseMatrix(
+        getConvolutionMatrix(bsplv, GaussianPSF(params.velocityPSF, 1.)));
+
+    // in the direct recording mode, arrange the nonzero elements of the aperture matrix column-wise
+    if(recordApertures) {
+        values = apertureConvolutionMatrix.values();
+        apertureColumnStart.assign(numBasisFnc+1, 0);
+        for(size_t k = 0; k < values.size(); k++)
+            apertureColumnStart[values[k].j+1]++;
+        for(size_t c = 0; c < numBasisFnc; c++)
+            apertureColumnStart[c+1] += apertureColumnStart[c];
+        apertureRowIndex.resize(values.size());
+        apertureValue.resize(values.size());
+        std::vector<unsigned int> pos(apertureColumnStart.begin(), apertureColumnStart.end()-1);
+        for(size_t k = 0; k < values.size(); k++) {
+            unsigned int e = pos[values[k].j]++;
+            apertureRowIndex[e] = values[k].i;
+            apertureValue[e] = values[k].v;
+        }
+    }
 }
 
 template<int N>
-void LOSVDGrid<N>::addPoint(const double point[6], const double mult, double* datacube) const
+void LOSVDGrid<N>::addPoints(const double points[], const double mults[], const unsigned int numPoints,
+    double* datacube) const
+{
+    // consecutive points on the trajectory often share the same set of nonzero basis functions,
+    // so their contributions are first summed up in a small block of (N+1)^3 elements,
+    // and this block is added to the datacube only when the next point falls into
+    // a different grid cell (or at the end)
+    double block[(N+1)*(N+1)*(N+1)];
+    int blockx = -1, blocky = -1, blockv = -1;  // leftmost indices of basis functions in the block
+    for(unsigned int p=0; p<numPoints; p++) {
+        // convert the point to the image plane coordinates and the line-of-sight velocity
+        const double* point = points + p*6;
+        const double
+        X =   transformMatrix[0] * point[0] + transformMatrix[1] * point[1] + transformMatrix[2] * point[2],
+        Y =   transformMatrix[3] * point[0] + transformMatrix[4] * point[1] + transformMatrix[5] * point[2],
+        // z' axis points towards the observer, so we have a minus sign for v_los
+        V = -(transformMatrix[6] * point[3] + transformMatrix[7] * point[4] + transformMatrix[8] * point[5]);
+        // find the index of grid segment in each dimension that this points belongs to,
+        // and evaluate all nontrivial basis functions at this point in each dimension
+        double weightx[N+1], weighty[N+1], weightv[N+1];
+        int indx = bsplx.nonzeroComponents(X, 0, weightx),
+            indy = bsply.nonzeroComponents(Y, 0, weighty),
+            indv = bsplv.nonzeroComponents(V, 0, weightv);
+        if(indx != blockx || indy != blocky || indv != blockv) {
+            if(blockx >= 0)
+                addBlock(blockx, blocky, blockv, block, datacube);
+            std::fill(block, block + (N+1)*(N+1)*(N+1), 0.);
+            blockx = indx;
+            blocky = indy;
+            blockv = indv;
+        }
+        // add the outer product of three 1d arrays of weights to the block
+        for(int i=0; i<=N; i++)
+            for(int j=0; j<=N; j++) {
+                const double weightxy = mults[p] * weightx[i] * weighty[j];
+                double* dest = block + (i * (N+1) + j) * (N+1);
+                for(int k=0; k<=N; k++)
+                    dest[k] += weightxy * weightv[k];
+            }
+    }
+    if(blockx >= 0)
+        addBlock(blockx, blocky, blockv, block, datacube);
+}
+
+template<int N>
+void LOSVDGrid<N>::addBlock(int indx, int indy, int indv, const double block[], double* datacube) const
 {
-    double xp =   transformMatrix[0] * point[0] + transformMatrix[1] * point[1] + transformMatrix[2] * point[2];
-    double yp =   transformMatrix[3] * point[0] + transformMatrix[4] * point[1] + transformMatrix[5] * point[2];
-    // z' axis points towards the observer, so we have a minus sign for v_los
-    double vl = -(transformMatrix[6] * point[3] + transformMatrix[7] * point[4] + transformMatrix[8] * point[5]);
-
-    // find the index of grid segment in each dimension that this points belongs to,
-    // and evaluate all nontrivial basis functions at this point in each dimension
-    double weightx[N+1], weighty[N+1], weightv[N+1];
-    int indx = bsplx.nonzeroComponents(xp, 0, weightx),
-        indy = bsply.nonzeroComponents(yp, 0, weighty),
-        indv = bsplv.nonzeroComponents(vl, 0, weightv);
-
-    // add the contribution of this point to the datacube
     const size_t nx = bsplx.numValues(), nv = bsplv.numValues();
     for(int i=0; i<=N; i++)
-        for(int j=0; j<=N; j++)
-            for(int k=0; k<=N; k++)
-                //datacube((indy + j) * nx + indx + i, indv + k) +=
-                datacube[ ((indy + j) * nx + indx + i) * nv + indv + k ] +=
-                    mult * weightx[i] * weighty[j] * weightv[k];
+        for(int j=0; j<=N; j++) {
+            const double* src = block + (i * (N+1) + j) * (N+1);
+            // index of the spatial basis function (row of the datacube)
+            const size_t indxy = (indy + j) * nx + indx + i;
+            if(!recordApertures) {
+                //datacube(indxy, indv + k) += ...
+                double* dest = datacube + indxy * nv + indv;
+                for(int k=0; k<=N; k++)
+                    dest[k] += src[k];
+            } else {
+                // distribute the contribution among all apertures that overlap with this basis function
+                for(unsigned int e = apertureColumnStart[indxy]; e < apertureColumnStart[indxy+1]; e++) {
+                    const double mult = apertureValue[e];
+                    double* dest = datacube + apertureRowIndex[e] * nv + indv;
+                    for(int k=0; k<=N; k++)
+                        dest[k] += mult * src[k];
+                }
+            }
+        }
 }
 
 template<int N>
 math::Matrix<double> LOSVDGrid<N>::getAmplitudes(const math::Matrix<double> &datacube) const
 {
-    // 1st stage: spatial convolution and rebinning
+    if(recordApertures) {
+        // the spatial convolution and rebinning has already been performed during data collection,
+        // and the datacube contains the LOSVDs in each aperture - only apply the velocity convolution
+        math::Matrix<double> result(apertureConvolutionMatrix.rows(), bsplv.numValues());
+        math::blas_dgemm(math::CblasNoTrans, math::CblasTrans,
+            1., datacube, velocityConvolutionMatrix, 0., result);
+        return result;
+    }
+    // 1st stage: spatial convolution and rebinning (sparse-dense matrix product)
     math::Matrix<double> tmpmat(apertureConvolutionMatrix.rows(), bsplv.numValues());
     math::blas_dgemm(math::CblasNoTrans, math::CblasNoTrans,
         1., apertureConvolutionMatrix, datacube, 0., tmpmat);
@@ -66,10 +66,17 @@ struct LOSVDGridParams {
     std::vector<GaussianPSF> spatialPSF;  ///< array of spatial point-spread functions
     double velocityPSF;                   ///< width of the gaussian velocity smoothing kernel
     std::vector<math::Polygon> apertures; ///< array of apertures on the image plane
+    /// whether to accumulate the data for each orbit directly in the spatially convolved
+    /// and rebinned representation (an array of LOSVDs in each aperture), instead of
+    /// the full 3d datacube of B-spline amplitudes: this saves memory and the cost of
+    /// finalization of each orbit, but makes each point on the trajectory more expensive
+    /// to record, so is preferrable when the number of apertures is much smaller than
+    /// the number of spatial basis functions, or when the spatial PSF is narrow
+    bool recordApertures;
 
     /// set (unreasonable) default values
     LOSVDGridParams() :
-        theta(0.), phi(0.), chi(0.), velocityPSF(0.) {}
+        theta(0.), phi(0.), chi(0.), velocityPSF(0.), recordApertures(false) {}
 };
 
 
@@ -87,6 +94,15 @@ public:
     /// allocate a new internal 3d data cube stored in a 2d matrix of the appropriate shape
     virtual math::Matrix<double> newDatacube() const = 0;
 
+    /// add several weighted points to the datacube at once (more efficient than adding them
+    /// one by one with `addPoint()`, especially if consecutive points are close to each other).
+    /// \param[in]  points  is the flattened array of numPoints 6d phase-space points;
+    /// \param[in]  mults   is the array of their weights;
+    /// \param[in]  numPoints  is the number of points;
+    /// \param[in,out]  datacube  points to the external array storing the flattened data cube.
+    virtual void addPoints(const double points[], const double mults[], const unsigned int numPoints,
+        double* datacube) const = 0;
+
     /// convert the intermediate data stored in the regular 3d data cube
     /// into the array of basis function amplitudes for the LOSVD in each aperture
     virtual math::Matrix<double> getAmplitudes(const math::Matrix<double> &datacube) const = 0;
@@ -125,6 +141,10 @@ public:
     where each row represents the data for a single aperture.
     The last step uses two auxiliary matrices for the spatial and velocity directions, correspondingly,
     which are initialized in the constructor.
+    Alternatively, if `LOSVDGridParams::recordApertures` is set, the spatial convolution and
+    rebinning is applied to each point as it is added, and the external array stores
+    the LOSVD in each aperture (numApertures rows, bsplv.numValues() columns), so that only
+    the velocity convolution is performed at the end.
     \tparam N  is the degree of B-spline interpolators (0,1,2 or 3).
     Higher-degree interpolators are more accurate and allow a larger pixel size
     (fewer expansion coefficients).
@@ -133,8 +153,19 @@ template<int N>
 class LOSVDGrid: public BaseLOSVDGrid {
     double transformMatrix[9];     ///< rotation matrix for transforming intrinsic to projected coords
     const math::BsplineInterpolator1d<N> bsplx, bsply, bsplv;  ///< basis-set interpolators
-    math::Matrix<double> apertureConvolutionMatrix;  ///< spatial convolution and rebinning matrix
-    math::Matrix<double> velocityConvolutionMatrix;  ///< velocity convolution matrix
+    math::SparseMatrix<double> apertureConvolutionMatrix;  ///< spatial convolution and rebinning matrix
+    math::SparseMatrix<double> velocityConvolutionMatrix;  ///< velocity convolution matrix
+    const bool recordApertures;    ///< whether to record the data directly in apertures
+    /// column-compressed copy of the nonzero elements of apertureConvolutionMatrix,
+    /// used in the direct recording mode: for each spatial basis function (column) with index c,
+    /// the elements with indices from apertureColumnStart[c] to apertureColumnStart[c+1]-1
+    /// contain the aperture (row) indices and the corresponding values of the matrix
+    std::vector<unsigned int> apertureColumnStart, apertureRowIndex;
+    std::vector<double> apertureValue;
+
+    /// add the contribution of a block of (N+1)^3 basis functions with the leftmost indices
+    /// indx, indy, indv to the datacube (or to the array of LOSVDs in apertures)
+    void addBlock(int indx, int indy, int indv, const double block[], double* datacube) const;
 public:
     /// construct the grid with given parameters
     /// \throw std::invalid_argument if the parameters are incorrect
@@ -142,12 +173,15 @@ public:
 
     /// return the total number of points in the flattened datacube
     virtual unsigned int numValues() const {
-        return bsplx.numValues() * bsply.numValues() * bsplv.numValues();
+        return (recordApertures ? apertureConvolutionMatrix.rows() :
+            bsplx.numValues() * bsply.numValues()) * bsplv.numValues();
     }
 
     /// allocate a new internal 3d data cube stored in a 2d matrix of the appropriate shape
+    /// (or the array of LOSVDs in each aperture, if recordApertures==true)
     virtual math::Matrix<double> newDatacube() const {
-        return math::Matrix<double>(bsplx.numValues() * bsply.numValues(), bsplv.numValues(), 0.);
+        return math::Matrix<double>(recordApertures ? apertureConvolutionMatrix.rows() :
+            bsplx.numValues() * bsply.numValues(), bsplv.numValues(), 0.);
     }
 
     /// add a weighted point to the datacube.
@@ -157,7 +191,12 @@ public:
     /// \param[in,out]  datacube points to the external array storing the flattened 3d data cube;
     /// all its elements that have a contribution from the input point are incremented by
     /// the weights of corresponding basis functions multiplied by the input factor 'mult'.
-    virtual void addPoint(const double point[6], const double mult, double* datacube) const;
+    virtual void addPoint(const double point[6], const double mult, double* datacube) const {
+        addPoints(point, &mult, 1, datacube);
+    }
+
+    virtual void addPoints(const double points[], const double mults[], const unsigned int numPoints,
+        double* datacube) const;
 
     virtual math::Matrix<double> getAmplitudes(const math::Matrix<double> &datacube) const;
 
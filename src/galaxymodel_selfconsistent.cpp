@@ -2,6 +2,7 @@
 #include "galaxymodel.h"
 #include "actions_staeckel.h"
 #include "actions_spherical.h"
+#include "actions_triaxial.h"
 #include "potential_composite.h"
 #include "potential_multipole.h"
 #include "potential_cylspline.h"
@@ -173,7 +174,8 @@ void updateTotalPotential(SelfConsistentModel& model)
     if(totalDensityDisk != NULL)
         compPot.push_back(potential::CylSpline::create(*totalDensityDisk, model.mmaxAngularCyl,
             model.sizeRadialCyl,   model.RminCyl, model.RmaxCyl,
-            model.sizeVerticalCyl, model.zminCyl, model.zmaxCyl, true /*use derivs*/));
+            model.sizeVerticalCyl, model.zminCyl, model.zmaxCyl, true /*use derivs*/,
+            model.useFFTCyl));
 
     // now check if the total potential is elementary or composite
     if(compPot.size()==0)
@@ -185,7 +187,9 @@ void updateTotalPotential(SelfConsistentModel& model)
 
     // update the action finder
     std::cout << "done\nUpdating action finder..."<<std::flush;
-    if(isSpherical(*model.totalPotential))
+    if(model.useTriaxialActionFinder)
+        model.actionFinder.reset(new actions::ActionFinderTriaxialFudge(model.totalPotential));
+    else if(isSpherical(*model.totalPotential))
         model.actionFinder.reset(new actions::ActionFinderSpherical(*model.totalPotential));
     else
         model.actionFinder.reset(
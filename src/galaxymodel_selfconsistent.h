@@ -291,6 +291,13 @@ public:
     /// whether to use the interpolated action finder (faster but less accurate)
     bool useActionInterpolation;
 
+    /** whether to use the triaxial Staeckel fudge action finder instead of the spherical or
+        axisymmetric one (the potential must have triaxial symmetry); in this case the actions
+        are J_lambda, J_nu, J_mu (stored in Jr, Jz, Jphi), so the DFs of all components should
+        be expressed in terms of these actions, and the flag `useActionInterpolation` is ignored
+    */
+    bool useTriaxialActionFinder;
+
     /** parameters of grid for computing the multipole expansion of the combined
         density profile of spheroidal components;
         in general, these parameters should encompass the range of analogous parameters 
@@ -312,13 +319,14 @@ public:
     double RminCyl, RmaxCyl;      ///< innermost (non-zero) and outermost grid nodes in cylindrical radius
     unsigned int sizeVerticalCyl; ///< number of grid nodes in vertical (z) direction
     double zminCyl, zmaxCyl;      ///< innermost and outermost grid nodes in vertical direction
+    bool useFFTCyl;               ///< whether to use the faster Hankel-transform Poisson solver
 
     /// assign default values
     SelfConsistentModel() :
-        useActionInterpolation(true),
+        useActionInterpolation(true), useTriaxialActionFinder(false),
         lmaxAngularSph(0), mmaxAngularSph(0), sizeRadialSph(25), rminSph(0), rmaxSph(0),
         mmaxAngularCyl(0), sizeRadialCyl(20), RminCyl(0), RmaxCyl(0),
-        sizeVerticalCyl(20), zminCyl(0), zmaxCyl(0)
+        sizeVerticalCyl(20), zminCyl(0), zmaxCyl(0), useFFTCyl(false)
     {}
 };
 
@@ -52,6 +52,26 @@ inline math::Matrix<double> finalizeData(
     const BaseLOSVDGrid& fnc, const math::Matrix<double>& datacube)
 { return fnc.getAmplitudes(datacube); }  // non-trivial finalization
 
+/// add several 6d points with their weights to the datacube
+template<typename FncType>
+void addPoints(const FncType& fnc, const double points[], const double mults[],
+    const unsigned int numPoints, double* datacube);
+
+/// generic implementation: add each point separately
+template<>
+inline void addPoints(const math::IFunctionNdimAdd& fnc, const double points[], const double mults[],
+    const unsigned int numPoints, double* datacube)
+{
+    for(unsigned int i=0; i<numPoints; i++)
+        fnc.addPoint(points + i*6, mults[i], datacube);
+}
+
+/// specialized implementation for the LOSVD grid, which processes all points in one batch
+template<>
+inline void addPoints(const BaseLOSVDGrid& fnc, const double points[], const double mults[],
+    const unsigned int numPoints, double* datacube)
+{ fnc.addPoints(points, mults, numPoints, datacube); }
+
 
 /// Orbit runtime function that collects the values of a given N-dimensional function
 /// for each point on the trajectory, weighted by the amount of time spent at this point
@@ -101,13 +121,16 @@ public:
     {
         time += tend-tbegin;
         double substep = (tend-tbegin) / NUM_SAMPLES_PER_STEP;  // duration of each sub-step
-        double *dataptr = datacube.data();
+        // position and velocity in cartesian coordinates at all sub-steps, and their weights
+        double points[NUM_SAMPLES_PER_STEP * 6], mults[NUM_SAMPLES_PER_STEP];
         for(int s=0; s<NUM_SAMPLES_PER_STEP; s++) {
-            double point[6];  // position and velocity in cartesian coordinates at the current sub-step
             double tsubstep = tbegin + substep * (s+0.5);  // equally-spaced samples in time
-            solver.getSol(tsubstep, point);
-            fnc.addPoint(point, substep, dataptr);
+            solver.getSol(tsubstep, points + s*6);
+            mults[s] = substep;
         }
+        // add all points from this timestep in one call, which is more efficient
+        // for functions that provide a batched implementation
+        addPoints(fnc, points, mults, NUM_SAMPLES_PER_STEP, datacube.data());
         return orbit::SR_CONTINUE;
     }
 };
@@ -12,16 +12,17 @@
 //----- velocity assignment -----//
 namespace galaxymodel {
 
-particles::ParticleArrayCar assignVelocityEdd(
-    const particles::ParticleArray<coord::PosCyl>& pointCoords,
-    const potential::BasePotential& pot,
-    const SphericalModelLocal& sphModel)
-{
-    size_t npoints = pointCoords.size();
-    particles::ParticleArrayCar result;
-    result.data.reserve(npoints);
-    for(size_t i=0; i<npoints; i++) {
-        const coord::PosCyl& point = pointCoords.point(i);
+namespace {  // internal
+
+/// sampler of velocities from the isotropic DF of a spherical model
+class VelocitySamplerEdd {
+    const potential::BasePotential& pot;
+    const SphericalModelLocal& sphModel;
+public:
+    VelocitySamplerEdd(const potential::BasePotential& _pot, const SphericalModelLocal& _sphModel) :
+        pot(_pot), sphModel(_sphModel) {}
+    coord::PosVelCar operator()(const coord::PosCyl& point) const
+    {
         double Phi = pot.value(point);
         double v;
         int numAttempts = 0;  // prevent a lockup in troubled cases
@@ -30,24 +31,23 @@ particles::ParticleArrayCar assignVelocityEdd(
         } while(Phi + 0.5*v*v > 0 && ++numAttempts<100);
         double vec[3];
         math::getRandomUnitVector(vec);
-        result.add(coord::PosVelCar(
+        return coord::PosVelCar(
             point.R * cos(point.phi), point.R * sin(point.phi), point.z,
-            v * vec[0], v * vec[1], v * vec[2]),
-            pointCoords.mass(i));
+            v * vec[0], v * vec[1], v * vec[2]);
     }
-    return result;
-}
+};
 
-particles::ParticleArrayCar assignVelocityJeansSph(
-    const particles::ParticleArray<coord::PosCyl>& pointCoords,
-    const potential::BasePotential& pot,
-    const math::IFunction& jeansSphModel, const double beta)
-{
-    size_t npoints = pointCoords.size();
-    particles::ParticleArrayCar result;
-    result.data.reserve(npoints);
-    for(size_t i=0; i<npoints; i++) {
-        const coord::PosCyl& point = pointCoords.point(i);
+/// sampler of velocities from a Gaussian distribution given by a spherical Jeans model
+class VelocitySamplerJeansSph {
+    const potential::BasePotential& pot;
+    const math::IFunction& jeansSphModel;
+    const double beta;
+public:
+    VelocitySamplerJeansSph(const potential::BasePotential& _pot,
+        const math::IFunction& _jeansSphModel, const double _beta) :
+        pot(_pot), jeansSphModel(_jeansSphModel), beta(_beta) {}
+    coord::PosVelCar operator()(const coord::PosCyl& point) const
+    {
         double r = hypot(point.R, point.z);
         double sigma_r = jeansSphModel.value(r);
         double sigma_t = sigma_r * sqrt(2-2*beta);  // vel.disp. in two tangential directions combined
@@ -63,26 +63,25 @@ particles::ParticleArrayCar assignVelocityJeansSph(
         double vper[3];
         math::getRandomPerpendicularVector(xyz, vper);
         if(r==0) r=1.;  // avoid indeterminacy
-        result.add(coord::PosVelCar(
+        return coord::PosVelCar(
             xyz[0], xyz[1], xyz[2],
             vr * xyz[0] / r + vt * vper[0],
             vr * xyz[1] / r + vt * vper[1],
-            vr * xyz[2] / r + vt * vper[2]),
-            pointCoords.mass(i));
+            vr * xyz[2] / r + vt * vper[2]);
     }
-    return result;
-}
+};
 
-particles::ParticleArrayCar assignVelocityJeansAxi(
-    const particles::ParticleArray<coord::PosCyl>& pointCoords,
-    const potential::BasePotential& pot,
-    const JeansAxi& jeansAxiModel, const double kappa)
-{
-    size_t npoints = pointCoords.size();
-    particles::ParticleArrayCar result;
-    result.data.reserve(npoints);
-    for(size_t i=0; i<npoints; i++) {
-        const coord::PosCyl& point = pointCoords.point(i);
+/// sampler of velocities from a triaxial Gaussian distribution given by an axisymmetric Jeans model
+class VelocitySamplerJeansAxi {
+    const potential::BasePotential& pot;
+    const JeansAxi& jeansAxiModel;
+    const double kappa;
+public:
+    VelocitySamplerJeansAxi(const potential::BasePotential& _pot,
+        const JeansAxi& _jeansAxiModel, const double _kappa) :
+        pot(_pot), jeansAxiModel(_jeansAxiModel), kappa(_kappa) {}
+    coord::PosVelCar operator()(const coord::PosCyl& point) const
+    {
         const coord::Vel2Cyl vel2  = jeansAxiModel.velDisp(point);
         double sigma_z   = sqrt(vel2.vz2);
         double sigma_R   = sqrt(vel2.vR2);
@@ -98,12 +97,71 @@ particles::ParticleArrayCar assignVelocityJeansAxi(
             vR *= sigma_R;
             vz *= sigma_z;
         } while(Phi + 0.5 * (vR*vR + vz*vz + vphi*vphi) > 0 && ++numAttempts<100);
-        result.add(toPosVelCar(coord::PosVelCyl(point, coord::VelCyl(vR, vz, vphi))),
-            pointCoords.mass(i));
+        return toPosVelCar(coord::PosVelCyl(point, coord::VelCyl(vR, vz, vphi)));
+    }
+};
+
+/** assign velocities to all particles using the given sampler, in parallel if OpenMP is available
+    (each thread uses its own stream of random numbers, see `math::random()`; hence the result
+    is deterministic for a fixed number of threads).
+    The output array is allocated in advance and filled in place, so that the particles keep
+    their order regardless of the number of threads.
+*/
+template<typename VelocitySampler>
+particles::ParticleArrayCar assignVelocityParallel(
+    const particles::ParticleArray<coord::PosCyl>& pointCoords,
+    const VelocitySampler& sampler, const char* funcName)
+{
+    const ptrdiff_t npoints = pointCoords.size();
+    particles::ParticleArrayCar result;
+    result.data.resize(npoints);
+    std::string errorMessage;  // store the error text in case of an exception in the openmp block
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for(ptrdiff_t i=0; i<npoints; i++) {
+        try{
+            result.data[i].first  = sampler(pointCoords.point(i));
+            result.data[i].second = pointCoords.mass(i);
+        }
+        catch(std::exception& ex) {
+            errorMessage = ex.what();
+        }
     }
+    if(!errorMessage.empty())
+        throw std::runtime_error(std::string(funcName) + ": " + errorMessage);
     return result;
 }
 
+}  // internal namespace
+
+particles::ParticleArrayCar assignVelocityEdd(
+    const particles::ParticleArray<coord::PosCyl>& pointCoords,
+    const potential::BasePotential& pot,
+    const SphericalModelLocal& sphModel)
+{
+    return assignVelocityParallel(pointCoords,
+        VelocitySamplerEdd(pot, sphModel), "assignVelocityEdd");
+}
+
+particles::ParticleArrayCar assignVelocityJeansSph(
+    const particles::ParticleArray<coord::PosCyl>& pointCoords,
+    const potential::BasePotential& pot,
+    const math::IFunction& jeansSphModel, const double beta)
+{
+    return assignVelocityParallel(pointCoords,
+        VelocitySamplerJeansSph(pot, jeansSphModel, beta), "assignVelocityJeansSph");
+}
+
+particles::ParticleArrayCar assignVelocityJeansAxi(
+    const particles::ParticleArray<coord::PosCyl>& pointCoords,
+    const potential::BasePotential& pot,
+    const JeansAxi& jeansAxiModel, const double kappa)
+{
+    return assignVelocityParallel(pointCoords,
+        VelocitySamplerJeansAxi(pot, jeansAxiModel, kappa), "assignVelocityJeansAxi");
+}
+
 particles::ParticleArrayCar assignVelocity(
     const particles::ParticleArray<coord::PosCyl>& pointCoords,
     const potential::BaseDensity& dens,
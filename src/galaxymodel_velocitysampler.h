@@ -19,6 +19,9 @@
     Another routine `assignVelocity()` presents a higher-level interface that automatically
     chooses between the three methods based on the provided arguments, and constructs
     the respective velocity generators internally.
+    Velocities are assigned in parallel if OpenMP is available, with each thread using its own
+    stream of random numbers (see `math::random()`); the order of particles is preserved,
+    and the result is deterministic for a fixed number of threads.
 */
 #pragma once
 #include "potential_base.h"
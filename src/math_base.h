@@ -142,6 +142,24 @@ public:
     */
     virtual void eval(const double vars[], double values[]) const = 0;
 
+    /** evaluate the function at several points at once.
+        The default implementation simply calls `eval()` for each point in turn, but derived
+        classes may provide a more efficient implementation (e.g., when the function is computed
+        by an external routine with a large per-call overhead, such as a Python callback).
+        Routines that naturally produce batches of points (e.g., `integrateNdim`) use this method.
+        \param[in]  npoints  is the number of points;
+        \param[in]  vars   is the 2d array of size npoints*N, containing the N-dimensional points
+                    stored consecutively (vars[p*N+n] is the n-th coordinate of p-th point);
+        \param[out] values is the 2d array of size npoints*M that will contain the function values
+                    (values[p*M+m] is the m-th value at the p-th point).
+    */
+    virtual void evalmany(const size_t npoints, const double vars[], double values[]) const
+    {
+        const unsigned int N = numVars(), M = numValues();
+        for(size_t p=0; p<npoints; p++)
+            eval(vars + p*N, values + p*M);
+    }
+
     /// return the dimensionality of the input point (N)
     virtual unsigned int numVars() const = 0;
 
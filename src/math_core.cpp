@@ -354,6 +354,117 @@ double quasiRandomHalton(unsigned int ind, unsigned int base)
     return val;
 }
 
+namespace {
+/// number of binary digits in the Sobol sequence
+static const unsigned int SOBOL_BITS = 32;
+
+/// parameters of primitive polynomials and initial direction numbers for dimensions 1..20
+/// (dimension 0 is the van der Corput sequence in base 2),
+/// taken from Joe & Kuo (2008, SIAM J.Sci.Comput, 30, 2635), file new-joe-kuo-6.21201
+struct SobolInit { unsigned int deg, poly, m[7]; };
+static const SobolInit SOBOL_INIT[MAX_SOBOL_DIM-1] = {
+    {1,  0, {1}},
+    {2,  1, {1, 3}},
+    {3,  1, {1, 3, 1}},
+    {3,  2, {1, 1, 1}},
+    {4,  1, {1, 1, 3, 3}},
+    {4,  4, {1, 3, 5, 13}},
+    {5,  2, {1, 1, 5, 5, 17}},
+    {5,  4, {1, 1, 5, 5, 5}},
+    {5,  7, {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6,  1, {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+    {6, 19, {1, 1, 1, 15, 7, 5}},
+    {6, 22, {1, 3, 1, 15, 13, 25}},
+    {6, 25, {1, 1, 5, 5, 19, 61}},
+    {7,  1, {1, 3, 7, 11, 23, 15, 103}},
+    {7,  4, {1, 3, 7, 13, 13, 15, 69}} };
+
+/// table of direction numbers for all dimensions, computed once at program startup
+class SobolDirections {
+    unsigned int dir[MAX_SOBOL_DIM][SOBOL_BITS];
+public:
+    SobolDirections() {
+        for(unsigned int k=0; k<SOBOL_BITS; k++)
+            dir[0][k] = 1u << (SOBOL_BITS-1-k);
+        for(unsigned int d=1; d<MAX_SOBOL_DIM; d++) {
+            const SobolInit& init = SOBOL_INIT[d-1];
+            const unsigned int s = init.deg;
+            for(unsigned int k=0; k<SOBOL_BITS; k++) {
+                if(k<s) {
+                    dir[d][k] = init.m[k] << (SOBOL_BITS-1-k);
+                } else {
+                    unsigned int v = dir[d][k-s] ^ (dir[d][k-s] >> s);
+                    for(unsigned int j=1; j<s; j++)
+                        if((init.poly >> (s-1-j)) & 1)
+                            v ^= dir[d][k-j];
+                    dir[d][k] = v;
+                }
+            }
+        }
+    }
+    /// compute the integer representation of a Sobol number (without the Gray code ordering)
+    inline unsigned int value(unsigned int index, unsigned int d) const {
+        unsigned int result = 0;
+        for(unsigned int k=0; index>0; k++, index >>= 1)
+            if(index & 1)
+                result ^= dir[d][k];
+        return result;
+    }
+};
+
+static const SobolDirections sobolDirections;
+
+/// reverse the order of bits in a 32-bit integer
+inline unsigned int reverseBits(unsigned int x)
+{
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+    x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+/// integer hash function used to derive independent scrambling seeds for each dimension
+inline unsigned int hashInt(unsigned int x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+/// nested uniform (Owen) scrambling of binary digits, using the hash-based permutation
+/// of Laine & Karras in the version of Burley (2020, J.Comp.Graph.Tech, 9, 10):
+/// each output bit depends only on the same and more significant bits of the input
+inline unsigned int owenScramble(unsigned int x, unsigned int seed)
+{
+    x  = reverseBits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return reverseBits(x);
+}
+}  // internal namespace
+
+double quasiRandomSobol(unsigned int index, unsigned int dim, unsigned int scramble)
+{
+    if(dim >= MAX_SOBOL_DIM)
+        throw std::invalid_argument("quasiRandomSobol: dimension index is too large");
+    unsigned int val = sobolDirections.value(index, dim);
+    if(scramble)
+        val = owenScramble(val, hashInt(scramble + hashInt(dim)));
+    return val * (1. / 4294967296.);   // 2^-32
+}
+
 
 /* ------ algebraic transformations of functions ------- */
 
@@ -1058,32 +1169,35 @@ struct CubatureParams {
         F(_F), numEval(0){};
 };
 
-int integrandNdimWrapperCubature(unsigned int ndim, const double *x, void *v_param,
-    unsigned int fdim, double *fval)
+int integrandNdimWrapperCubature(unsigned int ndim, unsigned int npt, const double *x,
+    void *v_param, unsigned int fdim, double *fval)
 {
     CubatureParams* param = static_cast<CubatureParams*>(v_param);
     assert(ndim == param->F.numVars() && fdim == param->F.numValues());
     try {
-        param->numEval++;
-        param->F.eval(x, fval);
+        param->numEval += npt;
+        // the integration rule provides all points of one or several subregions at once,
+        // which are passed to the function in a single call (possibly more efficient)
+        param->F.evalmany(npt, x, fval);
         // check if the result is not finite (not performed unless in debug mode)
         if(utils::verbosityLevel >= utils::VL_WARNING) {
-            double result=0;
-            for(unsigned int i=0; i<fdim; i++)
-                result+=fval[i];
-            if(!isFinite(result)) {
-                param->error = "integrateNdim: invalid function value encountered at";
-                for(unsigned int n=0; n<ndim; n++)
-                    param->error += ' ' + utils::toString(x[n], 15);
-                param->error += '\n' + utils::stacktrace();
-                return -1;
+            for(unsigned int p=0; p<npt; p++) {
+                double result=0;
+                for(unsigned int i=0; i<fdim; i++)
+                    result+=fval[p*fdim+i];
+                if(!isFinite(result)) {
+                    param->error = "integrateNdim: invalid function value encountered at";
+                    for(unsigned int n=0; n<ndim; n++)
+                        param->error += ' ' + utils::toString(x[p*ndim+n], 15);
+                    param->error += '\n' + utils::stacktrace();
+                    return -1;
+                }
             }
         }
         return 0;   // success
     }
     catch(std::exception& e) {
         param->error = std::string("integrateNdim: ") + e.what() + '\n' + utils::stacktrace();
-;
         return -1;  // signal of error
     }
 }
@@ -1127,7 +1241,7 @@ void integrateNdim(const IFunctionNdim& F, const double xlower[], const double x
         throw std::runtime_error(param.error);
 #else
     CubatureParams param(F);
-    hcubature(numValues, &integrandNdimWrapperCubature, &param,
+    hcubature_v(numValues, &integrandNdimWrapperCubature, &param,
         numVars, xlower, xupper, maxNumEval, absToler, relToler,
         ERROR_INDIVIDUAL, result, error);
     if(numEval!=NULL)
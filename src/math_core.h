@@ -192,6 +192,27 @@ double quasiRandomHalton(unsigned int index, unsigned int base);
 static const unsigned int MAX_PRIMES = 10;  // not that there aren't more!
 static const int PRIMES[MAX_PRIMES] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29 };
 
+/** return a quasirandom number from the Sobol sequence, optionally with Owen-type scrambling.
+    \param[in]  index  is the index of the point in the sequence (starting from 0);
+    \param[in]  dim    is the index of the coordinate (0 <= dim < MAX_SOBOL_DIM);
+    one obtains an N-dimensional point by calling this function N times with the same index
+    and dim=0..N-1; unlike the Halton sequence, the quality of the Sobol sequence does not
+    deteriorate noticeably with the increase of dimension, and any 2^k consecutive points
+    starting from a multiple of 2^k are equally distributed among 2^k equal intervals in each
+    coordinate.
+    \param[in]  scramble  if nonzero, specifies the seed for the nested uniform scrambling of
+    the sequence (a random permutation of binary digits, which preserves the equidistribution
+    property but removes correlations between coordinates and makes the sequence randomized,
+    so that the errors of integral estimates may be computed from several independent seeds);
+    if zero, the original (unscrambled) sequence is returned.
+    \return  a number between 0 and 1 (may be exactly 0, but never 1).
+    \throw   std::invalid_argument if dim is out of range.
+*/
+double quasiRandomSobol(unsigned int index, unsigned int dim, unsigned int scramble=0);
+
+/** maximum number of dimensions supported by `quasiRandomSobol` */
+static const unsigned int MAX_SOBOL_DIM = 21;
+
 ///@}
 /// \name  ----- root-finding and minimization routines -----
 ///@{
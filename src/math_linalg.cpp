@@ -1,5 +1,6 @@
 #include "math_linalg.h"
 #include "math_core.h"  // for binSearch
+#include <algorithm>
 #include <cmath>
 #include <stdexcept>
 
@@ -60,6 +61,21 @@ void eliminateNearZeros(Matrix<double>& mat, double threshold)
                 mat(i,j)=0;
 }
 
+namespace{
+/// check the dimensions of matrices in the product  C = op(A) * op(B)
+template<typename MatrixA, typename MatrixB>
+void checkProductDimensions(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB,
+    const MatrixA& A, const MatrixB& B, const Matrix<double>& C)
+{
+    size_t NR1 = TransA==CblasNoTrans ? A.rows() : A.cols();
+    size_t NC1 = TransA==CblasNoTrans ? A.cols() : A.rows();
+    size_t NR2 = TransB==CblasNoTrans ? B.rows() : B.cols();
+    size_t NC2 = TransB==CblasNoTrans ? B.cols() : B.rows();
+    if(NC1 != NR2 || NR1 != C.rows() || NC2 != C.cols())
+        throw std::length_error("blas_dgemm: incompatible matrix dimensions");
+}
+}  // internal namespace
+
 template<> void blas_daxpy(double alpha, const std::vector<double>& X, std::vector<double>& Y)
 {
     const size_t size = X.size();
@@ -625,6 +641,52 @@ void blas_dgemm(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB,
     assert((size_t)mat(C).rows() == C.rows() && (size_t)mat(C).cols() == C.cols());
 }
 
+void blas_dgemm(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB,
+    double alpha, const SparseMatrix<double>& A, const Matrix<double>& B, double beta, Matrix<double>& C)
+{
+    checkProductDimensions(TransA, TransB, A, B, C);
+    if(beta==0)
+        mat(C).setZero();
+    else if(beta!=1)
+        mat(C) *= beta;
+    if(alpha==0)
+        return;
+    if(TransA == CblasNoTrans) {
+        if(TransB == CblasNoTrans)
+            mat(C).noalias() += alpha * mat(A) * mat(B);
+        else
+            mat(C).noalias() += alpha * mat(A) * mat(B).transpose();
+    } else {
+        if(TransB == CblasNoTrans)
+            mat(C).noalias() += alpha * mat(A).transpose() * mat(B);
+        else
+            mat(C).noalias() += alpha * mat(A).transpose() * mat(B).transpose();
+    }
+}
+
+void blas_dgemm(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB,
+    double alpha, const Matrix<double>& A, const SparseMatrix<double>& B, double beta, Matrix<double>& C)
+{
+    checkProductDimensions(TransA, TransB, A, B, C);
+    if(beta==0)
+        mat(C).setZero();
+    else if(beta!=1)
+        mat(C) *= beta;
+    if(alpha==0)
+        return;
+    if(TransA == CblasNoTrans) {
+        if(TransB == CblasNoTrans)
+            mat(C).noalias() += alpha * mat(A) * mat(B);
+        else
+            mat(C).noalias() += alpha * mat(A) * mat(B).transpose();
+    } else {
+        if(TransB == CblasNoTrans)
+            mat(C).noalias() += alpha * mat(A).transpose() * mat(B);
+        else
+            mat(C).noalias() += alpha * mat(A).transpose() * mat(B).transpose();
+    }
+}
+
 void blas_dtrsm(CBLAS_SIDE Side, CBLAS_UPLO Uplo, CBLAS_TRANSPOSE TransA, CBLAS_DIAG Diag,
     double alpha, const Matrix<double>& A, Matrix<double>& B)
 {
@@ -1300,6 +1362,84 @@ template<> void blas_dgemm(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB,
 #endif
 }
 
+#ifdef HAVE_GSL_SPARSE
+namespace{
+/** Compute the product of a sparse matrix S (in the compressed-column format) and a dense matrix D.
+    If sparseLeft==true, compute  C += alpha * op(S) * op(D),  otherwise  C += alpha * op(D) * op(S).
+    The loop goes over nonzero elements of S, each one contributing to an entire row or column of C.
+*/
+void spblas_dgemm_mixed(bool sparseLeft, CBLAS_TRANSPOSE TransS, CBLAS_TRANSPOSE TransD,
+    double alpha, const gsl_spmatrix* S, const Matrix<double>& D, Matrix<double>& C)
+{
+    const size_t nrowsC = C.rows(), ncolsC = C.cols(), ncolsD = D.cols();
+    const double* dataD = D.data();
+    double* dataC = C.data();
+    for(size_t col=0; col<S->size2; col++) {
+        for(size_t k=S->p[col]; k<(size_t)S->p[col+1]; k++) {
+            // element of op(S) with indices [i,j]
+            const size_t i = TransS==CblasNoTrans ? S->i[k] : col, j = TransS==CblasNoTrans ? col : S->i[k];
+            const double val = alpha * S->data[k];
+            if(sparseLeft) {
+                // C[i, l] += val * op(D)[j, l]  for all l
+                if(TransD==CblasNoTrans)
+                    for(size_t l=0; l<ncolsC; l++)
+                        dataC[i * ncolsC + l] += val * dataD[j * ncolsD + l];
+                else
+                    for(size_t l=0; l<ncolsC; l++)
+                        dataC[i * ncolsC + l] += val * dataD[l * ncolsD + j];
+            } else {
+                // C[l, j] += op(D)[l, i] * val  for all l
+                if(TransD==CblasNoTrans)
+                    for(size_t l=0; l<nrowsC; l++)
+                        dataC[l * ncolsC + j] += val * dataD[l * ncolsD + i];
+                else
+                    for(size_t l=0; l<nrowsC; l++)
+                        dataC[l * ncolsC + j] += val * dataD[i * ncolsD + l];
+            }
+        }
+    }
+}
+}  // internal namespace
+#endif
+
+void blas_dgemm(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB,
+    double alpha, const SparseMatrix<double>& A, const Matrix<double>& B, double beta, Matrix<double>& C)
+{
+    checkProductDimensions(TransA, TransB, A, B, C);
+    if(A.impl == NULL)
+        throw std::length_error("blas_dgemm: empty matrix");
+#ifdef HAVE_GSL_SPARSE
+    if(beta==0)
+        std::fill(C.data(), C.data() + C.size(), 0.);
+    else
+        blas_dmul(beta, C);
+    if(alpha!=0)
+        spblas_dgemm_mixed(true, TransA, TransB, alpha, static_cast<const gsl_spmatrix*>(A.impl), B, C);
+#else
+    gsl_blas_dgemm((CBLAS_TRANSPOSE_t)TransA, (CBLAS_TRANSPOSE_t)TransB, alpha,
+        MatC(static_cast<const double*>(A.impl), A.rows(), A.cols()), MatC(B), beta, Mat(C));
+#endif
+}
+
+void blas_dgemm(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB,
+    double alpha, const Matrix<double>& A, const SparseMatrix<double>& B, double beta, Matrix<double>& C)
+{
+    checkProductDimensions(TransA, TransB, A, B, C);
+    if(B.impl == NULL)
+        throw std::length_error("blas_dgemm: empty matrix");
+#ifdef HAVE_GSL_SPARSE
+    if(beta==0)
+        std::fill(C.data(), C.data() + C.size(), 0.);
+    else
+        blas_dmul(beta, C);
+    if(alpha!=0)
+        spblas_dgemm_mixed(false, TransB, TransA, alpha, static_cast<const gsl_spmatrix*>(B.impl), A, C);
+#else
+    gsl_blas_dgemm((CBLAS_TRANSPOSE_t)TransA, (CBLAS_TRANSPOSE_t)TransB, alpha,
+        MatC(A), MatC(static_cast<const double*>(B.impl), B.rows(), B.cols()), beta, Mat(C));
+#endif
+}
+
 void blas_dtrsm(CBLAS_SIDE Side, CBLAS_UPLO Uplo, CBLAS_TRANSPOSE TransA, CBLAS_DIAG Diag,
     double alpha, const Matrix<double>& A, Matrix<double>& B)
 {
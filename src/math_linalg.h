@@ -452,6 +452,15 @@ template<typename MatrixType>
 void blas_dgemm(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB,
     double alpha, const MatrixType& A, const MatrixType& B, double beta, MatrixType& C);
 
+/// matrix product of a sparse and a dense matrix:  C := alpha * A * B + beta * C,
+/// with the cost proportional to the number of nonzero elements in A times the number of columns in C
+void blas_dgemm(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB,
+    double alpha, const SparseMatrix<double>& A, const Matrix<double>& B, double beta, Matrix<double>& C);
+
+/// matrix product of a dense and a sparse matrix:  C := alpha * A * B + beta * C
+void blas_dgemm(CBLAS_TRANSPOSE TransA, CBLAS_TRANSPOSE TransB,
+    double alpha, const Matrix<double>& A, const SparseMatrix<double>& B, double beta, Matrix<double>& C);
+
 /// matrix product for a triangular matrix A:
 /// B := alpha * A^{-1} * B  (if Side=Left)  or  alpha * B * A^{-1}  (if Side=Right)
 void blas_dtrsm(CBLAS_SIDE Side, CBLAS_UPLO Uplo, CBLAS_TRANSPOSE TransA, CBLAS_DIAG Diag,
@@ -13,8 +13,10 @@
 
 #include "math_optimization.h"
 #include "math_base.h"
+#include "utils.h"
 #include <stdexcept>
 #include <cmath>
+#include <algorithm>
 
 namespace math{
 
@@ -122,7 +124,12 @@ std::vector<double> linearOptimizationSolve(const IMatrix<NumT>& A,
 #ifdef HAVE_CVXOPT
     return quadraticOptimizationSolve(A, rhs, L, BandMatrix<NumT>(std::vector<NumT>()), xmin, xmax);
 #else
-    throw std::runtime_error("linearOptimizationSolve not implemented");
+    IterativeSolverResult result = quadraticOptimizationSolveIterative(A, rhs, L,
+        BandMatrix<NumT>(), std::vector<NumT>(), std::vector<NumT>(), xmin, xmax);
+    if(!result.converged)
+        throw std::runtime_error("linearOptimizationSolve: solver did not converge "
+            "(the problem may be infeasible)");
+    return result.x;
 #endif
 }
 #endif
@@ -301,11 +308,13 @@ std::vector<double> quadraticOptimizationSolve(
 #ifdef HAVE_GLPK
     if(Q.size()==0)  // linear problems will be redirected to the appropriate solver
         return linearOptimizationSolve(A, rhs, L, xmin, xmax);
-    else
-        throw std::runtime_error("quadraticOptimizationSolve not implemented");
-#else
-    throw std::runtime_error("quadraticOptimizationSolve not implemented");
 #endif
+    IterativeSolverResult result = quadraticOptimizationSolveIterative(A, rhs, L, Q,
+        std::vector<NumT>(), std::vector<NumT>(), xmin, xmax);
+    if(!result.converged)
+        throw std::runtime_error("quadraticOptimizationSolve: solver did not converge "
+            "(the problem may be infeasible)");
+    return result.x;
 }
 #endif
 
@@ -479,6 +488,372 @@ std::vector<double> quadraticOptimizationSolveApprox(
     return result;
 }
 
+//------- built-in iterative solver -------//
+namespace{
+
+/// compressed-column representation of the nonzero elements of a matrix
+template<typename NumT>
+struct ColumnMatrix {
+    std::vector<size_t> colStart;        ///< index of the first element of each column (plus one extra)
+    std::vector<unsigned int> rowIndex;  ///< row indices of nonzero elements
+    std::vector<NumT> values;            ///< values of nonzero elements
+
+    /// extract the nonzero elements from a matrix accessed through the generic interface
+    explicit ColumnMatrix(const IMatrix<NumT>& A) : colStart(A.cols()+1, 0)
+    {
+        const size_t numTotal = A.size(), numCols = A.cols();
+        size_t row, col;
+        // 1st pass: count nonzero elements in each column
+        for(size_t k=0; k<numTotal; k++)
+            if(A.elem(k, row, col) != 0)
+                colStart[col+1]++;
+        for(size_t c=0; c<numCols; c++)
+            colStart[c+1] += colStart[c];
+        // 2nd pass: store the elements
+        rowIndex.resize(colStart.back());
+        values.resize(colStart.back());
+        std::vector<size_t> pos(colStart.begin(), colStart.end()-1);
+        for(size_t k=0; k<numTotal; k++) {
+            NumT val = A.elem(k, row, col);
+            if(val != 0) {
+                rowIndex[pos[col]] = row;
+                values  [pos[col]] = val;
+                pos[col]++;
+            }
+        }
+    }
+};
+
+/** The optimization problem in the standard form used by the PDHG solver:
+    minimize  c^T z + (1/2) z^T diag(d) z  subject to  M z = b,  lo <= z <= hi.
+    The vector z consists of N_v original variables x followed by pairs of slack variables
+    for each of N_a constraints that may be violated (with finite penalties),
+    and the matrix M consists of the original matrix A augmented by +1 and -1 elements
+    at the intersection of the row of each such constraint with the columns of its slack variables.
+*/
+template<typename NumT>
+class PDHGProblem {
+public:
+    const size_t numVar, numCons;            ///< N_v, N_c
+    size_t numTotal;                         ///< total number of variables (including slacks)
+    const ColumnMatrix<NumT> A;              ///< nonzero elements of the original matrix
+    std::vector<double> b, c, d, lo, hi;     ///< vectors describing the problem
+    std::vector<size_t> slackRow;            ///< row index of each pair of slack variables
+
+    PDHGProblem(const IMatrix<NumT>& matrix, const std::vector<NumT>& rhs,
+        const std::vector<NumT>& L, const IMatrix<NumT>& Q,
+        const std::vector<NumT>& consPenaltyLin, const std::vector<NumT>& consPenaltyQuad,
+        const std::vector<NumT>& xmin, const std::vector<NumT>& xmax) :
+        numVar(matrix.cols()), numCons(matrix.rows()), numTotal(numVar),
+        A(matrix), b(rhs.begin(), rhs.end()),
+        c(numVar, 0.), d(numVar, 0.), lo(numVar, 0.), hi(numVar, INFINITY)
+    {
+        for(size_t v=0; v<numVar; v++) {
+            if(!L.empty())
+                c[v] = L[v];
+            if(!xmin.empty())
+                lo[v] = xmin[v];
+            if(!xmax.empty())
+                hi[v] = xmax[v];
+        }
+        for(size_t k=0, size=Q.size(); k<size; k++) {
+            size_t row, col;
+            double val = Q.elem(k, row, col);
+            if(val != 0 && row != col)
+                throw std::invalid_argument(
+                    "quadraticOptimizationSolveIterative: matrix Q must be diagonal");
+            d[row] += val;
+        }
+        for(size_t r=0; r<numCons; r++) {
+            double penLin  = consPenaltyLin.empty()  ? INFINITY : consPenaltyLin [r];
+            double penQuad = consPenaltyQuad.empty() ? INFINITY : consPenaltyQuad[r];
+            if(consPenaltyLin.empty() != consPenaltyQuad.empty())  // only one type of penalty given
+                (consPenaltyLin.empty() ? penLin : penQuad) = 0;
+            if(penLin<0 || penQuad<0)
+                throw std::invalid_argument(
+                    "quadraticOptimizationSolveIterative: constraint penalties must be non-negative");
+            if(isFinite(penLin + penQuad)) {
+                slackRow.push_back(r);
+                for(int s=0; s<2; s++) {
+                    c .push_back(penLin);
+                    d .push_back(penQuad);
+                    lo.push_back(0);
+                    hi.push_back(INFINITY);
+                }
+            }
+        }
+        numTotal = c.size();
+    }
+
+    /// compute  out = M z,  skipping the variables that are zero
+    void multiply(const std::vector<double>& z, std::vector<double>& out) const
+    {
+        std::fill(out.begin(), out.end(), 0.);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            std::vector<double> tmp(numCons, 0.);  // thread-local accumulator
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for(ptrdiff_t v=0; v<(ptrdiff_t)numVar; v++) {
+                const double zv = z[v];
+                if(zv == 0) continue;
+                for(size_t k=A.colStart[v], end=A.colStart[v+1]; k<end; k++)
+                    tmp[A.rowIndex[k]] += A.values[k] * zv;
+            }
+#ifdef _OPENMP
+#pragma omp critical(PDHGmultiply)
+#endif
+            for(size_t r=0; r<numCons; r++)
+                out[r] += tmp[r];
+        }
+        for(size_t s=0; s<slackRow.size(); s++)
+            out[slackRow[s]] += z[numVar + 2*s] - z[numVar + 2*s + 1];
+    }
+
+    /// compute  out = M^T y
+    void multiplyTransposed(const std::vector<double>& y, std::vector<double>& out) const
+    {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for(ptrdiff_t v=0; v<(ptrdiff_t)numVar; v++) {
+            double sum = 0;
+            for(size_t k=A.colStart[v], end=A.colStart[v+1]; k<end; k++)
+                sum += A.values[k] * y[A.rowIndex[k]];
+            out[v] = sum;
+        }
+        for(size_t s=0; s<slackRow.size(); s++) {
+            out[numVar + 2*s    ] =  y[slackRow[s]];
+            out[numVar + 2*s + 1] = -y[slackRow[s]];
+        }
+    }
+
+    /// compute the relative residuals of the primal constraints (Mz = b)
+    /// and of the optimality conditions, given the vectors z, y, Mz, M^T y
+    void residuals(const std::vector<double>& z, const std::vector<double>& Mz,
+        const std::vector<double>& MTy, double normb, double normc,
+        /*output*/ double& primal, double& dual) const
+    {
+        primal = 0;
+        for(size_t r=0; r<numCons; r++)
+            primal += pow_2(Mz[r] - b[r]);
+        primal = sqrt(primal) / (1 + normb);
+        // gradient of the Lagrangian w.r.t. each variable should be zero for variables
+        // inside the allowed interval, non-negative at the lower and non-positive at the upper bound
+        dual = 0;
+        for(size_t v=0; v<numTotal; v++) {
+            double grad = c[v] + d[v] * z[v] + MTy[v];
+            if(z[v] <= lo[v])
+                grad = fmin(grad, 0);
+            else if(z[v] >= hi[v])
+                grad = fmax(grad, 0);
+            dual += pow_2(grad);
+        }
+        dual = sqrt(dual) / (1 + normc);
+    }
+};
+
+inline double norm(const std::vector<double>& vec)
+{
+    double sum = 0;
+    for(size_t i=0; i<vec.size(); i++)
+        sum += pow_2(vec[i]);
+    return sqrt(sum);
+}
+
+inline double distance(const std::vector<double>& vec1, const std::vector<double>& vec2)
+{
+    double sum = 0;
+    for(size_t i=0; i<vec1.size(); i++)
+        sum += pow_2(vec1[i] - vec2[i]);
+    return sqrt(sum);
+}
+
+/// how often to evaluate the residuals and check the restart criteria
+static const unsigned int PDHG_EVAL_INTERVAL = 64;
+
+}  // internal namespace
+
+template<typename NumT>
+IterativeSolverResult quadraticOptimizationSolveIterative(
+    const IMatrix<NumT>& A, const std::vector<NumT>& rhs,
+    const std::vector<NumT>& L, const IMatrix<NumT>& Q,
+    const std::vector<NumT>& consPenaltyLin, const std::vector<NumT>& consPenaltyQuad,
+    const std::vector<NumT>& xmin, const std::vector<NumT>& xmax,
+    const IterativeSolverParams& params)
+{
+    const size_t numVariables = A.cols(), numConstraints = A.rows();
+    if( rhs.size()!=numConstraints ||
+        (!L.empty()    && L.size()!=numVariables) ||
+        (!xmin.empty() && xmin.size()!=numVariables) ||
+        (!xmax.empty() && xmax.size()!=numVariables) ||
+        (Q.size()!=0 && (Q.rows()!=numVariables || Q.cols()!=numVariables)) ||
+        (!consPenaltyLin.empty()  && consPenaltyLin. size()!=numConstraints) ||
+        (!consPenaltyQuad.empty() && consPenaltyQuad.size()!=numConstraints) ||
+        (!params.initPrimal.empty() && params.initPrimal.size()!=numVariables) ||
+        (!params.initDual.empty()   && params.initDual.size()!=numConstraints) )
+        throw std::invalid_argument("quadraticOptimizationSolveIterative: invalid size of input arrays");
+
+    const PDHGProblem<NumT> prob(A, rhs, L, Q, consPenaltyLin, consPenaltyQuad, xmin, xmax);
+    const size_t numTotal = prob.numTotal;
+    const double normb = norm(prob.b), normc = norm(prob.c);
+
+    // diagonal preconditioners for the primal and dual step sizes (Pock&Chambolle 2011, alpha=1):
+    // tau_v = 1 / sum_r |M_rv|,  sigma_r = 1 / sum_v |M_rv|
+    std::vector<double> tau0(numTotal, 1.), sigma0(numConstraints, 0.), tau(numTotal), sigma(numConstraints);
+    for(size_t v=0; v<numVariables; v++) {
+        double sum = 0;
+        for(size_t k=prob.A.colStart[v]; k<prob.A.colStart[v+1]; k++) {
+            double val = fabs(prob.A.values[k]);
+            sum += val;
+            sigma0[prob.A.rowIndex[k]] += val;
+        }
+        if(sum > 0)
+            tau0[v] = 1 / sum;
+    }
+    for(size_t s=0; s<prob.slackRow.size(); s++)
+        sigma0[prob.slackRow[s]] += 2;
+    for(size_t r=0; r<numConstraints; r++)
+        sigma0[r] = sigma0[r] > 0 ? 1 / sigma0[r] : 1.;
+    // the relative scaling of primal and dual step sizes ("primal weight"), adjusted at restarts
+    double omega = normb > 0 && normc > 0 ? normc / normb : 1.;
+
+    // initial values of primal and dual variables
+    std::vector<double> z(numTotal, 0.), y(numConstraints, 0.);
+    for(size_t v=0; v<numVariables; v++)
+        z[v] = fmax(prob.lo[v], fmin(prob.hi[v], params.initPrimal.empty() ? 0. : params.initPrimal[v]));
+    if(!params.initDual.empty())
+        y.assign(params.initDual.begin(), params.initDual.end());
+    std::vector<double> Mz(numConstraints), MTy(numTotal), zbar(numTotal), Mzbar(numConstraints);
+    prob.multiply(z, Mz);
+    // initialize the slack variables from the residuals of the constraints for the initial guess
+    for(size_t s=0; s<prob.slackRow.size(); s++) {
+        size_t r = prob.slackRow[s];
+        double delta = Mz[r] - prob.b[r];
+        z[numVariables + 2*s    ] = fmax(-delta, 0);
+        z[numVariables + 2*s + 1] = fmax( delta, 0);
+        Mz[r] = prob.b[r];
+    }
+    prob.multiplyTransposed(y, MTy);
+
+    // running averages of the iterates since the last restart, and the state at the last restart
+    std::vector<double> zsum(numTotal, 0.), ysum(numConstraints, 0.), Mzsum(numConstraints, 0.),
+        MTysum(numTotal, 0.), zavg(numTotal), yavg(numConstraints), Mzavg(numConstraints),
+        MTyavg(numTotal), zlast(z), ylast(y);
+    unsigned int numAvg = 0, iterLastRestart = 0;
+    double errLastRestart = INFINITY, errPrev = INFINITY;
+
+    IterativeSolverResult result;
+    result.converged = false;
+    result.primalResidual = result.dualResidual = INFINITY;
+    unsigned int iter = 0;
+    while(iter < params.maxNumIter) {
+        // step sizes, scaled by the primal weight and a safety factor
+        if(numAvg == 0) {
+            for(size_t v=0; v<numTotal; v++)
+                tau[v] = 0.95 * tau0[v] / omega;
+            for(size_t r=0; r<numConstraints; r++)
+                sigma[r] = 0.95 * sigma0[r] * omega;
+        }
+        // primal step: proximal operator for the objective function and the box constraints,
+        // followed by the extrapolation zbar = 2 z_new - z_old
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for(ptrdiff_t v=0; v<(ptrdiff_t)numTotal; v++) {
+            double znew = (z[v] - tau[v] * (prob.c[v] + MTy[v])) / (1 + tau[v] * prob.d[v]);
+            znew  = fmax(prob.lo[v], fmin(prob.hi[v], znew));
+            zbar[v] = 2 * znew - z[v];
+            z[v] = znew;
+        }
+        // dual step
+        prob.multiply(zbar, Mzbar);
+        for(size_t r=0; r<numConstraints; r++) {
+            y[r] += sigma[r] * (Mzbar[r] - prob.b[r]);
+            Mz[r] = 0.5 * (Mz[r] + Mzbar[r]);  // since M z_new = (M zbar + M z_old) / 2
+        }
+        prob.multiplyTransposed(y, MTy);
+        iter++;
+
+        // accumulate the averages
+        for(size_t v=0; v<numTotal; v++) {
+            zsum[v]   += z[v];
+            MTysum[v] += MTy[v];
+        }
+        for(size_t r=0; r<numConstraints; r++) {
+            ysum[r]  += y[r];
+            Mzsum[r] += Mz[r];
+        }
+        numAvg++;
+        if(iter % PDHG_EVAL_INTERVAL != 0 && iter != params.maxNumIter)
+            continue;
+
+        // evaluate the residuals for the current and the averaged iterates
+        for(size_t v=0; v<numTotal; v++) {
+            zavg[v]   = zsum[v]   / numAvg;
+            MTyavg[v] = MTysum[v] / numAvg;
+        }
+        for(size_t r=0; r<numConstraints; r++) {
+            yavg[r]  = ysum[r]  / numAvg;
+            Mzavg[r] = Mzsum[r] / numAvg;
+        }
+        double primCur, dualCur, primAvg, dualAvg;
+        prob.residuals(z,    Mz,    MTy,    normb, normc, primCur, dualCur);
+        prob.residuals(zavg, Mzavg, MTyavg, normb, normc, primAvg, dualAvg);
+        double errCur = sqrt(pow_2(primCur) + pow_2(dualCur)),
+               errAvg = sqrt(pow_2(primAvg) + pow_2(dualAvg));
+        bool useAvg   = errAvg < errCur;
+        double err    = useAvg ? errAvg : errCur;
+        result.primalResidual = useAvg ? primAvg : primCur;
+        result.dualResidual   = useAvg ? dualAvg : dualCur;
+        result.converged = result.primalResidual <= params.tolerance &&
+            result.dualResidual <= params.tolerance;
+        if(useAvg) {  // the averaged iterate is better
+            z.swap(zavg);  y.swap(yavg);  Mz.swap(Mzavg);  MTy.swap(MTyavg);
+        }
+        if(params.reportInterval > 0 && (iter % params.reportInterval < PDHG_EVAL_INTERVAL))
+            utils::msg(utils::VL_DEBUG, "quadraticOptimizationSolveIterative",
+                "Iteration " + utils::toString(iter) +
+                ": primal residual=" + utils::toString(result.primalResidual) +
+                ", dual residual="   + utils::toString(result.dualResidual));
+        if(result.converged)
+            break;
+
+        // restart criteria: sufficient decrease of the residual since the last restart,
+        // or a moderate decrease and no further progress, or a long time since the last restart
+        if( useAvg || err <= 0.2 * errLastRestart ||
+            (err <= 0.8 * errLastRestart && err > errPrev) ||
+            iter - iterLastRestart >= 0.36 * iter)
+        {
+            // update the primal weight, balancing the changes of primal and dual variables
+            double dz = distance(z, zlast), dy = distance(y, ylast);
+            if(dz > 0 && dy > 0 && isFinite(dz + dy))
+                omega = exp(0.5 * log(dy / dz) + 0.5 * log(omega));
+            zlast = z;
+            ylast = y;
+            errLastRestart = err;
+            iterLastRestart = iter;
+            std::fill(zsum.begin(),   zsum.end(),   0.);
+            std::fill(ysum.begin(),   ysum.end(),   0.);
+            std::fill(Mzsum.begin(),  Mzsum.end(),  0.);
+            std::fill(MTysum.begin(), MTysum.end(), 0.);
+            numAvg = 0;
+        }
+        errPrev = err;
+    }
+    result.numIter = iter;
+    result.x.assign(z.begin(), z.begin() + numVariables);
+    result.dual = y;
+    if(params.reportInterval > 0)
+        utils::msg(utils::VL_DEBUG, "quadraticOptimizationSolveIterative",
+            std::string(result.converged ? "Converged" : "Did not converge") +
+            " after " + utils::toString(iter) + " iterations");
+    return result;
+}
+
 // explicit instantiations for NumT = float and double
 template std::vector<double> linearOptimizationSolve(const IMatrix<float>&,
     const std::vector<float>&, const std::vector<float>&,
@@ -513,4 +888,14 @@ template std::vector<double> quadraticOptimizationSolveApprox(const IMatrix<doub
     const std::vector<double>&, const std::vector<double>&, const IMatrix<double>&,
     const std::vector<double>&, const std::vector<double>&,
     const std::vector<double>&, const std::vector<double>&);
+
+template IterativeSolverResult quadraticOptimizationSolveIterative(const IMatrix<float>&,
+    const std::vector<float>&, const std::vector<float>&, const IMatrix<float>&,
+    const std::vector<float>&, const std::vector<float>&,
+    const std::vector<float>&, const std::vector<float>&, const IterativeSolverParams&);
+
+template IterativeSolverResult quadraticOptimizationSolveIterative(const IMatrix<double>&,
+    const std::vector<double>&, const std::vector<double>&, const IMatrix<double>&,
+    const std::vector<double>&, const std::vector<double>&,
+    const std::vector<double>&, const std::vector<double>&, const IterativeSolverParams&);
 }
@@ -26,7 +26,8 @@ namespace math{
     \throw   std::invalid_argument if the sizes of input vectors/matrices are inconsistent,
     or std::runtime_error if the problem has no solution or the solver reports any other error.
     \tparam  NumT  is the numerical type of the input arrays (float or double).
-    \note    This routine is not thread-safe.
+    \note    This routine is not thread-safe. If neither GLPK nor CVXOPT are available,
+    the built-in iterative solver `quadraticOptimizationSolveIterative()` is used instead.
 */
 template<typename NumT>
 std::vector<double> linearOptimizationSolve(
@@ -60,7 +61,9 @@ std::vector<double> linearOptimizationSolve(
     or std::runtime_error if the problem has no solution, the solver is not available or
     in case of any other error reported by the solver.
     \tparam  NumT  is the numerical type of the input arrays (float or double).
-    \note    This routine is not thread-safe.
+    \note    This routine is not thread-safe. If CVXOPT is not available, linear problems are
+    handled by GLPK, if it is present, and otherwise the built-in iterative solver
+    `quadraticOptimizationSolveIterative()` is used (which requires Q to be diagonal).
 */
 template<typename NumT>
 std::vector<double> quadraticOptimizationSolve(
@@ -142,4 +145,71 @@ std::vector<double> quadraticOptimizationSolveApprox(
     const std::vector<NumT>& xmin = std::vector<NumT>(),
     const std::vector<NumT>& xmax = std::vector<NumT>());
 
+/// parameters of the built-in iterative optimization solver
+struct IterativeSolverParams {
+    /// relative tolerance on the residuals of the constraint equations and of the optimality
+    /// conditions (i.e., the norm of the residual vector divided by 1 + the norm of the RHS vector
+    /// or the vector of linear penalties, correspondingly)
+    double tolerance;
+    /// maximum number of iterations
+    unsigned int maxNumIter;
+    /// interval (number of iterations) between progress reports
+    /// (printed via utils::msg at the debug verbosity level); 0 means no reports
+    unsigned int reportInterval;
+    /// initial guess for the solution vector (N_v elements, or empty)
+    std::vector<double> initPrimal;
+    /// initial guess for the Lagrange multipliers (N_c elements, or empty),
+    /// usually taken from the output of a previous run for a similar problem
+    std::vector<double> initDual;
+    /// assign default values
+    IterativeSolverParams() : tolerance(1e-6), maxNumIter(100000), reportInterval(0) {}
+};
+
+/// output of the built-in iterative optimization solver
+struct IterativeSolverResult {
+    std::vector<double> x;     ///< the solution vector (N_v elements)
+    std::vector<double> dual;  ///< Lagrange multipliers for the constraints (N_c elements)
+    unsigned int numIter;      ///< number of iterations performed
+    double primalResidual;     ///< relative residual of the constraint equations
+    double dualResidual;       ///< relative residual of the optimality conditions
+    bool converged;            ///< whether both residuals are below the required tolerance
+};
+
+/** Solve a linear or quadratic optimization problem with a built-in first-order iterative method,
+    which does not depend on any external library.
+    The problem is the same as in `quadraticOptimizationSolveApprox()` (with exact constraints
+    in the case of empty or infinite constraint penalties), except that the matrix of quadratic
+    penalties Q for the variables must be diagonal.
+    The method is the primal-dual hybrid gradient algorithm (Chambolle&Pock 2011) with
+    diagonal preconditioning, adaptive restarts and primal weight updates (as in the PDLP solver,
+    Applegate+ 2021). Each iteration involves one multiplication of the matrix A and
+    its transpose by a vector, which only loop over nonzero elements of the matrix (extracted once
+    at the beginning), skip the variables that are currently zero, and are OpenMP-parallelized.
+    This method is well suited for large problems (N_v ~ 10^5-10^6) that arise in Schwarzschild
+    modelling, but may need many iterations to reach a high accuracy.
+    The routine is thread-safe, so that many problems may be solved in parallel, and supports
+    warm starts from the solution of a similar problem (e.g., one with different penalties).
+    \param[in]  A, rhs, L, Q, consPenaltyLin, consPenaltyQuad, xmin, xmax  have the same meaning
+    as in `quadraticOptimizationSolveApprox()`, except that Q must be diagonal (or empty), and the
+    constraint penalties may both be empty, meaning that all constraints must be satisfied exactly;
+    \param[in]  params  are the parameters of the solver (tolerance, max number of iterations,
+    progress reporting, and the initial guess for the solution and the Lagrange multipliers);
+    \return  the solution vector, the Lagrange multipliers and the convergence status
+    (no exception is raised if the solver did not converge);
+    \throw   std::invalid_argument if the sizes of input arrays are inconsistent,
+    or the matrix Q is not diagonal.
+    \tparam  NumT  is the numerical type of the input arrays (float or double).
+*/
+template<typename NumT>
+IterativeSolverResult quadraticOptimizationSolveIterative(
+    const     IMatrix<NumT>& A,
+    const std::vector<NumT>& rhs,
+    const std::vector<NumT>& L = std::vector<NumT>(),
+    const     IMatrix<NumT>& Q = BandMatrix<NumT>(),
+    const std::vector<NumT>& consPenaltyLin  = std::vector<NumT>(),
+    const std::vector<NumT>& consPenaltyQuad = std::vector<NumT>(),
+    const std::vector<NumT>& xmin = std::vector<NumT>(),
+    const std::vector<NumT>& xmax = std::vector<NumT>(),
+    const IterativeSolverParams& params = IterativeSolverParams());
+
 }  // namespace
@@ -6,7 +6,6 @@
 #include <cmath>
 #include <map>
 #include <algorithm>
-#include <alloca.h>
 
 //#define USE_NEW_METHOD
 
@@ -14,6 +13,9 @@ namespace math{
 
 namespace {  // internal namespace for Sampler class
 
+/// number of points passed to the function in a single call to `evalmany()`
+static const unsigned int EVAL_BLOCK_SIZE = 256;
+
 #ifndef USE_NEW_METHOD
 
 /**      Definitions:
@@ -92,8 +94,10 @@ namespace {  // internal namespace for Sampler class
 */
 class Sampler{
 public:
-    /** Construct an N-dimensional sampler object */
-    Sampler(const IFunctionNdim& fnc, const double xlower[], const double xupper[]);
+    /** Construct an N-dimensional sampler object;
+        if quasiRandom==true, the points in each pass are taken from a scrambled Sobol sequence
+        instead of pseudo-random numbers */
+    Sampler(const IFunctionNdim& fnc, const double xlower[], const double xupper[], bool quasiRandom);
 
     /** Perform a number of samples from the distribution function with the current binning scheme,
         and computes the estimate of integral EI (stored internally) */
@@ -131,6 +135,12 @@ private:
     /// a shorthand for the number of dimensions
     const unsigned int Ndim;
 
+    /// seed for scrambling the quasi-random sequence, or 0 if pseudo-random numbers are used
+    unsigned int quasiRandomSeed;
+
+    /// index of the next point in the quasi-random sequence (continues across passes)
+    unsigned int quasiRandomIndex;
+
     /// the total N-dimensional volume to be surveyed                    [ V ]
     double volume;
 
@@ -168,11 +178,13 @@ private:
     /** randomly sample an N-dimensional point, such that it has equal probability 
         of falling into each cell, and its location within the given cell
         has uniform probability distribution.
+        In the quasi-random mode, the point is the next one from the scrambled Sobol sequence
+        in the unit hypercube, mapped onto the cells in the same way as a pseudo-random one.
         \param[out] coords - array of point coordinates;                      [ x[d] ]
         \return  the weight of this point w(x), which is proportional to
         the N-dimensional volume Vc(x) of the cell that contains the point.   [ w(x) ]
     */
-    double samplePoint(double coords[]) const;
+    double samplePoint(double coords[]);
 
     /** randomly sample an N-dimensional point inside a given cell;
         \param[in]  cellInd is the index of cell that the point should lie in;
@@ -215,9 +227,19 @@ static const unsigned int MIN_SAMPLES_PER_BIN = MIN_SAMPLES_PER_CELL * 20;
 /// maximum number of bins in each dimension (MUST be a power of two)
 static const unsigned int MAX_BINS_PER_DIM = 16;
 
-Sampler::Sampler(const IFunctionNdim& _fnc, const double xlower[], const double xupper[]) :
-    fnc(_fnc), Ndim(fnc.numVars())
+Sampler::Sampler(const IFunctionNdim& _fnc, const double xlower[], const double xupper[],
+    bool quasiRandom) :
+    fnc(_fnc), Ndim(fnc.numVars()), quasiRandomSeed(0), quasiRandomIndex(0)
 {
+    if(quasiRandom) {
+        if(Ndim > MAX_SOBOL_DIM)
+            throw std::invalid_argument("sampleNdim: quasi-random sampling supports at most " +
+                utils::toString(MAX_SOBOL_DIM) + " dimensions");
+        // the scrambling seed is derived from the pseudo-random number generator,
+        // so that different calls produce statistically independent sequences,
+        // but the result is still reproducible for a fixed state of the generator
+        quasiRandomSeed = std::max(1u, static_cast<unsigned int>(random() * 4294967295.));
+    }
     volume      = 1.0;
     numCells    = 1;
     numCallsFnc = 0;
@@ -233,11 +255,13 @@ Sampler::Sampler(const IFunctionNdim& _fnc, const double xlower[], const double
         throw std::runtime_error("sampleNdim: cannot sample from an infinite region");
 }
 
-double Sampler::samplePoint(double coords[]) const
+double Sampler::samplePoint(double coords[])
 {
     double binVol = 1.0;
     for(unsigned int d=0; d<Ndim; d++) {
-        double rn = random();
+        double rn = quasiRandomSeed ?
+            quasiRandomSobol(quasiRandomIndex, d, quasiRandomSeed) :
+            random();
         if(rn<0 || rn>=1) rn=0;
         rn *= binBoundaries[d].size()-1;
         // the integer part of the random number gives the bin index
@@ -246,6 +270,8 @@ double Sampler::samplePoint(double coords[]) const
         coords[d] = binBoundaries[d][b]*(1-rn) + binBoundaries[d][b+1]*rn;
         binVol   *= (binBoundaries[d][b+1] - binBoundaries[d][b]);
     }
+    if(quasiRandomSeed)
+        quasiRandomIndex++;
     return binVol;
 }
 
@@ -288,34 +314,31 @@ void Sampler::evalFncLoop(unsigned int first, unsigned int count)
     if(count==0) return;
     bool badValueOccured = false;
     std::string errorMsg;
-    // loop over assigned points and compute the values of function (possibly in parallel)
+    // the points are split into blocks, and all points in a block are passed to the function
+    // in a single call (which may be more efficient than calling it separately for each point);
+    // blocks are processed independently (possibly in parallel)
+    const int numBlocks = (count + EVAL_BLOCK_SIZE - 1) / EVAL_BLOCK_SIZE;
 #ifdef _OPENMP
-#pragma omp parallel for schedule(dynamic,256)
-    for(int i=0; i<(int)count; i++) {
-        double val;
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int b=0; b<numBlocks; b++) {
+        const unsigned int start = first + b * EVAL_BLOCK_SIZE,
+        npoints = std::min<unsigned int>(EVAL_BLOCK_SIZE, first + count - start);
+        double values[EVAL_BLOCK_SIZE];
         try{
-            fnc.eval(&(sampleCoords(i+first, 0)), &val);
+            fnc.evalmany(npoints, &(sampleCoords(start, 0)), values);
         }
         // guard against possible exceptions, since they must not leave the OpenMP block
         catch(std::exception& e) {
             errorMsg = e.what();
-            val = NAN;
+            std::fill(values, values+npoints, NAN);
         }
-        if(val<0 || !isFinite(val))
-            badValueOccured = true;
-        weightedFncValues[i+first] *= val;
-    }
-#else
-    for(unsigned int i=0; i<count; i++) {
-        double val;
-        fnc.eval(&(sampleCoords(i+first, 0)), &val);
-        if(val<0 || !isFinite(val)) {
-            badValueOccured = true;
-            i=count;
+        for(unsigned int i=0; i<npoints; i++) {
+            if(values[i]<0 || !isFinite(values[i]))
+                badValueOccured = true;
+            weightedFncValues[start+i] *= values[i];
         }
-        weightedFncValues[i+first] *= val;
     }
-#endif
     numCallsFnc += count;
     if(badValueOccured)
         throw std::runtime_error("Error in sampleNdim: " + 
@@ -876,25 +899,28 @@ double Sampler::computeResult()
 void Sampler::evalFncLoop(PointEnum firstPointIndex, PointEnum lastPointIndex)
 {
     if(firstPointIndex>=lastPointIndex) return;
-    // loop over assigned points and compute the values of function (in parallel)
+    // loop over blocks of points and compute the values of function (in parallel),
+    // passing all points of a block to the function in a single call
     bool badValueOccured = false;
     std::string errorMsg;
+    const PointEnum numBlocks = (lastPointIndex - firstPointIndex + EVAL_BLOCK_SIZE - 1) / EVAL_BLOCK_SIZE;
 #ifdef _OPENMP
-#pragma omp parallel for schedule(dynamic,256)
+#pragma omp parallel for schedule(dynamic)
 #endif
-    for(PointEnum pointIndex = firstPointIndex; pointIndex < lastPointIndex; pointIndex++) {
-        double val;
+    for(PointEnum b = 0; b < numBlocks; b++) {
+        const PointEnum start = firstPointIndex + b * EVAL_BLOCK_SIZE,
+        npoints = std::min<PointEnum>(EVAL_BLOCK_SIZE, lastPointIndex - start);
         try{
-            fnc.eval(&pointCoords[pointIndex * Ndim], &val);
+            fnc.evalmany(npoints, &pointCoords[start * Ndim], &fncValues[start]);
         }
         // guard against possible exceptions, since they must not leave the OpenMP block
         catch(std::exception& e) {
             errorMsg = e.what();
-            val = NAN;
+            std::fill(fncValues.begin() + start, fncValues.begin() + start + npoints, NAN);
         }
-        if(val<0 || !isFinite(val))
-            badValueOccured = true;
-        fncValues[pointIndex] = val;
+        for(PointEnum pointIndex = start; pointIndex < start + npoints; pointIndex++)
+            if(fncValues[pointIndex]<0 || !isFinite(fncValues[pointIndex]))
+                badValueOccured = true;
     }
     if(badValueOccured)
         throw std::runtime_error("Error in sampleNdim: " + 
@@ -1166,12 +1192,13 @@ void Sampler::drawSamples(Matrix<double>& outputSamples) const
 
 void sampleNdim(const IFunctionNdim& fnc, const double xlower[], const double xupper[], 
     const size_t numSamples,
-    Matrix<double>& samples, size_t* numTrialPoints, double* integral, double* interror)
+    Matrix<double>& samples, size_t* numTrialPoints, double* integral, double* interror,
+    bool quasiRandom)
 {
     if(fnc.numValues() != 1)
         throw std::invalid_argument("sampleNdim: function must provide one value");
 #ifndef USE_NEW_METHOD
-    Sampler sampler(fnc, xlower, xupper);
+    Sampler sampler(fnc, xlower, xupper, quasiRandom);
 
     // first warmup run (actually, two) to collect statistics and adjust bins
     const unsigned int numWarmupSamples = std::max<unsigned int>(numSamples*0.2, 10000);
@@ -28,9 +28,16 @@ namespace math{
                 of F over the given region (this could be compared with the exact value, if known,
                 to estimate the bias/error in sampling scheme);
     \param[out] interror (optional) if not NULL, will store the error estimate of the integral;
+    \param[in]  quasiRandom (optional, default false) if true, the internal sampling points
+                are drawn from a scrambled Sobol sequence (see `quasiRandomSobol`) instead of
+                pseudo-random numbers; this typically reduces the error of the integral and
+                the noise in the output samples for the same number of function evaluations,
+                but the returned error estimate (computed as for a purely random sample)
+                is then overly conservative. Supports at most MAX_SOBOL_DIM dimensions.
  */
 void sampleNdim(const IFunctionNdim& F, const double xlower[], const double xupper[],
     const size_t numSamples,
-    Matrix<double>& samples, size_t* numTrialPoints=NULL, double* integral=NULL, double* interror=NULL);
+    Matrix<double>& samples, size_t* numTrialPoints=NULL, double* integral=NULL, double* interror=NULL,
+    bool quasiRandom=false);
 
 }  // namespace
\ No newline at end of file
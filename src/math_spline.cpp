@@ -561,6 +561,30 @@ inline void regularizeSpline(const std::vector<double>& xval,
 }  // internal namespace
 
 
+GridIndexer::GridIndexer(const std::vector<double>& grid) :
+    x0(0), invStep(0), size(grid.size())
+{
+    if(size < 2)
+        return;
+    const double step = (grid[size-1] - grid[0]) / (size-1);
+    if(!(step > 0) || !isFinite(step))
+        return;
+    // the grid is considered uniform if every node deviates from its nominal location by less
+    // than a quarter of the step: then the index computed from the coordinate is off by at most
+    // one segment, which is corrected by a single comparison
+    for(ptrdiff_t i=1; i<size-1; i++)
+        if(!(fabs(grid[i] - grid[0] - i * step) < 0.25 * step))
+            return;
+    x0 = grid[0];
+    invStep = 1 / step;
+}
+
+ptrdiff_t GridIndexer::binarySearch(const double x, const double grid[]) const
+{
+    return binSearch(x, grid, size);
+}
+
+
 BaseInterpolator1d::BaseInterpolator1d(const std::vector<double>& xv, const std::vector<double>& fv) :
     xval(xv), fval(fv)
 {
@@ -580,6 +604,7 @@ BaseInterpolator1d::BaseInterpolator1d(const std::vector<double>& xv, const std:
         if(!isFinite(fv[i]))
             throw std::invalid_argument("Error in 1d interpolator: function values must be finite "
                 "(f["+utils::toString(i)+"]="+utils::toString(fv[i])+")\n" + utils::stacktrace());
+    xind = GridIndexer(xval);
 }
 
 LinearInterpolator::LinearInterpolator(const std::vector<double>& xv, const std::vector<double>& yv) :
@@ -591,7 +616,7 @@ LinearInterpolator::LinearInterpolator(const std::vector<double>& xv, const std:
 
 void LinearInterpolator::evalDeriv(const double x, double* value, double* deriv, double* deriv2) const
 {
-    int i = std::max<int>(0, std::min<int>(xval.size()-2, binSearch(x, &xval[0], xval.size())));
+    int i = std::max<int>(0, std::min<int>(xval.size()-2, xind(x, &xval[0])));
     if(value)
         *value = linearInterp(x, xval[i], xval[i+1], fval[i], fval[i+1]);
     if(deriv)
@@ -659,7 +684,7 @@ void CubicSpline::evalDeriv(const double x, double* val, double* deriv, double*
     int size = xval.size();
     if(size == 0)
         throw std::length_error("Empty spline");
-    int index = binSearch(x, &xval[0], size);
+    int index = xind(x, &xval[0]);
     if(index < 0) {
         if(val)
             *val   = fval[0] + (fder[0]==0 ? 0 : fder[0] * (x-xval[0]));
@@ -747,8 +772,8 @@ double CubicSpline::integrate(double x1, double x2, const IFunctionIntegral& f)
             return result;
         x2 = xval[size-1];
     }
-    unsigned int i1 = binSearch(x1, &xval.front(), size);
-    unsigned int i2 = binSearch(x2, &xval.front(), size);
+    unsigned int i1 = xind(x1, &xval.front());
+    unsigned int i2 = xind(x2, &xval.front());
     for(unsigned int i=i1; i<=i2; i++) {
         double x  = xval[i];
         double h  = xval[i+1] - x;
@@ -789,7 +814,7 @@ void QuinticSpline::evalDeriv(const double x, double* val, double* deriv, double
     int size = xval.size();
     if(size == 0)
         throw std::length_error("Empty spline");
-    int index = binSearch(x, &xval[0], size);
+    int index = xind(x, &xval[0]);
     if(index < 0) {
         if(val)
             *val   = fval[0] + (fder[0]==0 ? 0 : fder[0] * (x-xval[0]));
@@ -832,6 +857,7 @@ LogLogSpline::LogLogSpline(const std::vector<double>& xvalues, const std::vector
     logfval.resize(numPoints);
     logfder.resize(numPoints, NAN);  // by default points are marked as 'bad'
     std::transform(xvalues.begin(), xvalues.end(), logxval.begin(), log);
+    logxind = GridIndexer(logxval);
     std::transform(fvalues.begin(), fvalues.end(), logfval.begin(), log);
 
     // construct spline(s) for the sections of x grid where the function values are strictly positive
@@ -889,6 +915,7 @@ LogLogSpline::LogLogSpline(const std::vector<double>& xvalues, const std::vector
     logfder. resize(numPoints, NAN);
     logfder2.resize(numPoints);
     std::transform(xvalues.begin(), xvalues.end(), logxval.begin(), log);
+    logxind = GridIndexer(logxval);
     std::transform(fvalues.begin(), fvalues.end(), logfval.begin(), log);
     
     // construct spline(s) for the sections of x grid where the function values are strictly positive
@@ -953,8 +980,8 @@ void LogLogSpline::evalDeriv(const double x, double* value, double* deriv, doubl
     int size = xval.size();
     if(size == 0)
         throw std::length_error("Empty spline");
-    int index = binSearch(x, &xval[0], size);
     double logx = log(x);
+    int index = logxind(logx, &logxval[0]);
 
     if(index < 0 || index >= size-1) {
         index = (index<0 ? 0 : size-1);
@@ -1319,6 +1346,8 @@ BaseInterpolator2d::BaseInterpolator2d(
     if(fvalues.cols() != ysize)
         throw std::length_error(
             "Error in 2d interpolator initialization: y and f array lengths differ");
+    xind = GridIndexer(xval);
+    yind = GridIndexer(yval);
 }
 
 // ------- Bilinear interpolation in 2d ------- //
@@ -1338,8 +1367,8 @@ void LinearInterpolator2d::evalDeriv(const double x, const double y,
     const int
         nx  = xval.size(),
         ny  = yval.size(),
-        xi  = binSearch(x, &xval.front(), nx),
-        yi  = binSearch(y, &yval.front(), ny),
+        xi  = xind(x, &xval.front()),
+        yi  = yind(y, &yval.front()),
         // indices of corner nodes in the flattened 2d array
         ill = xi * ny + yi, // xlow,ylow
         ilu = ill + 1,      // xlow,yupp
@@ -1377,9 +1406,36 @@ void LinearInterpolator2d::evalDeriv(const double x, const double y,
 
 //------------ 2D CUBIC SPLINE -------------//
 
+namespace{
+/// convert a set of K arrays of spline derivatives into a single interleaved array of floats
+/// (the compact storage mode of 2d splines), and release the memory of original arrays
+template<int K>
+void packCoefs(std::vector<double>* arrays[K], std::vector<float>& packed)
+{
+    const size_t size = arrays[0]->size();
+    packed.resize(size * K);
+    for(size_t i=0; i<size; i++)
+        for(int k=0; k<K; k++)
+            packed[i * K + k] = static_cast<float>((*arrays[k])[i]);
+    for(int k=0; k<K; k++)
+        std::vector<double>().swap(*arrays[k]);
+}
+
+/// collect Q consecutive coefficients of two nodes from the interleaved array into the array
+/// used for constructing the intermediate splines: out = { c1[0], c2[0], c1[1], c2[1], ... }
+template<int Q>
+inline void gatherCoefs(const float c1[], const float c2[], double out[])
+{
+    for(int q=0; q<Q; q++) {
+        out[2*q  ] = c1[q];
+        out[2*q+1] = c2[q];
+    }
+}
+}  // internal namespace
+
 CubicSpline2d::CubicSpline2d(const std::vector<double>& xgrid, const std::vector<double>& ygrid,
     const Matrix<double>& fvalues,
-    double deriv_xmin, double deriv_xmax, double deriv_ymin, double deriv_ymax) :
+    double deriv_xmin, double deriv_xmax, double deriv_ymin, double deriv_ymax, bool compact) :
     BaseInterpolator2d(xgrid, ygrid, fvalues),
     fx (fvalues.size()),
     fy (fvalues.size()),
@@ -1419,6 +1475,10 @@ CubicSpline2d::CubicSpline2d(const std::vector<double>& xgrid, const std::vector
                 fxy[i * ysize + j] = tmpvalues[i];
         }
     }
+    if(compact) {
+        std::vector<double>* arrays[3] = { &fx, &fy, &fxy };
+        packCoefs<3>(arrays, packed);
+    }
 }
 
 void CubicSpline2d::evalDeriv(const double x, const double y,
@@ -1430,8 +1490,8 @@ void CubicSpline2d::evalDeriv(const double x, const double y,
         nx = xval.size(),
         ny = yval.size(),
         // indices of grid cell in x and y
-        xi = binSearch(x, &xval.front(), nx),
-        yi = binSearch(y, &yval.front(), ny),
+        xi = xind(x, &xval.front()),
+        yi = yind(y, &yval.front()),
         // indices in flattened 2d arrays:
         ill = xi * ny + yi, // xlow,ylow
         ilu = ill + 1,      // xlow,yupp
@@ -1457,12 +1517,22 @@ void CubicSpline2d::evalDeriv(const double x, const double y,
         xlow = xval[xi],
         xupp = xval[xi+1],
         ylow = yval[yi],
-        yupp = yval[yi+1],
-        // values and derivatives for the intermediate Hermite splines
-        flow  [4] = { fval[ill], fval[iul], fx [ill], fx [iul] },
-        fupp  [4] = { fval[ilu], fval[iuu], fx [ilu], fx [iuu] },
-        dflow [4] = { fy  [ill], fy  [iul], fxy[ill], fxy[iul] },
-        dfupp [4] = { fy  [ilu], fy  [iuu], fxy[ilu], fxy[iuu] };
+        yupp = yval[yi+1];
+    // values and derivatives for the intermediate Hermite splines
+    double flow[4], fupp[4], dflow[4], dfupp[4];
+    if(packed.empty()) {
+        flow [0] = fval[ill];  flow [1] = fval[iul];  flow [2] = fx [ill];  flow [3] = fx [iul];
+        fupp [0] = fval[ilu];  fupp [1] = fval[iuu];  fupp [2] = fx [ilu];  fupp [3] = fx [iuu];
+        dflow[0] = fy  [ill];  dflow[1] = fy  [iul];  dflow[2] = fxy[ill];  dflow[3] = fxy[iul];
+        dfupp[0] = fy  [ilu];  dfupp[1] = fy  [iuu];  dfupp[2] = fxy[ilu];  dfupp[3] = fxy[iuu];
+    } else {
+        const float *cll = &packed[ill*3], *clu = &packed[ilu*3],
+            *cul = &packed[iul*3], *cuu = &packed[iuu*3];
+        flow[0] = fval[ill];  flow[1] = fval[iul];  flow[2] = cll[0];  flow[3] = cul[0];
+        fupp[0] = fval[ilu];  fupp[1] = fval[iuu];  fupp[2] = clu[0];  fupp[3] = cuu[0];
+        gatherCoefs<2>(cll+1, cul+1, dflow);
+        gatherCoefs<2>(clu+1, cuu+1, dfupp);
+    }
     double F  [4];  // {   f    (xlow, y),   f    (xupp, y),  df/dx   (xlow, y),  df/dx   (xupp, y) }
     double dF [4];  // {  df/dy (xlow, y),  df/dy (xupp, y), d2f/dxdy (xlow, y), d2f/dxdy (xupp, y) }
     double d2F[4];  // { d2f/dy2(xlow, y), d2f/dy2(xupp, y), d3f/dxdy2(xlow, y), d3f/dxdy2(xupp, y) }
@@ -1486,7 +1556,8 @@ void CubicSpline2d::evalDeriv(const double x, const double y,
 //------------ 2D QUINTIC SPLINE -------------//
 
 QuinticSpline2d::QuinticSpline2d(const std::vector<double>& xgrid, const std::vector<double>& ygrid,
-    const Matrix<double>& fvalues, const Matrix<double>& dfdx, const Matrix<double>& dfdy) :
+    const Matrix<double>& fvalues, const Matrix<double>& dfdx, const Matrix<double>& dfdy,
+    bool compact) :
     BaseInterpolator2d(xgrid, ygrid, fvalues),
     fx   (dfdx.data(), dfdx.data() + dfdx.size()),
     fy   (dfdy.data(), dfdy.data() + dfdy.size()),
@@ -1613,6 +1684,10 @@ QuinticSpline2d::QuinticSpline2d(const std::vector<double>& xgrid, const std::ve
                 fxyy[i * ysize + j] = 0.;
         }
     }
+    if(compact) {
+        std::vector<double>* arrays[8] = { &fx, &fxx, &fy, &fxy, &fxxy, &fyy, &fxyy, &fxxyy };
+        packCoefs<8>(arrays, packed);
+    }
 }
 
 void QuinticSpline2d::evalDeriv(const double x, const double y,
@@ -1625,8 +1700,8 @@ void QuinticSpline2d::evalDeriv(const double x, const double y,
         nx = xval.size(),
         ny = yval.size(),
         // indices of grid cell in x and y
-        xi = binSearch(x, &xval.front(), nx),
-        yi = binSearch(y, &yval.front(), ny),
+        xi = xind(x, &xval.front()),
+        yi = yind(y, &yval.front()),
         // indices in flattened 2d arrays:
         ill = xi * ny + yi, // xlow,ylow
         ilu = ill + 1,      // xlow,yupp
@@ -1654,14 +1729,35 @@ void QuinticSpline2d::evalDeriv(const double x, const double y,
         xlow = xval[xi],
         xupp = xval[xi+1],
         ylow = yval[yi],
-        yupp = yval[yi+1],
-        // values and derivatives for the intermediate splines
-        fl [6] = { fval[ill], fval[iul], fx  [ill], fx  [iul], fxx  [ill], fxx  [iul] },
-        fu [6] = { fval[ilu], fval[iuu], fx  [ilu], fx  [iuu], fxx  [ilu], fxx  [iuu] },
-        f1l[6] = { fy  [ill], fy  [iul], fxy [ill], fxy [iul], fxxy [ill], fxxy [iul] },
-        f1u[6] = { fy  [ilu], fy  [iuu], fxy [ilu], fxy [iuu], fxxy [ilu], fxxy [iuu] },
-        f2l[6] = { fyy [ill], fyy [iul], fxyy[ill], fxyy[iul], fxxyy[ill], fxxyy[iul] },
-        f2u[6] = { fyy [ilu], fyy [iuu], fxyy[ilu], fxyy[iuu], fxxyy[ilu], fxxyy[iuu] };
+        yupp = yval[yi+1];
+    // values and derivatives for the intermediate splines
+    double fl[6], fu[6], f1l[6], f1u[6], f2l[6], f2u[6];
+    if(packed.empty()) {
+        const double
+        tl [6] = { fval[ill], fval[iul], fx  [ill], fx  [iul], fxx  [ill], fxx  [iul] },
+        tu [6] = { fval[ilu], fval[iuu], fx  [ilu], fx  [iuu], fxx  [ilu], fxx  [iuu] },
+        t1l[6] = { fy  [ill], fy  [iul], fxy [ill], fxy [iul], fxxy [ill], fxxy [iul] },
+        t1u[6] = { fy  [ilu], fy  [iuu], fxy [ilu], fxy [iuu], fxxy [ilu], fxxy [iuu] },
+        t2l[6] = { fyy [ill], fyy [iul], fxyy[ill], fxyy[iul], fxxyy[ill], fxxyy[iul] },
+        t2u[6] = { fyy [ilu], fyy [iuu], fxyy[ilu], fxyy[iuu], fxxyy[ilu], fxxyy[iuu] };
+        std::copy(tl,  tl +6, fl );
+        std::copy(tu,  tu +6, fu );
+        std::copy(t1l, t1l+6, f1l);
+        std::copy(t1u, t1u+6, f1u);
+        std::copy(t2l, t2l+6, f2l);
+        std::copy(t2u, t2u+6, f2u);
+    } else {
+        const float *cll = &packed[ill*8], *clu = &packed[ilu*8],
+            *cul = &packed[iul*8], *cuu = &packed[iuu*8];
+        fl[0] = fval[ill];  fl[1] = fval[iul];
+        fu[0] = fval[ilu];  fu[1] = fval[iuu];
+        gatherCoefs<2>(cll,   cul,   fl+2);
+        gatherCoefs<2>(clu,   cuu,   fu+2);
+        gatherCoefs<3>(cll+2, cul+2, f1l);
+        gatherCoefs<3>(clu+2, cuu+2, f1u);
+        gatherCoefs<3>(cll+5, cul+5, f2l);
+        gatherCoefs<3>(clu+5, cuu+5, f2u);
+    }
     // compute intermediate splines
     double
         F  [6],  // {   f    (xlow/upp, y),  df/dx   (xl/u, y), d2f/dx2   (xl/u, y) }
@@ -1686,7 +1782,7 @@ void QuinticSpline2d::evalDeriv(const double x, const double y,
 LinearInterpolator3d::LinearInterpolator3d(const std::vector<double>& xnodes,
     const std::vector<double>& ynodes, const std::vector<double>& znodes,
     const std::vector<double>& fvalues) :
-    xval(xnodes), yval(ynodes), zval(znodes), fval(fvalues)
+    xval(xnodes), yval(ynodes), zval(znodes), xind(xval), yind(yval), zind(zval), fval(fvalues)
 {
     const int nx = xval.size(), ny = yval.size(), nz = zval.size();
     const unsigned int nval = nx*ny*nz;   // total number of nodes in the 3d grid
@@ -1701,9 +1797,9 @@ double LinearInterpolator3d::value(double x, double y, double z) const
     ny = yval.size(),
     nz = zval.size(),
     // indices of grid cell in x, y and z
-    xi = binSearch(x, &xval.front(), nx),
-    yi = binSearch(y, &yval.front(), ny),
-    zi = binSearch(z, &zval.front(), nz),
+    xi = xind(x, &xval.front()),
+    yi = yind(y, &yval.front()),
+    zi = zind(z, &zval.front()),
     il = (xi * ny + yi) * nz + zi,
     iu = il + ny * nz;
     if(xi<0 || xi>=nx-1 || yi<0 || yi>=ny-1 || zi<0 || zi>=nz-1)
@@ -1732,7 +1828,7 @@ double LinearInterpolator3d::value(double x, double y, double z) const
 
 CubicSpline3d::CubicSpline3d(const std::vector<double>& xnodes, const std::vector<double>& ynodes,
     const std::vector<double>& znodes, const std::vector<double>& fvalues) :
-    xval(xnodes), yval(ynodes), zval(znodes)
+    xval(xnodes), yval(ynodes), zval(znodes), xind(xval), yind(yval), zind(zval)
 {
     const int nx = xval.size(), ny = yval.size(), nz = zval.size();
     const unsigned int nval = nx*ny*nz,   // total number of nodes in the 3d grid
@@ -1856,9 +1952,9 @@ double CubicSpline3d::value(double x, double y, double z) const
     ny = yval.size(),
     nz = zval.size(),
     // indices of grid cell in x, y and z
-    xi = binSearch(x, &xval.front(), nx),
-    yi = binSearch(y, &yval.front(), ny),
-    zi = binSearch(z, &zval.front(), nz);
+    xi = xind(x, &xval.front()),
+    yi = yind(y, &yval.front()),
+    zi = zind(z, &zval.front());
     if(xi<0 || xi>=nx-1 || yi<0 || yi>=ny-1 || zi<0 || zi>=nz-1)
         return NAN;
     const int
@@ -2623,8 +2719,9 @@ template<int N>
 class SplineLogDensityFitter: public IFunctionNdimDeriv {
 public:
     SplineLogDensityFitter(
+        const std::vector<double>& grid,
         const std::vector<double>& xvalues, const std::vector<double>& weights,
-        const std::vector<double>& grid, FitOptions options,
+        const std::vector<double>& sqweights, FitOptions options,
         SplineLogFitParams& params);
 
     /** Return the array of interpolated function values, properly normalized,
@@ -2687,6 +2784,7 @@ private:
     const unsigned int numBasisFnc;   ///< shortcut for the number of B-splines (numNodes+N-1)
     const unsigned int numAmpl;       ///< the number of amplitudes that may be varied (numBasisFnc-1)
     const unsigned int numData;       ///< number of sample points
+    double numEffective;              ///< effective number of samples, (sum w_i)^2 / sum w_i^2
     const FitOptions options;         ///< whether the definition interval extends to +-inf
     static const int GLORDER = 8;     ///< order of GL quadrature for computing the normalization
     double GLnodes[GLORDER], GLweights[GLORDER];  ///< nodes and weights of GL quadrature
@@ -2704,6 +2802,7 @@ SplineLogDensityFitter<N>::SplineLogDensityFitter(
     const std::vector<double>& _grid,
     const std::vector<double>& xvalues,
     const std::vector<double>& weights,
+    const std::vector<double>& sqweights,
     FitOptions _options,
     SplineLogFitParams& _params) :
     grid(_grid),
@@ -2711,6 +2810,7 @@ SplineLogDensityFitter<N>::SplineLogDensityFitter(
     numBasisFnc(numNodes),
     numAmpl(numBasisFnc - 1),
     numData(xvalues.size()),
+    numEffective(numData),
     options(_options),
     params(_params),
     sumWeights(0),
@@ -2718,7 +2818,7 @@ SplineLogDensityFitter<N>::SplineLogDensityFitter(
 {
     if(numData <= 0)
         throw std::length_error("splineLogDensity: no data");
-    if(numData != weights.size())
+    if(numData != weights.size() || (!sqweights.empty() && numData != sqweights.size()))
         throw std::length_error("splineLogDensity: sizes of input arrays are not equal");
     if(numNodes<2)
         throw std::invalid_argument("splineLogDensity: grid size should be at least 2");
@@ -2745,7 +2845,7 @@ SplineLogDensityFitter<N>::SplineLogDensityFitter(
     // quick scan to analyze the weights
     double minWeight = INFINITY;
     double xmin = grid[0], xmax = grid[numNodes-1];
-    double avgx = 0, avgx2 = 0;
+    double avgx = 0, avgx2 = 0, sumSqWeights = 0;
     for(unsigned int p=0; p<numData; p++) {
         double xval = xvalues[p], weight = weights[p];
         if(weight < 0)
@@ -2756,6 +2856,8 @@ SplineLogDensityFitter<N>::SplineLogDensityFitter(
             weight == 0)
             continue;
         sumWeights += weight;
+        if(!sqweights.empty())
+            sumSqWeights += sqweights[p];
         avgx       += weight * xval;
         avgx2      += weight * pow_2(xval);
         minWeight   = std::min(minWeight, weight);
@@ -2765,6 +2867,10 @@ SplineLogDensityFitter<N>::SplineLogDensityFitter(
     if(sumWeights==0)
         throw std::invalid_argument("splineLogDensity: sum of sample weights should be positive");
 
+    // for binned data, the number of input points is not the number of original samples
+    if(!sqweights.empty() && sumSqWeights > 0)
+        numEffective = pow_2(sumWeights) / sumSqWeights;
+
     // compute the mean and dispersion of input samples
     avgx /= sumWeights;
     avgx2/= sumWeights;
@@ -2773,6 +2879,9 @@ SplineLogDensityFitter<N>::SplineLogDensityFitter(
 
     // compute the values of all nontrivial basis functions for each point,
     // multiplied by the point weight, and store them in this matrix
+    // (for binned data, the multiplication factor is the square root of the sum of squared
+    // weights of samples in the bin, so that the matrix B^T B has the same meaning as for
+    // the original unbinned samples)
     SparseMatrixSpecial<N+1> Bmatrix(numData, numAmpl);
 #ifdef _OPENMP
 #pragma omp parallel for schedule(static)
@@ -2788,8 +2897,9 @@ SplineLogDensityFitter<N>::SplineLogDensityFitter(
         int ind = N==1 ?
             bsplineValuesExtrapolated<1>(xval, &grid[0], numNodes, Bspl) :
             bsplineNaturalCubicValues   (xval, &grid[0], numNodes, Bspl);
+        double mult = sqweights.empty() ? weight : sqrt(sqweights[p]) / sumWeights;
         for(int b=0; b<=N; b++)
-            Bspl[b] *= weight;
+            Bspl[b] *= mult;
         Bmatrix.assignRow(p, ind, Bspl);
     }
 
@@ -2798,10 +2908,13 @@ SplineLogDensityFitter<N>::SplineLogDensityFitter(
     Wbasis.assign(numBasisFnc, 0.);
     for(unsigned int p=0; p<numData; p++) {
         unsigned int ind = Bmatrix.indcol[p];
+        double weight = weights[p] / sumWeights,
+        mult = sqweights.empty() ? weight : sqrt(sqweights[p]) / sumWeights;
+        if(mult == 0)
+            continue;
         for(int b=0; b <= std::min<int>(N, numBasisFnc-ind-1); b++) {
-            double weight = weights[p] / sumWeights;
-            Vbasis.at(ind+b) += Bmatrix.values.at(p*(N+1)+b);
-            Wbasis.at(ind+b) += Bmatrix.values.at(p*(N+1)+b) * weight;
+            Vbasis.at(ind+b) += Bmatrix.values.at(p*(N+1)+b) * (weight / mult);
+            Wbasis.at(ind+b) += Bmatrix.values.at(p*(N+1)+b) * mult;
         }
     }
 
@@ -2893,7 +3006,7 @@ double SplineLogDensityFitter<N>::logLrms(const std::vector<double>& ampl) const
     assert(ampl.size() == numAmpl);
     double GdG0[2];
     logG(&ampl[0], NULL, NULL, GdG0);
-    double rms = sumWeights * sqrt((GdG0[1] - pow_2(GdG0[0])) / numData);
+    double rms = sumWeights * sqrt((GdG0[1] - pow_2(GdG0[0])) / numEffective);
     if(utils::verbosityLevel >= utils::VL_VERBOSE) {
         double avg = sumWeights * (GdG0[0] + log(sumWeights) - logG(&ampl[0]));
         utils::msg(utils::VL_VERBOSE, "splineLogDensity",
@@ -3167,12 +3280,12 @@ private:
 template<int N>
 std::vector<double> splineLogDensity(const std::vector<double> &grid,
     const std::vector<double> &xvalues, const std::vector<double> &weights,
-    FitOptions options, double smoothing)
+    FitOptions options, double smoothing, const std::vector<double> &sqweights)
 {
     SplineLogFitParams params;
     const SplineLogDensityFitter<N> fitter(grid, xvalues,
         weights.empty()? std::vector<double>(xvalues.size(), 1./xvalues.size()) : weights,
-        options, params);
+        sqweights, options, params);
     if(N==1) { // find the best-fit amplitudes without any smoothing
         std::vector<double> result(params.ampl);
         int numIter = findRootNdimDeriv(fitter, &params.ampl[0], 1e-8*params.gradNorm, 100, &result[0]);
@@ -3210,9 +3323,11 @@ std::vector<double> splineLogDensity(const std::vector<double> &grid,
 
 // force the template instantiations to compile
 template std::vector<double> splineLogDensity<1>(
-    const std::vector<double>&, const std::vector<double>&, const std::vector<double>&, FitOptions, double);
+    const std::vector<double>&, const std::vector<double>&, const std::vector<double>&,
+    FitOptions, double, const std::vector<double>&);
 template std::vector<double> splineLogDensity<3>(
-    const std::vector<double>&, const std::vector<double>&, const std::vector<double>&, FitOptions, double);
+    const std::vector<double>&, const std::vector<double>&, const std::vector<double>&,
+    FitOptions, double, const std::vector<double>&);
 
 //------------ GENERATION OF UNEQUALLY SPACED GRIDS ------------//
 
@@ -4,37 +4,92 @@
 #define POT_DEF
 #include <defacc.h> // from NEMOINC
 #include <cmath>
+#include <vector>
 #include "potential_factory.h"
+#include "potential_cylspline.h"
 
 /** defines a wrapper class that is used in constructing NEMO potential
     and acceleration objects from an AGAMA potential that is specified
     by parameters in an ini file, or by a potential coefficients file.
     The usage is as follows: in gyrfalcON, for instance, one adds
     `accname=agama accfile=params.ini`
-    to the command line arguments, and provides all necessary parameters 
+    to the command line arguments, and provides all necessary parameters
     in the params.ini text file (see readme.pdf for explanation of the options).
-    Alternatively, a previously created file with coefficients of a potential 
+    Alternatively, a previously created file with coefficients of a potential
     expansion can be given as `accfile=mypotential`.
     The choice is determined by the file extesion (.ini vs any other).
+    Optional parameters `accpars=Omega[,mmax]` specify the pattern speed and, if the second
+    parameter is given, request the potential to be replaced by its CylSpline approximation
+    with the given order of azimuthal expansion, which is typically much cheaper to evaluate
+    than the original potential (e.g., a composite model of a rotating bar).
+
+    The NEMO interface passes the entire array of bodies to `set_time()` before computing
+    the accelerations for each active body in turn via `acc()`. When all bodies are active
+    at each step, the potential and accelerations for all of them are computed at once in
+    `set_time()` (in parallel, if OpenMP is available) and stored in a cache, from which `acc()`
+    retrieves them. However, with block time-stepping only a small fraction of bodies may be
+    active, and `set_time()` does not receive the activity flags, so this precomputation is
+    enabled only after two consecutive steps in which (nearly) all bodies were requested;
+    otherwise each body is computed directly in `acc()`, as it is when its position does not
+    match the cached one (or the body is not in the array).
 **/
 struct agama {
     potential::PtrPotential pot;  ///< pointer to the actual instance of potential
     double Omega;                 ///< rotation pattern speed
     mutable double cost, sint;    ///< cos/sin of time-dependent rotation angle
     ///< ("mutable" qualifier is a hack to circumvent the API restriction)
+    mutable const void* cacheBodies;       ///< pointer to the array of positions of cached bodies
+    mutable std::vector<double> cacheData; ///< for each body, position, potential and acceleration
+    mutable int numBodies;        ///< number of bodies passed to the last call of set_time()
+    mutable int numCalls;         ///< number of calls to acc() since the last call of set_time()
+    mutable int numFullSteps;     ///< number of consecutive steps with (nearly) all bodies active
+    static const int CACHE_STRIDE = 7;     ///< number of elements in cacheData per body
     static const char* name() { return "agama"; }
     bool NeedMass() const { return false; }
     bool NeedVels() const { return false; }
 
     template<int NDIM, typename scalar>
-    void set_time(double t, int, const scalar*, const scalar*, const scalar*) const  // why is it defined as const??
+    void set_time(double t, int n, const scalar*, const scalar* pos, const scalar*) const  // why is it defined as const??
     {
         cost=cos(Omega*t);
         sint=sin(Omega*t);
+        cacheBodies = NULL;
+        // determine whether (nearly) all bodies were active at the previous step
+        numFullSteps = numBodies > 0 && numCalls >= 0.9 * numBodies ? numFullSteps+1 : 0;
+        numBodies = n;
+        numCalls  = 0;
+        // precomputing the potential for all bodies pays off only if most of them are active,
+        // which is predicted from the previous two steps (in a block time-stepping scheme,
+        // a step with all bodies active is always followed by a step with only a few of them)
+        if(!pot || n<=0 || pos==NULL || numFullSteps < 2)
+            return;
+        // evaluate the potential for all bodies at once, converting the input to double only once
+        cacheData.resize(static_cast<size_t>(n) * CACHE_STRIDE);
+        const double cosa = cost, sina = sint;
+        const potential::BasePotential& potential = *pot;
+        bool fail = false;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for(int i=0; i<n; i++) {
+            double* data = &cacheData[static_cast<size_t>(i) * CACHE_STRIDE];
+            data[0] = pos[i*NDIM];
+            data[1] = pos[i*NDIM+1];
+            data[2] = NDIM>=3 ? pos[i*NDIM+2] : 0;
+            try{
+                evalRotated(potential, cosa, sina, data, data+3);
+            }
+            catch(std::exception&) {
+                fail = true;
+            }
+        }
+        if(!fail)
+            cacheBodies = pos;
     }
 
     // constructor
-    agama(const double* pars, int npar, const char *file)
+    agama(const double* pars, int npar, const char *file) :
+        cacheBodies(NULL), numBodies(0), numCalls(0), numFullSteps(0)
     {
         if(file==NULL || file[0]==0) {
             nemo_dprintf(0, "Should provide the name of INI or potential coefficients file in accfile=...\n");
@@ -46,9 +101,14 @@ struct agama {
                 pot = potential::createPotential(filename);
             else
                 pot = potential::readPotential(filename);
+            if(npar>=2 && pars[1]>=0)
+                pot = potential::CylSpline::create(*pot, static_cast<int>(pars[1]),
+                    /*gridSizeR*/ 32, /*Rmin, Rmax: autodetect*/ 0, 0,
+                    /*gridSizez*/ 32, /*zmin, zmax: autodetect*/ 0, 0);
         }
         catch(std::exception& e){
             nemo_dprintf(0, "Error in creating potential specified in %s: %s\n", file, e.what());
+            pot.reset();
             return;
         }
         Omega=npar>=1 ? pars[0] : 0;
@@ -65,14 +125,40 @@ struct agama {
             for(int i=0; i<NDIM; i++) accel[i]=0;
             return;
         }
-        coord::PosCar point(pos[0]*cost+pos[1]*sint, pos[1]*cost-pos[0]*sint, NDIM>=3?pos[2]:0);
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        numCalls++;
+        double point[3] = {pos[0], pos[1], NDIM>=3 ? pos[2] : 0}, result[4];
+        const double* data = result;
+        // check if the body belongs to the array for which the values have been precomputed
+        const scalar* bodies = static_cast<const scalar*>(cacheBodies);
+        ptrdiff_t index = bodies ? (pos - bodies) / NDIM : -1;
+        if( index >= 0 && static_cast<size_t>(index+1) * CACHE_STRIDE <= cacheData.size() &&
+            cacheData[index * CACHE_STRIDE  ] == point[0] &&
+            cacheData[index * CACHE_STRIDE+1] == point[1] &&
+            cacheData[index * CACHE_STRIDE+2] == point[2])
+            data = &cacheData[index * CACHE_STRIDE + 3];
+        else
+            evalRotated(*pot, cost, sint, point, result);
+        poten    = static_cast<scalar>(data[0]);
+        accel[0] = static_cast<scalar>(data[1]);
+        accel[1] = static_cast<scalar>(data[2]);
+        if(NDIM==3) accel[2] = static_cast<scalar>(data[3]);
+    }
+
+    /// compute the potential and acceleration at the given point in the inertial frame,
+    /// taking into account the rotation of the potential by the angle with the given cos/sin;
+    /// output: result[0] = potential, result[1..3] = acceleration
+    static void evalRotated(const potential::BasePotential& potential, double cosa, double sina,
+        const double point[3], double result[4])
+    {
         coord::GradCar grad;
-        double Phi;
-        pot->eval(point, &Phi, &grad);
-        poten = static_cast<scalar>(Phi);
-        accel[0] = -static_cast<scalar>(grad.dx*cost-grad.dy*sint);
-        accel[1] = -static_cast<scalar>(grad.dy*cost+grad.dx*sint);
-        if(NDIM==3) accel[2] = -static_cast<scalar>(grad.dz);
+        potential.eval(coord::PosCar(point[0]*cosa+point[1]*sina, point[1]*cosa-point[0]*sina, point[2]),
+            &result[0], &grad);
+        result[1] = -(grad.dx*cosa-grad.dy*sina);
+        result[2] = -(grad.dy*cosa+grad.dx*sina);
+        result[3] = -grad.dz;
     }
 };
 __DEF__ACC(agama)
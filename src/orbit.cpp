@@ -1,5 +1,6 @@
 #include "orbit.h"
 #include "potential_base.h"
+#include "potential_evolving.h"
 #include "utils.h"
 #include <stdexcept>
 #include <cmath>
@@ -53,6 +54,19 @@ void OrbitIntegratorRot::eval(const double /*t*/,
     dxdt[5] = -grad.dz;
 }
 
+void OrbitIntegratorEvolving::eval(const double t,
+    const math::OdeStateType& x, math::OdeStateType& dxdt) const
+{
+    coord::GradCar grad;
+    potential.eval(timeStart + t, coord::PosCar(x[0], x[1], x[2]), NULL, &grad);
+    dxdt[0] = x[3];
+    dxdt[1] = x[4];
+    dxdt[2] = x[5];
+    dxdt[3] = -grad.dx;
+    dxdt[4] = -grad.dy;
+    dxdt[5] = -grad.dz;
+}
+
 template<>
 void OrbitIntegrator<coord::Cyl>::eval(const double /*t*/,
     const math::OdeStateType& x, math::OdeStateType& dxdt) const
@@ -15,7 +15,8 @@
     constructed internally for each orbit.
     The second part is implemented by any class derived from `math::IOdeSystem`, and this module
     provides such classes (`orbit::OrbitIntegrator`) for the three standard coordinate systems
-    with time-independent potentials, which however may have a nonzero pattern speed.
+    with time-independent potentials, which however may have a nonzero pattern speed,
+    and `orbit::OrbitIntegratorEvolving` for time-dependent potentials (`potential::Evolving`).
     The third part is realized through a generic system of 'runtime functions', which are attached
     to the orbit and called after each timestep of the ODE integrator, so that they can access
     the trajectory at any point within the current timestep (obtain the interpolated solution)
@@ -32,6 +33,8 @@
 #include "smart.h"
 #include <vector>
 
+namespace potential { class Evolving; }
+
 /** Orbit integration routines and classes */
 namespace orbit {
 
@@ -147,6 +150,27 @@ public:
     virtual bool isStdHamiltonian() const { return Omega==0; }
 };
 
+/** The function providing the RHS of the differential equation in the cartesian coordinate system
+    for a time-dependent potential represented by a series of snapshots.
+    The time argument of the ODE system starts from zero for each orbit,
+    so the potential is evaluated at time  timeStart + t.
+*/
+class OrbitIntegratorEvolving: public math::IOdeSystem {
+    /// time-dependent potential in which the orbit is computed
+    const potential::Evolving& potential;
+    /// time (in the units of the potential) corresponding to the beginning of orbit integration
+    const double timeStart;
+public:
+    /// initialize the object for the given potential and the initial time
+    OrbitIntegratorEvolving(const potential::Evolving& _potential, double _timeStart=0) :
+        potential(_potential), timeStart(_timeStart) {};
+
+    virtual void eval(const double t, const math::OdeStateType& x, math::OdeStateType& dxdt) const;
+
+    virtual unsigned int size() const { return 6; }
+    virtual bool isStdHamiltonian() const { return true; }
+};
+
 
 /** Assorted parameters of orbit integration */
 struct OrbitIntParams {
@@ -2,6 +2,7 @@
 #include "math_core.h"
 #include "math_spline.h"
 #include <cmath>
+#include <stdexcept>
 
 namespace potential{
 
@@ -13,6 +14,9 @@ static const double EPSREL_DENSITY_INT = 1e-4;
 /// (otherwise its relative accuracy is too low and its derivative cannot be reliably estimated)
 static const double EPSREL_DENSITY_DER = DBL_EPSILON / ROOT3_DBL_EPSILON;
 
+/// minimum number of points in evalmanyDensityCyl for which the loop is parallelized
+static const size_t MIN_POINTS_PARALLEL = 1024;
+
 // -------- Computation of density from Laplacian in various coordinate systems -------- //
 
 double BasePotential::densityCar(const coord::PosCar &pos) const
@@ -110,6 +114,57 @@ void DensityIntegrandNdim::eval(const double vars[], double values[]) const
         values[0] = 0;  // a non-negative result is required sometimes, e.g., for density sampling
 }
 
+void DensityIntegrandNdim::evalmany(const size_t npoints, const double vars[], double values[]) const
+{
+    // collect the points with non-zero jacobian (others are nearly at zero or infinity),
+    // and compute the density at all of them in a single call
+    const unsigned int N = numVars();
+    std::vector<coord::PosCyl> pos;
+    std::vector<double> jac, dens_values;
+    std::vector<size_t> indices;
+    for(size_t p=0; p<npoints; p++) {
+        double scvars[3] = {vars[p*N], vars[p*N+1], axisym ? 0. : vars[p*N+2]}, jacp;
+        coord::PosCyl posp = unscaleVars(scvars, &jacp);
+        values[p] = 0;
+        if(jacp!=0) {
+            pos.push_back(posp);
+            jac.push_back(jacp);
+            indices.push_back(p);
+        }
+    }
+    if(pos.empty())
+        return;
+    dens_values.resize(pos.size());
+    dens.evalmanyDensityCyl(pos.size(), &pos[0], &dens_values[0]);
+    for(size_t i=0; i<indices.size(); i++) {
+        double value = dens_values[i] * jac[i];
+        values[indices[i]] = nonnegative && value<0 ? 0 : value;
+    }
+}
+
+void BaseDensity::evalmanyDensityCyl(const size_t npoints, const coord::PosCyl pos[],
+    double values[]) const
+{
+    std::string errorMsg;
+    // small batches (e.g., from integration or sampling routines, which typically already run
+    // in parallel over blocks of points) are processed serially to avoid the threading overhead
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic,64) if(npoints >= MIN_POINTS_PARALLEL)
+#endif
+    for(ptrdiff_t p=0; p<(ptrdiff_t)npoints; p++) {
+        // exceptions must not leave the OpenMP block, so they are caught and rethrown afterwards
+        try{
+            values[p] = density(pos[p]);
+        }
+        catch(std::exception& e) {
+            errorMsg = e.what();
+            values[p] = NAN;
+        }
+    }
+    if(!errorMsg.empty())
+        throw std::runtime_error(errorMsg);
+}
+
 double BaseDensity::enclosedMass(const double r) const
 {
     if(r==0) return 0;   // this assumes no central point mass! overriden in Plummer density model
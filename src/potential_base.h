@@ -58,6 +58,21 @@ public:
     double density(const coord::PosSph &pos) const {
         return densitySph(pos); }
 
+    /** Evaluate density at several points in cylindrical coordinates at once.
+        The default implementation calls `density()` for each point (in parallel if OpenMP
+        is available and the number of points is large enough), but derived classes may provide
+        a more efficient batched implementation
+        (e.g., a user-defined Python function, which is then called once for the entire array).
+        This method is used when all points are known in advance, e.g., in the construction of
+        potential expansions from a density model.
+        \param[in]  npoints  is the number of points;
+        \param[in]  pos  is the array of positions of length npoints;
+        \param[out] values  will contain the values of density at these points.
+        \throw std::runtime_error if the density could not be computed at any point.
+    */
+    virtual void evalmanyDensityCyl(const size_t npoints, const coord::PosCyl pos[],
+        double values[]) const;
+
     /// returns the symmetry type of this density or potential
     virtual coord::SymmetryType symmetry() const = 0;
 
@@ -417,6 +432,9 @@ public:
     /// integrand for the density at a given point (R,z,phi) with appropriate coordinate scaling
     virtual void eval(const double vars[], double values[]) const;
 
+    /// same for several points at once, calling the batched density evaluation routine
+    virtual void evalmany(const size_t npoints, const double vars[], double values[]) const;
+
     /// dimensions of integration: only integrate in phi if density is not axisymmetric
     virtual unsigned int numVars() const { return axisym ? 2 : 3; }
 
@@ -11,6 +11,7 @@
 #include <cassert>
 #include <stdexcept>
 #include <alloca.h>
+#include <complex>
 
 namespace potential {
 
@@ -38,23 +39,32 @@ const double EPS2_SOFTENING = 1e-12;
 /// relative accuracy of potential computation (integration tolerance parameter)
 static const double EPSREL_POTENTIAL_INT = 1e-6;
 
+/// number of e-folds in radius by which the logarithmic grid used in the Hankel transform
+/// extends beyond the innermost and outermost nodes of the output grid
+static const double HANKEL_PADDING = 20.;
+
+/// maximum spacing of the logarithmic grid in radius used in the Hankel transform
+static const double HANKEL_MAX_LOG_STEP = 0.05;
+
+/// number of sub-intervals in each segment of the vertical grid used in the Hankel-transform solver
+static const int HANKEL_NUM_SUBDIV_Z = 8;
+
+/// log-spacing of the extension of this vertical grid beyond the outermost node of the output grid
+static const double HANKEL_LOG_STEP_Z = 0.1;
+
 // ------- Fourier expansion of density or potential ------- //
 // The routine 'computeFourierCoefs' can work with both density and potential classes,
 // computes the azimuthal Fourier expansion for either density (in the first case),
 // or potential and its R- and z-derivatives (in the second case).
 // To avoid code duplication, the function that actually retrieves the relevant quantity
-// is separated into a dedicated routine 'storeValue', which stores either one or three
-// values for each input point. The 'computeFourierCoefs' routine is templated on both
-// the type of input data and the number of quantities stored for each point.
+// is separated into a dedicated routine 'storeValues', which stores either one or three
+// values for each input point (for the potential, it calls 'storeValue' for each point,
+// while the density is computed for all points in one batch). The 'computeFourierCoefs' routine
+// is templated on both the type of input data and the number of quantities stored for each point.
 
 template<class BaseDensityOrPotential>
 void storeValue(const BaseDensityOrPotential& src, const coord::PosCyl& pos, double values[], int numVal);
 
-template<>
-inline void storeValue(const BaseDensity& src, const coord::PosCyl& pos, double values[], int) {
-    *values = src.density(pos);
-}
-
 template<>
 inline void storeValue(const BasePotential& src, const coord::PosCyl& pos, double values[], int numVal) {
     coord::GradCyl grad;
@@ -63,6 +73,46 @@ inline void storeValue(const BasePotential& src, const coord::PosCyl& pos, doubl
     values[numVal*2] = grad.dz;
 }
 
+// store the values of input quantities at all points of the grid in (R,z,phi):
+// for each node of the (R,z) grid there is a block of `stride*NQuantities` values,
+// of which the first `numPhi` elements in each of NQuantities sub-blocks are filled.
+// The generic implementation calls `storeValue` for each point in parallel,
+// while for a density model all points are passed in a single call to its batched routine
+// (which is itself parallelized in the default implementation).
+template<class BaseDensityOrPotential>
+void storeValues(const BaseDensityOrPotential& src, const std::vector<coord::PosCyl>& points,
+    unsigned int numPhi, unsigned int stride, int NQuantities, double values[])
+{
+    const int numNodes = points.size() / numPhi;
+    std::string errorMsg;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int n=0; n<numNodes; n++) {
+        try{
+            for(unsigned int i=0; i<numPhi; i++)
+                storeValue<BaseDensityOrPotential>(src, points[n * numPhi + i],
+                    &values[n * stride * NQuantities + i], stride);
+        }
+        catch(std::exception& e) {
+            errorMsg = e.what();
+        }
+    }
+    if(!errorMsg.empty())
+        throw std::runtime_error(errorMsg);
+}
+
+template<>
+void storeValues(const BaseDensity& src, const std::vector<coord::PosCyl>& points,
+    unsigned int numPhi, unsigned int stride, int /*NQuantities==1*/, double values[])
+{
+    std::vector<double> densValues(points.size());
+    src.evalmanyDensityCyl(points.size(), &points[0], &densValues[0]);
+    for(size_t n=0; n<points.size() / numPhi; n++)
+        for(unsigned int i=0; i<numPhi; i++)
+            values[n * stride + i] = densValues[n * numPhi + i];
+}
+
 template<class BaseDensityOrPotential, int NQuantities>
 void computeFourierCoefs(const BaseDensityOrPotential &src,
     const unsigned int mmax,
@@ -89,24 +139,39 @@ void computeFourierCoefs(const BaseDensityOrPotential &src,
     }
     std::string errorMsg;
 
+    // 1st step: collect the values of input quantities at all points of the 3d grid in (R,z,phi),
+    // so that they may be computed in one batch
+    const unsigned int numPhi = trans.size(), stride = 2*mmax+1;
+    std::vector<coord::PosCyl> points;
+    points.reserve(numPoints * numPhi);
+    for(int n=0; n<numPoints; n++)
+        for(unsigned int i=0; i<numPhi; i++)
+            points.push_back(coord::PosCyl(gridR[n % sizeR], gridz[n / sizeR], trans.phi(i)));
+    std::vector<double> allValues(numPoints * stride * NQuantities);
+    try{
+        storeValues<BaseDensityOrPotential>(src, points, numPhi, stride, NQuantities, &allValues[0]);
+    }
+    catch(std::exception& e) {
+        throw std::runtime_error(std::string("Error in computeFourierCoefs: ") + e.what());
+    }
+
+    // 2nd step: Fourier-transform these values at each node of the (R,z) grid
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
     {
         // thread-local variables
-        std::vector<double> values((2*mmax+1) * NQuantities), coefs_m(2*mmax+1);
+        std::vector<double> coefs_m(2*mmax+1);
 #ifdef _OPENMP
 #pragma omp for schedule(dynamic)
 #endif
         for(int n=0; n<numPoints; n++) {
             int iR = n % sizeR;  // index in radial grid
             int iz = n / sizeR;  // index in vertical direction
+            const double* values = &allValues[n * stride * NQuantities];
             try{
-                for(unsigned int i=0; i<trans.size(); i++)
-                    storeValue<BaseDensityOrPotential>(src,
-                        coord::PosCyl(gridR[iR], gridz[iz], trans.phi(i)), &values[i], 2*mmax+1);
                 for(int q=0; q<NQuantities; q++) {
-                    trans.transform(&values[q*(2*mmax+1)], &coefs_m[0]);
+                    trans.transform(&values[q*stride], &coefs_m[0]);
                     for(unsigned int i=0; i<numHarmonicsComputed; i++) {
                         int m = indices[i];
                         coefs[q]->at(m+mmax)(iR, iz) =
@@ -222,6 +287,30 @@ private:
     const bool useDerivs;
 };
 
+// For an axisymmetric potential we don't use interpolation,
+// as the Fourier expansion of density trivially has only one harmonic;
+// also, if the input density is already a Fourier expansion, use it directly.
+// Otherwise, we need to create a temporary DensityAzimuthalHarmonic interpolating object,
+// which is returned by this routine (or an empty pointer if it is not needed).
+PtrDensity createDensityInterpolator(const BaseDensity &src,
+    unsigned int mmax,
+    const std::vector<double> &gridR,
+    const std::vector<double> &gridz)
+{
+    if(isZRotSymmetric(src) || src.name() == DensityAzimuthalHarmonic::myName())
+        return PtrDensity();
+    unsigned int sizez = gridz.size();
+    double Rmax = gridR.back() * 100;
+    double Rmin = gridR[1] * 0.01;
+    double zmax = gridz.back() * 100;
+    double zmin = gridz[0]==0 ? gridz[1] * 0.01 :
+        gridz[sizez/2]==0 ? gridz[sizez/2+1] * 0.01 : Rmin;
+    double delta=0.1;  // relative difference between grid nodes = log(x[n+1]/x[n])
+    return DensityAzimuthalHarmonic::create(src, mmax,
+        static_cast<unsigned int>(log(Rmax/Rmin)/delta), Rmin, Rmax,
+        static_cast<unsigned int>(log(zmax/zmin)/delta), zmin, zmax);
+}
+
 void computePotentialCoefsFromDensity(const BaseDensity &src,
     unsigned int mmax,
     const std::vector<double> &gridR,
@@ -244,26 +333,11 @@ void computePotentialCoefsFromDensity(const BaseDensity &src,
         }
     }
 
-    PtrDensity densInterp;  // pointer to an internally created interpolating object if it is needed
-    const BaseDensity* dens = &src;  // pointer to either the original density or the interpolated one
-    // For an axisymmetric potential we don't use interpolation,
-    // as the Fourier expansion of density trivially has only one harmonic;
-    // also, if the input density is already a Fourier expansion, use it directly.
-    // Otherwise, we need to create a temporary DensityAzimuthalHarmonic interpolating object.
-    if(!isZRotSymmetric(src) && src.name() != DensityAzimuthalHarmonic::myName()) {
-        double Rmax = gridR.back() * 100;
-        double Rmin = gridR[1] * 0.01;
-        double zmax = gridz.back() * 100;
-        double zmin = gridz[0]==0 ? gridz[1] * 0.01 :
-            gridz[sizez/2]==0 ? gridz[sizez/2+1] * 0.01 : Rmin;
-        double delta=0.1;  // relative difference between grid nodes = log(x[n+1]/x[n])
-        // create a density interpolator; it will be automatically deleted upon return
-        densInterp = DensityAzimuthalHarmonic::create(src, mmax,
-            static_cast<unsigned int>(log(Rmax/Rmin)/delta), Rmin, Rmax,
-            static_cast<unsigned int>(log(zmax/zmin)/delta), zmin, zmax);
-        // and use it for computing the potential
-        dens = densInterp.get();
-    }
+    // pointer to an internally created interpolating object if it is needed
+    // (it will be automatically deleted upon return)
+    PtrDensity densInterp = createDensityInterpolator(src, mmax, gridR, gridz);
+    // pointer to either the original density or the interpolated one
+    const BaseDensity* dens = densInterp ? densInterp.get() : &src;
 
     int numPoints = sizeR * sizez;
     std::string errorMsg;
@@ -301,6 +375,344 @@ void computePotentialCoefsFromDensity(const BaseDensity &src,
         throw std::runtime_error("Error in computePotentialCoefsCyl: "+errorMsg);
 }
 
+// ------- Computation of potential from density via Hankel transforms ------- //
+// An alternative, much faster method for solving the Poisson equation is based on
+// the representation of the Green's function for the m-th azimuthal harmonic as
+//   Q_{m-1/2}(u) / (pi sqrt(R R')) = \int_0^\infty dk J_m(k R) J_m(k R') exp(-k |z-z'|).
+// The m-th harmonic of density is Hankel-transformed in R at each node of a fine grid in z,
+// then for each wavenumber k it is convolved with the exponential kernel in z
+// (which takes linear time with a two-pass recursion), and finally transformed back to R.
+// The Hankel transforms are performed on a logarithmic grid with the FFTLog method
+// (Hamilton 2000, MNRAS, 312, 257), so that the total cost is O(N_R log(N_R) N_z)
+// instead of O(N_R^2 N_z^2) for the direct integration.
+
+/// in-place discrete Fourier transform of a complex array whose length is a power of two:
+/// data_k <- \sum_j data_j exp(-2 pi i j k / N)
+void fourierTransform(std::vector< std::complex<double> > &data)
+{
+    const size_t size = data.size();
+    // bit-reversal permutation
+    for(size_t i=1, j=0; i<size; i++) {
+        size_t bit = size >> 1;
+        for(; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if(i < j)
+            std::swap(data[i], data[j]);
+    }
+    // butterfly operations
+    for(size_t len=2; len<=size; len <<= 1) {
+        for(size_t j=0; j<len/2; j++) {
+            const std::complex<double> w(cos(2*M_PI*j/len), -sin(2*M_PI*j/len));
+            for(size_t i=j; i<size; i+=len) {
+                std::complex<double> u = data[i], v = data[i+len/2] * w;
+                data[i] = u + v;
+                data[i+len/2] = u - v;
+            }
+        }
+    }
+}
+
+/// logarithm of the gamma function of a complex argument (Lanczos approximation)
+std::complex<double> lnGammaComplex(std::complex<double> z)
+{
+    static const double coefs[9] = { 0.99999999999980993, 676.5203681218851,
+        -1259.1392167224028, 771.32342877765313, -176.61502916214059, 12.507343278686905,
+        -0.13857109526572012, 9.9843695780195716e-6, 1.5056327351493116e-7 };
+    if(z.real() < 0.5)  // use the recurrence relation to shift the argument
+        return lnGammaComplex(z + 1.) - log(z);
+    z -= 1.;
+    std::complex<double> sum = coefs[0], t = z + 7.5;
+    for(int i=1; i<9; i++)
+        sum += coefs[i] / (z + 1.*i);
+    return 0.5*log(2*M_PI) + (z + 0.5) * log(t) - t + log(sum);
+}
+
+/** Hankel transform of order mu on a logarithmic grid:
+    g(k) = \int_0^\infty f(r) J_mu(k r) r dr,
+    where the input function is given at nodes r_j = r_0 exp(j Delta), j=0..N-1 (N=2^n),
+    and the output is computed at nodes k_j = 1 / r_{N-1-j}.
+    The integral is computed exactly for the periodic continuation of the function
+    a(ln r) = f(r) r^{2-s}, which therefore should be negligibly small at both ends of the grid;
+    the bias exponent s must lie in the range -mu < s < 3/2.
+*/
+class HankelTransform {
+    std::vector<double> powIn, powOut;           ///< r_j^{2-s}  and  r_{N-1-j}^s
+    std::vector< std::complex<double> > kernel;  ///< multipliers in the Fourier space
+public:
+    HankelTransform(const std::vector<double> &radii, int mu, double bias) :
+        powIn(radii.size()), powOut(radii.size()), kernel(radii.size())
+    {
+        const unsigned int size = radii.size();
+        const double delta = log(radii.back() / radii.front()) / (size-1);
+        for(unsigned int j=0; j<size; j++) {
+            powIn [j] = std::pow(radii[j], 2-bias);
+            powOut[j] = std::pow(radii[size-1-j], bias);
+        }
+        for(unsigned int n=0; n<size; n++) {
+            if(n == size/2)
+                continue;  // the Nyquist frequency is discarded
+            // Mellin transform of the Bessel function, times the phase factor
+            // and the normalization of the inverse Fourier transform
+            std::complex<double> z(bias, 2*M_PI / (delta * size) * (n < size/2 ? 1.*n : n-1.*size));
+            kernel[n] = exp( (z-1.) * M_LN2 + lnGammaComplex(0.5 * (1.*mu + z)) -
+                lnGammaComplex(1. + 0.5 * (1.*mu - z)) - std::complex<double>(0, 2*M_PI*n/size) ) / (1.*size);
+        }
+    }
+
+    /// perform the transform: input[j] = f(r_j),  output[j] = g(k_j)
+    void transform(const double input[], double output[]) const
+    {
+        const unsigned int size = kernel.size();
+        std::vector< std::complex<double> > tmp(size);
+        for(unsigned int j=0; j<size; j++)
+            tmp[j] = input[j] * powIn[j];
+        fourierTransform(tmp);
+        for(unsigned int n=0; n<size; n++)
+            tmp[n] *= kernel[n];
+        fourierTransform(tmp);
+        for(unsigned int j=0; j<size; j++)
+            output[j] = tmp[j].real() * powOut[j];
+    }
+};
+
+/// weights of the values of a function f(t) at t=0, d/2, d in the integral over a grid segment
+/// with an exponential kernel, approximating the function by a quadratic polynomial:
+/// \int_0^d exp(-k (d-t)) f(t) dt = d * ( w[0] * f(0) + w[1] * f(d/2) + w[2] * f(d) ),  x = k d;
+/// w[3] = exp(-x) is the attenuation factor across the segment
+inline void exponentialSegmentWeights(double x, double w[4])
+{
+    // J_n = \int_0^1 exp(-x (1-u)) u^n du,  n=0..2
+    double J0 = 0, J1 = 0, J2 = 0;
+    w[3] = exp(-x);
+    if(x < 1) {  // series expansion:  J_n = \sum_i (-x)^i n! / (n+i+1)!
+        double term = 1;  // (-x)^i / i!
+        for(int i=0; i<=16; i++) {
+            J0 += term / (i+1);
+            J1 += term / ((i+1) * (i+2));
+            J2 += term * 2 / ((i+1) * (i+2) * (i+3));
+            term *= -x / (i+1);
+        }
+    } else {     // recurrence relation
+        J0 = (1 - w[3]) / x;
+        J1 = (1 - J0) / x;
+        J2 = (1 - 2 * J1) / x;
+    }
+    w[0] = J0 - 3 * J1 + 2 * J2;
+    w[1] = 4 * (J1 - J2);
+    w[2] = 2 * J2 - J1;
+}
+
+void computePotentialCoefsFromDensityHankel(const BaseDensity &src,
+    unsigned int mmax,
+    const std::vector<double> &gridR,
+    const std::vector<double> &gridz,
+    bool useDerivs,
+    std::vector< math::Matrix<double> >* output[])
+{
+    unsigned int sizeR = gridR.size(), sizez = gridz.size();
+    if(sizeR<CYLSPLINE_MIN_GRID_SIZE || sizez<CYLSPLINE_MIN_GRID_SIZE || gridR[0]!=0)
+        throw std::invalid_argument("computePotentialCoefsCyl: invalid grid parameters");
+    if(isZRotSymmetric(src))
+        mmax = 0;
+    std::vector<int> indices = math::getIndicesAzimuthal(mmax, src.symmetry());
+    unsigned int numQuantitiesOutput = useDerivs ? 3 : 1;  // Phi only, or Phi plus two derivs
+    for(unsigned int q=0; q<numQuantitiesOutput; q++) {
+        output[q]->resize(2*mmax+1);
+        for(unsigned int i=0; i<indices.size(); i++)
+            output[q]->at(indices[i]+mmax)=math::Matrix<double>(sizeR, sizez, 0);
+    }
+    PtrDensity densInterp = createDensityInterpolator(src, mmax, gridR, gridz);
+    const BaseDensity* dens = densInterp ? densInterp.get() : &src;
+    const bool zsym = isZReflSymmetric(*dens);
+
+    // logarithmic grid in R extending well beyond the output grid on both ends,
+    // and the corresponding grid in wavenumber
+    const double logRmin = log(gridR[1]) - HANKEL_PADDING, logRmax = log(gridR.back()) + HANKEL_PADDING;
+    unsigned int numR = 64;
+    while((logRmax - logRmin) / (numR-1) > HANKEL_MAX_LOG_STEP)
+        numR *= 2;
+    const double deltaR = (logRmax - logRmin) / (numR-1);
+    std::vector<double> radii(numR), logRadii(numR), wavenums(numR);
+    for(unsigned int j=0; j<numR; j++) {
+        logRadii[j] = logRmin + deltaR * j;
+        radii[j]    = exp(logRadii[j]);
+        wavenums[numR-1-j] = 1 / radii[j];
+    }
+
+    // fine grid in z: each segment of the (mirrored) output grid is subdivided into several parts,
+    // and the grid is extended logarithmically far beyond the outermost node on both sides;
+    // the density is integrated in z with a quadratic approximation on each pair of segments
+    const std::vector<double> nodes = gridz[0]==0 ? math::mirrorGrid(gridz) : gridz;
+    const double zmax = fmax(-nodes.front(), nodes.back());
+    std::vector<double> ext;
+    for(double z = zmax * exp(2*HANKEL_LOG_STEP_Z); z < zmax * exp(HANKEL_PADDING);
+        z *= exp(2*HANKEL_LOG_STEP_Z))
+        ext.push_back(z);
+    std::vector<double> gridzpairs;  // boundaries of pairs of segments
+    for(unsigned int i=ext.size(); i>0; i--)
+        gridzpairs.push_back(-ext[i-1]);
+    std::vector<unsigned int> indzfine(sizez);  // indices of output nodes in the fine grid
+    for(unsigned int i=0; i<nodes.size(); i++) {
+        if(i>0) {
+            // the segments adjacent to z=0 are further subdivided logarithmically towards zero,
+            // to resolve a possible density cusp at origin
+            double step = (nodes[i]-nodes[i-1]) / (HANKEL_NUM_SUBDIV_Z/2);
+            std::vector<double> inner;
+            if(nodes[i-1] == 0 || nodes[i] == 0)
+                for(double z = step * exp(-2*HANKEL_LOG_STEP_Z); z > step * exp(-0.5*HANKEL_PADDING);
+                    z *= exp(-2*HANKEL_LOG_STEP_Z))
+                    inner.push_back(z);
+            if(nodes[i-1] == 0)
+                for(unsigned int n=inner.size(); n>0; n--)
+                    gridzpairs.push_back(inner[n-1]);
+            for(int s=1; s<HANKEL_NUM_SUBDIV_Z/2; s++)
+                gridzpairs.push_back(nodes[i-1] + step * s);
+            if(nodes[i] == 0)
+                for(unsigned int n=0; n<inner.size(); n++)
+                    gridzpairs.push_back(-inner[n]);
+        }
+        for(unsigned int iz=0; iz<sizez; iz++)
+            if(gridz[iz] == nodes[i])
+                indzfine[iz] = 2 * gridzpairs.size();
+        gridzpairs.push_back(nodes[i]);
+    }
+    gridzpairs.insert(gridzpairs.end(), ext.begin(), ext.end());
+    const int numpairs = gridzpairs.size()-1, numz = 2*numpairs+1;
+    // if the grid is symmetric w.r.t. z-reflection up to roundoff errors, make it exactly symmetric
+    bool symmetric = true;
+    for(int i=0; i<=numpairs; i++)
+        symmetric &= fabs(gridzpairs[i] + gridzpairs[numpairs-i]) <= zmax * SQRT_DBL_EPSILON;
+    if(symmetric)
+        for(int i=0; i<numpairs/2; i++)
+            gridzpairs[i] = -gridzpairs[numpairs-i];
+    std::vector<double> gridzfine(numz);
+    for(int i=0; i<=numpairs; i++) {
+        gridzfine[2*i] = gridzpairs[i];
+        if(i<numpairs)
+            gridzfine[2*i+1] = 0.5 * (gridzpairs[i] + gridzpairs[i+1]);
+    }
+    // if both the density and the grid are symmetric w.r.t. z-reflection,
+    // the density needs to be computed only for z>=0
+    const bool mirror = symmetric && isZReflSymmetric(*dens);
+
+    // temporary arrays: Hankel transform of density at each node of the fine z-grid,
+    // and the convolution of the latter with the exponential kernel in z and its z-derivative
+    // at each output node in z, for all wavenumbers
+    math::Matrix<double> densTrans(numz, numR), conv(sizez, numR), convDeriv(sizez, numR);
+    std::string errorMsg;
+
+    for(unsigned int i=0; i<indices.size(); i++) {
+        const int m = indices[i], absm = math::abs(m);
+        const HankelTransform
+            transDens(radii, absm, 0.5), transPhi(wavenums, absm, 0.5), transDerivR(wavenums, absm+1, 1.);
+
+        // 1st step: collect the values of density harmonic and transform them to the k-space
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for(int iz=0; iz<numz; iz++) {
+            try{
+                if(mirror && gridzfine[iz] < 0)
+                    continue;  // will be copied from the positive-z half
+                std::vector<double> tmp(numR);
+                for(unsigned int j=0; j<numR; j++)
+                    tmp[j] = density_rho_m(*dens, m, radii[j], gridzfine[iz]);
+                transDens.transform(&tmp[0], &densTrans(iz, 0));
+            }
+            catch(std::exception& e) {
+                errorMsg = e.what();
+            }
+        }
+        if(!errorMsg.empty())
+            throw std::runtime_error("Error in computePotentialCoefsCyl: "+errorMsg);
+        if(mirror)
+            for(int iz=0; iz<numz/2; iz++)
+                std::copy(&densTrans(numz-1-iz, 0), &densTrans(numz-1-iz, 0) + numR, &densTrans(iz, 0));
+
+        // 2nd step: for each wavenumber, convolve the transformed density with exp(-k |z-z'|),
+        // computing the integrals from below and from above by recursion
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for(int j=0; j<(int)numR; j++) {
+            const double k = wavenums[j];
+            // integrals from below and from above, and the weights for each pair of segments
+            std::vector<double> tmp(2*numz + 4*numpairs, 0.);
+            double *below = &tmp[0], *above = &tmp[numz], *w = &tmp[2*numz];
+            for(int ip=0; ip<numpairs; ip++)
+                exponentialSegmentWeights(k * (gridzpairs[ip+1] - gridzpairs[ip]), &w[4*ip]);
+            for(int ip=0; ip<numpairs; ip++) {
+                const double *wf = &w[4*ip], d = gridzpairs[ip+1] - gridzpairs[ip];
+                below[2*ip+2] = below[2*ip] * wf[3] + d * (wf[0] * densTrans(2*ip, j) +
+                    wf[1] * densTrans(2*ip+1, j) + wf[2] * densTrans(2*ip+2, j));
+            }
+            for(int ip=numpairs-1; ip>=0; ip--) {
+                const double *wb = &w[4*ip], d = gridzpairs[ip+1] - gridzpairs[ip];
+                above[2*ip] = above[2*ip+2] * wb[3] + d * (wb[0] * densTrans(2*ip+2, j) +
+                    wb[1] * densTrans(2*ip+1, j) + wb[2] * densTrans(2*ip, j));
+            }
+            for(unsigned int iz=0; iz<sizez; iz++) {
+                conv(iz, j) = below[indzfine[iz]] + above[indzfine[iz]];
+                convDeriv(iz, j) = k * (above[indzfine[iz]] - below[indzfine[iz]]);
+            }
+        }
+
+        // 3rd step: inverse Hankel transform from the k-space to R at each output node in z,
+        // and interpolation from the logarithmic grid in R to the output grid
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for(int iz=0; iz<(int)sizez; iz++) {
+            try{
+                std::vector<double> tmp(3*numR);
+                double *input = &tmp[0], *result = &tmp[numR], *result1 = &tmp[2*numR];
+                // the values at R=0 are given by the k-space integrals (nonzero only for m=0)
+                double Phi0 = 0, dPhidz0 = 0;
+                for(unsigned int j=0; j<numR; j++) {
+                    Phi0    += conv(iz, j) * wavenums[j];
+                    dPhidz0 += convDeriv(iz, j) * wavenums[j];
+                }
+                // Phi_m(R) = -2 pi \int_0^\infty dk J_m(k R) conv(k)
+                for(unsigned int j=0; j<numR; j++)
+                    input[j] = -2*M_PI * conv(iz, j) / wavenums[j];
+                transPhi.transform(input, result);
+                math::CubicSpline splPhi(logRadii, std::vector<double>(result, result+numR));
+                output[0]->at(m+mmax)(0, iz) = m==0 ? -2*M_PI * deltaR * Phi0 : 0;
+                for(unsigned int iR=1; iR<sizeR; iR++)
+                    output[0]->at(m+mmax)(iR, iz) = splPhi(log(gridR[iR]));
+                if(!useDerivs)
+                    continue;
+                // dPhi_m/dR = m/R Phi_m + 2 pi \int_0^\infty dk k J_{m+1}(k R) conv(k)
+                for(unsigned int j=0; j<numR; j++)
+                    input[j] = 2*M_PI * conv(iz, j);
+                transDerivR.transform(input, result1);
+                for(unsigned int j=0; j<numR; j++)
+                    result1[j] += absm * result[j] / radii[j];
+                math::CubicSpline splDerivR(logRadii, std::vector<double>(result1, result1+numR));
+                // dPhi_m/dz = -2 pi \int_0^\infty dk J_m(k R) d conv(k) / dz
+                for(unsigned int j=0; j<numR; j++)
+                    input[j] = -2*M_PI * convDeriv(iz, j) / wavenums[j];
+                transPhi.transform(input, result);
+                math::CubicSpline splDerivz(logRadii, std::vector<double>(result, result+numR));
+                output[1]->at(m+mmax)(0, iz) = 0;
+                output[2]->at(m+mmax)(0, iz) = m==0 ? -2*M_PI * deltaR * dPhidz0 : 0;
+                for(unsigned int iR=1; iR<sizeR; iR++) {
+                    output[1]->at(m+mmax)(iR, iz) = splDerivR(log(gridR[iR]));
+                    output[2]->at(m+mmax)(iR, iz) = zsym && gridz[iz]==0 ? 0 : splDerivz(log(gridR[iR]));
+                }
+                if(zsym && gridz[iz]==0)
+                    output[2]->at(m+mmax)(0, iz) = 0;
+            }
+            catch(std::exception& e) {
+                errorMsg = e.what();
+            }
+        }
+        if(!errorMsg.empty())
+            throw std::runtime_error("Error in computePotentialCoefsCyl: "+errorMsg);
+    }
+}
+
 // transform an N-body snapshot to an array of Fourier harmonic coefficients
 void computeAzimuthalHarmonicsFromParticles(
     const particles::ParticleArray<coord::PosCyl>& particles,
@@ -444,10 +856,14 @@ void computePotentialCoefsCyl(const BaseDensity &src,
     const std::vector<double> &gridz,
     std::vector< math::Matrix<double> > &Phi,
     std::vector< math::Matrix<double> > &dPhidR,
-    std::vector< math::Matrix<double> > &dPhidz)
+    std::vector< math::Matrix<double> > &dPhidz,
+    bool useFFT)
 {
     std::vector< math::Matrix<double> > *coefs[3] = {&Phi, &dPhidR, &dPhidz};
-    computePotentialCoefsFromDensity(src, mmax, gridR, gridz, true, coefs);
+    if(useFFT)
+        computePotentialCoefsFromDensityHankel(src, mmax, gridR, gridz, true, coefs);
+    else
+        computePotentialCoefsFromDensity(src, mmax, gridR, gridz, true, coefs);
 }
 
 // potential coefs from density, without derivatves
@@ -455,10 +871,14 @@ void computePotentialCoefsCyl(const BaseDensity &src,
     const unsigned int mmax,
     const std::vector<double> &gridR,
     const std::vector<double> &gridz,
-    std::vector< math::Matrix<double> > &Phi)
+    std::vector< math::Matrix<double> > &Phi,
+    bool useFFT)
 {
     std::vector< math::Matrix<double> > *coefs = &Phi;
-    computePotentialCoefsFromDensity(src, mmax, gridR, gridz, false, &coefs);
+    if(useFFT)
+        computePotentialCoefsFromDensityHankel(src, mmax, gridR, gridz, false, &coefs);
+    else
+        computePotentialCoefsFromDensity(src, mmax, gridR, gridz, false, &coefs);
 }
 
 // potential coefs from N-body array, with derivatives
@@ -831,7 +1251,7 @@ void chooseGridRadii(const particles::ParticleArray<coord::PosCyl>& particles,
 
 PtrPotential CylSpline::create(const BaseDensity& src, int mmax,
     unsigned int gridSizeR, double Rmin, double Rmax, 
-    unsigned int gridSizez, double zmin, double zmax, bool useDerivs)
+    unsigned int gridSizez, double zmin, double zmax, bool useDerivs, bool useFFT)
 {
     // ensure the grid radii are set to some reasonable values
     chooseGridRadii(src, gridSizeR, Rmin, Rmax, gridSizez, zmin, zmax);
@@ -844,9 +1264,9 @@ PtrPotential CylSpline::create(const BaseDensity& src, int mmax,
         gridz = math::mirrorGrid(gridz);
     std::vector< math::Matrix<double> > Phi, dPhidR, dPhidz;
     if(useDerivs)
-        computePotentialCoefsCyl(src, mmax, gridR, gridz, Phi, dPhidR, dPhidz);
+        computePotentialCoefsCyl(src, mmax, gridR, gridz, Phi, dPhidR, dPhidz, useFFT);
     else
-        computePotentialCoefsCyl(src, mmax, gridR, gridz, Phi);
+        computePotentialCoefsCyl(src, mmax, gridR, gridz, Phi, useFFT);
     return PtrPotential(new CylSpline(gridR, gridz, Phi, dPhidR, dPhidz));
 }
 
@@ -905,7 +1325,8 @@ CylSpline::CylSpline(
     const std::vector<double> &gridz_orig,
     const std::vector< math::Matrix<double> > &Phi,
     const std::vector< math::Matrix<double> > &dPhidR,
-    const std::vector< math::Matrix<double> > &dPhidz)
+    const std::vector< math::Matrix<double> > &dPhidz,
+    bool compact)
 {
     unsigned int sizeR = gridR_orig.size(), sizez = gridz_orig.size(), sizez_orig = sizez;
     bool haveDerivs = dPhidR.size() > 0 && dPhidz.size() > 0;
@@ -1012,8 +1433,8 @@ CylSpline::CylSpline(
         }
         if(nontrivial) {  // only construct splines if they are not identically zero
             spl[mm] = haveDerivs ? 
-                math::PtrInterpolator2d(new math::QuinticSpline2d(gridR, gridz, val, derR, derz)) :
-                math::PtrInterpolator2d(new math::CubicSpline2d(gridR, gridz, val, 0, NAN, NAN, NAN));
+                math::PtrInterpolator2d(new math::QuinticSpline2d(gridR, gridz, val, derR, derz, compact)) :
+                math::PtrInterpolator2d(new math::CubicSpline2d(gridR, gridz, val, 0, NAN, NAN, NAN, compact));
             // check if this non-trivial harmonic breaks any symmetry
             int m = mm-mmax;
             if(m!=0)  // no z-rotation symmetry because m!=0 coefs are non-zero
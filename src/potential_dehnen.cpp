@@ -1,28 +1,31 @@
 #include "potential_dehnen.h"
+#include "potential_multipole.h"
 #include "math_core.h"
 #include <cmath>
 #include <stdexcept>
 
 namespace potential {
 
-/// relative accuracy of potential computation (integration tolerance parameter)
-static const double EPSREL_POTENTIAL_INT = 1e-6;
+/// parameters of the Multipole approximation for the axisymmetric potential:
+/// order of angular expansion, number of radial grid points, and grid extent in units of scale radius
+static const int DEHNEN_APPROX_LMAX = 16;
+static const unsigned int DEHNEN_APPROX_GRID_SIZE = 60;
+static const double DEHNEN_APPROX_RMIN = 1e-4, DEHNEN_APPROX_RMAX = 1e4;
 
-// Note that we use an integration rule with fixed maximum order, so it may not always achieve
-// the required relative accuracy (in particular, at large radii the error is fairly large).
-// There are several possible ways out:
-// 1) use an adaptive-order rule (replace 'integrate' with 'integrateAdaptive') -
-//    would considerably slow down calculations that are already not too fast;
-// 2) replace the integration with a spherical-harmonic expansion up to l=2 at large radii
-//    (like in Ferrers potential, but will need to take into account that density is non-zero
-//    at all radii) - possible but would require extra work;
-// 3) use a Multipole potential expansion instead - a preferred solution.
-//    For this to work properly, one needs to supply the *density* profile, not the potential,
-//    so that the Multipole potential will solve the Poisson equation itself.
-//    This may be done by down-casting an instance of Dehnen class to BaseDensity,
-//    or by using a SpheroidDensity object instead.
+// The potential of a non-spherical model is a one-dimensional integral over the auxiliary variable s,
+// and its gradient and hessian are similar integrals with different integrands.
+// Rather than computing each of these integrals separately with an adaptive rule,
+// we use a single fixed-order quadrature, in which the integration variable is transformed
+// so that the integrands are nearly polynomial both at small and large radii
+// (the scale radius of the integrand in s scales inversely with the distance from origin).
+// This is faster than the separate adaptive integration of each quantity by two orders of magnitude,
+// and for triaxial models is as fast as the evaluation of a Multipole expansion of a comparable
+// accuracy (which needs a large number of angular terms). For axisymmetric models, however,
+// a Multipole expansion with mmax=0 is several times cheaper, hence it may be constructed
+// from the exact potential in the constructor (if requested), and used subsequently.
     
-Dehnen::Dehnen(double _mass, double _scalerad, double _gamma, double _axisRatioY, double _axisRatioZ): 
+Dehnen::Dehnen(double _mass, double _scalerad, double _gamma, double _axisRatioY, double _axisRatioZ,
+    bool _exact) :
     BasePotentialCar(), mass(_mass), scalerad(_scalerad),
     gamma(_gamma), axisRatioY(_axisRatioY), axisRatioZ(_axisRatioZ)
 {
@@ -30,6 +33,12 @@ Dehnen::Dehnen(double _mass, double _scalerad, double _gamma, double _axisRatioY
         throw std::invalid_argument("Error in Dehnen potential: scale radius must be positive");
     if(gamma<0 || gamma>2)
         throw std::invalid_argument("Error in Dehnen potential: gamma must lie in the range [0:2]");
+    if(!(axisRatioY>0 && axisRatioZ>0))
+        throw std::invalid_argument("Error in Dehnen potential: axis ratios must be positive");
+    math::prepareIntegrationTableGL(0, 1, GL_ORDER, glnodes, glweights);
+    if(!_exact && axisRatioY==1 && axisRatioZ!=1)
+        approx = Multipole::create(*this, DEHNEN_APPROX_LMAX, /*mmax*/ 0, DEHNEN_APPROX_GRID_SIZE,
+            DEHNEN_APPROX_RMIN * scalerad, DEHNEN_APPROX_RMAX * scalerad);
 }
 
 double Dehnen::densityCar(const coord::PosCar& pos) const
@@ -39,53 +48,6 @@ double Dehnen::densityCar(const coord::PosCar& pos) const
         math::pow(m, -gamma) * math::pow(scalerad+m, gamma-4);
 }
 
-/// \cond INTERNAL_DOCS
-
-class DehnenIntegrandPhi: public math::IFunctionNoDeriv {
-    double X2, Y2, Z2, gamma, q2, p2;
-public:
-    DehnenIntegrandPhi(const coord::PosCar& pt, double gam, double q, double p, double scalerad) :
-        X2(pow_2(pt.x/scalerad)), Y2(pow_2(pt.y/scalerad)), Z2(pow_2(pt.z/scalerad)),
-    gamma(gam), q2(q*q), p2(p*p) {};
-    virtual double value(double s) const {
-        const double s2 = s*s;
-        const double m = s * sqrt( X2 + Y2/(1-(1-q2)*s2) + Z2/(1-(1-p2)*s2) );
-        const double numerator = (gamma==2)? (log((1+m)*s/m) - 1/(1+m) - log(s)) :
-            (1 - (3-gamma)*math::pow(m/(m+1), 2-gamma) + (2-gamma)*math::pow(m/(m+1), 3-gamma))/(2-gamma);
-        return -numerator / sqrt( (1-(1-q2)*s2) * (1-(1-p2)*s2) );
-    }
-};
-
-class DehnenIntegrandForce: public math::IFunctionNoDeriv {
-    double X2, Y2, Z2;
-    double gamma;
-public:
-    double a2;  // squared scale radius in i-th coordinate
-    double C1, C2, C3, C4, C5;  // coefficients in computation as in Merritt&Fridman 1996
-    enum { FORCE, DERIV, DERIV_MIXED } mode;
-    DehnenIntegrandForce(const coord::PosCar& pt, double _gamma) :
-        X2(pt.x*pt.x), Y2(pt.y*pt.y), Z2(pt.z*pt.z), gamma(_gamma) {};
-    double value(double s) const {
-        const double s2=s*s;
-        const double m = s * sqrt(X2 / (a2 + C1*s2) + Y2 / (a2 + C2*s2) + Z2 / (a2 + C3*s2) );
-        double result = s2 * math::pow(m/(1+m), -gamma);
-        switch(mode) {
-            case FORCE:
-                return result / pow_2(pow_2(1+m)) /
-                sqrt( (a2 + C1*s2) * (a2 + C2*s2) * (a2 + C3*s2) );
-            case DERIV:
-                return result * s2 * (gamma + 4*m) / (pow_2(m * pow_2(1+m)) * (1+m) * 
-                sqrt( (a2 + C1*s2) * (a2 + C2*s2) * (a2 + C3*s2) ) );
-            case DERIV_MIXED:
-                return result * s2 * (gamma + 4*m) / (pow_2(m * pow_2(1+m)) * (1+m) * 
-                sqrt( (a2 + C5*s2) * pow_3(a2 + C4*s2) ) );
-            default:  // shouldn't happen
-                throw std::runtime_error("Incorrect integration mode in Dehnen potential");
-        }
-    }
-};
-/// \endcond
-
 void Dehnen::evalCar(const coord::PosCar &pos,
     double* potential, coord::GradCar* deriv, coord::HessCar* deriv2) const
 {
@@ -116,6 +78,37 @@ void Dehnen::evalCar(const coord::PosCar &pos,
         }
         return;
     }
+    if(approx)
+        approx->eval(pos, potential, deriv, deriv2);
+    else
+        evalExact(pos, potential, deriv, deriv2);
+}
+
+/// the integrand for the potential of a non-spherical model, expressed in terms of
+/// the scaled elliptical radius m; at large m it is computed from a series expansion in 1/(1+m)
+/// to avoid the cancellation of terms
+static double potentialIntegrand(double m, double gamma)
+{
+    const double v = 1/(1+m), a = 1-gamma;
+    if(v > 0.25)
+        return gamma==2 ? log((1+m)/m) - v :
+            (1 - (3-gamma) * math::pow(1-v, 2-gamma) + (2-gamma) * math::pow(1-v, 3-gamma)) / (2-gamma);
+    // (3-gamma) \int_0^v u (1-u)^{1-gamma} du = (3-gamma) \sum_k binom(1-gamma, k) (-1)^k v^{k+2} / (k+2)
+    double sum = 0, coef = 1, vpow = v*v;
+    for(int k=0; k<50; k++) {
+        double term = coef * vpow / (k+2);
+        sum  += term;
+        if(fabs(term) <= 1e-16 * fabs(sum))
+            break;
+        coef *= (k-a) / (k+1);
+        vpow *= v;
+    }
+    return (3-gamma) * sum;
+}
+
+void Dehnen::evalExact(const coord::PosCar &pos,
+    double* potential, coord::GradCar* deriv, coord::HessCar* deriv2) const
+{
     if(pos.x==0 && pos.y==0 && pos.z==0 && gamma>=2) {
         if(potential)
             *potential = -INFINITY;
@@ -123,69 +116,60 @@ void Dehnen::evalCar(const coord::PosCar &pos,
             deriv->dx = deriv->dy = deriv->dz = INFINITY;
         return;
     }
-    if(potential) {
-        DehnenIntegrandPhi fnc(pos, gamma, axisRatioY, axisRatioZ, scalerad);
-        *potential = math::integrate(fnc, 0, 1, EPSREL_POTENTIAL_INT) * mass/scalerad;
-    }
-    if(deriv==NULL && deriv2==NULL)
-        return;
-    double scalerad2 = pow_2(scalerad);
-    DehnenIntegrandForce fnc(pos, gamma);
-    fnc.a2 = scalerad2;
-    fnc.C1 = 0;
-    fnc.C2 = (pow_2(axisRatioY)-1)*scalerad2;
-    fnc.C3 = (pow_2(axisRatioZ)-1)*scalerad2;
-    fnc.mode = fnc.FORCE;
-    double result = math::integrate(fnc, 0, 1, EPSREL_POTENTIAL_INT);
-    if(deriv)
-        deriv->dx = (3-gamma)*mass * pos.x * result;
-    if(deriv2) {
-        fnc.mode = fnc.DERIV;
-        deriv2->dx2  = (3-gamma)*mass *
-            (result - pow_2(pos.x/scalerad) * math::integrate(fnc, 0, 1, EPSREL_POTENTIAL_INT) );
-        fnc.C4 = fnc.C2;
-        fnc.C5 = fnc.C3;
-        fnc.mode = fnc.DERIV_MIXED;
-        deriv2->dxdy = -(3-gamma)*mass * pos.x*pos.y/scalerad *
-            math::integrate(fnc, 0, 1, EPSREL_POTENTIAL_INT);
-        fnc.mode = fnc.FORCE;
+    // dimensionless coordinates
+    const double X = pos.x/scalerad, Y = pos.y/scalerad, Z = pos.z/scalerad,
+    X2 = X*X, Y2 = Y*Y, Z2 = Z*Z, r = sqrt(X2+Y2+Z2),
+    q2 = pow_2(axisRatioY), p2 = pow_2(axisRatioZ);
+    // the integration variable s in [0..1] is expressed through tau in [0..1]
+    // as ln(1 + r s) = tau ln(1 + r), so that the nodes are spaced uniformly in s at s < 1/r,
+    // where the integrands have a cusp, and logarithmically at larger s, where they decay
+    // as a power law; in turn, tau = t^3 (10 - 15 t + 6 t^2), which clusters the nodes towards
+    // both endpoints, softening the singularity at s=0 for non-integer gamma and resolving
+    // the rapid variation of the integrands at s~1 for strongly flattened models
+    const double lnr = log1p(r), ratio = r>0 ? lnr / r : 1.;
+    // accumulated integrals: potential, 3 gradient components, 6 hessian components
+    double intPhi = 0, intF[3] = {0,0,0}, intH[6] = {0,0,0,0,0,0};
+    for(int k=0; k<GL_ORDER; k++) {
+        const double t = glnodes[k], tau = t*t*t * (10-15*t+6*t*t),
+        s  = r>0 ? expm1(lnr * tau) / r : tau, s2 = s*s,
+        // ds = (ds/dtau) (dtau/dt) dt, combined with the common denominator of all integrands
+        Aq = 1 - (1-q2) * s2, Ap = 1 - (1-p2) * s2,
+        w  = glweights[k] * (lnr * s + ratio) * 30*t*t*pow_2(1-t) / sqrt(Aq * Ap),
+        m  = s * sqrt(X2 + Y2/Aq + Z2/Ap);
+        if(potential)
+            intPhi += w * potentialIntegrand(m, gamma);
+        if(deriv || deriv2) {
+            const double f = math::pow(m, -gamma) * math::pow(1+m, gamma-4) * w * s2,
+            invAq = 1/Aq, invAp = 1/Ap;
+            intF[0] += f;
+            intF[1] += f * invAq;
+            intF[2] += f * invAp;
+            if(deriv2) {
+                const double g = f * s2 * (gamma + 4*m) / (m*m * (1+m));
+                intH[0] += g;
+                intH[1] += g * invAq * invAq;
+                intH[2] += g * invAp * invAp;
+                intH[3] += g * invAq;
+                intH[4] += g * invAq * invAp;
+                intH[5] += g * invAp;
+            }
+        }
     }
-
-    fnc.a2 = scalerad2*pow_2(axisRatioY);
-    fnc.C1 = (1-pow_2(axisRatioY))*scalerad2;
-    fnc.C2 = 0;
-    fnc.C3 = (pow_2(axisRatioZ)-pow_2(axisRatioY))*scalerad2;
-    result = math::integrate(fnc, 0, 1, EPSREL_POTENTIAL_INT);
-    if(deriv)
-        deriv->dy = (3-gamma)*mass * pos.y * result;
-    if(deriv2) {
-        fnc.mode = fnc.DERIV;
-        deriv2->dy2  = (3-gamma)*mass *
-            (result - pow_2(pos.y/axisRatioY/scalerad) * math::integrate(fnc, 0, 1, EPSREL_POTENTIAL_INT) );
-        fnc.C4 = fnc.C3;
-        fnc.C5 = fnc.C1;
-        fnc.mode = fnc.DERIV_MIXED;
-        deriv2->dydz = -(3-gamma)*mass * pos.y*pos.z/axisRatioY/scalerad *
-            math::integrate(fnc, 0, 1, EPSREL_POTENTIAL_INT);
-        fnc.mode = fnc.FORCE;
+    if(potential)
+        *potential = -mass/scalerad * intPhi;
+    const double multF = (3-gamma) * mass / pow_2(scalerad), multH = multF / scalerad;
+    if(deriv) {
+        deriv->dx = multF * X * intF[0];
+        deriv->dy = multF * Y * intF[1];
+        deriv->dz = multF * Z * intF[2];
     }
-
-    fnc.a2 = scalerad2*pow_2(axisRatioZ);
-    fnc.C1 = (1-pow_2(axisRatioZ))*scalerad2;
-    fnc.C2 = (pow_2(axisRatioY)-pow_2(axisRatioZ))*scalerad2;
-    fnc.C3 = 0;
-    result = math::integrate(fnc, 0, 1, EPSREL_POTENTIAL_INT);
-    if(deriv)
-        deriv->dz = (3-gamma)*mass * pos.z * result;
     if(deriv2) {
-        fnc.mode = fnc.DERIV;
-        deriv2->dz2  = (3-gamma)*mass *
-            (result - pow_2(pos.z/axisRatioZ/scalerad) * math::integrate(fnc, 0, 1, EPSREL_POTENTIAL_INT) );
-        fnc.C4 = fnc.C1;
-        fnc.C5 = fnc.C2;
-        fnc.mode = fnc.DERIV_MIXED;
-        deriv2->dxdz = -(3-gamma)*mass * pos.x*pos.z/axisRatioZ/scalerad *
-            math::integrate(fnc, 0, 1, EPSREL_POTENTIAL_INT);
+        deriv2->dx2  = multH * (intF[0] - X2 * intH[0]);
+        deriv2->dy2  = multH * (intF[1] - Y2 * intH[1]);
+        deriv2->dz2  = multH * (intF[2] - Z2 * intH[2]);
+        deriv2->dxdy =-multH * X * Y * intH[3];
+        deriv2->dydz =-multH * Y * Z * intH[4];
+        deriv2->dxdz =-multH * X * Z * intH[5];
     }
 }
 
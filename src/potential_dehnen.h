@@ -5,13 +5,25 @@
 **/
 #pragma once
 #include "potential_base.h"
+#include "smart.h"
 
 namespace potential {
 
-/** Dehnen(1993) double power-law model **/
+/** Dehnen(1993) double power-law model.
+    In the spherical case the potential is given by analytic expressions;
+    otherwise it is expressed as a one-dimensional integral, which is computed by a fixed-order
+    Gauss-Legendre quadrature (all derivatives are evaluated simultaneously at the same nodes).
+    For an axisymmetric model, this is still several times more expensive than an interpolated
+    potential, hence one may set the flag `exact=false` in the constructor to create
+    a Multipole approximation of the potential, which is then used in all subsequent
+    evaluations (its relative error is ~1e-5 in potential and ~1e-4 in force, and its
+    construction takes a fraction of a second); by default the potential is evaluated exactly.
+    Triaxial models are always evaluated exactly, since the interpolation would not be any faster.
+**/
 class Dehnen: public BasePotentialCar {
 public:
-    Dehnen(double _mass, double _scalerad, double _gamma, double _axisRatioY=1., double _axisRatioZ=1.);
+    Dehnen(double _mass, double _scalerad, double _gamma, double _axisRatioY=1., double _axisRatioZ=1.,
+        bool _exact=true);
     virtual const char* name() const { return myName(); }
     static const char* myName() { static const char* text = "Dehnen"; return text; }
     virtual coord::SymmetryType symmetry() const { 
@@ -24,6 +36,16 @@ private:
     const double gamma;      ///< cusp exponent for Dehnen potential
     const double axisRatioY; ///< axis ratio y/x of equidensity surfaces
     const double axisRatioZ; ///< axis ratio z/x of equidensity surfaces
+    /// interpolated approximation of an axisymmetric potential (empty if evaluated exactly)
+    PtrPotential approx;
+    /// order of Gauss-Legendre quadrature for computing the non-spherical potential
+    static const int GL_ORDER = 24;
+    /// nodes and weights of this quadrature rule on the unit interval
+    double glnodes[GL_ORDER], glweights[GL_ORDER];
+
+    /// compute the non-spherical potential by a fixed-order quadrature
+    void evalExact(const coord::PosCar &pos,
+        double* potential, coord::GradCar* deriv, coord::HessCar* deriv2) const;
 
     virtual void evalCar(const coord::PosCar &pos,
         double* potential, coord::GradCar* deriv, coord::HessCar* deriv2) const;
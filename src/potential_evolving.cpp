@@ -0,0 +1,296 @@
+#include "potential_evolving.h"
+#include "potential_factory.h"
+#include "math_core.h"
+#include "utils.h"
+#include <stdexcept>
+#include <cmath>
+#include <algorithm>
+
+namespace potential{
+
+namespace {
+
+/// instantaneous potential given by a weighted combination of two snapshots
+class InterpolatedSnapshot: public BasePotentialCyl {
+    PtrPotential pot1, pot2;  ///< the two snapshots bracketing the given time
+    double weight;            ///< the weight of the second snapshot (the first one has 1-weight)
+public:
+    InterpolatedSnapshot(const PtrPotential& _pot1, const PtrPotential& _pot2, double _weight) :
+        pot1(_pot1), pot2(_pot2), weight(_weight) {}
+
+    virtual coord::SymmetryType symmetry() const {
+        return static_cast<coord::SymmetryType>(pot1->symmetry() & pot2->symmetry()); }
+    virtual const char* name() const { return myName(); }
+    static const char* myName() { static const char* text = "InterpolatedSnapshot"; return text; }
+
+private:
+    virtual void evalCyl(const coord::PosCyl &pos,
+        double* potential, coord::GradCyl* deriv, coord::HessCyl* deriv2) const
+    {
+        double pot1val, pot2val;
+        coord::GradCyl der1, der2;
+        coord::HessCyl hess1, hess2;
+        pot1->eval(pos, potential? &pot1val : NULL, deriv? &der1 : NULL, deriv2? &hess1 : NULL);
+        pot2->eval(pos, potential? &pot2val : NULL, deriv? &der2 : NULL, deriv2? &hess2 : NULL);
+        const double w1 = 1-weight, w2 = weight;
+        if(potential)
+            *potential = w1 * pot1val + w2 * pot2val;
+        if(deriv) {
+            deriv->dR   = w1 * der1.dR   + w2 * der2.dR;
+            deriv->dz   = w1 * der1.dz   + w2 * der2.dz;
+            deriv->dphi = w1 * der1.dphi + w2 * der2.dphi;
+        }
+        if(deriv2) {
+            deriv2->dR2    = w1 * hess1.dR2    + w2 * hess2.dR2;
+            deriv2->dz2    = w1 * hess1.dz2    + w2 * hess2.dz2;
+            deriv2->dphi2  = w1 * hess1.dphi2  + w2 * hess2.dphi2;
+            deriv2->dRdz   = w1 * hess1.dRdz   + w2 * hess2.dRdz;
+            deriv2->dRdphi = w1 * hess1.dRdphi + w2 * hess2.dRdphi;
+            deriv2->dzdphi = w1 * hess1.dzdphi + w2 * hess2.dzdphi;
+        }
+    }
+};
+
+/// check that the array of times is non-empty and strictly increasing
+void checkTimes(const std::vector<double>& times, size_t size)
+{
+    if(times.empty() || times.size() != size)
+        throw std::invalid_argument("Evolving: arrays of times and snapshots must be non-empty "
+            "and have equal length");
+    for(size_t i=0; i<times.size(); i++)
+        if(!isFinite(times[i]) || (i>0 && times[i] <= times[i-1]))
+            throw std::invalid_argument("Evolving: times must be monotonically increasing");
+}
+
+/// read a variable shared between threads that may be concurrently modified by another thread
+template<typename T>
+inline T atomicRead(const T& var)
+{
+    T val;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+    val = var;
+    return val;
+}
+
+/// write a variable shared between threads that may be concurrently read by another thread
+template<typename T>
+inline void atomicWrite(T& var, const T val)
+{
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+    var = val;
+}
+
+}  // internal namespace
+
+Evolving::Evolving(const std::vector<double>& times, const std::vector<PtrPotential>& potentials,
+    bool _interpLinear) :
+    snapshotTimes(times), interpLinear(_interpLinear), maxLoaded(potentials.size()),
+    loaded(potentials), loadedPtr(potentials.size()), ready(potentials.size(), 1),
+    pins(potentials.size(), 0), lastUsed(potentials.size(), 0), useCounter(0)
+{
+    checkTimes(times, potentials.size());
+    for(size_t i=0; i<potentials.size(); i++) {
+        if(!potentials[i])
+            throw std::invalid_argument("Evolving: snapshot potentials must not be empty");
+        loadedPtr[i] = potentials[i].get();
+    }
+}
+
+Evolving::Evolving(const std::vector<double>& times, const std::vector<std::string>& _fileNames,
+    bool _interpLinear, unsigned int _maxLoaded, const units::ExternalUnits& _converter) :
+    snapshotTimes(times), fileNames(_fileNames), interpLinear(_interpLinear),
+    maxLoaded(std::max(_maxLoaded, 2u)), converter(_converter),
+    loaded(_fileNames.size()), loadedPtr(_fileNames.size(), NULL), ready(_fileNames.size(), 0),
+    pins(_fileNames.size(), 0), lastUsed(_fileNames.size(), 0), useCounter(0)
+{
+    checkTimes(times, _fileNames.size());
+}
+
+unsigned int Evolving::locate(double time, double& weight) const
+{
+    int size = snapshotTimes.size();
+    int index = math::binSearch(time, &snapshotTimes[0], size);
+    if(index < 0 || size == 1) {   // before the first snapshot (or NaN)
+        weight = 0;
+        return 0;
+    }
+    if(index >= size-1) {          // at or after the last snapshot
+        weight = 1;
+        return size-2;
+    }
+    weight = interpLinear ?
+        (time - snapshotTimes[index]) / (snapshotTimes[index+1] - snapshotTimes[index]) : 0;
+    return index;
+}
+
+void Evolving::load(unsigned int index) const
+{
+    if(ready[index])
+        return;
+    // discard the least recently used snapshots that are not currently in use, if the limit is reached
+    unsigned int numLoaded = 0;
+    for(size_t i=0; i<loaded.size(); i++)
+        numLoaded += ready[i];
+    std::vector<bool> inUse(loaded.size(), false);
+    while(numLoaded >= maxLoaded) {
+        size_t oldest = loaded.size();
+        for(size_t i=0; i<loaded.size(); i++)
+            if(ready[i] && !inUse[i] &&
+                (oldest == loaded.size() || atomicRead(lastUsed[i]) < atomicRead(lastUsed[oldest])))
+                oldest = i;
+        if(oldest == loaded.size())
+            break;   // all loaded snapshots are in use: temporarily exceed the limit
+        // retract the flag first, and then check that no thread has started using this snapshot
+        // (a thread first increments the counter and then checks the flag, so at least one of
+        // the two parties sees the change made by the other one)
+        atomicWrite(ready[oldest], 0);
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+        if(atomicRead(pins[oldest]) > 0) {
+            atomicWrite(ready[oldest], 1);
+            inUse[oldest] = true;
+            continue;
+        }
+        loadedPtr[oldest] = NULL;
+        loaded[oldest].reset();
+        numLoaded--;
+    }
+    utils::msg(utils::VL_DEBUG, "Evolving",
+        "Loading snapshot #" + utils::toString(index) + " from " + fileNames[index]);
+    loaded[index] = readPotential(fileNames[index], converter);
+    loadedPtr[index] = loaded[index].get();
+    atomicWrite(useCounter, useCounter+1);
+    atomicWrite(lastUsed[index], useCounter);
+    // publish the pointer before raising the flag
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+    atomicWrite(ready[index], 1);
+}
+
+const BasePotential& Evolving::acquire(unsigned int index) const
+{
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+    pins[index]++;
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+    if(!atomicRead(ready[index])) {
+        // slow path: load the snapshot, serializing the access to the cache
+        // (exceptions must not escape the critical section, so are caught and rethrown afterwards)
+        std::string error;
+#ifdef _OPENMP
+#pragma omp critical(EvolvingPotentialCache)
+#endif
+        {
+            try{
+                load(index);
+            }
+            catch(std::exception& e) {
+                error = e.what();
+            }
+        }
+        if(!error.empty()) {
+            release(index);
+            throw std::runtime_error("Evolving: cannot load snapshot #" + utils::toString(index) +
+                ": " + error);
+        }
+    }
+    // the snapshot is in memory and cannot be discarded while in use
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+    atomicWrite(lastUsed[index], atomicRead(useCounter));
+    return *loadedPtr[index];
+}
+
+void Evolving::release(unsigned int index) const
+{
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+    pins[index]--;
+}
+
+PtrPotential Evolving::getSnapshot(unsigned int index) const
+{
+    PtrPotential result;
+    std::string error;
+#ifdef _OPENMP
+#pragma omp critical(EvolvingPotentialCache)
+#endif
+    {
+        try{
+            load(index);
+            result = loaded[index];
+        }
+        catch(std::exception& e) {
+            error = e.what();
+        }
+    }
+    if(!result)
+        throw std::runtime_error("Evolving: cannot load snapshot #" + utils::toString(index) +
+            ": " + error);
+    return result;
+}
+
+struct Evolving::SnapshotPin {
+    const Evolving& evol;
+    const unsigned int index;
+    const BasePotential& pot;
+    SnapshotPin(const Evolving& _evol, unsigned int _index) :
+        evol(_evol), index(_index), pot(evol.acquire(index)) {}
+    ~SnapshotPin() { evol.release(index); }
+};
+
+void Evolving::eval(double time, const coord::PosCar& pos,
+    double* potential, coord::GradCar* deriv, coord::HessCar* deriv2) const
+{
+    double weight;
+    unsigned int index = locate(time, weight);
+    if(weight == 0 || weight == 1) {   // only one snapshot is needed
+        SnapshotPin snap(*this, weight == 0 ? index : index+1);
+        snap.pot.eval(pos, potential, deriv, deriv2);
+        return;
+    }
+    double pot1, pot2;
+    coord::GradCar der1, der2;
+    coord::HessCar hess1, hess2;
+    SnapshotPin snap1(*this, index), snap2(*this, index+1);
+    snap1.pot.eval(pos, potential? &pot1 : NULL, deriv? &der1 : NULL, deriv2? &hess1 : NULL);
+    snap2.pot.eval(pos, potential? &pot2 : NULL, deriv? &der2 : NULL, deriv2? &hess2 : NULL);
+    const double w1 = 1-weight, w2 = weight;
+    if(potential)
+        *potential = w1 * pot1 + w2 * pot2;
+    if(deriv) {
+        deriv->dx = w1 * der1.dx + w2 * der2.dx;
+        deriv->dy = w1 * der1.dy + w2 * der2.dy;
+        deriv->dz = w1 * der1.dz + w2 * der2.dz;
+    }
+    if(deriv2) {
+        deriv2->dx2  = w1 * hess1.dx2  + w2 * hess2.dx2;
+        deriv2->dy2  = w1 * hess1.dy2  + w2 * hess2.dy2;
+        deriv2->dz2  = w1 * hess1.dz2  + w2 * hess2.dz2;
+        deriv2->dxdy = w1 * hess1.dxdy + w2 * hess2.dxdy;
+        deriv2->dydz = w1 * hess1.dydz + w2 * hess2.dydz;
+        deriv2->dxdz = w1 * hess1.dxdz + w2 * hess2.dxdz;
+    }
+}
+
+PtrPotential Evolving::snapshot(double time) const
+{
+    double weight;
+    unsigned int index = locate(time, weight);
+    if(weight == 0 || weight == 1)
+        return getSnapshot(weight == 0 ? index : index+1);
+    return PtrPotential(new InterpolatedSnapshot(getSnapshot(index), getSnapshot(index+1), weight));
+}
+
+}  // namespace potential
@@ -0,0 +1,119 @@
+/** \file    potential_evolving.h
+    \brief   Time-dependent potential represented by a sequence of snapshots
+    \date    2026
+
+    This module provides a potential that changes with time, represented by a series of
+    static potentials (typically Multipole or CylSpline expansions constructed from successive
+    snapshots of an N-body simulation) taken at given moments of time.
+    The potential at an arbitrary time is linearly interpolated between the two snapshots
+    bracketing this time; since the expansions are linear in their coefficients, this is equivalent
+    to the linear interpolation of coefficients (up to the nonlinear scaling used internally in
+    the spline interpolators, i.e. at the level of interpolation errors), but avoids constructing
+    a new expansion at every timestep of orbit integration.
+    The snapshots may be provided as potential objects, or as names of coefficient files
+    (as written by `writePotential`) which are loaded only when needed: at any time, at most
+    a fixed number of most recently used snapshots are kept in memory.
+    Orbits are integrated in this potential using `orbit::OrbitIntegratorEvolving`,
+    which passes the time argument of the ODE system to the potential.
+*/
+#pragma once
+#include "potential_base.h"
+#include "units.h"
+#include "smart.h"
+#include <vector>
+#include <string>
+
+namespace potential{
+
+/** Time-dependent potential given by a series of snapshots, interpolated in time.
+    Since its evaluation requires the time argument, this class is not derived from BasePotential;
+    instead, the method `snapshot()` returns an ordinary potential object representing
+    the instantaneous potential at the given time, which may be used in any static context.
+    Outside the time interval covered by snapshots, the first or the last snapshot is used.
+    All methods are thread-safe: snapshots that are already in memory are accessed without locking,
+    and only the lazy loading or discarding of snapshots is serialized internally.
+*/
+class Evolving {
+public:
+    /** Construct the time-dependent potential from an array of snapshots held in memory.
+        \param[in]  times  is the array of times of snapshots, must be sorted in increasing order;
+        \param[in]  potentials  is the array of potentials of the same length;
+        \param[in]  interpLinear  determines whether the potential is linearly interpolated
+        between snapshots (true) or taken from the last snapshot preceding the given time (false);
+        \throw std::invalid_argument if the arrays are empty, have different lengths,
+        or the times are not monotonic.
+    */
+    Evolving(const std::vector<double>& times, const std::vector<PtrPotential>& potentials,
+        bool interpLinear=true);
+
+    /** Construct the time-dependent potential from a series of coefficient files,
+        which are loaded on demand when the potential at the corresponding time is needed.
+        \param[in]  times  is the array of times of snapshots, sorted in increasing order;
+        \param[in]  fileNames  is the array of file names with potential coefficients;
+        \param[in]  interpLinear  determines the interpolation in time (see above);
+        \param[in]  maxLoaded  is the maximum number of snapshots simultaneously kept in memory
+        (at least two, to accommodate the snapshots bracketing the current time);
+        when a new snapshot needs to be loaded, the least recently used one is discarded
+        (unless all of them are being used by other threads at that moment, in which case
+        the limit is temporarily exceeded);
+        \param[in]  converter  is the unit converter passed to `readPotential()`.
+    */
+    Evolving(const std::vector<double>& times, const std::vector<std::string>& fileNames,
+        bool interpLinear=true, unsigned int maxLoaded=4,
+        const units::ExternalUnits& converter = units::ExternalUnits());
+
+    /** Evaluate the potential and up to two its derivatives at the given time and position
+        in cartesian coordinates; any of the output arguments may be NULL if not needed. */
+    void eval(double time, const coord::PosCar& pos,
+        double* potential=NULL, coord::GradCar* deriv=NULL, coord::HessCar* deriv2=NULL) const;
+
+    /** Return the instantaneous potential at the given time: either one of the snapshots,
+        or a weighted combination of the two snapshots bracketing this time. */
+    PtrPotential snapshot(double time) const;
+
+    /// return the array of times of snapshots
+    const std::vector<double>& times() const { return snapshotTimes; }
+
+    /// return the number of snapshots
+    unsigned int size() const { return snapshotTimes.size(); }
+
+private:
+    std::vector<double> snapshotTimes;     ///< times of snapshots
+    std::vector<std::string> fileNames;    ///< file names of snapshots (empty if all are preloaded)
+    const bool interpLinear;               ///< whether to interpolate linearly between snapshots
+    const unsigned int maxLoaded;          ///< max number of simultaneously loaded snapshots
+    const units::ExternalUnits converter;  ///< unit converter for loading the snapshots
+    /// snapshots currently held in memory (modified only inside the critical section)
+    mutable std::vector<PtrPotential> loaded;
+    /// raw pointers to the loaded snapshots, valid while the corresponding flag `ready` is set
+    mutable std::vector<const BasePotential*> loadedPtr;
+    /// flags indicating that the snapshot is loaded, set after the pointer has been assigned
+    mutable std::vector<int> ready;
+    /// number of threads currently using each snapshot (those with nonzero count are not discarded)
+    mutable std::vector<int> pins;
+    mutable std::vector<unsigned long> lastUsed;  ///< counter value at the last access to each snapshot
+    mutable unsigned long useCounter;      ///< incremented each time a snapshot is loaded
+
+    /// return the index of the snapshot preceding the given time and the weight of the next one
+    unsigned int locate(double time, double& weight) const;
+
+    /// load the snapshot with the given index if it is not yet in memory,
+    /// discarding the least recently used ones if needed (called only inside the critical section)
+    void load(unsigned int index) const;
+
+    /// return the snapshot with the given index, loading it if necessary, and mark it as used
+    /// by the current thread, so that it stays in memory until the matching call to `release()`;
+    /// in the common case that the snapshot is already loaded, no locking is involved
+    const BasePotential& acquire(unsigned int index) const;
+
+    /// unmark the snapshot previously obtained with `acquire()`
+    void release(unsigned int index) const;
+
+    /// return a shared pointer to the snapshot with the given index, loading it if necessary
+    PtrPotential getSnapshot(unsigned int index) const;
+
+    /// helper object that acquires a snapshot in the constructor and releases it in the destructor
+    struct SnapshotPin;
+};
+
+}  // namespace potential
@@ -17,6 +17,9 @@
 #include <stdexcept>
 #include <fstream>
 #include <map>
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
 
 namespace potential {
 
@@ -94,6 +97,8 @@ struct ConfigPotential
     unsigned int lmax;       ///< number of angular terms in spherical-harmonic expansion
     unsigned int mmax;       ///< number of angular terms in azimuthal-harmonic expansion
     double smoothing;        ///< amount of smoothing in Multipole initialized from an N-body snapshot
+    bool exact;              ///< whether to avoid internal interpolation in analytic potentials (Dehnen)
+    bool useFFT;             ///< whether to use the Hankel-transform Poisson solver in CylSpline
     std::string file;        ///< name of file with coordinates of points, or coefficients of expansion
     /// default constructor initializes the fields to some reasonable values
     ConfigPotential() :
@@ -101,7 +106,7 @@ struct ConfigPotential
         mass(1.), scaleRadius(1.), scaleRadius2(1.),
         axisRatioY(1.), axisRatioZ(1.), gamma(1.),
         gridSizeR(25), gridSizez(25), rmin(0), rmax(0), zmin(0), zmax(0),
-        lmax(6), mmax(6), smoothing(1.)
+        lmax(6), mmax(6), smoothing(1.), exact(true), useFFT(false)
     {};
 };
 
@@ -289,6 +294,8 @@ ConfigPotential parseParams(const utils::KeyValueMap& params, const units::Exter
     config.lmax        = params.getInt("lmax", config.lmax);
     config.mmax        = params.contains("mmax") ? params.getInt("mmax", config.mmax) : config.lmax;
     config.smoothing   = params.getDouble("smoothing", config.smoothing);
+    config.exact       = params.getBool("exact", config.exact);
+    config.useFFT      = params.getBool("useFFT", config.useFFT);
     return config;
 }
 
@@ -683,7 +690,8 @@ namespace {
 template<bool MULTIPOLE_INDEXING_ORDER>
 void writeSphericalHarmonics(std::ostream& strm,
     const std::vector<double> &radii,
-    const std::vector< std::vector<double> > &coefs)
+    const std::vector< std::vector<double> > &coefs,
+    const unsigned int width)
 {
     assert(coefs.size()>0);
     int lmax = static_cast<int>(sqrt((MULTIPOLE_INDEXING_ORDER ? coefs.size() : coefs[0].size()) * 1.0)-1);
@@ -692,13 +700,13 @@ void writeSphericalHarmonics(std::ostream& strm,
             strm << "\tl="<<l<<",m="<<m;  // header line
     strm << '\n';
     for(unsigned int n=0; n<radii.size(); n++) {
-        strm << utils::pp(radii[n], 15);
+        strm << utils::pp(radii[n], width);
         if(MULTIPOLE_INDEXING_ORDER) {
             for(unsigned int i=0; i<coefs.size(); i++)
-                strm << '\t' + (n>=coefs[i].size() || coefs[i][n] == 0 ? "0" : utils::pp(coefs[i][n], 15));
+                strm << '\t' + (n>=coefs[i].size() || coefs[i][n] == 0 ? "0" : utils::pp(coefs[i][n], width));
         } else {
             for(unsigned int i=0; i<coefs[n].size(); i++)
-                strm << '\t' + (coefs[n][i] == 0 ? "0" : utils::pp(coefs[n][i], 15));
+                strm << '\t' + (coefs[n][i] == 0 ? "0" : utils::pp(coefs[n][i], width));
         }
         strm << '\n';
     }
@@ -707,7 +715,8 @@ void writeSphericalHarmonics(std::ostream& strm,
 void writeAzimuthalHarmonics(std::ostream& strm,
     const std::vector<double>& gridR,
     const std::vector<double>& gridz,
-    const std::vector< math::Matrix<double> >& data)
+    const std::vector< math::Matrix<double> >& data,
+    const unsigned int width)
 {
     int mmax = (static_cast<int>(data.size())-1)/2;
     assert(mmax>=0);
@@ -715,19 +724,19 @@ void writeAzimuthalHarmonics(std::ostream& strm,
         if(data[mm].rows()*data[mm].cols()>0) {
             strm << (-mmax+mm) << "\t#m\n#z(row)\\R(col)";
             for(unsigned int iR=0; iR<gridR.size(); iR++)
-                strm << "\t" + utils::pp(gridR[iR], 15);
+                strm << "\t" + utils::pp(gridR[iR], width);
             strm << "\n";
             for(unsigned int iz=0; iz<gridz.size(); iz++) {
-                strm << utils::pp(gridz[iz], 15);
+                strm << utils::pp(gridz[iz], width);
                 for(unsigned int iR=0; iR<gridR.size(); iR++)
-                    strm << "\t"  + utils::pp(data[mm](iR, iz), 15);
+                    strm << "\t"  + utils::pp(data[mm](iR, iz), width);
                 strm << "\n";
             }
         }
 }
     
 void writePotentialBSE(std::ostream& strm, const BasisSetExp& potBSE,
-    const units::ExternalUnits& converter)
+    const units::ExternalUnits& converter, const unsigned int width)
 {
     std::vector<double> indices;
     std::vector< std::vector<double> > coefs;
@@ -744,11 +753,11 @@ void writePotentialBSE(std::ostream& strm, const BasisSetExp& potBSE,
         (potBSE.getNumCoefsRadial()+1) << "\t#n_radial\n" << 
         lmax << "\t#l_max\n" << 
         potBSE.getAlpha() <<"\t#alpha\n#Phi\n#index";
-    writeSphericalHarmonics<false>(strm, indices, coefs);
+    writeSphericalHarmonics<false>(strm, indices, coefs, width);
 }
 
 void writePotentialSpline(std::ostream& strm, const SplineExp& potSpline,
-    const units::ExternalUnits& converter)
+    const units::ExternalUnits& converter, const unsigned int width)
 {
     std::vector<double> radii;
     std::vector< std::vector<double> > coefs;
@@ -765,11 +774,11 @@ void writePotentialSpline(std::ostream& strm, const SplineExp& potSpline,
         (potSpline.getNumCoefsRadial()+1) << "\t#n_radial\n" << 
         lmax << "\t#l_max\n" <<
         0 <<"\t#unused\n#Phi\n#radius";
-    writeSphericalHarmonics<false>(strm, radii, coefs);
+    writeSphericalHarmonics<false>(strm, radii, coefs, width);
 }
 
 void writePotentialMultipole(std::ostream& strm, const Multipole& potMul,
-    const units::ExternalUnits& converter)
+    const units::ExternalUnits& converter, const unsigned int width)
 {
     std::vector<double> radii;
     std::vector< std::vector<double> > Phi, dPhi;
@@ -785,13 +794,13 @@ void writePotentialMultipole(std::ostream& strm, const Multipole& potMul,
     strm << Multipole::myName() << "\n" << 
         radii.size() << "\t#n_radial\n" << 
         lmax << "\t#l_max\n0\t#unused\n#Phi\n#radius";
-    writeSphericalHarmonics<true>(strm, radii, Phi);
+    writeSphericalHarmonics<true>(strm, radii, Phi, width);
     strm << "\n#dPhi/dr\n#radius";
-    writeSphericalHarmonics<true>(strm, radii, dPhi);
+    writeSphericalHarmonics<true>(strm, radii, dPhi, width);
 }
 
 void writePotentialCylSpline(std::ostream& strm, const CylSpline& potential,
-    const units::ExternalUnits& converter)
+    const units::ExternalUnits& converter, const unsigned int width)
 {
     std::vector<double> gridR, gridz;
     std::vector<math::Matrix<double> > Phi, dPhidR, dPhidz;
@@ -810,15 +819,15 @@ void writePotentialCylSpline(std::ostream& strm, const CylSpline& potential,
         gridz.size() << "\t#size_z\n" <<
         mmax << "\t#m_max\n";
     strm << "#Phi\n";
-    writeAzimuthalHarmonics(strm, gridR, gridz, Phi);
+    writeAzimuthalHarmonics(strm, gridR, gridz, Phi, width);
     strm << "\n#dPhi/dR\n";
-    writeAzimuthalHarmonics(strm, gridR, gridz, dPhidR);
+    writeAzimuthalHarmonics(strm, gridR, gridz, dPhidR, width);
     strm << "\n#dPhi/dz\n";
-    writeAzimuthalHarmonics(strm, gridR, gridz, dPhidz);
+    writeAzimuthalHarmonics(strm, gridR, gridz, dPhidz, width);
 }
 
 void writeDensitySphericalHarmonic(std::ostream& strm, const DensitySphericalHarmonic& density,
-    const units::ExternalUnits& converter)
+    const units::ExternalUnits& converter, const unsigned int width)
 {
     std::vector<double> radii;
     std::vector<std::vector<double> > coefs;
@@ -831,11 +840,11 @@ void writeDensitySphericalHarmonic(std::ostream& strm, const DensitySphericalHar
     strm << DensitySphericalHarmonic::myName() << "\n" <<
         radii.size() << "\t#n_radial\n" << 
         lmax << "\t#l_max\n0\t#unused\n#rho\n#radius";
-    writeSphericalHarmonics<true>(strm, radii, coefs);
+    writeSphericalHarmonics<true>(strm, radii, coefs, width);
 }
 
 void writeDensityAzimuthalHarmonic(std::ostream& strm, const DensityAzimuthalHarmonic& density,
-    const units::ExternalUnits& converter)
+    const units::ExternalUnits& converter, const unsigned int width)
 {
     std::vector<double> gridR, gridz;
     std::vector<math::Matrix<double> > coefs;
@@ -851,13 +860,19 @@ void writeDensityAzimuthalHarmonic(std::ostream& strm, const DensityAzimuthalHar
         gridz.size() << "\t#size_z\n" <<
         mmax << "\t#m_max\n";
         strm << "#rho\n";
-    writeAzimuthalHarmonics(strm, gridR, gridz, coefs);
+    writeAzimuthalHarmonics(strm, gridR, gridz, coefs, width);
 }
 
-} // end internal namespace
+/// number of characters used to write each value in the coefficient files by default
+static const unsigned int COEF_WIDTH = 15;
 
-bool writeDensity(const std::string& fileName, const BaseDensity& dens,
-    const units::ExternalUnits& converter)
+/// number of characters sufficient to represent any double value exactly (at least 17 digits)
+static const unsigned int COEF_WIDTH_EXACT = 24;
+
+/// write the coefficients of the density or potential expansion with the given precision
+/// (number of characters per value)
+bool writeDensityWithWidth(const std::string& fileName, const BaseDensity& dens,
+    const units::ExternalUnits& converter, const unsigned int width)
 {
     if(fileName.empty())
         return false;
@@ -869,22 +884,22 @@ bool writeDensity(const std::string& fileName, const BaseDensity& dens,
         type = getDensityTypeByName(dens.name());
     switch(type) {
     case PT_BSE:
-        writePotentialBSE(strm, dynamic_cast<const BasisSetExp&>(dens), converter);
+        writePotentialBSE(strm, dynamic_cast<const BasisSetExp&>(dens), converter, width);
         break;
     case PT_SPLINE:
-        writePotentialSpline(strm, dynamic_cast<const SplineExp&>(dens), converter);
+        writePotentialSpline(strm, dynamic_cast<const SplineExp&>(dens), converter, width);
         break;
     case PT_MULTIPOLE:
-        writePotentialMultipole(strm, dynamic_cast<const Multipole&>(dens), converter);
+        writePotentialMultipole(strm, dynamic_cast<const Multipole&>(dens), converter, width);
         break;
     case PT_CYLSPLINE:
-        writePotentialCylSpline(strm, dynamic_cast<const CylSpline&>(dens), converter);
+        writePotentialCylSpline(strm, dynamic_cast<const CylSpline&>(dens), converter, width);
         break;
     case PT_DENS_CYLGRID:
-        writeDensityAzimuthalHarmonic(strm, dynamic_cast<const DensityAzimuthalHarmonic&>(dens), converter);
+        writeDensityAzimuthalHarmonic(strm, dynamic_cast<const DensityAzimuthalHarmonic&>(dens), converter, width);
         break;
     case PT_DENS_SPHHARM:
-        writeDensitySphericalHarmonic(strm, dynamic_cast<const DensitySphericalHarmonic&>(dens), converter);
+        writeDensitySphericalHarmonic(strm, dynamic_cast<const DensitySphericalHarmonic&>(dens), converter, width);
         break;
     case PT_COMPOSITE: {  // could be either composite density or composite potential
         strm << dens.name() << "\n";
@@ -908,7 +923,7 @@ bool writeDensity(const std::string& fileName, const BaseDensity& dens,
                 dens = compPot->component(i).get();
             assert(dens);
             std::string fileNameComp = fileName+'_'+utils::toString(i);
-            if(writeDensity(fileNameComp, *dens, converter))
+            if(writeDensityWithWidth(fileNameComp, *dens, converter, width))
                 strm << fileNameComp << '\n';
         }
         break;
@@ -920,6 +935,14 @@ bool writeDensity(const std::string& fileName, const BaseDensity& dens,
     return strm.good();
 }
 
+} // end internal namespace
+
+bool writeDensity(const std::string& fileName, const BaseDensity& dens,
+    const units::ExternalUnits& converter)
+{
+    return writeDensityWithWidth(fileName, dens, converter, COEF_WIDTH);
+}
+
 ///@}
 /// \name Legacy interface for loading GalPot parameters from a text file (deprecated)
 //        ----------------------------------------------------------------------------
@@ -1078,7 +1101,8 @@ PtrPotential createAnalyticPotential(const ConfigPotential& params)
         return PtrPotential(new MiyamotoNagai(params.mass, params.scaleRadius, params.scaleRadius2));
     case PT_DEHNEN:
         return PtrPotential(new Dehnen(
-            params.mass, params.scaleRadius, params.gamma, params.axisRatioY, params.axisRatioZ));
+            params.mass, params.scaleRadius, params.gamma, params.axisRatioY, params.axisRatioZ,
+            params.exact));
     case PT_FERRERS:
         return PtrPotential(new Ferrers(
             params.mass, params.scaleRadius, params.axisRatioY, params.axisRatioZ)); 
@@ -1108,6 +1132,21 @@ PtrPotential createAnalyticPotential(const ConfigPotential& params)
     }
 }
 
+// CylSpline constructed from a density model may use an alternative Poisson solver
+inline PtrPotential createCylSpline(const ConfigPotential& params, const BaseDensity& source)
+{
+    return CylSpline::create(source, params.mmax,
+        params.gridSizeR, params.rmin, params.rmax,
+        params.gridSizez, params.zmin, params.zmax, /*useDerivs*/ true, params.useFFT);
+}
+
+inline PtrPotential createCylSpline(const ConfigPotential& params, const BasePotential& source)
+{
+    return CylSpline::create(source, params.mmax,
+        params.gridSizeR, params.rmin, params.rmax,
+        params.gridSizez, params.zmin, params.zmax);
+}
+
 /** Create an instance of potential expansion class according to the parameters passed in params,
     for the provided source density or potential
     (template parameter SourceType==BaseDensity or BasePotential) */
@@ -1125,9 +1164,7 @@ PtrPotential createPotentialExpansion(const ConfigPotential& params, const Sourc
             params.rmin, params.rmax));
     }
     case PT_CYLSPLINE: {
-        return CylSpline::create(source, params.mmax,
-            params.gridSizeR, params.rmin, params.rmax,
-            params.gridSizez, params.zmin, params.zmax);
+        return createCylSpline(params, source);
     }
     case PT_MULTIPOLE: {
         return Multipole::create(source, params.lmax, params.mmax,
@@ -1143,6 +1180,80 @@ inline bool isPotentialExpansion(PotentialType type)
     return type == PT_SPLINE || type == PT_BSE || type == PT_CYLSPLINE || type == PT_MULTIPOLE;
 }
 
+/// \name On-disk cache of potential expansions constructed from analytic density profiles
+///@{
+
+/// identifier included in the cache keys: it must be incremented whenever the construction
+/// of potential expansions changes, so that the previously cached potentials are not used
+static const char* CACHE_VERSION = "Potential v1";
+
+/** Canonical representation of the parameters in a key-value map, which does not depend
+    on the order of parameters or the case of their names (but does depend on the formatting
+    of values, e.g. "1" and "1.0" are considered different) */
+std::string canonicalParams(const utils::KeyValueMap& kvmap)
+{
+    std::vector<std::string> keys = kvmap.keys();
+    for(size_t i=0; i<keys.size(); i++)
+        std::transform(keys[i].begin(), keys[i].end(), keys[i].begin(), ::tolower);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::string result;
+    for(size_t i=0; i<keys.size(); i++)
+        result += keys[i] + '=' + kvmap.getString(keys[i]) + '\n';
+    return result;
+}
+
+/// the part of the cache key describing the unit conversion
+std::string canonicalUnits(const units::ExternalUnits& converter)
+{
+    return "units=" +
+        utils::toString(converter.lengthUnit, 17) + ',' +
+        utils::toString(converter.velocityUnit, 17) + ',' +
+        utils::toString(converter.massUnit, 17) + '\n';
+}
+
+/// load the potential from a cache file if it exists, otherwise return an empty pointer
+PtrPotential readCachedPotential(const std::string& cacheFile)
+{
+    if(cacheFile.empty() || !utils::fileExists(cacheFile))
+        return PtrPotential();
+    try{
+        PtrPotential pot = readPotential(cacheFile);
+        utils::msg(utils::VL_DEBUG, "createPotential", "Loaded "+std::string(pot->name())+" from "+cacheFile);
+        return pot;
+    }
+    catch(std::exception& e) {  // a corrupted file will be overwritten
+        utils::msg(utils::VL_WARNING, "createPotential",
+            "Cannot read cached potential from "+cacheFile+": "+e.what());
+        return PtrPotential();
+    }
+}
+
+/** store the potential in the cache file and return the copy read back from this file,
+    so that the results do not depend on whether the cache was used or not.
+    The coefficients are written with enough digits to be restored exactly, so that the copy
+    differs from the original potential only by round-off errors in the internal scaling
+    of coordinates (~1e-12 relative).
+    The file is first written under a temporary name and then renamed,
+    so that concurrent processes never see an incomplete file */
+PtrPotential writeCachedPotential(const std::string& cacheFile, const PtrPotential& pot)
+{
+    if(cacheFile.empty())
+        return pot;
+    std::string tmpFile = cacheFile + '.' + utils::toString((long)getpid()) +
+        '.' + utils::toString(pot.get()) + ".tmp";
+    if(!writeDensityWithWidth(tmpFile, *pot, units::ExternalUnits(), COEF_WIDTH_EXACT) ||
+        std::rename(tmpFile.c_str(), cacheFile.c_str()) != 0) {
+        utils::msg(utils::VL_WARNING, "createPotential", "Cannot write cache file "+cacheFile);
+        std::remove(tmpFile.c_str());
+        return pot;
+    }
+    PtrPotential cached = readCachedPotential(cacheFile);
+    return cached ? cached : pot;
+}
+
+///@}
+
 /** Universal routine for creating any elementary (non-composite) potential,
     either an analytic one or a potential expansion constructed from a density model
     or loaded from a text file.
@@ -1181,6 +1292,13 @@ PtrPotential createAnyPotential(const utils::KeyValueMap& kvmap,
     if(params.potentialType == PT_UNKNOWN)
         throw std::runtime_error("Must specify the potential type");
     if(isPotentialExpansion(params.potentialType)) {
+        // check if the same potential has already been constructed and stored in the cache
+        const std::string cacheFile = utils::getCacheFileName(
+            CACHE_VERSION + ('\n' + canonicalParams(kvmap) + canonicalUnits(converter)),
+            getCoefFileExtension(params.potentialType));
+        PtrPotential poten = readCachedPotential(cacheFile);
+        if(poten)
+            return poten;
         // create a temporary density or potential model
         // to serve as the source for potential expansion
         if( params.densityType == PT_DEHNEN || 
@@ -1189,10 +1307,11 @@ PtrPotential createAnyPotential(const utils::KeyValueMap& kvmap,
         {   // use an analytic potential as the source
             ConfigPotential potparams(params);
             potparams.potentialType  = params.densityType;
-            return createPotentialExpansion(params, *createAnalyticPotential(potparams));
-        }
-        // otherwise use analytic density as the source
-        return createPotentialExpansion(params, *createDensity(kvmap, converter));
+            potparams.exact = true;  // no point in expanding an interpolated potential
+            poten = createPotentialExpansion(params, *createAnalyticPotential(potparams));
+        } else  // otherwise use analytic density as the source
+            poten = createPotentialExpansion(params, *createDensity(kvmap, converter));
+        return writeCachedPotential(cacheFile, poten);
     } else  // elementary potential, or an error
         return createAnalyticPotential(params);
 }
@@ -1228,6 +1347,8 @@ PtrPotential createPotential(
     std::vector<PtrPotential> componentsPot;
     // all density components that will contribute to the additional Multipole potential
     std::vector<PtrDensity> componentsDens;
+    // key for the on-disk cache of this Multipole potential
+    std::string cacheKey = CACHE_VERSION + std::string("\nGalPot\n") + canonicalUnits(converter);
 
     // assemble the set of density components for the multipole
     // (all spheroids and residual part of disks),
@@ -1241,6 +1362,7 @@ PtrPotential createPotential(
         // SpheroidDensity and SersicDensity profiles will also be added to the Multipole
         if(utils::stringsEqual(type, DiskDensity::myName())) {
             DiskParam dpar = parseDiskParams(kvmap[i], converter);
+            cacheKey += canonicalParams(kvmap[i]);
             if(dpar.surfaceDensity != 0) {
                 // the two parts of disk profile: DiskAnsatz goes to the list of potentials...
                 componentsPot.push_back(PtrPotential(new DiskAnsatz(dpar)));
@@ -1250,9 +1372,11 @@ PtrPotential createPotential(
                 componentsDens.push_back(PtrDensity(new DiskAnsatz(dpar)));
             }
         } else if(utils::stringsEqual(type, SpheroidDensity::myName())) {
+            cacheKey += canonicalParams(kvmap[i]);
             componentsDens.push_back(PtrDensity(
                 new SpheroidDensity(parseSphrParams(kvmap[i], converter))));
         } else if(utils::stringsEqual(type, SersicParam::myName())) {
+            cacheKey += canonicalParams(kvmap[i]);
             componentsDens.push_back(PtrDensity(
                 new SpheroidDensity(parseSersicParams(kvmap[i], converter))));
         } else {
@@ -1260,16 +1384,22 @@ PtrPotential createPotential(
         }
     }
 
-    // create an additional Multipole potential if needed
+    // create an additional Multipole potential if needed, or load it from the cache
     if(!componentsDens.empty()) {
-        PtrDensity totalDens;
-        if(componentsDens.size() == 1)
-            totalDens = componentsDens[0];
-        else
-            totalDens.reset(new CompositeDensity(componentsDens));
-        componentsPot.push_back(Multipole::create(*totalDens,
-            isSpherical   (*totalDens) ? 0 : GALPOT_LMAX,
-            isAxisymmetric(*totalDens) ? 0 : GALPOT_MMAX, GALPOT_NRAD));
+        const std::string cacheFile = utils::getCacheFileName(cacheKey,
+            getCoefFileExtension(PT_MULTIPOLE));
+        PtrPotential mul = readCachedPotential(cacheFile);
+        if(!mul) {
+            PtrDensity totalDens;
+            if(componentsDens.size() == 1)
+                totalDens = componentsDens[0];
+            else
+                totalDens.reset(new CompositeDensity(componentsDens));
+            mul = writeCachedPotential(cacheFile, Multipole::create(*totalDens,
+                isSpherical   (*totalDens) ? 0 : GALPOT_LMAX,
+                isAxisymmetric(*totalDens) ? 0 : GALPOT_MMAX, GALPOT_NRAD));
+        }
+        componentsPot.push_back(mul);
     }
 
     assert(componentsPot.size()>0);
@@ -1326,5 +1456,177 @@ PtrPotential createPotential(const utils::KeyValueMap& params,
     return createPotentialFromParticles(parseParams(params, converter), particles);
 }
 
+///@}
+/// \name Merging the components of a composite potential
+//        -----------------------------------------------
+///@{
+
+namespace {
+
+/// append the components of a potential to the list, expanding nested composite potentials
+void flattenComposite(const PtrPotential& pot, std::vector<PtrPotential>& list)
+{
+    if(pot->name() == CompositeCyl::myName()) {
+        const CompositeCyl& comp = dynamic_cast<const CompositeCyl&>(*pot);
+        for(unsigned int i=0; i<comp.size(); i++)
+            flattenComposite(comp.component(i), list);
+    } else
+        list.push_back(pot);
+}
+
+/// add the array src to the array dest, extending dest with zeros if it is shorter
+void addCoefs(const std::vector<double>& src, std::vector<double>& dest)
+{
+    if(dest.size() < src.size())
+        dest.resize(src.size(), 0.);
+    for(size_t i=0; i<src.size(); i++)
+        dest[i] += src[i];
+}
+
+/// add the matrix src to the matrix dest, which may be empty (then it is replaced by src)
+void addCoefs(const math::Matrix<double>& src, math::Matrix<double>& dest)
+{
+    if(src.size() == 0)
+        return;
+    if(dest.size() == 0) {
+        dest = src;
+        return;
+    }
+    assert(src.rows() == dest.rows() && src.cols() == dest.cols());
+    const double* s = src.data();
+    double* d = dest.data();
+    for(size_t i=0, size=src.size(); i<size; i++)
+        d[i] += s[i];
+}
+
+/// check if two grids coincide (up to roundoff errors in their reconstruction from scaled coordinates)
+bool sameGrid(const std::vector<double>& grid1, const std::vector<double>& grid2)
+{
+    if(grid1.size() != grid2.size())
+        return false;
+    for(size_t i=0; i<grid1.size(); i++)
+        if(fabs(grid1[i] - grid2[i]) > 1e-12 * fmax(fabs(grid1[i]), fabs(grid2[i])))
+            return false;
+    return true;
+}
+
+/// coefficients of Multipole expansions that share the same radial grid
+struct MultipoleGroup {
+    size_t index;   ///< index of the merged potential in the output list
+    unsigned int count;  ///< number of merged potentials
+    std::vector<double> radii;
+    std::vector<std::vector<double> > Phi, dPhi;
+};
+
+/// coefficients of CylSpline expansions that share the same grid in (R,z)
+struct CylSplineGroup {
+    size_t index;   ///< index of the merged potential in the output list
+    unsigned int count;  ///< number of merged potentials
+    std::vector<double> gridR, gridz;
+    std::vector<math::Matrix<double> > Phi, dPhidR, dPhidz;
+};
+
+}  // internal namespace
+
+PtrPotential compilePotential(const PtrPotential& potential, bool compact)
+{
+    std::vector<PtrPotential> components, result;
+    flattenComposite(potential, components);
+    std::vector<math::PtrFunction> diskRadialFncs, diskVerticalFncs;
+    size_t diskIndex = 0;
+    std::vector<MultipoleGroup> groupsMul;
+    std::vector<CylSplineGroup> groupsCyl;
+    for(size_t c=0; c<components.size(); c++) {
+        const std::string name = components[c]->name();
+        if(name == DiskAnsatz::myName()) {
+            const DiskAnsatz& disk = dynamic_cast<const DiskAnsatz&>(*components[c]);
+            if(diskRadialFncs.empty()) {
+                diskIndex = result.size();
+                result.push_back(components[c]);
+            }
+            diskRadialFncs.insert(diskRadialFncs.end(),
+                disk.radialFunctions().begin(), disk.radialFunctions().end());
+            diskVerticalFncs.insert(diskVerticalFncs.end(),
+                disk.verticalFunctions().begin(), disk.verticalFunctions().end());
+        } else if(name == Multipole::myName()) {
+            MultipoleGroup group;
+            dynamic_cast<const Multipole&>(*components[c]).getCoefs(group.radii, group.Phi, group.dPhi);
+            size_t g = 0;
+            while(g < groupsMul.size() && !sameGrid(groupsMul[g].radii, group.radii))
+                g++;
+            if(g == groupsMul.size()) {  // start a new group
+                group.index = result.size();
+                group.count = 1;
+                groupsMul.push_back(group);
+                result.push_back(components[c]);
+            } else {  // add the coefficients to an existing group
+                groupsMul[g].count++;
+                if(groupsMul[g].Phi.size() < group.Phi.size()) {
+                    groupsMul[g].Phi .resize(group.Phi.size(), std::vector<double>(group.radii.size(), 0.));
+                    groupsMul[g].dPhi.resize(group.Phi.size(), std::vector<double>(group.radii.size(), 0.));
+                }
+                for(size_t i=0; i<group.Phi.size(); i++) {
+                    addCoefs(group.Phi [i], groupsMul[g].Phi [i]);
+                    addCoefs(group.dPhi[i], groupsMul[g].dPhi[i]);
+                }
+            }
+        } else if(name == CylSpline::myName()) {
+            CylSplineGroup group;
+            dynamic_cast<const CylSpline&>(*components[c]).getCoefs(
+                group.gridR, group.gridz, group.Phi, group.dPhidR, group.dPhidz);
+            size_t g = 0;
+            while(g < groupsCyl.size() &&
+                !(sameGrid(groupsCyl[g].gridR, group.gridR) && sameGrid(groupsCyl[g].gridz, group.gridz)))
+                g++;
+            if(g == groupsCyl.size()) {
+                group.index = result.size();
+                group.count = 1;
+                groupsCyl.push_back(group);
+                result.push_back(components[c]);
+            } else {
+                CylSplineGroup& dest = groupsCyl[g];
+                dest.count++;
+                // the number of terms is 2*mmax+1, and the m=0 term is in the middle
+                int mmaxSrc = group.Phi.size() / 2, mmaxDest = dest.Phi.size() / 2;
+                if(mmaxSrc > mmaxDest) {  // pad the arrays on both sides with empty matrices
+                    int pad = mmaxSrc - mmaxDest;
+                    dest.Phi   .insert(dest.Phi   .begin(), pad, math::Matrix<double>());
+                    dest.dPhidR.insert(dest.dPhidR.begin(), pad, math::Matrix<double>());
+                    dest.dPhidz.insert(dest.dPhidz.begin(), pad, math::Matrix<double>());
+                    dest.Phi   .resize(2*mmaxSrc+1);
+                    dest.dPhidR.resize(2*mmaxSrc+1);
+                    dest.dPhidz.resize(2*mmaxSrc+1);
+                    mmaxDest = mmaxSrc;
+                }
+                for(int m=-mmaxSrc; m<=mmaxSrc; m++) {
+                    addCoefs(group.Phi   [m+mmaxSrc], dest.Phi   [m+mmaxDest]);
+                    addCoefs(group.dPhidR[m+mmaxSrc], dest.dPhidR[m+mmaxDest]);
+                    addCoefs(group.dPhidz[m+mmaxSrc], dest.dPhidz[m+mmaxDest]);
+                }
+            }
+        } else
+            result.push_back(components[c]);
+    }
+
+    // replace the first element of each group by the merged potential
+    if(diskRadialFncs.size() > 1)
+        result[diskIndex].reset(new DiskAnsatz(diskRadialFncs, diskVerticalFncs));
+    // (in the compact mode, all expansions are reconstructed, even if they were not merged)
+    for(size_t g=0; g<groupsMul.size(); g++)
+        if(groupsMul[g].count > 1 || compact)
+            result[groupsMul[g].index].reset(
+                new Multipole(groupsMul[g].radii, groupsMul[g].Phi, groupsMul[g].dPhi, compact));
+    for(size_t g=0; g<groupsCyl.size(); g++)
+        if(groupsCyl[g].count > 1 || compact)
+            result[groupsCyl[g].index].reset(new CylSpline(groupsCyl[g].gridR, groupsCyl[g].gridz,
+                groupsCyl[g].Phi, groupsCyl[g].dPhidR, groupsCyl[g].dPhidz, compact));
+    utils::msg(utils::VL_DEBUG, "compilePotential", "Merged " + utils::toString(components.size()) +
+        " components into " + utils::toString(result.size()));
+    if(result.size() == 1)
+        return result[0];
+    else
+        return PtrPotential(new CompositeCyl(result));
+}
+
 ///@}
 }; // namespace
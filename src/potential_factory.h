@@ -10,6 +10,17 @@
     writing expansion coefficients to a text file,
     converting between potential parameters in `potential::ConfigPotential` structure and 
     a text array of key=value pairs (`utils::KeyValueMap`).
+
+    Potential expansions constructed from analytic density profiles by `createPotential()`
+    (including the Multipole component of GalPot-style models) may be stored in an on-disk cache
+    and reloaded on subsequent calls with the same parameters, even in a different process.
+    The cache is disabled by default and is enabled by `utils::setCacheDirectory()` or by
+    the environment variable AGAMA_CACHE_DIR; the cache key includes all parameters of the
+    components, the unit conversion factors, and the build date of the library.
+    The potential returned from the function is always the one read back from the cache file,
+    so the results do not depend on whether the cache was hit or missed; the coefficients are
+    stored at full precision, so that they differ from a potential constructed with the cache
+    disabled only at the level of floating-point round-off (~1e-12 relative).
 */
 
 #pragma once
@@ -203,6 +214,25 @@ PtrPotential readPotential(const std::string& coefFileName,
 bool writeDensity(const std::string& fileName, const BaseDensity& density,
     const units::ExternalUnits& converter = units::ExternalUnits());
 
+/** Create an equivalent potential that is faster to evaluate ("compile" a composite potential).
+    Nested composite potentials are flattened into a single list of components;
+    all `DiskAnsatz` components are fused into a single one, which computes the common
+    coordinate transformations only once; `Multipole` expansions sharing the same radial grid,
+    and `CylSpline` expansions sharing the same grid in (R,z), are merged into a single expansion
+    by summing up their coefficients. The fusion of DiskAnsatz components is exact (up to roundoff),
+    while the merged expansions coincide with the sum of original ones at grid nodes and differ
+    from it elsewhere only at the level of interpolation errors.
+    Components of other types are retained as they are.
+    \param[in]  potential  is the (possibly composite) potential;
+    \param[in]  compact  if true, all Multipole and CylSpline expansions (merged or not) are
+    reconstructed with derivatives in their interpolation tables stored in single precision,
+    which reduces the memory footprint by ~40% and improves cache efficiency when many threads
+    share one potential, at the expense of relative errors ~1e-7 in the potential and force.
+    \return  the single remaining component, or a composite potential of remaining components
+    (in the order of their first appearance in the original list).
+*/
+PtrPotential compilePotential(const PtrPotential& potential, bool compact=false);
+
 /// alias to writeDensity
 inline bool writePotential(const std::string& fileName, const BasePotential& potential,
     const units::ExternalUnits& converter = units::ExternalUnits()) {
@@ -6,9 +6,6 @@
 
 namespace potential {
 
-/// relative accuracy of root-finder for lambda
-const double ACCURACY_ROOT = 1e-6;
-    
 // Ferrers n=2 potential
 
 Ferrers::Ferrers(double _mass, double _R, double _q, double _p):
@@ -27,18 +24,41 @@ double Ferrers::densityCar(const coord::PosCar& pos) const
     return m2>1 ? 0 : rho0*pow_2(1-m2);
 }
 
-/// helper class to find lambda as the root of equation
-/// x^2/(lambda+a^2) + y^2/(lambda+b^2) + z^2/(lambda+c^2) = 1
-class FerrersLambdaRootFinder: public math::IFunctionNoDeriv {
-public:
-    FerrersLambdaRootFinder(double x, double y, double z, double a, double b, double c) :
-        x2(x*x), y2(y*y), z2(z*z), a2(a*a), b2(b*b), c2(c*c) {};
-    virtual double value(double lambda) const {
-        return x2/(lambda+a2) + y2/(lambda+b2) + z2/(lambda+c2) - 1;
+/// find lambda as the largest root of equation
+/// x^2/(lambda+a^2) + y^2/(lambda+b^2) + z^2/(lambda+c^2) = 1,
+/// which is equivalent to a cubic equation lambda^3 + B lambda^2 + C lambda + D = 0;
+/// it is solved in radicals, and the result is polished by a Newton iteration
+/// (this is considerably cheaper than a general-purpose root-finder)
+static double findLambda(double x2, double y2, double z2, double a2, double b2, double c2)
+{
+    const double
+    B = a2 + b2 + c2 - x2 - y2 - z2,
+    C = a2*b2 + a2*c2 + b2*c2 - x2*(b2+c2) - y2*(a2+c2) - z2*(a2+b2),
+    D = a2*b2*c2 - x2*b2*c2 - y2*a2*c2 - z2*a2*b2,
+    // depressed cubic  t^3 + P t + Q = 0,  lambda = t - B/3
+    P = C - B*B/3,
+    Q = B * (2*B*B - 9*C) / 27 + D,
+    disc = pow_2(Q/2) + pow_3(P/3);
+    double lambda;
+    if(disc > 0) {   // one real root
+        double sq = sqrt(disc);
+        lambda = cbrt(-Q/2 + sq) + cbrt(-Q/2 - sq) - B/3;
+    } else {         // three real roots, take the largest one
+        double mag = sqrt(-P/3), arg = -Q/2 / pow_3(mag);
+        lambda = 2 * mag * cos(acos(fmin(fmax(arg, -1.), 1.)) / 3) - B/3;
     }
-private:
-    double x2, y2, z2, a2, b2, c2;
-};
+    lambda = fmax(lambda, 0.);
+    // Newton iterations to eliminate the roundoff errors of the algebraic solution
+    for(int iter=0; iter<2; iter++) {
+        double
+        fa = x2 / (lambda+a2), fb = y2 / (lambda+b2), fc = z2 / (lambda+c2),
+        val = fa + fb + fc - 1,
+        der = -(fa / (lambda+a2) + fb / (lambda+b2) + fc / (lambda+c2));
+        if(der < 0)
+            lambda = fmax(lambda - val / der, 0.);
+    }
+    return lambda;
+}
 
 void Ferrers::evalCar(const coord::PosCar &pos,
     double* potential, coord::GradCar* grad, coord::HessCar* hess) const
@@ -71,8 +91,7 @@ void Ferrers::evalCar(const coord::PosCar &pos,
     double Wcurr[20];  // temp.coefs for lambda>0 if needed
     const double *W;   // coefs used in computation (either pre-computed or temp.)
     if(m2>1) {
-        FerrersLambdaRootFinder fnc(pos.x, pos.y, pos.z, a, b, c);
-        double lambda = math::findRoot(fnc, 0, INFINITY, ACCURACY_ROOT);
+        double lambda = findLambda(X2, Y2, Z2, a*a, b*b, c*c);
         computeW(lambda, Wcurr);
         W = Wcurr;
     } else 
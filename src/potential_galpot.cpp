@@ -205,41 +205,59 @@ double DiskDensity::densityCyl(const coord::PosCyl &pos) const
     return radialFnc->value(pos.R) * h;
 }
 
+DiskAnsatz::DiskAnsatz(const std::vector<math::PtrFunction>& _radialFncs,
+    const std::vector<math::PtrFunction>& _verticalFncs) :
+    radialFncs(_radialFncs), verticalFncs(_verticalFncs)
+{
+    if(radialFncs.empty() || radialFncs.size() != verticalFncs.size())
+        throw std::invalid_argument("DiskAnsatz: invalid size of input arrays");
+}
+
 double DiskAnsatz::densityCyl(const coord::PosCyl &pos) const
 {
-    double h, H, Hp, f, fp, fpp, r=sqrt(pow_2(pos.R) + pow_2(pos.z));
-    verticalFnc->evalDeriv(pos.z, &H, &Hp, &h);
-    radialFnc  ->evalDeriv(r, &f, &fp, &fpp);
-    return f*h + (pos.z!=0 ? 2*fp*(H+pos.z*Hp)/r : 0) + fpp*H;
+    double r = sqrt(pow_2(pos.R) + pow_2(pos.z)), result = 0;
+    for(size_t i=0; i<radialFncs.size(); i++) {
+        double h, H, Hp, f, fp, fpp;
+        verticalFncs[i]->evalDeriv(pos.z, &H, &Hp, &h);
+        radialFncs  [i]->evalDeriv(r, &f, &fp, &fpp);
+        result += f*h + (pos.z!=0 ? 2*fp*(H+pos.z*Hp)/r : 0) + fpp*H;
+    }
+    return result;
 }
 
 void DiskAnsatz::evalCyl(const coord::PosCyl &pos,
     double* potential, coord::GradCyl* deriv, coord::HessCyl* deriv2) const
 {
     double r = sqrt(pow_2(pos.R) + pow_2(pos.z));
-    double h=0, H=0, Hp=0, f=0, fp=0, fpp=0;
     bool deriv1 = deriv!=NULL || deriv2!=NULL;  // compute 1st derivative of f and H only if necessary
-    verticalFnc->evalDeriv(pos.z, &H, deriv1? &Hp : NULL, deriv2? &h : NULL);
-    radialFnc  ->evalDeriv(r,     &f, deriv1? &fp : NULL, deriv2? &fpp : NULL);
-    f  *= 4*M_PI;
-    fp *= 4*M_PI;
-    fpp*= 4*M_PI;
     double rinv = r>0 ? 1./r : 1.;  // if r==0, avoid indeterminacy in 0/0
     double Rr   = pos.R * rinv;
     double zr   = pos.z * rinv;
-    if(potential) {
-        *potential = f * H;
-    }
-    if(deriv) {
-        deriv->dR = H * Rr * fp;
-        deriv->dz = H * zr * fp + Hp * f;
-        deriv->dphi=0;
-    }
-    if(deriv2) {
-        deriv2->dR2 = H * (fpp * pow_2(Rr) + fp * rinv * pow_2(zr));
-        deriv2->dz2 = H * (fpp * pow_2(zr) + fp * rinv * pow_2(Rr)) + fp * Hp * zr * 2 + f * h;
-        deriv2->dRdz= H * Rr * zr * (fpp - fp * rinv) + fp * Hp * Rr;
-        deriv2->dRdphi=deriv2->dzdphi=deriv2->dphi2=0;
+    if(potential)
+        *potential = 0;
+    if(deriv)
+        deriv->dR = deriv->dz = deriv->dphi = 0;
+    if(deriv2)
+        deriv2->dR2 = deriv2->dz2 = deriv2->dRdz = deriv2->dRdphi = deriv2->dzdphi = deriv2->dphi2 = 0;
+    for(size_t i=0; i<radialFncs.size(); i++) {
+        double h=0, H=0, Hp=0, f=0, fp=0, fpp=0;
+        verticalFncs[i]->evalDeriv(pos.z, &H, deriv1? &Hp : NULL, deriv2? &h : NULL);
+        radialFncs  [i]->evalDeriv(r,     &f, deriv1? &fp : NULL, deriv2? &fpp : NULL);
+        f  *= 4*M_PI;
+        fp *= 4*M_PI;
+        fpp*= 4*M_PI;
+        if(potential) {
+            *potential += f * H;
+        }
+        if(deriv) {
+            deriv->dR += H * Rr * fp;
+            deriv->dz += H * zr * fp + Hp * f;
+        }
+        if(deriv2) {
+            deriv2->dR2 += H * (fpp * pow_2(Rr) + fp * rinv * pow_2(zr));
+            deriv2->dz2 += H * (fpp * pow_2(zr) + fp * rinv * pow_2(Rr)) + fp * Hp * zr * 2 + f * h;
+            deriv2->dRdz+= H * Rr * zr * (fpp - fp * rinv) + fp * Hp * Rr;
+        }
     }
 }
 
@@ -135,21 +135,32 @@ private:
     {  return densityCyl(toPosCyl(pos)); }
 };
 
-/** Part of the disk potential provided analytically as  4 pi f(r) H(z) */
+/** Part of the disk potential provided analytically as  4 pi f(r) H(z).
+    It may also represent a sum of several such terms (e.g., for several disk components),
+    which is faster to evaluate than a composite potential of individual terms,
+    since the coordinate transformations are shared between all terms.
+*/
 class DiskAnsatz: public BasePotentialCyl {
 public:
-    DiskAnsatz(const DiskParam& _params) : 
-        radialFnc  (createRadialDiskFnc(_params)),
-        verticalFnc(createVerticalDiskFnc(_params)) {};
+    DiskAnsatz(const DiskParam& _params) :
+        radialFncs  (1, createRadialDiskFnc(_params)),
+        verticalFncs(1, createVerticalDiskFnc(_params)) {};
     DiskAnsatz(const math::PtrFunction& _radialFnc, const math::PtrFunction& _verticalFnc) :
-        radialFnc(_radialFnc), verticalFnc(_verticalFnc) {};
+        radialFncs(1, _radialFnc), verticalFncs(1, _verticalFnc) {};
+    /// construct a sum of several terms with the given radial and vertical functions
+    DiskAnsatz(const std::vector<math::PtrFunction>& _radialFncs,
+        const std::vector<math::PtrFunction>& _verticalFncs);
     virtual coord::SymmetryType symmetry() const { return coord::ST_AXISYMMETRIC; }
     virtual const char* name() const { return myName(); }
     static const char* myName() { static const char* text = "DiskAnsatz"; return text; }
+    /// return the functions describing radial dependence of surface density for all terms
+    const std::vector<math::PtrFunction>& radialFunctions() const { return radialFncs; }
+    /// return the functions describing vertical density profile for all terms
+    const std::vector<math::PtrFunction>& verticalFunctions() const { return verticalFncs; }
 private:
-    math::PtrFunction radialFnc;     ///< function describing radial dependence of surface density
-    math::PtrFunction verticalFnc;   ///< function describing vertical density profile
-    /** Compute _part_ of the disk potential: f(r)*H(z) */
+    std::vector<math::PtrFunction> radialFncs;     ///< radial dependence of surface density
+    std::vector<math::PtrFunction> verticalFncs;   ///< vertical density profile
+    /** Compute _part_ of the disk potential: sum of f(r)*H(z) for all terms */
     virtual void evalCyl(const coord::PosCyl &pos,
         double* potential, coord::GradCyl* deriv, coord::HessCyl* deriv2) const;
     virtual double densityCyl(const coord::PosCyl &pos) const;
@@ -28,6 +28,20 @@ static const unsigned int ORDER_RAD_INT = 10;
 /// safety factor to avoid roundoff errors near grid boundaries
 static const double SAFETY_FACTOR = 100*DBL_EPSILON;
 
+/// maximum number of values (particles times harmonic terms) for which the density coefficients
+/// are computed from the harmonics of individual particles; for larger snapshots,
+/// the particles are first binned in radius, so that the memory cost does not depend on N
+static const double MAX_UNBINNED_HARMONICS = 1<<24;
+
+/// number of bins per grid segment in the binned computation of density coefficients
+static const int BINS_PER_GRID_SEGMENT = 16;
+
+/// maximum number of radial bins in the binned computation of density coefficients
+static const int MAX_NUM_BINS = 4096;
+
+/// number of bins in the histogram of particle radii used to choose the grid extent
+static const int NUM_BINS_HISTOGRAM = 65536;
+
 // Helper function to deduce symmetry from the list of non-zero coefficients;
 // combine the array of coefficients at different radii into a single array
 // and then call the corresponding routine from math::.
@@ -95,19 +109,15 @@ void restrictSphHarmCoefs(int lmax, int mmax, std::vector<std::vector<double> >&
 // functions, and computes the sph-harm expansion for either density (in the first case),
 // potential and its r-derivative (in the second case), or all values returned by the function
 // (in the third case). To avoid code duplication, the function that actually retrieves
-// the relevant quantity is separated into a dedicated routine `storeValue`,
-// which stores one or more values for each input point.
+// the relevant quantity is separated into a dedicated routine `storeValues`,
+// which stores one or more values for each input point of the entire grid
+// (for potentials and generic functions it calls `storeValue` for each point,
+// while the density is computed for all points in one batch).
 // The `computeSphHarmCoefsSph` routine is templated on the type of input data.
 
 template<class BaseDensityOrPotential>
 void storeValue(const BaseDensityOrPotential& src, const coord::PosCyl& pos, double values[]);
 
-template<>
-inline void storeValue(const BaseDensity& src, const coord::PosCyl& pos, double values[])
-{
-    *values = src.density(pos);
-}
-
 template<>
 inline void storeValue(const BasePotential& src, const coord::PosCyl& pos, double values[])
 {
@@ -130,6 +140,37 @@ template<> int numQuantities(const BaseDensity&)   { return 1; }
 template<> int numQuantities(const BasePotential&) { return 2; }
 template<> int numQuantities(const math::IFunctionNdim& src) { return src.numValues(); }
 
+// store the values of input quantities at all points of the grid:
+// the generic implementation calls `storeValue` for each point in parallel,
+// while for a density model all points are passed in a single call to its batched routine
+// (which is itself parallelized in the default implementation)
+template<class BaseDensityOrPotential>
+void storeValues(const BaseDensityOrPotential& src, const std::vector<coord::PosCyl>& points,
+    double values[])
+{
+    const int numPoints = points.size(), numValues = numQuantities(src);
+    std::string errorMsg;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int n=0; n<numPoints; n++) {
+        try{
+            storeValue(src, points[n], &values[n * numValues]);
+        }
+        catch(std::exception& e) {
+            errorMsg = e.what();
+        }
+    }
+    if(!errorMsg.empty())
+        throw std::runtime_error(errorMsg);
+}
+
+template<>
+void storeValues(const BaseDensity& src, const std::vector<coord::PosCyl>& points, double values[])
+{
+    src.evalmanyDensityCyl(points.size(), &points[0], values);
+}
+
 template<class BaseDensityOrPotential>
 void computeSphHarmCoefs(const BaseDensityOrPotential& src, 
     const math::SphHarmIndices& ind, const std::vector<double>& radii,
@@ -142,32 +183,29 @@ void computeSphHarmCoefs(const BaseDensityOrPotential& src,
     math::SphHarmTransformForward trans(ind);
 
     // 1st step: collect the values of input quantities at a 2d grid in (r,theta);
-    // loop over radii and angular directions, using a combined index variable for better load balancing.
+    // the entire grid is assembled first, using a combined index variable for radii and
+    // angular directions, so that all points may be processed in one batch.
     int numValues        = numQuantities(src);
     int numSamplesAngles = trans.size();  // size of array of density values at each r
     int numSamplesTotal  = numSamplesAngles * numPointsRadius;
     std::vector<double> values(numSamplesTotal * numValues);
-    std::string errorMsg;
-#ifdef _OPENMP
-#pragma omp parallel for schedule(dynamic)
-#endif
+    std::vector<coord::PosCyl> points;
+    points.reserve(numSamplesTotal);
     for(int n=0; n<numSamplesTotal; n++) {
-        try{
-            int indR    = n / numSamplesAngles;  // index in radial grid
-            int indA    = n % numSamplesAngles;  // combined index in angular direction (theta,phi)
-            double rad  = radii[indR];
-            double z    = rad * trans.costheta(indA);
-            double R    = sqrt(rad*rad - z*z);
-            double phi  = trans.phi(indA);
-            storeValue(src, coord::PosCyl(R, z, phi),
-                &values[(indR * numSamplesAngles + indA) * numValues]);
-        }
-        catch(std::exception& e) {
-            errorMsg = e.what();
-        }
+        int indR    = n / numSamplesAngles;  // index in radial grid
+        int indA    = n % numSamplesAngles;  // combined index in angular direction (theta,phi)
+        double rad  = radii[indR];
+        double z    = rad * trans.costheta(indA);
+        double R    = sqrt(rad*rad - z*z);
+        double phi  = trans.phi(indA);
+        points.push_back(coord::PosCyl(R, z, phi));
+    }
+    try{
+        storeValues(src, points, &values[0]);
+    }
+    catch(std::exception& e) {
+        throw std::runtime_error(std::string("Error in computeSphHarmCoefs: ") + e.what());
     }
-    if(!errorMsg.empty())
-        throw std::runtime_error("Error in computeSphHarmCoefs: "+errorMsg);
 
     // 2nd step: transform these values to spherical-harmonic expansion coefficients at each radius
     std::vector<double> shcoefs(ind.size());
@@ -246,6 +284,154 @@ void computeSphericalHarmonicsFromParticles(
         throw std::runtime_error("computeSphericalHarmonicsFromParticles: " + errorMsg);
 }
 
+/// determine the range of radii spanned by particles with non-zero mass and their number
+void getParticleRadiusRange(const particles::ParticleArray<coord::PosCyl> &particles,
+    double &rmin, double &rmax, long &nbody)
+{
+    rmin = INFINITY;
+    rmax = 0;
+    nbody= 0;
+    const long size = particles.size();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        double trmin = INFINITY, trmax = 0;
+        long tnbody = 0;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for(long i=0; i<size; i++) {
+            if(particles.mass(i) == 0)  // only consider particles with non-zero mass
+                continue;
+            double r = sqrt(pow_2(particles.point(i).R) + pow_2(particles.point(i).z));
+            trmin = std::min(trmin, r);
+            trmax = std::max(trmax, r);
+            tnbody++;
+        }
+#ifdef _OPENMP
+#pragma omp critical(MultipoleRadiusRange)
+#endif
+        {
+            rmin = std::min(rmin, trmin);
+            rmax = std::max(rmax, trmax);
+            nbody += tnbody;
+        }
+    }
+}
+
+/** Compute the spherical-harmonic expansion of particles binned in log-radius.
+    This is a memory-efficient alternative to `computeSphericalHarmonicsFromParticles`:
+    instead of storing the harmonics of each particle, it accumulates their sums in
+    a fixed number of narrow radial bins (much narrower than the spacing of the radial grid),
+    using thread-local arrays that are merged at the end.
+    Each non-empty bin then plays the role of a single particle, located at the mass-weighted
+    mean log-radius of its members, which is sufficiently accurate for the subsequent
+    penalized spline fits.
+    \param[in]  particles  is the array of particles;
+    \param[in]  ind  is the indexing scheme of the harmonic coefficients;
+    \param[in]  gridLogRadii  is the grid in log(r), which determines the bin width;
+    \param[out] logRadii  will contain the mean log-radius of particles in each non-empty bin;
+    \param[out] harmonics  will contain the total mass of particles in each bin (c=0) and
+    the mass-weighted average of each harmonic term (c>0) normalized by the l=0 term;
+    \param[out] sqweights  will contain the sum of squared masses in each bin.
+*/
+void computeBinnedSphericalHarmonicsFromParticles(
+    const particles::ParticleArray<coord::PosCyl> &particles,
+    const math::SphHarmIndices &ind,
+    const std::vector<double> &gridLogRadii,
+    std::vector<double> &logRadii,
+    std::vector< std::vector<double> > &harmonics,
+    std::vector<double> &sqweights)
+{
+    double prmin, prmax;
+    long nbody;
+    getParticleRadiusRange(particles, prmin, prmax, nbody);
+    if(nbody==0)
+        throw std::invalid_argument("Multipole: no particles provided as input");
+    if(prmin==0)
+        throw std::runtime_error("computeSphericalHarmonicsFromParticles: "
+            "no massive particles at r=0 allowed");
+    double minStep = INFINITY;
+    for(unsigned int k=1; k<gridLogRadii.size(); k++)
+        minStep = std::min(minStep, gridLogRadii[k] - gridLogRadii[k-1]);
+    const double logrmin = log(prmin), logrmax = log(prmax) * (1+SAFETY_FACTOR);
+    const int numBins = std::max(1, std::min(MAX_NUM_BINS,
+        static_cast<int>(ceil((logrmax - logrmin) / minStep * BINS_PER_GRID_SEGMENT))));
+    const double binWidth = fmax(logrmax - logrmin, minStep) / numBins;
+
+    // list of harmonic terms that need to be computed, and the layout of accumulator arrays:
+    // for each bin, the sum of squared masses, the sum of mass times log(r), and harmonic terms
+    std::vector<int> terms;
+    for(int m=ind.mmin(); m<=ind.mmax; m++)
+        for(int l=ind.lmin(m); l<=ind.lmax; l+=ind.step)
+            terms.push_back(ind.index(l, m));
+    const unsigned int numHarm = ind.size(), stride = numHarm + 2;
+    std::vector<double> acc(numBins * stride, 0.);
+    bool needSine = ind.mmin()<0;
+    const long size = particles.size();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        std::vector<double> tacc(numBins * stride, 0.);  // thread-local accumulator
+        std::vector<double> tmp(ind.lmax+1+2*ind.mmax);
+        double *leg = &tmp[0], *trig = leg + ind.lmax+1;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for(long i=0; i<size; i++) {
+            const double mass = particles.mass(i);
+            if(mass == 0)
+                continue;
+            const coord::PosCyl& pos = particles.point(i);
+            double r   = sqrt(pow_2(pos.R) + pow_2(pos.z));
+            double tau = pos.z / (r + pos.R);
+            double logr= log(r);
+            int bin = std::max(0, std::min(numBins-1, static_cast<int>((logr - logrmin) / binWidth)));
+            double* dest = &tacc[bin * stride];
+            dest[0] += mass * mass;
+            dest[1] += mass * logr;
+            dest += 2;
+            math::trigMultiAngle(pos.phi, ind.mmax, needSine, trig);
+            for(int m=0; m<=ind.mmax; m++) {
+                math::sphHarmArray(ind.lmax, m, tau, leg);
+                for(int l=ind.lmin(m); l<=ind.lmax; l+=ind.step)
+                    dest[ind.index(l, m)] += mass * leg[l-m] * 2*M_SQRTPI *
+                        (m==0 ? 1 : M_SQRT2 * trig[m-1]);
+                if(needSine && m>0)
+                    for(int l=ind.lmin(-m); l<=ind.lmax; l+=ind.step)
+                        dest[ind.index(l, -m)] += mass * leg[l-m] * 2*M_SQRTPI *
+                            M_SQRT2 * trig[ind.mmax+m-1];
+            }
+        }
+#ifdef _OPENMP
+#pragma omp critical(MultipoleBinnedHarmonics)
+#endif
+        for(size_t j=0; j<acc.size(); j++)
+            acc[j] += tacc[j];
+    }
+
+    // convert the accumulated sums into the arrays of "pseudo-particles"
+    logRadii.clear();
+    sqweights.clear();
+    harmonics.assign(numHarm, std::vector<double>());
+    for(unsigned int t=0; t<terms.size(); t++)
+        harmonics[terms[t]].reserve(numBins);
+    for(int bin=0; bin<numBins; bin++) {
+        const double* src = &acc[bin * stride];
+        double sumMass = src[2];   // the l=0 term contains the sum of masses
+        if(sumMass == 0)
+            continue;
+        sqweights.push_back(src[0]);
+        logRadii.push_back(src[1] / sumMass);
+        for(unsigned int t=0; t<terms.size(); t++)
+            harmonics[terms[t]].push_back(terms[t]==0 ? sumMass : src[2+terms[t]] / sumMass);
+    }
+    utils::msg(utils::VL_DEBUG, "Multipole", "Binned "+utils::toString(nbody)+" particles into "+
+        utils::toString(logRadii.size())+" radial bins");
+}
+
 
 /// auto-assign min/max radii of the grid if they were not provided, for a smooth density model
 void chooseGridRadii(const BaseDensity& src, const unsigned int gridSizeR,
@@ -343,39 +529,80 @@ void chooseGridRadii(const BaseDensity& src, const unsigned int gridSizeR,
         "Grid in r=["+utils::toString(rmin)+":"+utils::toString(rmax)+"] ");
 }
 
-/// auto-assign min/max radii of the grid if they were not provided, for a discrete N-body model
+/// auto-assign min/max radii of the grid if they were not provided, for a discrete N-body model.
+/// For snapshots of moderate size, the required quantiles of the radial distribution of particles
+/// are determined exactly from a copy of the array of radii; for large snapshots, they are
+/// estimated from a fine-grained histogram in log(r), so that the memory cost does not depend on
+/// the number of particles (the relative error in the quantiles is ~1e-3 or better)
 void chooseGridRadii(const particles::ParticleArray<coord::PosCyl>& particles,
     unsigned int gridSizeR, double &rmin, double &rmax) 
 {
     if(rmin!=0 && rmax!=0)
         return;
-    std::vector<double> radii;
-    radii.reserve(particles.size());
-    double prmin=INFINITY, prmax=0;
-    for(size_t i=0; i<particles.size(); i++) {
-        double r = sqrt(pow_2(particles.point(i).R) + pow_2(particles.point(i).z));
-        if(particles.mass(i) != 0) {   // only consider particles with non-zero mass
-            radii.push_back(r);
-            prmin = std::min(prmin, r);
-            prmax = std::max(prmax, r);
-        }
-    }
-    size_t nbody = radii.size();
+    double prmin, prmax;
+    long nbody;
+    getParticleRadiusRange(particles, prmin, prmax, nbody);
     if(nbody==0)
         throw std::invalid_argument("Multipole: no particles provided as input");
-    std::nth_element(radii.begin(), radii.begin() + nbody/2, radii.end());
-    double rhalf = radii[nbody/2];   // half-mass radius (if all particles have equal mass)
-    double spacing = 1 + sqrt(20./gridSizeR);  // ratio between two adjacent grid nodes
-    // # of points inside the first or outside the last grid node
+    const long size = particles.size();
+    // sorted radii of particles with the given ranks (0-based): half-mass radius
+    // (if all particles have equal mass), and the radii enclosing Nmin innermost or outermost points
     int Nmin = static_cast<int>(log(nbody+1)/log(2));
-    if(rmin==0) {
-        std::nth_element(radii.begin(), radii.begin() + Nmin, radii.end());
-        rmin = std::max(radii[Nmin], rhalf * std::pow(spacing, -0.5*gridSizeR));
-    }
-    if(rmax==0) {
-        std::nth_element(radii.begin(), radii.end() - Nmin, radii.end());
-        rmax = std::min(radii[nbody-Nmin], rhalf * std::pow(spacing, 0.5*gridSizeR));
+    long ranks[3] = { nbody/2, std::min<long>(Nmin, nbody-1), std::max<long>(nbody-Nmin, 0) };
+    double quantiles[3];
+    if(size <= MAX_UNBINNED_HARMONICS) {
+        std::vector<double> radii;
+        radii.reserve(nbody);
+        for(long i=0; i<size; i++)
+            if(particles.mass(i) != 0)   // only consider particles with non-zero mass
+                radii.push_back(sqrt(pow_2(particles.point(i).R) + pow_2(particles.point(i).z)));
+        for(int q=0; q<3; q++) {
+            std::nth_element(radii.begin(), radii.begin() + ranks[q], radii.end());
+            quantiles[q] = radii[ranks[q]];
+        }
+    } else {
+        // histogram of log-radii, accumulated in thread-local arrays
+        const double logrmin = log(std::max(prmin, prmax * DBL_EPSILON)),
+        logrmax = log(prmax) + SAFETY_FACTOR,
+        binWidth = fmax(logrmax - logrmin, SAFETY_FACTOR) / NUM_BINS_HISTOGRAM;
+        std::vector<long> hist(NUM_BINS_HISTOGRAM, 0);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            std::vector<long> thist(NUM_BINS_HISTOGRAM, 0);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for(long i=0; i<size; i++) {
+                if(particles.mass(i) == 0)
+                    continue;
+                double logr = log(sqrt(pow_2(particles.point(i).R) + pow_2(particles.point(i).z)));
+                thist[std::max(0, std::min(NUM_BINS_HISTOGRAM-1,
+                    static_cast<int>((logr - logrmin) / binWidth)))]++;
+            }
+#ifdef _OPENMP
+#pragma omp critical(MultipoleRadiusHistogram)
+#endif
+            for(int b=0; b<NUM_BINS_HISTOGRAM; b++)
+                hist[b] += thist[b];
+        }
+        // assume that particles are uniformly distributed in log(r) within each bin
+        for(int q=0; q<3; q++) {
+            long cumul = 0;
+            int b = 0;
+            while(b < NUM_BINS_HISTOGRAM-1 && cumul + hist[b] <= ranks[q])
+                cumul += hist[b++];
+            quantiles[q] = exp(logrmin + binWidth *
+                (b + (ranks[q] - cumul + 0.5) / std::max<long>(hist[b], 1)));
+        }
     }
+    double rhalf = quantiles[0];
+    double spacing = 1 + sqrt(20./gridSizeR);  // ratio between two adjacent grid nodes
+    if(rmin==0)
+        rmin = std::max(quantiles[1], rhalf * std::pow(spacing, -0.5*gridSizeR));
+    if(rmax==0)
+        rmax = std::min(quantiles[2], rhalf * std::pow(spacing, 0.5*gridSizeR));
     utils::msg(utils::VL_DEBUG, "Multipole",
         "Grid in r=["+utils::toString(rmin)+":"+utils::toString(rmax)+"]"
         ", particles span r=["+utils::toString(prmin)+":"+utils::toString(prmax)+"]");
@@ -635,7 +862,8 @@ void computeDensityCoefsSph(
     const math::SphHarmIndices &ind,
     const std::vector<double> &gridRadii,
     std::vector< std::vector<double> > &coefs,
-    double smoothing)
+    double smoothing,
+    bool forceBinned)
 {
     unsigned int gridSizeR = gridRadii.size();
     if(gridSizeR < MULTIPOLE_MIN_GRID_SIZE)
@@ -652,23 +880,29 @@ void computeDensityCoefsSph(
 
     // compute the sph-harm coefs at each particle's radius
     std::vector<std::vector<double> > harmonics(ind.size());
-    std::vector<double> particleRadii;
-    computeSphericalHarmonicsFromParticles(particles, ind, particleRadii, harmonics);
-
-    // normalize all l>0 harmonics by the value of l=0 term
-    // (the latter contains simply the particle masses),
-    // and convert the radii to log-radii
-    for(size_t i=0; i<particleRadii.size(); i++) {
-        particleRadii[i] = log(particleRadii[i]);
-        for(unsigned int c=1; c<ind.size(); c++)
-            if(!harmonics[c].empty() && harmonics[0][i]!=0)
-                harmonics[c][i] /= harmonics[0][i];
-    }
+    std::vector<double> particleRadii, sqweights;
+    if(!forceBinned && 1. * particles.size() * ind.size() <= MAX_UNBINNED_HARMONICS) {
+        computeSphericalHarmonicsFromParticles(particles, ind, particleRadii, harmonics);
+
+        // normalize all l>0 harmonics by the value of l=0 term
+        // (the latter contains simply the particle masses),
+        // and convert the radii to log-radii
+        for(size_t i=0; i<particleRadii.size(); i++) {
+            particleRadii[i] = log(particleRadii[i]);
+            for(unsigned int c=1; c<ind.size(); c++)
+                if(!harmonics[c].empty() && harmonics[0][i]!=0)
+                    harmonics[c][i] /= harmonics[0][i];
+        }
+    } else
+        // same for the particles binned in radius (already normalized and converted to log-radii)
+        computeBinnedSphericalHarmonicsFromParticles(particles, ind, gridLogRadii,
+            particleRadii, harmonics, sqweights);
 
     // construct the l=0 harmonic using a penalized log-density estimate
     math::CubicSpline spl0(gridLogRadii, math::splineLogDensity<3>(
         gridLogRadii, particleRadii, harmonics[0],
-        math::FitOptions(math::FO_INFINITE_LEFT | math::FO_INFINITE_RIGHT | math::FO_PENALTY_3RD_DERIV)));
+        math::FitOptions(math::FO_INFINITE_LEFT | math::FO_INFINITE_RIGHT | math::FO_PENALTY_3RD_DERIV),
+        /*smoothing*/ 0, sqweights));
     for(unsigned int k=0; k<gridSizeR; k++)
         coefs[0][k] = exp(spl0(gridLogRadii[k])) / (4*M_PI*pow_3(gridRadii[k]));
     if(utils::verbosityLevel >= utils::VL_DEBUG) {
@@ -762,6 +996,7 @@ void computePotentialCoefsSph(const BaseDensity& dens,
         try{
             // local per-thread temporary arrays
             std::vector<double> densValues(trans.size());
+            std::vector<coord::PosCyl> densPoints(trans.size(), coord::PosCyl(0, 0, 0));
             std::vector<double> tmpCoefs(ind.size());
             double rkminus1 = (k>0 ? gridRadii[k-1] : 0);
             double deltaGridR = k<gridSizeR ?
@@ -778,8 +1013,9 @@ void computePotentialCoefsSph(const BaseDensity& dens,
 
                 // collect the values of density at all points of angular grid at the given radius
                 for(unsigned int i=0; i<densValues.size(); i++)
-                    densValues[i] = dens.density(coord::PosCyl(
-                        r * sqrt(1-pow_2(trans.costheta(i))), r * trans.costheta(i), trans.phi(i)));
+                    densPoints[i] = coord::PosCyl(
+                        r * sqrt(1-pow_2(trans.costheta(i))), r * trans.costheta(i), trans.phi(i));
+                dens.evalmanyDensityCyl(densPoints.size(), &densPoints.front(), &densValues.front());
 
                 // compute density SH coefs
                 trans.transform(&densValues.front(), &tmpCoefs.front());
@@ -1043,7 +1279,8 @@ public:
     MultipoleInterp2d(
         const std::vector<double> &radii,
         const std::vector<std::vector<double> > &Phi,
-        const std::vector<std::vector<double> > &dPhi);
+        const std::vector<std::vector<double> > &dPhi,
+        bool compact);
     virtual coord::SymmetryType symmetry() const { return ind.symmetry(); }
     virtual const char* name() const { return "MultipoleInterp2d"; }
 private:
@@ -1138,7 +1375,8 @@ PtrPotential Multipole::create(
 Multipole::Multipole(
     const std::vector<double> &_gridRadii,
     const std::vector<std::vector<double> > &Phi,
-    const std::vector<std::vector<double> > &dPhi) :
+    const std::vector<std::vector<double> > &dPhi,
+    bool compact) :
     gridRadii(_gridRadii), ind(getIndicesFromCoefs(Phi, dPhi))
 {
     unsigned int gridSizeR = gridRadii.size();
@@ -1154,7 +1392,7 @@ Multipole::Multipole(
     // construct the interpolating splines
     impl = ind.lmax <= 2 ?   // choose between 1d or 2d splines, depending on the expected efficiency
         PtrPotential(new MultipoleInterp1d(gridRadii, Phi, dPhi)) :
-        PtrPotential(new MultipoleInterp2d(gridRadii, Phi, dPhi));
+        PtrPotential(new MultipoleInterp2d(gridRadii, Phi, dPhi, compact));
 
     // determine asymptotic behaviour at small and large radii
     asymptInner = initAsympt(gridRadii, Phi, dPhi, true);
@@ -1424,7 +1662,8 @@ std::vector<double> createGridInTheta(unsigned int lmax)
 MultipoleInterp2d::MultipoleInterp2d(
     const std::vector<double> &radii,
     const std::vector< std::vector<double> > &Phi,
-    const std::vector< std::vector<double> > &dPhi) :
+    const std::vector< std::vector<double> > &dPhi,
+    bool compact) :
     ind(getIndicesFromCoefs(Phi, dPhi)),
     logScaling(true)
 {
@@ -1505,7 +1744,7 @@ MultipoleInterp2d::MultipoleInterp2d(
             }
         }
         // establish 2D quintic spline for Phi_m(ln(r), tau)
-        spl[m+ind.mmax] = math::QuinticSpline2d(gridR, gridT, Phi_val, Phi_dR, Phi_dT);
+        spl[m+ind.mmax] = math::QuinticSpline2d(gridR, gridT, Phi_val, Phi_dR, Phi_dT, compact);
     }
 }
 
@@ -207,10 +207,15 @@ public:
                     and the second is the number of radial grid points;
         \param[in]  dPhi  is the matrix of radial derivatives of harmonic coefs
                     (same size as Phi, each element is  d Phi_{l,m}(r) / dr ).
+        \param[in]  compact  whether to store the derivatives in the interpolation tables in
+                    single precision, reducing their memory footprint by ~40% at the expense of
+                    relative errors ~1e-7 in the potential and force (only affects expansions
+                    with lmax>2, which use 2d splines).
     */
     Multipole(const std::vector<double> &radii,
         const std::vector<std::vector<double> > &Phi,
-        const std::vector<std::vector<double> > &dPhi);
+        const std::vector<std::vector<double> > &dPhi,
+        bool compact=false);
 
     /** return the array of spherical-harmonic expansion coefficients.
         \param[out] radii will contain the radii of grid nodes;
@@ -276,13 +281,17 @@ void computeDensityCoefsSph(const BaseDensity& dens,
     \param[out] coefs  will contain the arrays of computed sph.-harm. coefficients
     that can be provided to the constructor of `DensitySphericalHarmonic` class;
     will be resized as needed.
+    \param[in] forceBinned  if true, the particles are always binned in radius before fitting;
+    by default this is done only for large snapshots, when storing the harmonics of each
+    particle would take too much memory (the results of both approaches are nearly identical).
 */
 void computeDensityCoefsSph(
     const particles::ParticleArray<coord::PosCyl> &particles,
     const math::SphHarmIndices &ind,
     const std::vector<double> &gridRadii,
     std::vector< std::vector<double> > &coefs,
-    double smoothing = 1.0);
+    double smoothing = 1.0,
+    bool forceBinned = false);
 
 /** Compute spherical-harmonic expansion coefficients for a multi-component density.
     It is similar to the eponymous routine for an ordinary density model, except that
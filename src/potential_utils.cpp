@@ -30,6 +30,20 @@ static const int GLORDER2 = 10;  // for larger segments
 /// the choice between short and long segments is determined by the ratio between consecutive nodes
 static const double GLRATIO = 2.0;
 
+/// size of the grid in energy and in L/Lcirc(E) for the 2d interpolator of peri/apocenter radii
+static const unsigned int INTERP2D_SIZE_E = 50;
+static const unsigned int INTERP2D_SIZE_L = 40;
+
+/// default number of intervals of the energy grid covered by each tile of the 2d interpolator
+static const unsigned int INTERP2D_TILE = 7;
+
+/// each tile is constructed on the energy grid extended by this number of nodes on both sides,
+/// to reduce the influence of the boundary conditions of splines on the interpolated values
+static const unsigned int INTERP2D_OVERLAP = 6;
+
+/// number of values stored for each node of the grid: R1, R2 and their derivatives by E and L/Lcirc
+static const unsigned int INTERP2D_NUM_VALUES = 6;
+
 // -------- routines for conversion between energy, radius and angular momentum --------- //
 
 /** helper class to find the root of  Phi(R) = E */
@@ -732,26 +746,27 @@ double PhaseVolume::deltaE(const double logh1, const double logh2, double* g1) c
 
 // --------- 2d interpolation of peri/apocenter radii in equatorial plane --------- //
 
-Interpolator2d::Interpolator2d(const BasePotential& potential) :
-    pot(potential)
+Interpolator2d::Interpolator2d(const BasePotential& potential, unsigned int _tileSize) :
+    pot(potential), gridE(INTERP2D_SIZE_E), gridL(INTERP2D_SIZE_L),
+    tileSize(_tileSize>0 ? std::min(_tileSize, INTERP2D_SIZE_E-1) : INTERP2D_TILE),
+    tiles((INTERP2D_SIZE_E + tileSize - 2) / tileSize), tileReady(tiles.size(), 0),
+    rows(INTERP2D_SIZE_E)
 {
     // for computing the asymptotic values at E=Phi(0), we assume a power-law behavior of potential:
     // Phi = Phi0 + coef * r^s;  potential must be finite at r=0 for this implementation to work
-    double Phi0, slope = pot.innerSlope(&Phi0);
+    double Phi0;
+    slope = pot.innerSlope(&Phi0);
     if(!isFinite(Phi0) || slope<=0)
         throw std::runtime_error("Interpolator2d: can only deal with potentials that are finite at r->0");
-    const unsigned int sizeE = 50;
-    const unsigned int sizeL = 40;
+    const unsigned int sizeE = gridE.size(), sizeL = gridL.size();
 
     // create a grid in energy
-    std::vector<double> gridE(sizeE);
     for(unsigned int i=0; i<sizeE; i++) {
         double x = 1.*i/(sizeE-1);
         gridE[i] = (1 - pow_3(x) * (10+x*(-15+x*6))) * Phi0; // see below
     }
 
     // create a grid in L/Lcirc(E)
-    std::vector<double> gridL(sizeL);
     for(unsigned int i=0; i<sizeL; i++) {
         double x = 1.*i/(sizeL-1);
         // transformation of interval [0:1] onto itself that places more grid points near the edges:
@@ -759,19 +774,62 @@ Interpolator2d::Interpolator2d(const BasePotential& potential) :
         gridL[i] = pow_3(x) * (10+x*(-15+x*6));
         //pow_2(x*x) * (35+x*(-84+x*(70-x*20))); // <-- that would give three zero derivs
     }
+    // the 2d interpolation tables are constructed in getTile() when needed
+}
 
-    // fill 2d grids for scaled peri/apocenter radii R1, R2 and their derivatives in {E, L/Lcirc}:
-    math::Matrix<double> gridR1  (sizeE, sizeL), gridR2  (sizeE, sizeL);
-    math::Matrix<double> gridR1dE(sizeE, sizeL), gridR1dL(sizeE, sizeL);
-    math::Matrix<double> gridR2dE(sizeE, sizeL), gridR2dL(sizeE, sizeL);
-
-    // loop over values of energy strictly inside the interval [Ein:0];
-    // the boundary values will be treated separately
-    for(unsigned int iE=1; iE<sizeE-1; iE++) {
+void Interpolator2d::computeRow(unsigned int iE) const
+{
+    if(!rows[iE].empty())
+        return;
+    const unsigned int sizeE = gridE.size(), sizeL = gridL.size(), N = INTERP2D_NUM_VALUES;
+    // values of scaled peri/apocenter radii R1, R2 and their derivatives in {E, L/Lcirc}
+    // for each node in the given row, stored as {R1, R2, R1dE, R1dL, R2dE, R2dL}
+    std::vector<double> row(sizeL * N);
+
+    if(iE == 0) {
+        // asymptotic values at E -> Phi0
+        computeRow(1);
+        const std::vector<double>& next = rows[1];
+        double dE = gridE[1] - gridE[0];
+        for(unsigned int iL=0; iL<sizeL-1; iL++) {
+            double Z = gridL[iL];
+            RPeriApoRootFinderPowerLaw fnc(slope, Z*Z);
+            double R1overRc = math::findRoot(fnc, 0, 1, ACCURACY_ROOT);
+            double R2overRc = iL==0 ? std::pow(1+slope/2, 1/slope) : math::findRoot(fnc, 1, 2, ACCURACY_ROOT);
+            double dR1overRc_dZ = iL==0 ? sqrt(slope/(slope+2)) :
+                slope*Z / ((slope+2) * (1-std::pow(R1overRc, slope)) * R1overRc);
+            double dR2overRc_dZ = slope*Z / ((slope+2) * (1-std::pow(R2overRc, slope)) * R2overRc);
+            row[iL*N  ] = pow_2(R1overRc-1);
+            row[iL*N+1] = pow_2(R2overRc-1);
+            row[iL*N+3] = 2 * (R1overRc-1) * dR1overRc_dZ;
+            row[iL*N+5] = 2 * (R2overRc-1) * dR2overRc_dZ;
+            // we cannot directly compute derivatives w.r.t energy at gridE[0],
+            // so we use quadratic interpolation to obtain them
+            // from the values at gridE[0], gridE[1] and derivs w.r.t E at gridE[1]
+            row[iL*N+2] = 2 * (next[iL*N  ] - row[iL*N  ]) / dE - next[iL*N+2];
+            row[iL*N+4] = 2 * (next[iL*N+1] - row[iL*N+1]) / dE - next[iL*N+4];
+        }
+        // limiting values for L=Lcirc
+        row[(sizeL-1)*N+3] = row[(sizeL-1)*N+5] = -2/(slope+2);
+    } else if(iE == sizeE-1) {
+        // asymptotic values at E -> 0, assuming Keplerian regime
+        computeRow(sizeE-2);
+        const std::vector<double>& prev = rows[sizeE-2];
+        double dE = gridE[sizeE-1] - gridE[sizeE-2];
+        for(unsigned int iL=0; iL<sizeL; iL++) {
+            row[iL*N  ] = row[iL*N+1] = 1 - pow_2(gridL[iL]);
+            row[iL*N+3] = row[iL*N+5] = -2*gridL[iL];
+            row[iL*N+2] = -prev[iL*N+2] + 2 * (row[iL*N  ] - prev[iL*N  ]) / dE;
+            row[iL*N+4] = -prev[iL*N+4] + 2 * (row[iL*N+1] - prev[iL*N+1]) / dE;
+        }
+    } else {
+        // values of energy strictly inside the interval [Phi0:0];
+        // the potential is represented by the 1d interpolator in the equatorial plane
+        const FunctionToPotentialWrapper potential(pot);
         double E = gridE[iE];
         coord::GradCyl grad;
         coord::HessCyl hess;
-        double Rc     = potential::R_circ(potential, E);  // radius of a circular orbit with this energy
+        double Rc     = potential::R_circ(pot, E);  // radius of a circular orbit with this energy
         potential.eval(coord::PosCyl(Rc,0,0), NULL, &grad, &hess);
         double Lc     = Rc*sqrt(Rc*grad.dR);              // corresponding angular momentum
         double Om2kap2= grad.dR / (3*grad.dR + Rc*hess.dR2);  // ratio of epi.freqs (Omega / kappa)^2
@@ -785,11 +843,11 @@ Interpolator2d::Interpolator2d(const BasePotential& potential) :
             double R1, R2, Phi;
             if(iL==0) {  // exact values for a radial orbit
                 R1=0;
-                R2=potential::R_max(potential, E);
+                R2=potential::R_max(pot, E);
             } else
                 potential::findPlanarOrbitExtent(potential, E, L, R1, R2);
-            gridR1(iE, iL) = pow_2((R1-Rc)/Rc);
-            gridR2(iE, iL) = pow_2((R2-Rc)/Rc);
+            row[iL*N  ] = pow_2((R1-Rc)/Rc);
+            row[iL*N+1] = pow_2((R2-Rc)/Rc);
             // compute derivatives of Rperi/apo w.r.t. E and L/Lcirc
             potential.eval(coord::PosCyl(R1,0,0), &Phi, &grad);
             if(R1==0) grad.dR=0;   // it won't be used anyway, but prevents a possible NaN
@@ -798,80 +856,124 @@ Interpolator2d::Interpolator2d(const BasePotential& potential) :
             potential.eval(coord::PosCyl(R2,0,0), &Phi, &grad);
             double dR2dE = (1 - 2*(E-Phi) * dLcdE / Lc) / (grad.dR - 2*(E-Phi) / R2);
             double dR2dZ = -Lc * L / (grad.dR * pow_2(R2) - 2*(E-Phi) * R2);
-            gridR1dE(iE, iL) = 2*(R1-Rc) / pow_2(Rc) * (dR1dE - R1/Rc * dRcdE);
-            gridR1dL(iE, iL) = 2*(R1-Rc) / pow_2(Rc) *  dR1dZ;
-            gridR2dE(iE, iL) = 2*(R2-Rc) / pow_2(Rc) * (dR2dE - R2/Rc * dRcdE);
-            gridR2dL(iE, iL) = 2*(R2-Rc) / pow_2(Rc) *  dR2dZ;
+            row[iL*N+2] = 2*(R1-Rc) / pow_2(Rc) * (dR1dE - R1/Rc * dRcdE);
+            row[iL*N+3] = 2*(R1-Rc) / pow_2(Rc) *  dR1dZ;
+            row[iL*N+4] = 2*(R2-Rc) / pow_2(Rc) * (dR2dE - R2/Rc * dRcdE);
+            row[iL*N+5] = 2*(R2-Rc) / pow_2(Rc) *  dR2dZ;
         }
         // limiting values for a nearly circular orbit:
         // R{1,2} = Rcirc * (1 +- Omega/kappa * ecc),  where ecc = sqrt(1 - (L/Lcirc)^2)
-        gridR1(iE, sizeL-1) = gridR2(iE, sizeL-1) = gridR1dE(iE, sizeL-1) = gridR2dE(iE, sizeL-1) = 0;
-        gridR1dL(iE, sizeL-1) = gridR2dL(iE, sizeL-1) = -2*Om2kap2;
+        row[(sizeL-1)*N+3] = row[(sizeL-1)*N+5] = -2*Om2kap2;
     }
+    rows[iE].swap(row);
+}
 
-    // asymptotic values at E -> Phi0
-    double dE = gridE[1] - gridE[0];
-    for(unsigned int iL=0; iL<sizeL-1; iL++) {
-        double Z = gridL[iL];
-        RPeriApoRootFinderPowerLaw fnc(slope, Z*Z);
-        double R1overRc = math::findRoot(fnc, 0, 1, ACCURACY_ROOT);
-        double R2overRc = iL==0 ? std::pow(1+slope/2, 1/slope) : math::findRoot(fnc, 1, 2, ACCURACY_ROOT);
-        double dR1overRc_dZ = iL==0 ? sqrt(slope/(slope+2)) :
-            slope*Z / ((slope+2) * (1-std::pow(R1overRc, slope)) * R1overRc);
-        double dR2overRc_dZ = slope*Z / ((slope+2) * (1-std::pow(R2overRc, slope)) * R2overRc);
-        gridR1  (0, iL) = pow_2(R1overRc-1);
-        gridR2  (0, iL) = pow_2(R2overRc-1);
-        gridR1dL(0, iL) =  2 * (R1overRc-1) * dR1overRc_dZ;
-        gridR2dL(0, iL) =  2 * (R2overRc-1) * dR2overRc_dZ;
-        // we cannot directly compute derivatives w.r.t energy at gridE[0],
-        // so we use quadratic interpolation to obtain them
-        // from the values at gridE[0], gridE[1] and derivs w.r.t E at gridE[1]
-        gridR1dE(0, iL) = 2 * (gridR1(1, iL) - gridR1(0, iL)) / dE - gridR1dE(1, iL);
-        gridR2dE(0, iL) = 2 * (gridR2(1, iL) - gridR2(0, iL)) / dE - gridR2dE(1, iL);
-    }
-    // limiting values for L=Lcirc
-    gridR1  (0, sizeL-1) = gridR2  (0, sizeL-1) = gridR1dE(0, sizeL-1) = gridR2dE(0, sizeL-1) = 0;
-    gridR1dL(0, sizeL-1) = gridR2dL(0, sizeL-1) = -2/(slope+2);
-
-    // asymptotic values at E -> 0, assuming Keplerian regime
-    dE = gridE[sizeE-1] - gridE[sizeE-2];
-    for(unsigned int iL=0; iL<sizeL; iL++) {
-        gridR1  (sizeE-1, iL) = gridR2  (sizeE-1, iL) = 1 - pow_2(gridL[iL]);
-        gridR1dL(sizeE-1, iL) = gridR2dL(sizeE-1, iL) = -2*gridL[iL];
-        gridR1dE(sizeE-1, iL) = -gridR1dE(sizeE-2, iL) +
-            2 * (gridR1(sizeE-1, iL) - gridR1(sizeE-2, iL)) / dE;
-        gridR2dE(sizeE-1, iL) = -gridR2dE(sizeE-2, iL) +
-            2 * (gridR2(sizeE-1, iL) - gridR2(sizeE-2, iL)) / dE;
+const Interpolator2d::Tile* Interpolator2d::getTile(double E) const
+{
+    const unsigned int sizeE = gridE.size(), sizeL = gridL.size(), N = INTERP2D_NUM_VALUES;
+    if(!(E >= gridE[0] && E <= gridE[sizeE-1]))
+        return NULL;
+    const unsigned int index = std::min<unsigned int>(tiles.size()-1,
+        math::binSearch(E, &gridE[0], sizeE) / tileSize);
+    // double-checked initialization: each tile is constructed only once,
+    // even if the first access happens simultaneously from several OpenMP threads;
+    // the tile is published by setting its flag after it is complete, and is accessed
+    // outside the critical section only after the flag has been seen to be set
+    int ready;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+    ready = tileReady[index];
+    if(ready) {
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+        return tiles[index].get();
     }
-
-#if 0  /// test code, to be removed
-    std::ofstream strm("potentialInterpolator2d.log");
-    strm << std::setprecision(15);
-    for(unsigned int iE=0; iE<sizeE; iE++) {
-        for(unsigned int iL=0; iL<sizeL; iL++) {
-            strm << gridE[iE] << "\t" << gridL[iL] << "\t" << 
-            gridR1  (iE, iL) << "\t" << gridR1dE(iE, iL) << "\t" << gridR1dL(iE, iL) << "\t" <<
-            (iE>0 ? (gridR1(iE, iL)-gridR1(iE-1, iL)) / (gridE[iE]-gridE[iE-1]) : NAN) << "\t" <<
-            (iL>0 ? (gridR1(iE, iL)-gridR1(iE, iL-1)) / (gridL[iL]-gridL[iL-1]) : NAN) << "\t" <<
-            gridR2  (iE, iL) << "\t" << gridR2dE(iE, iL) << "\t" << gridR2dL(iE, iL) << "\t" <<
-            (iE>0 ? (gridR2(iE, iL)-gridR2(iE-1, iL)) / (gridE[iE]-gridE[iE-1]) : NAN) << "\t" <<
-            (iL>0 ? (gridR2(iE, iL)-gridR2(iE, iL-1)) / (gridL[iL]-gridL[iL-1]) : NAN) << "\n";
+    const Tile* ptr = NULL;
+    std::string error;
+    // exceptions must not escape the critical section, so are caught and rethrown afterwards
+#ifdef _OPENMP
+#pragma omp critical(Interpolator2dTiles)
+#endif
+    {
+        if(!tiles[index]) {
+            try{
+                // range of rows of the energy grid covered by this tile, including the overlap
+                const int
+                first = std::max<int>(0, int(index * tileSize) - int(INTERP2D_OVERLAP)),
+                last  = std::min<int>(sizeE-1, (index+1) * tileSize + INTERP2D_OVERLAP);
+                // compute the rows strictly inside the interval [Phi0:0] in parallel,
+                // and the boundary rows (if needed) afterwards, since they depend on the adjacent ones
+                const int firstInner = std::max(first, 1), lastInner = std::min<int>(last, sizeE-2);
+                std::string errorMessage;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+                for(int iE=firstInner; iE<=lastInner; iE++) {
+                    try{
+                        computeRow(iE);
+                    }
+                    catch(std::exception& e) {
+                        errorMessage = e.what();
+                    }
+                }
+                if(!errorMessage.empty())
+                    throw std::runtime_error(errorMessage);
+                computeRow(first);
+                computeRow(last);
+
+                // fill 2d grids for scaled peri/apocenter radii R1, R2 and their derivatives in {E, L/Lcirc}
+                const unsigned int size = last-first+1;
+                std::vector<double> tileE(gridE.begin()+first, gridE.begin()+last+1);
+                math::Matrix<double> gridR1  (size, sizeL), gridR2  (size, sizeL);
+                math::Matrix<double> gridR1dE(size, sizeL), gridR1dL(size, sizeL);
+                math::Matrix<double> gridR2dE(size, sizeL), gridR2dL(size, sizeL);
+                for(unsigned int i=0; i<size; i++) {
+                    const std::vector<double>& row = rows[i+first];
+                    for(unsigned int iL=0; iL<sizeL; iL++) {
+                        gridR1  (i, iL) = row[iL*N  ];
+                        gridR2  (i, iL) = row[iL*N+1];
+                        gridR1dE(i, iL) = row[iL*N+2];
+                        gridR1dL(i, iL) = row[iL*N+3];
+                        gridR2dE(i, iL) = row[iL*N+4];
+                        gridR2dL(i, iL) = row[iL*N+5];
+                    }
+                }
+
+                // create 2d interpolators
+                Tile* tile = new Tile();
+                shared_ptr<const Tile> result(tile);
+                tile->intR1 = math::QuinticSpline2d(tileE, gridL, gridR1, gridR1dE, gridR1dL);
+                tile->intR2 = math::QuinticSpline2d(tileE, gridL, gridR2, gridR2dE, gridR2dL);
+                tiles[index] = result;
+#ifdef _OPENMP
+#pragma omp flush
+#pragma omp atomic write
+#endif
+                tileReady[index] = 1;
+            }
+            catch(std::exception& e) {
+                error = e.what();
+            }
         }
-        strm<<"\n";
+        ptr = tiles[index].get();
     }
-    strm.close();
-#endif
-
-    // create 2d interpolators
-    intR1 = math::QuinticSpline2d(gridE, gridL, gridR1, gridR1dE, gridR1dL);
-    intR2 = math::QuinticSpline2d(gridE, gridL, gridR2, gridR2dE, gridR2dL);
+    if(!error.empty())
+        throw std::runtime_error("Interpolator2d: " + error);
+    return ptr;
 }
 
 void Interpolator2d::findScaledOrbitExtent(double E, double Lrel,
     double &R1rel, double &R2rel) const
 {
-    R1rel = 1 - sqrt(intR1.value(E, Lrel));
-    R2rel = 1 + sqrt(intR2.value(E, Lrel));
+    const Tile* tile = getTile(E);
+    if(!tile) {  // energy is outside the allowed range
+        R1rel = R2rel = NAN;
+        return;
+    }
+    R1rel = 1 - sqrt(tile->intR1.value(E, Lrel));
+    R2rel = 1 + sqrt(tile->intR2.value(E, Lrel));
 }
 
 void Interpolator2d::findPlanarOrbitExtent(double E, double L,
@@ -6,6 +6,7 @@
 #pragma once
 #include "potential_base.h"
 #include "math_spline.h"
+#include "smart.h"
 
 namespace potential{
 
@@ -192,12 +193,21 @@ private:
     The accuracy of peri/apocenter radii interpolation is at the level of 1e-10 or better
     for almost all orbits; however, if the density profile is not decaying fast enough at infinity
     (i.e. r^-3 or shallower), the accuracy is rapidly deteriorating for very loosely bound orbits.
+    The 2d interpolation tables are split into several tiles in energy, which are constructed
+    on demand when the corresponding range of energy is accessed for the first time
+    (this is thread-safe), so that the cost of initialization is proportional to the range
+    of energies actually used.
 */
 class Interpolator2d {
 public:
-    /** Create internal interpolation tables for the given potential,
-        which itself is not used afterwards */
-    explicit Interpolator2d(const BasePotential& potential);
+    /** Create the internal 1d interpolator for the given potential, which itself is not used
+        afterwards (2d interpolation tables are constructed from the 1d interpolator when needed).
+        \param[in]  potential  is the instance of an axisymmetric potential;
+        \param[in]  tileSize  is the number of intervals of the energy grid covered by each tile
+        (0 means the default value); if it is not smaller than the size of the grid,
+        a single table for the entire range of energies is constructed on first access.
+    */
+    explicit Interpolator2d(const BasePotential& potential, unsigned int tileSize=0);
 
     /** Compute parameters of an orbit in the equatorial plane with the given energy and ang.momentum.
         \param[in]  E is the energy, which must be in the range Phi(0) <= E < 0;
@@ -226,7 +236,30 @@ public:
     const Interpolator pot;
 
 private:
-    math::QuinticSpline2d intR1, intR2; ///< 2d interpolators for scaled peri/apocenter radii
+    /// 2d interpolators for scaled peri/apocenter radii in a range of energies
+    struct Tile {
+        math::QuinticSpline2d intR1, intR2;
+    };
+    std::vector<double> gridE;   ///< grid in energy
+    std::vector<double> gridL;   ///< grid in L/Lcirc(E)
+    double slope;                ///< power-law index of potential at r->0
+    unsigned int tileSize;       ///< number of intervals of the energy grid in each tile
+    /// tiles of 2d interpolators, each one is constructed on first access
+    mutable std::vector<shared_ptr<const Tile> > tiles;
+    /// flags indicating that the corresponding tile has been constructed: they are set only
+    /// after the tile is complete and are accessed atomically, while the tile itself is read
+    /// only after its flag has been seen to be set
+    mutable std::vector<int> tileReady;
+    /// values and derivatives of scaled peri/apocenter radii at the nodes of each row of
+    /// the energy grid, computed on demand (empty for rows that are not needed yet)
+    mutable std::vector<std::vector<double> > rows;
+
+    /// return the tile containing the given energy, constructing it if necessary,
+    /// or NULL if the energy is outside the grid
+    const Tile* getTile(double E) const;
+
+    /// compute the values at one row of the energy grid, if it was not already computed
+    void computeRow(unsigned int iE) const;
 };
 
 
@@ -35,6 +35,7 @@
 // include almost everything!
 #include "actions_spherical.h"
 #include "actions_staeckel.h"
+#include "actions_triaxial.h"
 #include "df_factory.h"
 #include "df_interpolated.h"
 #include "df_pseudoisotropic.h"
@@ -96,6 +97,59 @@ public:
 #endif
 };
 
+/// A lock-type object that sets the maximum number of OpenMP threads used in a single call
+/// of a Python API function (the value of its optional 'nthreads' argument) and restores
+/// the previous setting upon destruction. Since this setting is specific to the calling thread,
+/// several Python threads may run concurrent computations each with its own number of threads.
+/// A zero or negative value leaves the current setting unchanged; without OpenMP this is a no-op.
+class OmpThreads {
+#ifdef _OPENMP
+    int origMaxThreads;  ///< the value effective before this object was constructed
+public:
+    explicit OmpThreads(int numThreads) : origMaxThreads(omp_get_max_threads())
+    {
+        if(numThreads > 0)
+            omp_set_num_threads(numThreads);
+    }
+    ~OmpThreads()
+    {
+        omp_set_num_threads(origMaxThreads);
+    }
+#else
+public:
+    explicit OmpThreads(int) {}
+#endif
+};
+
+///@}
+//  ----------------------------------------------------------------
+/// \name  Helper classes to manage the Python global interpreter lock
+//  ----------------------------------------------------------------
+///@{
+
+/// This is a lock-type object that releases the Python global interpreter lock (GIL)
+/// during its existence and reacquires it upon destruction. It is placed around lengthy
+/// computations that do not use the Python C API, so that other Python threads may run
+/// concurrently; the code inside such sections that needs to access Python objects
+/// (e.g., user-defined callback functions or creation of Python objects)
+/// must temporarily reacquire the GIL using the `PyAcquireGIL` object.
+class PyReleaseGIL {
+    PyThreadState* state;  ///< the thread state saved when the lock was released
+public:
+    PyReleaseGIL() : state(PyEval_SaveThread()) {}
+    ~PyReleaseGIL() { PyEval_RestoreThread(state); }
+};
+
+/// A lock-type object that acquires the Python GIL during its existence, regardless of
+/// the thread it is created in; if the GIL is already held by the current thread, this is a no-op.
+/// Concurrent threads that need to call Python routines are serialized by this lock.
+class PyAcquireGIL {
+    PyGILState_STATE state;  ///< the state of the GIL before this object was constructed
+public:
+    PyAcquireGIL() : state(PyGILState_Ensure()) {}
+    ~PyAcquireGIL() { PyGILState_Release(state); }
+};
+
 ///@}
 //  ----------------------------------------------------------------------------
 /// \name  Mechanism for capturing the Control-C signal in lengthy calculations
@@ -108,6 +162,27 @@ volatile sig_atomic_t keyboardInterruptTriggered = 0;
 void customKeyboardInterruptHandler(int) { keyboardInterruptTriggered = 1; }
 /// previous signal handler restored after the computation is finished
 void (*defaultKeyboardInterruptHandler)(int) = NULL;
+/// number of lengthy computations (possibly running concurrently in several Python threads)
+/// that currently use the custom signal handler
+int numKeyboardInterruptUsers = 0;
+
+/// install the custom signal handler at the beginning of a lengthy computation
+/// (must be called while holding the GIL, which serializes the access to these variables)
+void installKeyboardInterruptHandler()
+{
+    if(numKeyboardInterruptUsers++ == 0) {
+        keyboardInterruptTriggered = 0;
+        defaultKeyboardInterruptHandler = signal(SIGINT, customKeyboardInterruptHandler);
+    }
+}
+
+/// restore the previous signal handler when the last of concurrent computations has finished
+/// (must be called while holding the GIL)
+void restoreKeyboardInterruptHandler()
+{
+    if(--numKeyboardInterruptUsers == 0)
+        signal(SIGINT, defaultKeyboardInterruptHandler);
+}
 
 ///@}
 //  ------------------------------------------------------------------
@@ -380,6 +455,36 @@ PyObject* resetUnits(PyObject* /*self*/, PyObject* /*args*/)
     return Py_None;
 }
 
+/// description of setCacheDir function
+static const char* docstringSetCacheDir =
+    "Set the directory for the on-disk cache of potential expansions and action-finder "
+    "interpolation tables.\n"
+    "When the cache is enabled, potential expansions constructed from analytic density profiles "
+    "(including the Multipole part of GalPot-style models) and interpolation tables of the "
+    "axisymmetric Staeckel fudge action finder are stored in this directory under names derived "
+    "from a hash of all construction parameters, and are loaded from there if the same object "
+    "is requested again (e.g., in subsequent runs of the same script).\n"
+    "Arguments:\n"
+    "  dir:  an existing writable directory; empty string or None disables the cache "
+    "(default, unless the environment variable AGAMA_CACHE_DIR is set).\n"
+    "Returns:\n"
+    "  the previous value of the cache directory.\n";
+
+/// set the cache directory
+PyObject* setCacheDir(PyObject* /*self*/, PyObject* arg)
+{
+    std::string prev = utils::getCacheDirectory();
+    if(arg == Py_None)
+        utils::setCacheDirectory("");
+    else if(PyString_Check(arg))
+        utils::setCacheDirectory(PyString_AsString(arg));
+    else {
+        PyErr_SetString(PyExc_TypeError, "setCacheDir() expects a string or None");
+        return NULL;
+    }
+    return Py_BuildValue("s", prev.c_str());
+}
+
 /// helper function for converting position to internal units
 inline coord::PosCar convertPos(const double input[]) {
     return coord::PosCar(
@@ -434,6 +539,162 @@ inline void unconvertActions(const actions::Actions& act, double dest[])
     dest[2] = act.Jphi / (conv->lengthUnit * conv->velocityUnit);
 }
 
+/// obtain a NumPy array of floats from an arbitrary Python object, avoiding a copy if possible:
+/// an existing array of doubles is used directly as long as its last dimension is contiguous,
+/// so that each row may be accessed as a plain C array, even if the array as a whole is not
+/// contiguous (e.g., a subset of columns of a larger array); otherwise a converted copy is made.
+/// \return  a new reference to the array, or NULL if the input cannot be converted
+PyArrayObject* toRowContiguousArray(PyObject* obj)
+{
+    PyArrayObject* arr = (PyArrayObject*) PyArray_FROM_OTF(obj, NPY_DOUBLE, NPY_ARRAY_ALIGNED);
+    if(arr && PyArray_NDIM(arr) >= 1 && PyArray_DIM(arr, PyArray_NDIM(arr)-1) > 1 &&
+        PyArray_STRIDE(arr, PyArray_NDIM(arr)-1) != sizeof(double))
+    {
+        PyArrayObject* copy = (PyArrayObject*)
+            PyArray_FROM_OTF((PyObject*)arr, NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
+        Py_DECREF(arr);
+        arr = copy;
+    }
+    return arr;
+}
+
+/// number of columns in the array of particle coordinates:
+/// 3 for position-only or 6 for position+velocity particle types
+template<typename ParticleT> inline int particleNumColumns();
+template<> inline int particleNumColumns<coord::PosCar>()    { return 3; }
+template<> inline int particleNumColumns<coord::PosCyl>()    { return 3; }
+template<> inline int particleNumColumns<coord::PosVelCar>() { return 6; }
+template<> inline int particleNumColumns<coord::PosVelCyl>() { return 6; }
+
+/// construct a particle from an array of 6 numbers (position and velocity in cartesian coordinates)
+inline void packParticle(const double xv[], coord::PosCar& point) {
+    point = coord::PosCar(xv[0], xv[1], xv[2]); }
+inline void packParticle(const double xv[], coord::PosVelCar& point) {
+    point = coord::PosVelCar(xv); }
+inline void packParticle(const double xv[], coord::PosCyl& point) {
+    point = coord::toPosCyl(coord::PosCar(xv[0], xv[1], xv[2])); }
+
+/// store the cartesian position [and velocity] of a particle in an array of 3 [or 6] numbers
+inline void unpackParticle(const coord::PosCar& point, double dest[]) {
+    dest[0] = point.x;  dest[1] = point.y;  dest[2] = point.z; }
+inline void unpackParticle(const coord::PosCyl& point, double dest[]) {
+    unpackParticle(coord::toPosCar(point), dest); }
+inline void unpackParticle(const coord::PosVelCar& point, double dest[]) {
+    point.unpack_to(dest); }
+inline void unpackParticle(const coord::PosVelCyl& point, double dest[]) {
+    coord::toPosVelCar(point).unpack_to(dest); }
+
+/** Convert a tuple of two arrays - coordinates (Nx3 or Nx6: positions and optionally velocities)
+    and masses (length N) - into a C++ particle array.
+    Input arrays of doubles are accessed in place without making an intermediate copy,
+    and the particle array is filled in a single parallel pass without holding the GIL,
+    performing the unit conversion on the fly. The resulting particle array is still a copy
+    of the input data, since the C++ routines that consume it require this container.
+    \tparam  ParticleT  is either coord::PosCar or coord::PosCyl (velocities, if provided,
+    are ignored), or coord::PosVelCar (velocities are set to zero if not provided);
+    \param[in]  particlesObj  is the Python tuple with two arrays;
+    \param[in]  convertUnits  determines whether to convert the input from user to internal units;
+    \param[out] result  will contain the particles;
+    \return  true if the input contained velocities;
+    \throw  std::invalid_argument if the input arrays are not valid.
+*/
+template<typename ParticleT>
+bool convertParticles(PyObject* particlesObj, bool convertUnits,
+    particles::ParticleArray<ParticleT>& result)
+{
+    static const char* errorstr = "'particles' must be a tuple with two arrays - "
+        "coordinates[+velocities] and mass, where the first one is a two-dimensional "
+        "Nx3 or Nx6 array and the second one is a one-dimensional array of length N";
+    PyObject *pointCoordObj, *pointMassObj;
+    if(!PyArg_ParseTuple(particlesObj, "OO", &pointCoordObj, &pointMassObj)) {
+        PyErr_Clear();
+        throw std::invalid_argument(errorstr);
+    }
+    PyArrayObject *pointCoordArr = toRowContiguousArray(pointCoordObj);
+    PyArrayObject *pointMassArr  = (PyArrayObject*)
+        PyArray_FROM_OTF(pointMassObj, NPY_DOUBLE, NPY_ARRAY_ALIGNED);
+    npy_intp nbody = 0;
+    if( pointCoordArr == NULL || pointMassArr == NULL ||  // input should contain valid arrays
+        PyArray_NDIM(pointMassArr) != 1 ||                // the second one should be 1d array
+        (nbody = PyArray_DIM(pointMassArr, 0)) <= 0 ||    // of length nbody > 0
+        PyArray_NDIM(pointCoordArr) != 2 ||               // the first one should be a 2d array
+        PyArray_DIM(pointCoordArr, 0) != nbody ||         // with nbody rows
+       (PyArray_DIM(pointCoordArr, 1) != 3 && PyArray_DIM(pointCoordArr, 1) != 6))  // and 3 or 6 columns
+    {
+        Py_XDECREF(pointCoordArr);
+        Py_XDECREF(pointMassArr);
+        PyErr_Clear();
+        throw std::invalid_argument(errorstr);
+    }
+    const bool haveVel = PyArray_DIM(pointCoordArr, 1) == 6;
+    const double
+        lengthUnit   = convertUnits ? conv->lengthUnit   : 1,
+        velocityUnit = convertUnits ? conv->velocityUnit : 1,
+        massUnit     = convertUnits ? conv->massUnit     : 1;
+    result.data.resize(nbody);
+    {
+        PyReleaseGIL unlock;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for(npy_intp i=0; i<nbody; i++) {
+            const double* src = &pyArrayElem<double>(pointCoordArr, i, 0);
+            double xv[6] = {src[0] * lengthUnit, src[1] * lengthUnit, src[2] * lengthUnit, 0, 0, 0};
+            if(haveVel) {
+                xv[3] = src[3] * velocityUnit;
+                xv[4] = src[4] * velocityUnit;
+                xv[5] = src[5] * velocityUnit;
+            }
+            packParticle(xv, result.data[i].first);
+            result.data[i].second = pyArrayElem<double>(pointMassArr, i) * massUnit;
+        }
+    }
+    Py_DECREF(pointCoordArr);
+    Py_DECREF(pointMassArr);
+    return haveVel;
+}
+
+/** Construct a tuple of two NumPy arrays - cartesian coordinates (Nx3 or Nx6, depending on
+    the particle type) and masses - from a C++ particle array, optionally converting
+    from internal to user units. The output arrays are filled in place in a single parallel pass
+    without holding the GIL.
+    \return  a new reference to the tuple, or NULL if the arrays could not be allocated.
+*/
+template<typename ParticleT>
+PyObject* createParticlesTuple(const particles::ParticleArray<ParticleT>& points, bool convertUnits)
+{
+    const int ncols = particleNumColumns<ParticleT>();
+    npy_intp dims[] = {static_cast<npy_intp>(points.size()), ncols};
+    PyObject* coord_arr = PyArray_SimpleNew(2, dims, NPY_DOUBLE);
+    PyObject* mass_arr  = PyArray_SimpleNew(1, dims, NPY_DOUBLE);
+    if(!coord_arr || !mass_arr) {
+        Py_XDECREF(coord_arr);
+        Py_XDECREF(mass_arr);
+        return NULL;
+    }
+    const double
+        lengthUnit   = convertUnits ? conv->lengthUnit   : 1,
+        velocityUnit = convertUnits ? conv->velocityUnit : 1,
+        massUnit     = convertUnits ? conv->massUnit     : 1;
+    double* coordData = static_cast<double*>(PyArray_DATA((PyArrayObject*)coord_arr));
+    double* massData  = static_cast<double*>(PyArray_DATA((PyArrayObject*)mass_arr));
+    const npy_intp size = dims[0];
+    {
+        PyReleaseGIL unlock;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for(npy_intp i=0; i<size; i++) {
+            double* dest = coordData + i * ncols;
+            unpackParticle(points.point(i), dest);
+            for(int c=0; c<ncols; c++)
+                dest[c] /= c<3 ? lengthUnit : velocityUnit;
+            massData[i] = points.mass(i) / massUnit;
+        }
+    }
+    return Py_BuildValue("NN", coord_arr, mass_arr);
+}
+
 
 ///@}
 //  --------------------------------------------------------------
@@ -801,7 +1062,7 @@ PyObject* callAnyFunctionOnArray(void* params, PyObject* args, anyFunction fnc)
                 obj = args;   // the entire tuple of arguments is the input array
         }
         if(obj) {
-            PyArrayObject *arr = (PyArrayObject*) PyArray_FROM_OTF(obj,  NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
+            PyArrayObject *arr = toRowContiguousArray(obj);  // no copy for an existing array of doubles
             if(arr == NULL) {
                 PyErr_SetString(PyExc_ValueError, "Input does not contain a valid array");
                 return NULL;
@@ -820,23 +1081,35 @@ PyObject* callAnyFunctionOnArray(void* params, PyObject* args, anyFunction fnc)
                 Py_DECREF(arr);
                 return NULL;
             }
-            keyboardInterruptTriggered = 0;
-            defaultKeyboardInterruptHandler = signal(SIGINT, customKeyboardInterruptHandler);
+            installKeyboardInterruptHandler();
             // allocate an appropriate output object
             PyObject* outputObj = allocOutputArr<numOutput>(numpt);
-            // loop over input array
+            std::string errorMsg;
+            {   // the loop does not use the Python C API, so the GIL is released for its duration
+                PyReleaseGIL unlock;
+                // loop over input array
 #ifdef _OPENMP
 #pragma omp parallel for schedule(dynamic)
 #endif
-            for(int i=0; i<numpt; i++) {
-                if(keyboardInterruptTriggered) continue;
-                double local_output[outputLength<numOutput>()];  // separate variable in each thread
-                fnc(params, &pyArrayElem<double>(arr, i, 0), local_output);
-                formatOutputArr<numOutput>(local_output, i, outputObj);
+                for(int i=0; i<numpt; i++) {
+                    if(keyboardInterruptTriggered) continue;
+                    double local_output[outputLength<numOutput>()];  // separate variable in each thread
+                    // exceptions must not leave the OpenMP block, so they are caught and rethrown later
+                    try{
+                        fnc(params, &pyArrayElem<double>(arr, i, 0), local_output);
+                        formatOutputArr<numOutput>(local_output, i, outputObj);
+                    }
+                    catch(std::exception& e) {
+                        errorMsg = e.what();
+                    }
+                }
             }
             Py_DECREF(arr);
-            signal(SIGINT, defaultKeyboardInterruptHandler);
-            if(keyboardInterruptTriggered) {
+            restoreKeyboardInterruptHandler();
+            if(keyboardInterruptTriggered || !errorMsg.empty()) {
+                Py_DECREF(outputObj);
+                if(!errorMsg.empty())
+                    throw std::runtime_error(errorMsg);
                 PyErr_SetObject(PyExc_KeyboardInterrupt, NULL);
                 return NULL;
             }
@@ -847,7 +1120,6 @@ PyObject* callAnyFunctionOnArray(void* params, PyObject* args, anyFunction fnc)
     }
     catch(std::exception& e) {
         PyErr_SetString(PyExc_ValueError, (std::string("Exception occurred: ")+e.what()).c_str());
-        signal(SIGINT, defaultKeyboardInterruptHandler);
         return NULL;
     }
 }
@@ -1054,12 +1326,12 @@ PyObject* Density_export(PyObject* self, PyObject* args)
 /// shared between Density and Potential classes
 PyObject* sampleDensity(const potential::BaseDensity& dens, PyObject* args, PyObject* namedArgs)
 {
-    static const char* keywords[] = {"n", "potential", "beta", "kappa", NULL};
-    int numPoints=0;
+    static const char* keywords[] = {"n", "potential", "beta", "kappa", "nthreads", NULL};
+    int numPoints=0, nthreads=0;
     PyObject* pot_obj=NULL;
     double beta=NAN, kappa=NAN;  // undefined by default, if no argument is provided
-    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "i|Odd", const_cast<char**>(keywords),
-        &numPoints, &pot_obj, &beta, &kappa))
+    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "i|Oddi", const_cast<char**>(keywords),
+        &numPoints, &pot_obj, &beta, &kappa, &nthreads))
     {
         return NULL;
     }
@@ -1074,28 +1346,23 @@ PyObject* sampleDensity(const potential::BaseDensity& dens, PyObject* args, PyOb
         return NULL;
     }
     try{
-        // do the sampling of the density profile
-        particles::ParticleArray<coord::PosCyl> points =
-            galaxymodel::generateDensitySamples(dens, numPoints);
-
-        // assign the velocities if needed
+        particles::ParticleArray<coord::PosCyl> points;
         particles::ParticleArrayCar pointsvel;
-        if(pot)
-            pointsvel = galaxymodel::assignVelocity(points, dens, *pot, beta, kappa);
-
-        // convert output to NumPy array
-        numPoints = points.size();
-        npy_intp dims[] = {numPoints, pot? 6 : 3};  // either position or position+velocity
-        PyArrayObject* point_arr = (PyArrayObject*)PyArray_SimpleNew(2, dims, NPY_DOUBLE);
-        PyArrayObject* mass_arr  = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_DOUBLE);
-        for(int i=0; i<numPoints; i++) {
+        {
+            OmpThreads threads(nthreads);
+            PyReleaseGIL unlock;
+            // do the sampling of the density profile
+            points = galaxymodel::generateDensitySamples(dens, numPoints);
+
+            // assign the velocities if needed
             if(pot)
-                unconvertPosVel(pointsvel.point(i), &pyArrayElem<double>(point_arr, i, 0));
-            else
-                unconvertPos(coord::toPosCar(points.point(i)), &pyArrayElem<double>(point_arr, i, 0));
-            pyArrayElem<double>(mass_arr, i) = points.mass(i) / conv->massUnit;
+                pointsvel = galaxymodel::assignVelocity(points, dens, *pot, beta, kappa);
         }
-        return Py_BuildValue("NN", point_arr, mass_arr);
+
+        // convert output to NumPy arrays: either position or position+velocity, and mass
+        return pot ?
+            createParticlesTuple(pointsvel, /*convertUnits*/ true) :
+            createParticlesTuple(points,    /*convertUnits*/ true);
     }
     catch(std::exception& e) {
         PyErr_SetString(PyExc_ValueError, 
@@ -1203,6 +1470,9 @@ static PyMethodDef Density_methods[] = {
       "moment of azimuthal velocity - into the mean streaming velocity <v_phi> and the velocity "
       "dispersion sigma_phi). kappa=0 means no net rotation, kappa=1 corresponds to sigma_phi=sigma_R). "
       "If this argument is provided, this triggers the use of the axisymmetric Jeans method.\n"
+      "  nthreads - the number of OpenMP threads (optional, default 0 means the number set by "
+      "the OMP_NUM_THREADS environment variable); the computation runs without holding "
+      "the Python global interpreter lock.\n"
       "Returns: a tuple of two arrays: "
       "a 2d array of size Nx3 (in case of positions only) or Nx6 (in case of velocity assignment), "
       "and a 1d array of N point masses." },
@@ -1251,6 +1521,34 @@ PyObject* createDensityObject(const potential::PtrDensity& dens)
     return (PyObject*)dens_obj;
 }
 
+/// call a user-defined Python function with a 2d array of N points (each with ndim coordinates)
+/// and store the N values returned by the function (an array of length N or, for N=1,
+/// possibly a single number) in the output array; throw an exception in case of error
+void callPythonFunctionMany(PyObject* fnc, npy_intp npoints, npy_intp ndim,
+    const double input[], double output[], const std::string& fncKind)
+{
+    PyAcquireGIL lock;  // the caller may have released the GIL
+    npy_intp dims[]  = {npoints, ndim};
+    PyObject* args   = PyArray_SimpleNewFromData(2, dims, NPY_DOUBLE, const_cast<double*>(input));
+    PyObject* result = PyObject_CallFunctionObjArgs(fnc, args, NULL);
+    Py_DECREF(args);
+    if(result == NULL) {
+        PyErr_Print();
+        throw std::runtime_error("Call to user-defined " + fncKind + " failed");
+    }
+    PyObject* arr = PyArray_FROM_OTF(result, NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
+    Py_DECREF(result);
+    if(arr == NULL || PyArray_SIZE((PyArrayObject*)arr) != npoints) {
+        Py_XDECREF(arr);
+        PyErr_Clear();
+        throw std::runtime_error("Invalid data type returned from user-defined " + fncKind +
+            " (expected an array of length " + utils::toString((long)npoints) + ")");
+    }
+    const double* data = static_cast<const double*>(PyArray_DATA((PyArrayObject*)arr));
+    std::copy(data, data+npoints, output);
+    Py_DECREF(arr);
+}
+
 /// Helper class for providing a BaseDensity interface
 /// to a Python function that returns density at one or several point
 class DensityWrapper: public potential::BaseDensity{
@@ -1270,6 +1568,7 @@ public:
     {
         utils::msg(utils::VL_VERBOSE, "Agama",
             "Deleted a C++ density wrapper for Python function "+fncname);
+        PyAcquireGIL lock;
         Py_DECREF(fnc);
     }
     virtual coord::SymmetryType symmetry() const { return sym; }
@@ -1279,28 +1578,23 @@ public:
     virtual double densitySph(const coord::PosSph &pos) const {
         return densityCar(toPosCar(pos)); }
     virtual double densityCar(const coord::PosCar &pos) const {
-        double xyz[3];
+        double xyz[3], value;
         unconvertPos(pos, xyz);
-        npy_intp dims[]  = {1, 3};
-        PyObject* args   = PyArray_SimpleNewFromData(2, dims, NPY_DOUBLE, xyz);
-        PyObject* result = PyObject_CallFunctionObjArgs(fnc, args, NULL);
-        Py_DECREF(args);
-        double value;
-        if(result == NULL) {
-            PyErr_Print();
-            throw std::runtime_error("Call to user-defined density function failed");
-        }
-        if(PyArray_Check(result))
-            value = pyArrayElem<double>(result, 0);
-        else if(PyNumber_Check(result))
-            value = PyFloat_AsDouble(result);
-        else {
-            Py_DECREF(result);
-            throw std::runtime_error("Invalid data type returned from user-defined density function");
-        }
-        Py_DECREF(result);
+        callPythonFunctionMany(fnc, 1, 3, xyz, &value, "density function");
         return value * conv->massUnit / pow_3(conv->lengthUnit);
     }
+    /// all points are passed to the Python function as a single Nx3 array
+    virtual void evalmanyDensityCyl(const size_t npoints, const coord::PosCyl pos[],
+        double values[]) const
+    {
+        if(npoints == 0) return;
+        std::vector<double> xyz(npoints * 3);
+        for(size_t p=0; p<npoints; p++)
+            unconvertPos(toPosCar(pos[p]), &xyz[p*3]);
+        callPythonFunctionMany(fnc, npoints, 3, &xyz[0], values, "density function");
+        for(size_t p=0; p<npoints; p++)
+            values[p] *= conv->massUnit / pow_3(conv->lengthUnit);
+    }
 };
 
 
@@ -1383,7 +1677,17 @@ static const char* docstringPotential =
     "coefficient) in Multipole.\n"
     "  mmax=...   order of azimuthal-harmonic expansion (max.index of Fourier coefficient in "
     "phi angle) in Multipole and CylSpline.\n"
-    "  smoothing=...   amount of smoothing in Multipole initialized from an N-body snapshot.\n\n"
+    "  smoothing=...   amount of smoothing in Multipole initialized from an N-body snapshot.\n"
+    "  exact=False   evaluate an axisymmetric Dehnen potential using an internal interpolated "
+    "approximation, which is several times faster than the direct quadrature and has a relative "
+    "error ~1e-5 (default True, i.e. no approximation).\n"
+    "  useFFT=True   solve the Poisson equation for a CylSpline potential initialized from "
+    "a density model using Hankel transforms, which is much faster than the default direct "
+    "integration and only slightly less accurate (default False).\n"
+    "  nthreads=...   number of OpenMP threads used in the construction of a potential expansion "
+    "(default 0 means the number set by the OMP_NUM_THREADS environment variable); "
+    "the construction does not hold the Python global interpreter lock, so that other Python "
+    "threads may run concurrently.\n\n"
     "Most of these parameters have reasonable default values; the only necessary ones are "
     "`type`, and for a potential expansion, `density` or `file` or `particles`.\n"
     "If the coefficiens of a potential expansion are loaded from a file, then the `type` argument "
@@ -1421,42 +1725,11 @@ potential::PtrPotential Potential_initFromParticles(
         throw std::invalid_argument("Cannot provide both 'particles' and 'density' arguments");
     if(!params.contains("type"))
         throw std::invalid_argument("Must provide 'type=\"...\"' argument");
-    PyObject *pointCoordObj, *pointMassObj;
-    if(!PyArg_ParseTuple(points, "OO", &pointCoordObj, &pointMassObj)) {
-        throw std::invalid_argument("'particles' must be a tuple with two arrays - "
-            "coordinates and mass, where the first one is a two-dimensional Nx3 or Nx6 array "
-            "and the second one is a one-dimensional array of length N");
-    }
-    PyArrayObject *pointCoordArr = (PyArrayObject*)
-        PyArray_FROM_OTF(pointCoordObj, NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
-    PyArrayObject *pointMassArr  = (PyArrayObject*)
-        PyArray_FROM_OTF(pointMassObj,  NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
-    if(pointCoordArr == NULL || pointMassArr == NULL) {
-        Py_XDECREF(pointCoordArr);
-        Py_XDECREF(pointMassArr);
-        throw std::invalid_argument("'particles' does not contain valid arrays");
-    }
-    int numpt = 0;
-    if(PyArray_NDIM(pointMassArr) == 1)
-        numpt = PyArray_DIM(pointMassArr, 0);
-    if(numpt == 0 || PyArray_NDIM(pointCoordArr) != 2 ||   // it must be a 2d array
-        PyArray_DIM(pointCoordArr, 0) != numpt ||          // with numpt rows
-        (PyArray_DIM(pointCoordArr, 1) != 3 && PyArray_DIM(pointCoordArr, 1) != 6))  // and 3 or 6 columns
-    {
-        Py_DECREF(pointCoordArr);
-        Py_DECREF(pointMassArr);
-        throw std::invalid_argument("'particles' does not contain valid arrays "
-            "(the first one must be 2d array of shape Nx3 or Nx6, "
-            "and the second one must be 1d array of length N)");
-    }
-    particles::ParticleArray<coord::PosCar> pointArray;
-    pointArray.data.reserve(numpt);
-    for(int i=0; i<numpt; i++) {
-        pointArray.add(convertPos(&pyArrayElem<double>(pointCoordArr, i, 0)),
-            pyArrayElem<double>(pointMassArr, i) * conv->massUnit);
-    }
-    Py_DECREF(pointCoordArr);
-    Py_DECREF(pointMassArr);
+    // potential expansions need only the positions in cylindrical coordinates,
+    // so the particles are converted directly into this form, avoiding another temporary copy
+    particles::ParticleArray<coord::PosCyl> pointArray;
+    convertParticles(points, /*convertUnits*/ true, pointArray);
+    PyReleaseGIL unlock;
     return potential::createPotential(params, pointArray, *conv);
 }
 
@@ -1483,6 +1756,7 @@ potential::PtrPotential Potential_initFromDict(PyObject* args)
             if(params.getString("type").empty())
                 throw std::invalid_argument("'type' argument must be provided");
             params.unset("density");
+            PyReleaseGIL unlock;
             return potential::createPotential(params, *dens, *conv);
         } else if(!PyString_Check(dens_obj)) {
             throw std::invalid_argument(
@@ -1491,6 +1765,7 @@ potential::PtrPotential Potential_initFromDict(PyObject* args)
                 "Density or Potential class, or a user-defined function of 3 coordinates)");
         }
     }
+    PyReleaseGIL unlock;
     return potential::createPotential(params, *conv);
 }
 
@@ -1528,6 +1803,7 @@ potential::PtrPotential Potential_initFromTuple(PyObject* tuple)
         for(Py_ssize_t i=0; i<PyTuple_Size(tuple); i++) {
             paramsArr.push_back(convertPyDictToKeyValueMap(PyTuple_GET_ITEM(tuple, i)));
         }
+        PyReleaseGIL unlock;
         return potential::createPotential(paramsArr, *conv);
     } else
         throw std::invalid_argument(
@@ -1537,6 +1813,25 @@ potential::PtrPotential Potential_initFromTuple(PyObject* tuple)
 /// the generic constructor of Potential object
 int Potential_init(PotentialObject* self, PyObject* args, PyObject* namedArgs)
 {
+    // the optional argument 'nthreads' is not a parameter of the potential itself:
+    // retrieve its value and remove it from (a copy of) the dictionary of named arguments
+    int nthreads = 0;
+    PyObject *key = NULL, *value = NULL;
+    Py_ssize_t pos = 0;
+    while(namedArgs!=NULL && PyDict_Check(namedArgs) && PyDict_Next(namedArgs, &pos, &key, &value)
+        && !utils::stringsEqual(toString(key), "nthreads"))
+        key = NULL;
+    if(key) {
+        nthreads = PyInt_AsLong(value);
+        if(PyErr_Occurred()) {
+            PyErr_SetString(PyExc_ValueError, "Argument 'nthreads' must be an integer");
+            return -1;
+        }
+        namedArgs = PyDict_Copy(namedArgs);
+        PyDict_DelItem(namedArgs, key);
+    } else
+        Py_XINCREF(namedArgs);
+    OmpThreads threads(nthreads);
     try{
         // check if we have only a tuple of potential components as arguments
         if(args!=NULL && PyTuple_Check(args) && PyTuple_Size(args)>0 && 
@@ -1555,9 +1850,11 @@ int Potential_init(PotentialObject* self, PyObject* args, PyObject* namedArgs)
         assert(self->pot);
         utils::msg(utils::VL_VERBOSE, "Agama", "Created "+std::string(self->pot->name())+
             " potential at "+utils::toString(self->pot.get()));
+        Py_XDECREF(namedArgs);
         return 0;
     }
     catch(std::exception& e) {
+        Py_XDECREF(namedArgs);
         PyErr_SetString(PyExc_ValueError, (std::string("Error in creating potential: ")+e.what()).c_str());
         return -1;
     }
@@ -1749,6 +2046,24 @@ PyObject* Potential_export(PyObject* self, PyObject* args)
     }
 }
 
+PyObject* Potential_compile(PyObject* self, PyObject* args, PyObject* namedArgs)
+{
+    if(!Potential_isCorrect(self))
+        return NULL;
+    static const char* keywords[] = {"compact", NULL};
+    int compact = 0;
+    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "|i", const_cast<char**>(keywords), &compact))
+        return NULL;
+    try{
+        return createPotentialObject(
+            potential::compilePotential(((PotentialObject*)self)->pot, compact));
+    }
+    catch(std::exception& e) {
+        PyErr_SetString(PyExc_ValueError, (std::string("Error in compile(): ")+e.what()).c_str());
+        return NULL;
+    }
+}
+
 PyObject* Potential_totalMass(PyObject* self)
 {
     if(!Potential_isCorrect(self))
@@ -1866,6 +2181,17 @@ static PyMethodDef Potential_methods[] = {
       "Export potential expansion coefficients to a text file\n"
       "Arguments: filename (string)\n"
       "Returns: none" },
+    { "compile", (PyCFunction)Potential_compile, METH_VARARGS | METH_KEYWORDS,
+      "Create an equivalent potential that is faster to evaluate: nested composite potentials "
+      "are flattened, all DiskAnsatz components are fused into one, and Multipole or CylSpline "
+      "expansions sharing the same grid are merged into a single expansion "
+      "(which agrees with the original sum to within interpolation accuracy)\n"
+      "Arguments:\n"
+      "  compact (optional, default False): if True, all Multipole and CylSpline expansions "
+      "store the derivatives in their interpolation tables in single precision, reducing "
+      "the memory footprint by ~40% (useful for large expansions shared by many threads) "
+      "at the expense of relative errors ~1e-7 in the potential and force\n"
+      "Returns: a new Potential object" },
     { "totalMass", (PyCFunction)Potential_totalMass, METH_NOARGS,
       "Return the total mass of the density model\n"
       "No arguments\n"
@@ -1958,16 +2284,25 @@ potential::PtrDensity getDensity(PyObject* dens_obj, coord::SymmetryType sym)
 //  --------------------------
 ///@{
 
-/// create a spherical or non-spherical action finder
-actions::PtrActionFinder createActionFinder(const potential::PtrPotential& pot, bool interpolate)
+/// create a spherical or axisymmetric action finder depending on the potential symmetry,
+/// or a triaxial one if explicitly requested
+actions::PtrActionFinder createActionFinder(const potential::PtrPotential& pot, bool interpolate,
+    bool triaxial=false)
 {
     assert(pot);
-    actions::PtrActionFinder af = isSpherical(*pot) ?
-        actions::PtrActionFinder(new actions::ActionFinderSpherical(*pot)) :
-        actions::PtrActionFinder(new actions::ActionFinderAxisymFudge(pot, interpolate));
-    utils::msg(utils::VL_VERBOSE, "Agama",
-        "Created " +
-        std::string(isSpherical(*pot) ? "Spherical" : interpolate ? "Interpolated Fudge" : "Fudge") +
+    actions::PtrActionFinder af;
+    std::string kind;
+    if(triaxial) {
+        af.reset(new actions::ActionFinderTriaxialFudge(pot));
+        kind = "Triaxial Fudge";
+    } else if(isSpherical(*pot)) {
+        af.reset(new actions::ActionFinderSpherical(*pot));
+        kind = "Spherical";
+    } else {
+        af.reset(new actions::ActionFinderAxisymFudge(pot, interpolate));
+        kind = interpolate ? "Interpolated Fudge" : "Fudge";
+    }
+    utils::msg(utils::VL_VERBOSE, "Agama", "Created " + kind +
         " action finder for " + pot->name() + " potential at " + utils::toString(af.get()));
     return af;
 }
@@ -1993,7 +2328,13 @@ static const char* docstringActionFinder =
     "to the constructor); if the potential is axisymmetric, there is a further option to use "
     "interpolation tables for actions (optional second argument 'interp=...', True by default), "
     "which speeds up computation of actions (but not actions and angles) at the expense of "
-    "a somewhat lower accuracy.\n"
+    "a somewhat lower accuracy. For a potential with triaxial symmetry, one may instead use "
+    "the triaxial Staeckel fudge by setting the optional argument 'triaxial=True' (False by "
+    "default); in this case the three actions are J_lambda, J_nu, J_mu, which are returned "
+    "in place of Jr, Jz, Jphi, and the 'interp' argument is ignored (the focal distances "
+    "are always interpolated as functions of energy). The construction of interpolation tables "
+    "is performed in parallel without holding the Python global interpreter lock; the number "
+    "of OpenMP threads may be set by the optional argument 'nthreads=...' (0 means the default).\n"
     "The () operator computes actions for a given position/velocity point, or array of points.\n"
     "Arguments: a sextet of floats (x,y,z,vx,vy,vz) or an Nx6 array of N such sextets, "
     "and optionally an 'angles=True' argument if frequencies and angles are also needed "
@@ -2004,11 +2345,11 @@ static const char* docstringActionFinder =
 
 int ActionFinder_init(PyObject* self, PyObject* args, PyObject* namedArgs)
 {
-    static const char* keywords[] = {"potential", "interp", NULL};
+    static const char* keywords[] = {"potential", "interp", "nthreads", "triaxial", NULL};
     PyObject* pot_obj=NULL;
-    int interpolate=1;
-    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "O|i", const_cast<char**>(keywords),
-        &pot_obj, &interpolate))
+    int interpolate=1, nthreads=0, triaxial=0;
+    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "O|iii", const_cast<char**>(keywords),
+        &pot_obj, &interpolate, &nthreads, &triaxial))
     {
         PyErr_SetString(PyExc_ValueError, "Incorrect parameters for ActionFinder constructor: "
             "must provide an instance of Potential to work with.");
@@ -2020,7 +2361,13 @@ int ActionFinder_init(PyObject* self, PyObject* args, PyObject* namedArgs)
         return -1;
     }
     try{
-        ((ActionFinderObject*)self)->af = createActionFinder(pot, interpolate);
+        actions::PtrActionFinder af;
+        {
+            OmpThreads threads(nthreads);
+            PyReleaseGIL unlock;
+            af = createActionFinder(pot, interpolate, triaxial);
+        }
+        ((ActionFinderObject*)self)->af = af;
         return 0;
     }
     catch(std::exception& e) {
@@ -2477,6 +2824,7 @@ public:
     }
     ~DistributionFunctionWrapper()
     {
+        PyAcquireGIL lock;
         utils::msg(utils::VL_VERBOSE, "Agama",
             "Deleted a C++ df wrapper for Python function "+toString(fnc));
         Py_DECREF(fnc);
@@ -2484,6 +2832,7 @@ public:
     virtual double value(const actions::Actions &J) const {
         double act[3];
         unconvertActions(J, act);
+        PyAcquireGIL lock;  // the caller may have released the GIL
         npy_intp dims[]  = {1, 3};
         PyObject* args   = PyArray_SimpleNewFromData(2, dims, NPY_DOUBLE, act);
         PyObject* result = PyObject_CallFunctionObjArgs(fnc, args, NULL);
@@ -2657,31 +3006,33 @@ int GalaxyModel_init(GalaxyModelObject* self, PyObject* args, PyObject* namedArg
 }
 
 /// generate samples in position/velocity space
-PyObject* GalaxyModel_sample_posvel(GalaxyModelObject* self, PyObject* args)
+PyObject* GalaxyModel_sample_posvel(GalaxyModelObject* self, PyObject* args, PyObject* namedArgs)
 {
     if(!GalaxyModel_isCorrect(self))
         return NULL;
-    int numPoints=0;
-    if(!PyArg_ParseTuple(args, "i", &numPoints) || numPoints<=0)
+    static const char* keywords[] = {"n", "quasirandom", "nthreads", NULL};
+    int numPoints=0, nthreads=0;
+    PyObject *quasirandom_flag = NULL;
+    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "i|Oi", const_cast<char**>(keywords),
+        &numPoints, &quasirandom_flag, &nthreads) || numPoints<=0)
     {
-        PyErr_SetString(PyExc_ValueError, "sample() takes one integer argument - the number of points");
+        PyErr_SetString(PyExc_ValueError, "sample() takes one required integer argument - "
+            "the number of points, and optional arguments quasirandom=False, nthreads=0");
         return NULL;
     }
     try{
         // do the sampling
         galaxymodel::GalaxyModel galmod(*self->pot_obj->pot, *self->af_obj->af, *self->df_obj->df);
-        particles::ParticleArrayCyl points = galaxymodel::generatePosVelSamples(galmod, numPoints);
-
-        // convert output to NumPy array
-        numPoints = points.size();
-        npy_intp dims[] = {numPoints, 6};
-        PyObject* posvel_arr = PyArray_SimpleNew(2, dims, NPY_DOUBLE);
-        PyObject* mass_arr   = PyArray_SimpleNew(1, dims, NPY_DOUBLE);
-        for(int i=0; i<numPoints; i++) {
-            unconvertPosVel(coord::toPosVelCar(points.point(i)), &pyArrayElem<double>(posvel_arr, i, 0));
-            pyArrayElem<double>(mass_arr, i) = points.mass(i) / conv->massUnit;
+        bool quasirandom = quasirandom_flag!=NULL && PyObject_IsTrue(quasirandom_flag);
+        particles::ParticleArrayCyl points;
+        {
+            OmpThreads threads(nthreads);
+            PyReleaseGIL unlock;
+            points = galaxymodel::generatePosVelSamples(galmod, numPoints, quasirandom);
         }
-        return Py_BuildValue("NN", posvel_arr, mass_arr);
+
+        // convert output to NumPy arrays
+        return createParticlesTuple(points, /*convertUnits*/ true);
     }
     catch(std::exception& e) {
         PyErr_SetString(PyExc_ValueError, 
@@ -2706,6 +3057,31 @@ struct GalaxyModelParams{
 };
 /// \endcond
 
+/// convert the moments of DF at one point to external units and store the requested ones in result
+void storeGalaxyModelMoments(const GalaxyModelParams* params,
+    double dens, const coord::VelCyl& vel, const coord::Vel2Cyl& vel2, double *result)
+{
+    unsigned int offset=0;
+    if(params->needDens) {
+        result[offset] = dens * pow_3(conv->lengthUnit) / conv->massUnit;  // dimension of density is M L^-3
+        offset += 1;
+    }
+    if(params->needVel) {
+        result[offset  ] = vel.vR   / conv->velocityUnit;
+        result[offset+1] = vel.vz   / conv->velocityUnit;
+        result[offset+2] = vel.vphi / conv->velocityUnit;
+        offset += 3;
+    }
+    if(params->needVel2) {
+        result[offset  ] = vel2.vR2    / pow_2(conv->velocityUnit);
+        result[offset+1] = vel2.vz2    / pow_2(conv->velocityUnit);
+        result[offset+2] = vel2.vphi2  / pow_2(conv->velocityUnit);
+        result[offset+3] = vel2.vRvz   / pow_2(conv->velocityUnit);
+        result[offset+4] = vel2.vRvphi / pow_2(conv->velocityUnit);
+        result[offset+5] = vel2.vzvphi / pow_2(conv->velocityUnit);
+    }
+}
+
 void fncGalaxyModelMoments(void* obj, const double input[], double *result) {
     const coord::PosCar point = convertPos(input);
     GalaxyModelParams* params = static_cast<GalaxyModelParams*>(obj);
@@ -2725,25 +3101,50 @@ void fncGalaxyModelMoments(void* obj, const double input[], double *result) {
         vel2.vR2 = vel2.vz2 = vel2.vphi2 = vel2.vRvz = vel2.vRvphi = vel2.vzvphi = NAN;
         utils::msg(utils::VL_WARNING, "GalaxyModel.moments", e.what());
     }
-    unsigned int offset=0;
-    if(params->needDens) {
-        result[offset] = dens * pow_3(conv->lengthUnit) / conv->massUnit;  // dimension of density is M L^-3
-        offset += 1;
-    }
-    if(params->needVel) {
-        result[offset  ] = vel.vR   / conv->velocityUnit;
-        result[offset+1] = vel.vz   / conv->velocityUnit;
-        result[offset+2] = vel.vphi / conv->velocityUnit;
-        offset += 3;
+    storeGalaxyModelMoments(params, dens, vel, vel2, result);
+}
+
+/// compute moments of DF for an Nx3 array of points at once using `computeMomentsMap`,
+/// which evaluates only once the points that are equivalent due to the symmetry of the model;
+/// any other input is handled point by point
+template<int numOutput>
+PyObject* computeGalaxyModelMoments(GalaxyModelParams& params, PyObject* points_obj)
+{
+    PyArrayObject* arr = PyArray_Check(points_obj) || PyList_Check(points_obj) ?
+        toRowContiguousArray(points_obj) : NULL;
+    int numpt = arr ? parseArray<INPUT_VALUE_TRIPLET>(arr) : 0;
+    if(numpt == 0) {
+        Py_XDECREF(arr);
+        PyErr_Clear();
+        return callAnyFunctionOnArray<INPUT_VALUE_TRIPLET, numOutput>
+            (&params, points_obj, fncGalaxyModelMoments);
     }
-    if(params->needVel2) {
-        result[offset  ] = vel2.vR2    / pow_2(conv->velocityUnit);
-        result[offset+1] = vel2.vz2    / pow_2(conv->velocityUnit);
-        result[offset+2] = vel2.vphi2  / pow_2(conv->velocityUnit);
-        result[offset+3] = vel2.vRvz   / pow_2(conv->velocityUnit);
-        result[offset+4] = vel2.vRvphi / pow_2(conv->velocityUnit);
-        result[offset+5] = vel2.vzvphi / pow_2(conv->velocityUnit);
+    std::vector<coord::PosCyl> points(numpt);
+    for(int i=0; i<numpt; i++)
+        points[i] = coord::toPosCyl(convertPos(&pyArrayElem<double>(arr, i, 0)));
+    Py_DECREF(arr);
+    std::vector<double> dens(params.needDens ? numpt : 0);
+    std::vector<coord::VelCyl> vel(params.needVel ? numpt : 0);
+    std::vector<coord::Vel2Cyl> vel2(params.needVel2 ? numpt : 0);
+    {   // an exception raised at any point is propagated to the caller
+        PyReleaseGIL unlock;
+        computeMomentsMap(params.model, points,
+            params.needDens ? &dens[0] : NULL,
+            params.needVel  ? &vel [0] : NULL,
+            params.needVel2 ? &vel2[0] : NULL);
+    }
+    PyObject* outputObj = allocOutputArr<numOutput>(numpt);
+    if(!outputObj)
+        return NULL;
+    double output[outputLength<numOutput>()];
+    for(int i=0; i<numpt; i++) {
+        storeGalaxyModelMoments(&params,
+            params.needDens ? dens[i] : 0,
+            params.needVel  ? vel [i] : coord::VelCyl(),
+            params.needVel2 ? vel2[i] : coord::Vel2Cyl(), output);
+        formatOutputArr<numOutput>(output, i, outputObj);
     }
+    return outputObj;
 }
 
 /// compute moments of DF at a given 3d point
@@ -2751,15 +3152,17 @@ PyObject* GalaxyModel_moments(GalaxyModelObject* self, PyObject* args, PyObject*
 {
     if(!GalaxyModel_isCorrect(self))
         return NULL;
-    static const char* keywords[] = {"point","dens", "vel", "vel2", NULL};
+    static const char* keywords[] = {"point","dens", "vel", "vel2", "nthreads", NULL};
     PyObject *points_obj = NULL, *dens_flag = NULL, *vel_flag = NULL, *vel2_flag = NULL;
+    int nthreads = 0;
     if(!PyArg_ParseTupleAndKeywords(
-        args, namedArgs, "O|OOO", const_cast<char**>(keywords),
-        &points_obj, &dens_flag, &vel_flag, &vel2_flag))
+        args, namedArgs, "O|OOOi", const_cast<char**>(keywords),
+        &points_obj, &dens_flag, &vel_flag, &vel2_flag, &nthreads))
     {
         //PyErr_SetString(PyExc_ValueError, "Invalid arguments passed to moments()");
         return NULL;
     }
+    OmpThreads threads(nthreads);
     try{
         GalaxyModelParams params(*self->pot_obj->pot, *self->af_obj->af, *self->df_obj->df,
             dens_flag==NULL || PyObject_IsTrue(dens_flag),
@@ -2768,38 +3171,31 @@ PyObject* GalaxyModel_moments(GalaxyModelObject* self, PyObject* args, PyObject*
         if(params.needDens) {
             if(params.needVel) {
                 if(params.needVel2)
-                    return callAnyFunctionOnArray
-                    <INPUT_VALUE_TRIPLET, OUTPUT_VALUE_SINGLE_AND_TRIPLET_AND_SEXTET>
-                    (&params, points_obj, fncGalaxyModelMoments);
+                    return computeGalaxyModelMoments
+                    <OUTPUT_VALUE_SINGLE_AND_TRIPLET_AND_SEXTET>(params, points_obj);
                 else
-                    return callAnyFunctionOnArray
-                    <INPUT_VALUE_TRIPLET, OUTPUT_VALUE_SINGLE_AND_TRIPLET>
-                    (&params, points_obj, fncGalaxyModelMoments);
+                    return computeGalaxyModelMoments
+                    <OUTPUT_VALUE_SINGLE_AND_TRIPLET>(params, points_obj);
             } else {
                 if(params.needVel2)
-                    return callAnyFunctionOnArray
-                    <INPUT_VALUE_TRIPLET, OUTPUT_VALUE_SINGLE_AND_SEXTET>
-                    (&params, points_obj, fncGalaxyModelMoments);
+                    return computeGalaxyModelMoments
+                    <OUTPUT_VALUE_SINGLE_AND_SEXTET>(params, points_obj);
                 else
-                    return callAnyFunctionOnArray
-                    <INPUT_VALUE_TRIPLET, OUTPUT_VALUE_SINGLE>
-                    (&params, points_obj, fncGalaxyModelMoments);
+                    return computeGalaxyModelMoments
+                    <OUTPUT_VALUE_SINGLE>(params, points_obj);
             }
         } else {
             if(params.needVel) {
                 if(params.needVel2)
-                    return callAnyFunctionOnArray
-                    <INPUT_VALUE_TRIPLET, OUTPUT_VALUE_TRIPLET_AND_SEXTET>
-                    (&params, points_obj, fncGalaxyModelMoments);
+                    return computeGalaxyModelMoments
+                    <OUTPUT_VALUE_TRIPLET_AND_SEXTET>(params, points_obj);
                 else
-                    return callAnyFunctionOnArray
-                    <INPUT_VALUE_TRIPLET, OUTPUT_VALUE_TRIPLET>
-                    (&params, points_obj, fncGalaxyModelMoments);
+                    return computeGalaxyModelMoments
+                    <OUTPUT_VALUE_TRIPLET>(params, points_obj);
             } else {
                 if(params.needVel2)
-                    return callAnyFunctionOnArray
-                    <INPUT_VALUE_TRIPLET, OUTPUT_VALUE_SEXTET>
-                    (&params, points_obj, fncGalaxyModelMoments);
+                    return computeGalaxyModelMoments
+                    <OUTPUT_VALUE_SEXTET>(params, points_obj);
                 else {
                     PyErr_SetString(PyExc_ValueError, "Nothing to compute!");
                     return NULL;
@@ -2828,18 +3224,40 @@ void fncGalaxyModelProjectedMoments(void* obj, const double input[], double *res
 }
 
 /// compute projected moments of distribution function
-PyObject* GalaxyModel_projectedMoments(GalaxyModelObject* self, PyObject* args)
+PyObject* GalaxyModel_projectedMoments(GalaxyModelObject* self, PyObject* args, PyObject* namedArgs)
 {
     if(!GalaxyModel_isCorrect(self))
         return NULL;
+    static const char* keywords[] = {"point", "nthreads", NULL};
     PyObject *points_obj = NULL;
-    if(!PyArg_ParseTuple(args, "O", &points_obj))
+    int nthreads = 0;
+    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "O|i", const_cast<char**>(keywords),
+        &points_obj, &nthreads))
     {
         //PyErr_SetString(PyExc_ValueError, "Invalid arguments passed to projectedMoments()");
         return NULL;
     }
+    OmpThreads threads(nthreads);
     try{
         GalaxyModelParams params(*self->pot_obj->pot, *self->af_obj->af, *self->df_obj->df);
+        // for an array of radii, compute all of them at once, skipping duplicate values
+        std::vector<double> radii = toDoubleArray(points_obj);
+        PyErr_Clear();  // if the input is not a 1d array, it will be handled in the generic way below
+        if(!radii.empty()) {
+            size_t size = radii.size();
+            for(size_t i=0; i<size; i++)
+                radii[i] *= conv->lengthUnit;
+            std::vector<double> surfaceDensity(size), losvdisp(size);
+            {   // an exception raised at any point is propagated to the caller
+                PyReleaseGIL unlock;
+                computeProjectedMomentsMap(params.model, radii, &surfaceDensity[0], &losvdisp[0]);
+            }
+            for(size_t i=0; i<size; i++) {
+                surfaceDensity[i] *= pow_2(conv->lengthUnit) / conv->massUnit;
+                losvdisp[i] /= pow_2(conv->velocityUnit);
+            }
+            return Py_BuildValue("NN", toPyArray(surfaceDensity), toPyArray(losvdisp));
+        }
         return callAnyFunctionOnArray<INPUT_VALUE_SINGLE, OUTPUT_VALUE_SINGLE_AND_SINGLE>
             (&params, points_obj, fncGalaxyModelProjectedMoments);
     }
@@ -2868,15 +3286,17 @@ PyObject* GalaxyModel_projectedDF(GalaxyModelObject* self, PyObject* args, PyObj
 {
     if(!GalaxyModel_isCorrect(self))
         return NULL;
-    static const char* keywords[] = {"point", "vz_error", NULL};
+    static const char* keywords[] = {"point", "vz_error", "nthreads", NULL};
     PyObject *points_obj = NULL;
     double vz_error = 0;
-    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "O|d", const_cast<char**>(keywords),
-        &points_obj, &vz_error))
+    int nthreads = 0;
+    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "O|di", const_cast<char**>(keywords),
+        &points_obj, &vz_error, &nthreads))
     {
         //PyErr_SetString(PyExc_ValueError, "Invalid arguments passed to projectedDF()");
         return NULL;
     }
+    OmpThreads threads(nthreads);
     try{
         GalaxyModelParams params(*self->pot_obj->pot, *self->af_obj->af, *self->df_obj->df);
         params.vz_error = vz_error * conv->velocityUnit;
@@ -2893,7 +3313,8 @@ PyObject* GalaxyModel_projectedDF(GalaxyModelObject* self, PyObject* args, PyObj
 bool computeVDFatPoint(const galaxymodel::GalaxyModel& model, const coord::PosCyl& point,
     const bool projected, const std::vector<double>& gridvR_ext,
     const std::vector<double>& gridvz_ext, const std::vector<double>& gridvphi_ext,
-    /*storage for output interpolators */ PyObject*& splinevR, PyObject*& splinevz, PyObject*& splinevphi)
+    /*storage for output interpolators */ PyObject*& splinevR, PyObject*& splinevz, PyObject*& splinevphi,
+    /*error message if the computation failed*/ std::string& errorMsg)
 {
     try{
         // create a default grid in velocity space (if not provided by the user), in internal units
@@ -2942,17 +3363,16 @@ bool computeVDFatPoint(const galaxymodel::GalaxyModel& model, const coord::PosCy
         for(unsigned int i=0; i<amplvphi.size(); i++)
             amplvphi[i] *= conv->velocityUnit;
 
-        // construct three interpolating spline objects
+        // construct three interpolating spline objects (this requires the GIL)
+        PyAcquireGIL lock;
         splinevR   = createCubicSpline(gridvR,   amplvR);
         splinevz   = createCubicSpline(gridvz,   amplvz);
         splinevphi = createCubicSpline(gridvphi, amplvphi);
         return true;
     }
     catch(std::exception& e) {
-#ifdef _OPENMP
-#pragma omp critical(PythonAPI)
-#endif
-        PyErr_SetString(PyExc_ValueError, (std::string("Error in vdf(): ")+e.what()).c_str());
+        // the Python error indicator is specific to the thread, so it is set by the caller
+        errorMsg = e.what();
         return false;
     }
 }
@@ -2962,19 +3382,19 @@ PyObject* GalaxyModel_vdf(GalaxyModelObject* self, PyObject* args, PyObject* nam
 {
     if(!GalaxyModel_isCorrect(self))
         return NULL;
-    static const char* keywords[] = {"point", "gridvR", "gridvz", "gridvphi", NULL};
+    static const char* keywords[] = {"point", "gridvR", "gridvz", "gridvphi", "nthreads", NULL};
     PyObject *points_obj = NULL, *gridvR_obj = NULL, *gridvz_obj = NULL, *gridvphi_obj = NULL;
+    int nthreads = 0;
     if(!PyArg_ParseTupleAndKeywords(
-        args, namedArgs, "O|OOO", const_cast<char**>(keywords),
-        &points_obj, &gridvR_obj, &gridvz_obj, &gridvphi_obj))
+        args, namedArgs, "O|OOOi", const_cast<char**>(keywords),
+        &points_obj, &gridvR_obj, &gridvz_obj, &gridvphi_obj, &nthreads))
     {
         //PyErr_SetString(PyExc_ValueError, "Invalid arguments passed to vdf()");
         return NULL;
     }
 
     // retrieve the input point(s)
-    PyArrayObject *points_arr =
-        (PyArrayObject*) PyArray_FROM_OTF(points_obj, NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
+    PyArrayObject *points_arr = toRowContiguousArray(points_obj);
     npy_intp npoints = 0;  // # of points at which the VDFs should be computed
     npy_intp ndim    = 0;  // dimensions of points: 2 for projected VDF at (x,y), 3 for (x,y,z)
     if(points_arr) {
@@ -2999,6 +3419,7 @@ PyObject* GalaxyModel_vdf(GalaxyModelObject* self, PyObject* args, PyObject* nam
 
     galaxymodel::GalaxyModel model(*self->pot_obj->pot, *self->af_obj->af, *self->df_obj->df);
     volatile bool allok = true;
+    std::string errorMsg;
 
     // in the case of several input points, the output will contain three arrays with spline objects
     PyObject *splvR = NULL, *splvz = NULL, *splvphi = NULL;
@@ -3020,6 +3441,9 @@ PyObject* GalaxyModel_vdf(GalaxyModelObject* self, PyObject* args, PyObject* nam
             pyArrayElem<PyObject*>(splvphi, ind) = NULL;
         }
 
+        // the loop runs without holding the GIL, which is reacquired only to create Python objects
+        OmpThreads threads(nthreads);
+        PyReleaseGIL unlock;
 #ifdef _OPENMP
 #pragma omp parallel for schedule(dynamic,1)
 #endif
@@ -3028,15 +3452,24 @@ PyObject* GalaxyModel_vdf(GalaxyModelObject* self, PyObject* args, PyObject* nam
                 pyArrayElem<double>(points_arr, ind, 0) * conv->lengthUnit,
                 pyArrayElem<double>(points_arr, ind, 1) * conv->lengthUnit,
                 ndim==3 ? pyArrayElem<double>(points_arr, ind, 2) * conv->lengthUnit : 0);
+            std::string err;
             if(allok) {  // if even a single point failed, don't continue
                 if(!computeVDFatPoint(model, toPosCyl(point), /*projected*/ ndim==2,
                     gridvR_arr, gridvz_arr, gridvphi_arr,
                     pyArrayElem<PyObject*>(splvR,   ind),
                     pyArrayElem<PyObject*>(splvz,   ind),
-                    pyArrayElem<PyObject*>(splvphi, ind)))
-                        allok = false;
+                    pyArrayElem<PyObject*>(splvphi, ind), err))
+                {
+#ifdef _OPENMP
+#pragma omp critical(vdfError)
+#endif
+                    errorMsg = err;
+                    allok = false;
+                }
             }
         }
+    }
+    if(npoints>1) {
         // if something went wrong, release any successfully created objects
         if(!allok) {
             for(int ind=npoints-1; ind>=0; ind--) {
@@ -3050,15 +3483,17 @@ PyObject* GalaxyModel_vdf(GalaxyModelObject* self, PyObject* args, PyObject* nam
             pyArrayElem<double>(points_arr, 0) * conv->lengthUnit,
             pyArrayElem<double>(points_arr, 1) * conv->lengthUnit,
             ndim==3 ? pyArrayElem<double>(points_arr, 2) * conv->lengthUnit : 0);
+        PyReleaseGIL unlock;
         allok &= computeVDFatPoint(model, toPosCyl(point), /*projected*/ ndim==2,
             gridvR_arr, gridvz_arr, gridvphi_arr,
-            /*output*/ splvR, splvz, splvphi);
+            /*output*/ splvR, splvz, splvphi, errorMsg);
     }
     Py_DECREF(points_arr);
     if(!allok) {
         Py_XDECREF(splvR);
         Py_XDECREF(splvz);
         Py_XDECREF(splvphi);
+        PyErr_SetString(PyExc_ValueError, ("Error in vdf(): "+errorMsg).c_str());
         return NULL;
     }
     return Py_BuildValue("NNN", splvR, splvz, splvphi);
@@ -3075,10 +3510,15 @@ static PyMemberDef GalaxyModel_members[] = {
 };
 
 static PyMethodDef GalaxyModel_methods[] = {
-    { "sample", (PyCFunction)GalaxyModel_sample_posvel, METH_VARARGS,
+    { "sample", (PyCFunction)GalaxyModel_sample_posvel, METH_VARARGS | METH_KEYWORDS,
       "Sample distribution function in the given potential by N particles.\n"
       "Arguments:\n"
-      "  Number of particles to sample.\n"
+      "  Number of particles to sample;\n"
+      "  quasirandom (boolean, default False) -- whether to use a scrambled Sobol quasi-random "
+      "sequence for the internal sampling points, which reduces the noise for the same number "
+      "of DF evaluations;\n"
+      "  nthreads -- (optional) the number of OpenMP threads (default 0 means the number set by "
+      "the OMP_NUM_THREADS environment variable).\n"
       "Returns:\n"
       "  A tuple of two arrays: position/velocity (2d array of size Nx6) and mass (1d array of length N)." },
     { "moments", (PyCFunction)GalaxyModel_moments, METH_VARARGS | METH_KEYWORDS,
@@ -3090,17 +3530,27 @@ static PyMethodDef GalaxyModel_methods[] = {
       "  dens (boolean, default True)  -- flag telling whether the density (0th moment) "
       "needs to be computed;\n"
       "  vel  (boolean, default False) -- same for streaming velocity (1st moment);\n"
-      "  vel2 (boolean, default True)  -- same for 2nd moment of velocity.\n"
+      "  vel2 (boolean, default True)  -- same for 2nd moment of velocity;\n"
+      "  nthreads -- (optional) the number of OpenMP threads (default 0 means the number set by "
+      "the OMP_NUM_THREADS environment variable).\n"
       "Returns:\n"
       "  For each input point, return the requested moments (one value for density, "
-      "a triplet for velocity, and 6 components of the 2nd moment tensor)." },
-    { "projectedMoments", (PyCFunction)GalaxyModel_projectedMoments, METH_VARARGS,
+      "a triplet for velocity, and 6 components of the 2nd moment tensor).\n"
+      "For an Nx3 array of points, the moments are computed only once for points that are "
+      "equivalent due to the symmetry of the model (e.g., differ only in phi for an axisymmetric "
+      "potential), and an exception is raised if the computation fails at any point; "
+      "for a single point, a failure results in NaN values." },
+    { "projectedMoments", (PyCFunction)GalaxyModel_projectedMoments, METH_VARARGS | METH_KEYWORDS,
       "Compute projected moments of distribution function in the given potential.\n"
       "Arguments:\n"
-      "  A single value or an array of values of cylindrical radius at which to compute moments.\n"
+      "  point -- a single value or an array of values of cylindrical radius "
+      "at which to compute moments;\n"
+      "  nthreads -- (optional) the number of OpenMP threads (default 0 means the number set by "
+      "the OMP_NUM_THREADS environment variable).\n"
       "Returns:\n"
       "  A tuple of two floats or arrays: surface density and line-of-sight velocity dispersion "
-      "at each input radius.\n" },
+      "at each input radius (coinciding radii in the input array are computed only once, "
+      "and an exception is raised if the computation fails at any of them).\n" },
     { "projectedDF", (PyCFunction)GalaxyModel_projectedDF, METH_VARARGS | METH_KEYWORDS,
       "Compute projected distribution function (integrated over z-coordinate and x- and y-velocities)\n"
       "Named arguments:\n"
@@ -3108,7 +3558,9 @@ static PyMethodDef GalaxyModel_methods[] = {
       "in cartesian coordinates and z-component of velocity "
       "(a triplet of numbers or an Nx3 array);\n"
       "  vz_error -- optional error on z-component of velocity "
-      "(DF will be convolved with a Gaussian if this error is non-zero)\n"
+      "(DF will be convolved with a Gaussian if this error is non-zero);\n"
+      "  nthreads -- (optional) the number of OpenMP threads (default 0 means the number set by "
+      "the OMP_NUM_THREADS environment variable).\n"
       "Returns:\n"
       "  The value of projected DF (integrated over the missing components of position and velocity) "
       "at each point." },
@@ -3128,6 +3580,8 @@ static PyMethodDef GalaxyModel_methods[] = {
       "all input points, while the automatic grid will be scaled with local escape velocity.\n"
       "  gridvz -- (optional) same for the interpolated f(v_z); if omitted, gridvR is used instead.\n"
       "  gridvphi -- (optional) same for f(v_phi), with gridvR as default.\n"
+      "  nthreads -- (optional) the number of OpenMP threads (default 0 means the number set by "
+      "the OMP_NUM_THREADS environment variable).\n"
       "Returns:\n"
       "  A tuple of three functions (in case of one input point) or arrays of functions (if N>1), "
       "which represent spline-interpolated VDFs f(v_R), f(v_z), f(v_phi) at each input point. "
@@ -3388,6 +3842,7 @@ typedef struct {
     ActionFinderObject* af;
     /// members of galaxymodel::SelfConsistentModel structure listed here
     bool useActionInterpolation;  ///< whether to use the interpolated action finder
+    bool useTriaxialActionFinder; ///< whether to use the triaxial action finder
     double rminSph, rmaxSph;      ///< range of radii for the logarithmic grid
     unsigned int sizeRadialSph;   ///< number of grid points in radius
     unsigned int lmaxAngularSph;  ///< maximum order of angular-harmonic expansion (l_max)
@@ -3395,6 +3850,7 @@ typedef struct {
     double zminCyl, zmaxCyl;      ///< innermost and outermost grid nodes in vertical direction
     unsigned int sizeRadialCyl;   ///< number of grid nodes in cylindrical radius
     unsigned int sizeVerticalCyl; ///< number of grid nodes in vertical (z) direction
+    bool useFFTCyl;               ///< whether to use the Hankel-transform Poisson solver for CylSpline
 } SelfConsistentModelObject;
 /// \endcond
 
@@ -3436,6 +3892,8 @@ int SelfConsistentModel_init(SelfConsistentModelObject* self, PyObject* args, Py
     self->af          = NULL;
     PyObject* interp  = getItemFromPyDict(namedArgs, "useActionInterpolation");
     self->useActionInterpolation = interp==NULL ? true : PyObject_IsTrue(interp);
+    PyObject* triax   = getItemFromPyDict(namedArgs, "useTriaxialActionFinder");
+    self->useTriaxialActionFinder = triax==NULL ? false : PyObject_IsTrue(triax);
     self->rminSph     = toDouble(getItemFromPyDict(namedArgs, "rminSph"), -2);
     self->rmaxSph     = toDouble(getItemFromPyDict(namedArgs, "rmaxSph"), -2);
     self->sizeRadialSph  = toInt(getItemFromPyDict(namedArgs, "sizeRadialSph"), -1);
@@ -3446,11 +3904,18 @@ int SelfConsistentModel_init(SelfConsistentModelObject* self, PyObject* args, Py
     self->zmaxCyl     = toDouble(getItemFromPyDict(namedArgs, "zmaxCyl"), -1);
     self->sizeRadialCyl  = toInt(getItemFromPyDict(namedArgs, "sizeRadialCyl"), -1);
     self->sizeVerticalCyl= toInt(getItemFromPyDict(namedArgs, "sizeVerticalCyl"), -1);
+    PyObject* useFFT  = getItemFromPyDict(namedArgs, "useFFTCyl");
+    self->useFFTCyl   = useFFT==NULL ? false : PyObject_IsTrue(useFFT);
     return 0;
 }
 
-PyObject* SelfConsistentModel_iterate(SelfConsistentModelObject* self)
+PyObject* SelfConsistentModel_iterate(SelfConsistentModelObject* self,
+    PyObject* args, PyObject* namedArgs)
 {
+    static const char* keywords[] = {"nthreads", NULL};
+    int nthreads = 0;
+    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "|i", const_cast<char**>(keywords), &nthreads))
+        return NULL;
     galaxymodel::SelfConsistentModel model;
     // parse the Python list of components
     if(self->components==NULL || !PyList_Check(self->components) || PyList_Size(self->components)==0)
@@ -3471,6 +3936,7 @@ PyObject* SelfConsistentModel_iterate(SelfConsistentModelObject* self)
         model.components.push_back(((ComponentObject*)elem)->comp);
     }
     model.useActionInterpolation = self->useActionInterpolation;
+    model.useTriaxialActionFinder = self->useTriaxialActionFinder;
     model.rminSph = self->rminSph * conv->lengthUnit;
     model.rmaxSph = self->rmaxSph * conv->lengthUnit;
     model.sizeRadialSph = self->sizeRadialSph;
@@ -3481,12 +3947,17 @@ PyObject* SelfConsistentModel_iterate(SelfConsistentModelObject* self)
     model.zmaxCyl = self->zmaxCyl * conv->lengthUnit;
     model.sizeRadialCyl = self->sizeRadialCyl;
     model.sizeVerticalCyl = self->sizeVerticalCyl;
+    model.useFFTCyl = self->useFFTCyl;
     if(self->pot!=NULL && PyObject_TypeCheck(self->pot, &PotentialType))
         model.totalPotential = ((PotentialObject*)self->pot)->pot;
     if(self->af!=NULL && PyObject_TypeCheck(self->af, &ActionFinderType))
         model.actionFinder = ((ActionFinderObject*)self->af)->af;
     try {
-        doIteration(model);
+        {
+            OmpThreads threads(nthreads);
+            PyReleaseGIL unlock;
+            doIteration(model);
+        }
         // update the total potential and action finder by copying the C++ smart pointers into
         // Python objects; old Python objects are released (and destroyed if no one else uses them)
         Py_XDECREF(self->pot);
@@ -3514,6 +3985,11 @@ static PyMemberDef SelfConsistentModel_members[] = {
     { const_cast<char*>("useActionInterpolation"), T_BOOL,
       offsetof(SelfConsistentModelObject, useActionInterpolation), 0,
       const_cast<char*>("Whether to use interpolated action finder (faster but less accurate)") },
+    { const_cast<char*>("useTriaxialActionFinder"), T_BOOL,
+      offsetof(SelfConsistentModelObject, useTriaxialActionFinder), 0,
+      const_cast<char*>("Whether to use the triaxial Staeckel fudge action finder "
+      "(the potential must be triaxial; actions are then J_lambda, J_nu, J_mu instead of Jr, Jz, Jphi, "
+      "and useActionInterpolation is ignored)") },
     { const_cast<char*>("rminSph"), T_DOUBLE, offsetof(SelfConsistentModelObject, rminSph), 0,
       const_cast<char*>("Spherical radius of innermost grid node for Multipole potential") },
     { const_cast<char*>("rmaxSph"), T_DOUBLE, offsetof(SelfConsistentModelObject, rmaxSph), 0,
@@ -3534,14 +4010,21 @@ static PyMemberDef SelfConsistentModel_members[] = {
       const_cast<char*>("Grid size in cylindrical radius for CylSpline potential") },
     { const_cast<char*>("sizeVerticalCyl"), T_INT, offsetof(SelfConsistentModelObject, sizeVerticalCyl), 0,
       const_cast<char*>("Grid size in z-coordinate for CylSpline potential") },
+    { const_cast<char*>("useFFTCyl"), T_BOOL, offsetof(SelfConsistentModelObject, useFFTCyl), 0,
+      const_cast<char*>("Whether to solve the Poisson equation for CylSpline potential using "
+      "Hankel transforms (much faster but slightly less accurate)") },
     { NULL }
 };
 
 static PyMethodDef SelfConsistentModel_methods[] = {
-    { "iterate", (PyCFunction)SelfConsistentModel_iterate, METH_NOARGS,
+    { "iterate", (PyCFunction)SelfConsistentModel_iterate, METH_VARARGS | METH_KEYWORDS,
       "Perform one iteration of self-consistent modelling procedure, "
       "recomputing density profiles of all DF-based components, "
-      "and then updating the total potential.\n" },
+      "and then updating the total potential.\n"
+      "Arguments:\n"
+      "  nthreads -- (optional) the number of OpenMP threads (default 0 means the number set by "
+      "the OMP_NUM_THREADS environment variable); the computation runs without holding "
+      "the Python global interpreter lock.\n" },
     { NULL }
 };
 
@@ -3706,6 +4189,8 @@ int Target_init(TargetObject* self, PyObject* args, PyObject* namedArgs)
                 toDouble(getItemFromPyDict(namedArgs, "spatialPSF")) * conv->lengthUnit));
             params.velocityPSF =
                 toDouble(getItemFromPyDict(namedArgs, "velocityPSF")) * conv->velocityUnit;
+            // whether to record the data for each orbit directly in apertures
+            params.recordApertures = toInt(getItemFromPyDict(namedArgs, "recordApertures"), 0) != 0;
             // degree of B-splines
             int degree = toInt(getItemFromPyDict(namedArgs, "degree"), -1);
             // apertures in the image plane where LOSVDs are analyzed
@@ -3890,6 +4375,19 @@ static const char* docstringOrbit =
     "The trajectory of each orbit is stored at regular intervals of time (`dt=time/(trajsize-1)`, "
     "so that the number of points is `trajsize`; both time and trajsize may differ between orbits.\n"
     "  accuracy (optional, default 1e-8):  relative accuracy of ODE integrator.\n"
+    "  storage (optional):  preallocated arrays for the data collected by each target "
+    "(a tuple/list with the same number of elements as targets). Each one must be a writable "
+    "C-contiguous array of float32 with the same shape as the output array that would otherwise be "
+    "created for this target (see below); the data is written into these arrays and they are "
+    "returned as the output. This makes it possible to store the orbit library in memory-mapped "
+    "files on disk (`numpy.memmap`), which need not fit into physical memory: a large library may "
+    "be computed in chunks, passing a subset of initial conditions and the corresponding rows of "
+    "the storage arrays (e.g., `storage=(stor1[i0:i1],)`) in each call. The solver `optsolve()` "
+    "accesses these arrays (or their transposed views) without making a copy.\n"
+    "  nthreads (optional):  the number of OpenMP threads used to integrate the orbits in parallel "
+    "(default 0 means the number set by the OMP_NUM_THREADS environment variable). "
+    "The integration runs without holding the Python global interpreter lock, so that "
+    "other Python threads may run concurrently.\n"
     "Returns:\n"
     "  depending on the arguments, one or a tuple of several data containers (one for each target, "
     "plus an extra one for trajectories). \n"
@@ -3921,11 +4419,14 @@ PyObject* orbit(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
     // parse input arguments
     orbit::OrbitIntParams params;
     double Omega = 0.;
-    PyObject *ic_obj = NULL, *time_obj = NULL, *pot_obj = NULL, *targets_obj = NULL, *trajsize_obj = NULL;
+    int nthreads = 0;
+    PyObject *ic_obj = NULL, *time_obj = NULL, *pot_obj = NULL, *targets_obj = NULL, *trajsize_obj = NULL,
+        *storage_obj = NULL;
     static const char* keywords[] =
-        {"ic", "time", "potential", "targets", "trajsize", "Omega", "accuracy", NULL};
-    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "|OOOOOdd", const_cast<char**>(keywords),
-        &ic_obj, &time_obj, &pot_obj, &targets_obj, &trajsize_obj, &Omega, &params.accuracy))
+        {"ic", "time", "potential", "targets", "trajsize", "Omega", "accuracy", "storage", "nthreads", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "|OOOOOddOi", const_cast<char**>(keywords),
+        &ic_obj, &time_obj, &pot_obj, &targets_obj, &trajsize_obj, &Omega, &params.accuracy,
+        &storage_obj, &nthreads))
     {
         return NULL;
     }
@@ -3939,8 +4440,7 @@ PyObject* orbit(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
     }
 
     // ensure that initial conditions were provided
-    PyArrayObject *ic_arr = ic_obj==NULL ? NULL :
-        (PyArrayObject*) PyArray_FROM_OTF(ic_obj, NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
+    PyArrayObject *ic_arr = ic_obj==NULL ? NULL : toRowContiguousArray(ic_obj);
     if(ic_arr == NULL || !(
         (PyArray_NDIM(ic_arr) == 1 && PyArray_DIM(ic_arr, 0) == 6) ||
         (PyArray_NDIM(ic_arr) == 2 && PyArray_DIM(ic_arr, 1) == 6) ) )
@@ -3999,6 +4499,30 @@ PyObject* orbit(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
         targets.push_back(((TargetObject*)targets_vec[t])->target);
     }
 
+    // check if preallocated storage arrays were provided for targets
+    std::vector<PyObject*> storage_vec = toPyObjectArray(storage_obj);
+    if(storage_obj != NULL && storage_vec.size() != numTargets) {
+        PyErr_SetString(PyExc_ValueError,
+            "Argument 'storage', if provided, must contain the same number of arrays as targets");
+        return NULL;
+    }
+    for(size_t t=0; t<storage_vec.size(); t++) {
+        PyArrayObject* arr = (PyArrayObject*)storage_vec[t];
+        if(!PyArray_Check(arr) ||
+            PyArray_TYPE(arr) != STORAGE_NUM_T ||
+            !PyArray_ISCARRAY(arr) ||  // C-contiguous, aligned and writable
+            !(singleOrbit ?
+            (PyArray_NDIM(arr) == 1 && PyArray_DIM(arr, 0) == (npy_intp)targets[t]->datacubeSize()) :
+            (PyArray_NDIM(arr) == 2 && PyArray_DIM(arr, 0) == numOrbits &&
+            PyArray_DIM(arr, 1) == (npy_intp)targets[t]->datacubeSize())) )
+        {
+            PyErr_SetString(PyExc_ValueError, ("Argument 'storage' must contain writable "
+                "C-contiguous float32 arrays of shape " + std::string(singleOrbit ? "" :
+                utils::toString(numOrbits) + "x") + "[number of constraints in each target]").c_str());
+            return NULL;
+        }
+    }
+
     // check if trajectory needs to be recorded
     std::vector<int> trajSizes;
     bool haveTraj = trajsize_obj!=NULL;  // in this case the output tuple contains one extra item
@@ -4041,6 +4565,12 @@ PyObject* orbit(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
     // the latter one is a Nx2 array of Python objects
     volatile bool fail = false;  // error flag (e.g., insufficient memory)
     for(size_t t=0; !fail && t < numTargets + haveTraj; t++) {
+        if(t < storage_vec.size()) {
+            // use the preallocated array, whose data will be overwritten
+            Py_INCREF(storage_vec[t]);
+            PyTuple_SetItem(result, t, storage_vec[t]);
+            continue;
+        }
         npy_intp numCols = t==numTargets ? 2 : targets[t]->datacubeSize();
         int datatype     = t==numTargets ? NPY_OBJECT : STORAGE_NUM_T;
         npy_intp size[2] = {numOrbits, numCols};
@@ -4055,14 +4585,16 @@ PyObject* orbit(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
     }
 
     // set up signal handler to stop the integration on a keyboard interrupt
-    keyboardInterruptTriggered = 0;
-    defaultKeyboardInterruptHandler = signal(SIGINT, customKeyboardInterruptHandler);
+    installKeyboardInterruptHandler();
 
-    // finally, run the orbit integration
+    // finally, run the orbit integration without holding the GIL
     volatile int numComplete = 0;
     volatile time_t tprint = time(NULL), tbegin = tprint;
+    std::string errorMsg;
     if(!fail) {
         const orbit::OrbitIntegratorRot orbitIntegrator(*pot, Omega / conv->timeUnit);
+        OmpThreads threads(nthreads);
+        PyReleaseGIL unlock;
 
 #ifdef _OPENMP
 #pragma omp parallel for schedule(dynamic, 1)
@@ -4099,10 +4631,8 @@ PyObject* orbit(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
                     const npy_intp size = traj.size();
                     npy_intp dims[] = {size, 6};
                     PyObject *time_arr, *traj_arr;
-#ifdef _OPENMP
-#pragma omp critical(PythonAPI)
-#endif
-                    {   // avoid concurrent non-readonly access to Python C API
+                    {   // creation of Python objects requires the GIL
+                        PyAcquireGIL lock;
                         time_arr = PyArray_SimpleNew(1, dims, STORAGE_NUM_T);
                         traj_arr = PyArray_SimpleNew(2, dims, STORAGE_NUM_T);
                     }
@@ -4148,10 +4678,11 @@ PyObject* orbit(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
                 }
             }
             catch(std::exception& e) {
+                // the Python error indicator is specific to the thread, so it is set after the loop
 #ifdef _OPENMP
-#pragma omp critical(PythonAPI)
+#pragma omp critical(orbitError)
 #endif
-                PyErr_SetString(PyExc_ValueError, (std::string("Error in orbit(): ")+e.what()).c_str());
+                errorMsg = e.what();
                 fail = true;
             }
         }
@@ -4159,12 +4690,16 @@ PyObject* orbit(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
     if(numOrbits != 1)
         printf("%i orbits complete (%.4g orbits/s)\n", numComplete,
             numComplete / difftime(time(NULL), tbegin));
-    signal(SIGINT, defaultKeyboardInterruptHandler);  // restore signal handler
+    restoreKeyboardInterruptHandler();
+    if(!errorMsg.empty())
+        PyErr_SetString(PyExc_ValueError, ("Error in orbit(): "+errorMsg).c_str());
     if(keyboardInterruptTriggered) {
         PyErr_SetObject(PyExc_KeyboardInterrupt, NULL);
         fail = true;
     }
     if(fail) {
+        if(!PyErr_Occurred())  // an error raised in another thread (e.g., insufficient memory)
+            PyErr_SetString(PyExc_MemoryError, "Error in orbit(): cannot allocate output arrays");
         Py_XDECREF(result);
         return NULL;
     }
@@ -4346,20 +4881,12 @@ PyObject* readSnapshot(PyObject* /*self*/, PyObject* args)
         // we do not perform any unit conversion on the particle coordinates/masses:
         // they are read 'as is' from the file, and any such conversion will take place when
         // feeding them to other routines, such as constructing the potential or integrating orbits
-        particles::ParticleArrayCar snap = particles::readSnapshot(name);
-        npy_intp size[] = { static_cast<npy_intp>(snap.size()), 6 };
-        PyObject* posvel_arr = PyArray_SimpleNew(2, size, NPY_DOUBLE);
-        PyObject* mass_arr   = PyArray_SimpleNew(1, size, NPY_DOUBLE);
-        if(!posvel_arr || !mass_arr) {
-            Py_XDECREF(posvel_arr);
-            Py_XDECREF(mass_arr);
-            return NULL;
-        }
-        for(size_t i=0; i<snap.size(); i++) {
-            snap.point(i).unpack_to(&pyArrayElem<double>(posvel_arr, i, 0));
-            pyArrayElem<double>(mass_arr, i) = snap.mass(i);
+        particles::ParticleArrayCar snap;
+        {
+            PyReleaseGIL unlock;
+            snap = particles::readSnapshot(name);
         }
-        return Py_BuildValue("NN", posvel_arr, mass_arr);
+        return createParticlesTuple(snap, /*convertUnits*/ false);
     }
     catch(std::exception& e) {
         PyErr_SetString(PyExc_ValueError, e.what());
@@ -4389,59 +4916,25 @@ PyObject* writeSnapshot(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
         return NULL;
     }
 
-    // parse the input arrays
-    static const char* errorstr = "'particles' must be a tuple with two arrays - "
-        "coordinates[+velocities] and mass, where the first one is a two-dimensional "
-        "Nx3 or Nx6 array and the second one is a one-dimensional array of length N";
-    PyObject *pointCoordObj, *pointMassObj;
-    if(!PyArg_ParseTuple(particles_obj, "OO", &pointCoordObj, &pointMassObj)) {
-        PyErr_SetString(PyExc_ValueError, errorstr);
-        return NULL;
-    }
-    PyArrayObject *pointCoordArr = (PyArrayObject*)
-        PyArray_FROM_OTF(pointCoordObj, NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
-    PyArrayObject *pointMassArr  = (PyArrayObject*)
-        PyArray_FROM_OTF(pointMassObj,  NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
-    npy_intp nbody = 0;
-    if( pointCoordArr == NULL || pointMassArr == NULL ||  // input should contain valid arrays
-        PyArray_NDIM(pointMassArr) != 1 ||                // the second one should be 1d array
-        (nbody = PyArray_DIM(pointMassArr, 0)) <= 0 ||    // of length nbody > 0
-        PyArray_NDIM(pointCoordArr) != 2 ||               // the first one should be a 2d array
-        PyArray_DIM(pointCoordArr, 0) != nbody ||         // with nbody rows
-       (PyArray_DIM(pointCoordArr, 1) != 3 && PyArray_DIM(pointCoordArr, 1) != 6))  // and 3 or 6 columns
-    {
-        Py_XDECREF(pointCoordArr);
-        Py_XDECREF(pointMassArr);
-        PyErr_SetString(PyExc_ValueError, errorstr);
-        return NULL;
-    }
-    bool haveVel = PyArray_DIM(pointCoordArr, 1) == 6;  // whether we have velocity data
-    particles::ParticleArrayCar pointArray;
-    pointArray.data.reserve(nbody);
-    for(npy_intp i=0; i<nbody; i++) {
-        const double *xv = &pyArrayElem<double>(pointCoordArr, i, 0);
+    try{
+        // parse the input arrays;
         // we do not perform any unit conversion on the particle coordinates/masses:
         // if they came from various sampling routines, they are already in physical units
-        pointArray.add(coord::PosVelCar(
-            xv[0], xv[1], xv[2], haveVel? xv[3] : 0., haveVel? xv[4] : 0., haveVel? xv[5] : 0.),
-            pyArrayElem<double>(pointMassArr, i));
-    }
-    Py_DECREF(pointCoordArr);
-    Py_DECREF(pointMassArr);
-
-    // write snapshot
-    try{
+        particles::ParticleArrayCar pointArray;
+        convertParticles(particles_obj, /*convertUnits*/ false, pointArray);
+        // write snapshot
+        PyReleaseGIL unlock;
         if(format)
             particles::writeSnapshot(filename, pointArray, format);
         else
             particles::writeSnapshot(filename, pointArray);
-        Py_INCREF(Py_None);
-        return Py_None;
     }
     catch(std::exception& e) {
         PyErr_SetString(PyExc_ValueError, e.what());
         return NULL;
     }
+    Py_INCREF(Py_None);
+    return Py_None;
 }
 
 ///@}
@@ -4546,18 +5039,46 @@ static const char* docstringOptsolve =
     "if not provided, it implies a vector of zeros, i.e. the solution must be nonnegative).\n"
     "  xmax:    1d vector of length C - maximum allowed values for the solution x (optional - "
     "if not provided, it implies no upper limit).\n"
+    "  iterative:  (bool, default False) whether to use the built-in first-order iterative solver "
+    "instead of an external library (GLPK or CVXOPT); this is also the default choice when neither "
+    "of these libraries is available. It requires much less memory for large problems, scales well "
+    "with the number of threads, and supports a warm start from a previous solution, but only "
+    "achieves a moderate accuracy of constraint satisfaction and optimality.\n"
+    "  xinit:   1d vector of length C - initial guess for the solution, e.g., from a previous "
+    "call with slightly different arguments (optional, used only by the iterative solver).\n"
+    "  accuracy:  relative tolerance of the iterative solver (optional, default 1e-6).\n"
+    "  maxiter:   maximum number of iterations of the iterative solver (optional, default 100000).\n"
+    "  dualinit:  1d vector of length R, or a tuple of vectors R1,R2,... - initial guess for "
+    "the Lagrange multipliers of the constraints, usually taken from the output of a previous call "
+    "with returndual=True (optional, used only by the iterative solver).\n"
+    "  returndual:  (bool, default False) whether to return also the Lagrange multipliers "
+    "(only for the iterative solver).\n"
+    "  report:    interval (number of iterations) between progress reports of the iterative solver, "
+    "which are printed at the debug verbosity level (optional, default 0 - no reports).\n"
+    "  nthreads:  the number of OpenMP threads used by the iterative solver (optional, default 0 "
+    "means the number set by the OMP_NUM_THREADS environment variable); this solver runs without "
+    "holding the Python global interpreter lock.\n"
     "Returns:\n"
     "  the vector x solving the above system; if it cannot be solved exactly and no penalties "
-    "for constraint violation were provided, then raise an exception.";
+    "for constraint violation were provided, then raise an exception "
+    "(the iterative solver returns the last approximation with a warning if it did not converge). "
+    "If returndual=True, return a tuple of two vectors: x and the Lagrange multipliers "
+    "(of length R, stacked together if the matrix was given as a tuple).";
 ///
 PyObject* optsolve(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
 {
     static const char* keywords[] =
-        {"matrix", "rhs", "xpenl", "xpenq", "rpenl", "rpenq", "xmin", "xmax", NULL};
+        {"matrix", "rhs", "xpenl", "xpenq", "rpenl", "rpenq", "xmin", "xmax",
+        "iterative", "xinit", "accuracy", "maxiter", "dualinit", "returndual", "report", "nthreads", NULL};
     PyObject *matrix_obj = NULL, *rhs_obj = NULL, *xpenl_obj = NULL, *xpenq_obj = NULL,
-        *rpenl_obj = NULL, *rpenq_obj = NULL, *xmin_obj = NULL, *xmax_obj = NULL;
-    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "OO|OOOOOO", const_cast<char**>(keywords),
-        &matrix_obj, &rhs_obj, &xpenl_obj, &xpenq_obj, &rpenl_obj, &rpenq_obj, &xmin_obj, &xmax_obj))
+        *rpenl_obj = NULL, *rpenq_obj = NULL, *xmin_obj = NULL, *xmax_obj = NULL,
+        *iterative_flag = NULL, *xinit_obj = NULL, *dualinit_obj = NULL, *returndual_flag = NULL;
+    math::IterativeSolverParams params;
+    int maxNumIter = params.maxNumIter, reportInterval = params.reportInterval, nthreads = 0;
+    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "OO|OOOOOOOOdiOOii", const_cast<char**>(keywords),
+        &matrix_obj, &rhs_obj, &xpenl_obj, &xpenq_obj, &rpenl_obj, &rpenq_obj, &xmin_obj, &xmax_obj,
+        &iterative_flag, &xinit_obj, &params.tolerance, &maxNumIter,
+        &dualinit_obj, &returndual_flag, &reportInterval, &nthreads))
     {
         //PyErr_SetString(PyExc_ValueError, "Invalid arguments passed to optsolve()");
         return NULL;
@@ -4625,12 +5146,65 @@ PyObject* optsolve(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
         return NULL;
     }
 
+    std::vector<double> xinit = toDoubleArray(xinit_obj);
+    if(!xinit.empty() && (int)xinit.size() != nCol) {
+        PyErr_SetString(PyExc_ValueError, "Argument 'xinit', if provided, must be a 1d array "
+            "with length matching the number of columns in 'matrix'");
+        return NULL;
+    }
+    std::vector<double> dualinit;
+    if(!stackVectors(dualinit_obj, nRow, dualinit)) {
+        PyErr_SetString(PyExc_ValueError, "Argument 'dualinit', if provided, must be a 1d array "
+            "or a tuple of such arrays matching the number of rows in 'matrix'");
+        return NULL;
+    }
+    if(params.tolerance <= 0 || maxNumIter <= 0 || reportInterval < 0) {
+        PyErr_SetString(PyExc_ValueError,
+            "Arguments 'accuracy' and 'maxiter' must be positive, and 'report' must be non-negative");
+        return NULL;
+    }
+    params.maxNumIter = maxNumIter;
+    params.reportInterval = reportInterval;
+    params.initPrimal = xinit;
+    params.initDual   = dualinit;
+#if !defined(HAVE_GLPK) && !defined(HAVE_CVXOPT)
+    bool iterative = true;   // no other solver is available
+#else
+    bool iterative = iterative_flag!=NULL && PyObject_IsTrue(iterative_flag);
+#endif
+    bool returndual = returndual_flag!=NULL && PyObject_IsTrue(returndual_flag);
+    if(returndual && !iterative) {
+        PyErr_SetString(PyExc_ValueError,
+            "Argument 'returndual' is only supported by the iterative solver");
+        return NULL;
+    }
+    std::vector<double> dual;
+
     // construct an interface layer for matrix stacking
     StackedMatrix matrix(matrixStack, nRowTotal, nCol, nRow);
 
     // call the appropriate solver
     try {
-        if(rpenl.empty() && rpenq.empty()) {
+        OmpThreads threads(nthreads);
+        if(iterative) {
+            // missing lower bounds imply non-negative solution, as for other solvers;
+            // the iterative solver does not use the Python C API, so the GIL is released during
+            // its operation, and reacquired before issuing a warning about non-convergence
+            math::IterativeSolverResult res;
+            {
+                PyReleaseGIL unlock;
+                res = math::quadraticOptimizationSolveIterative(matrix, rhs, xpenl,
+                    math::BandMatrix<double>(xpenq), rpenl, rpenq, xmin, xmax, params);
+            }
+            if(!res.converged && PyErr_WarnEx(NULL,
+                ("optsolve(): iterative solver did not converge after " +
+                utils::toString(res.numIter) + " iterations (residuals: primal=" +
+                utils::toString(res.primalResidual) + ", dual=" +
+                utils::toString(res.dualResidual) + ")").c_str(), 1) < 0)
+                return NULL;   // warning was turned into an exception
+            result.swap(res.x);
+            dual.swap(res.dual);
+        } else if(rpenl.empty() && rpenq.empty()) {
             if(xpenq.empty())
                 result = math::linearOptimizationSolve(
                     matrix, rhs, xpenl, xmin, xmax);
@@ -4650,6 +5224,8 @@ PyObject* optsolve(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
         PyErr_SetString(PyExc_ValueError, (std::string("Error in optsolve(): ")+e.what()).c_str());
         return NULL;
     }
+    if(returndual)
+        return Py_BuildValue("NN", toPyArray(result), toPyArray(dual));
     return toPyArray(result);
 }
 
@@ -5097,23 +5673,12 @@ class FncWrapper: public math::IFunctionNdim {
 public:
     FncWrapper(unsigned int _nvars, PyObject* _fnc): nvars(_nvars), fnc(_fnc) {}
     virtual void eval(const double vars[], double values[]) const {
-        npy_intp dims[]  = {1, nvars};
-        PyObject* args   = PyArray_SimpleNewFromData(2, dims, NPY_DOUBLE, const_cast<double*>(vars));
-        PyObject* result = PyObject_CallFunctionObjArgs(fnc, args, NULL);
-        Py_DECREF(args);
-        if(result == NULL) {
-            PyErr_Print();
-            throw std::runtime_error("Exception occurred inside integrand");
-        }
-        if(PyArray_Check(result))
-            values[0] = pyArrayElem<double>(result, 0);  // TODO: ensure that it's a float array!
-        else if(PyNumber_Check(result))
-            values[0] = PyFloat_AsDouble(result);
-        else {
-            Py_DECREF(result);
-            throw std::runtime_error("Invalid data type returned from user-defined function");
-        }
-        Py_DECREF(result);
+        callPythonFunctionMany(fnc, 1, nvars, vars, values, "function");
+    }
+    /// all points are passed to the Python function as a single array of shape npoints x nvars
+    virtual void evalmany(const size_t npoints, const double vars[], double values[]) const {
+        if(npoints > 0)
+            callPythonFunctionMany(fnc, npoints, nvars, vars, values, "function");
     }
     virtual unsigned int numVars()   const { return nvars; }
     virtual unsigned int numValues() const { return 1; }
@@ -5246,6 +5811,10 @@ static const char* docstringSampleNdim =
     "that specify the lower and upper boundaries of the region (hypercube) to be sampled; "
     "alternatively, a single value - the number of dimensions - may be passed instead of 'lower', "
     "in which case the default interval [0:1] is used for each dimension;\n"
+    "  quasirandom - (boolean, default False) whether to use a scrambled Sobol quasi-random "
+    "sequence instead of pseudo-random numbers for the internal sampling points "
+    "(at most 21 dimensions); this typically reduces the error of the integral "
+    "for the same number of function evaluations, although the reported error is then overestimated.\n"
     "Returns: a tuple consisting of the array of samples with shape (nsamples,ndim), "
     "the integral of the function over the given region estimated in a Monte Carlo way from the samples, "
     "error estimate of the integral, and the actual number of function evaluations performed "
@@ -5256,11 +5825,11 @@ static const char* docstringSampleNdim =
 /// N-dimensional sampling
 PyObject* sampleNdim(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
 {
-    static const char* keywords[] = {"fnc", "nsamples", "lower", "upper", NULL};
+    static const char* keywords[] = {"fnc", "nsamples", "lower", "upper", "quasirandom", NULL};
     int numSamples=-1;
-    PyObject *callback=NULL, *lower_obj=NULL, *upper_obj=NULL;
-    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "Oi|OO", const_cast<char**>(keywords),
-        &callback, &numSamples, &lower_obj, &upper_obj) ||
+    PyObject *callback=NULL, *lower_obj=NULL, *upper_obj=NULL, *quasirandom_flag=NULL;
+    if(!PyArg_ParseTupleAndKeywords(args, namedArgs, "Oi|OOO", const_cast<char**>(keywords),
+        &callback, &numSamples, &lower_obj, &upper_obj, &quasirandom_flag) ||
         !PyCallable_Check(callback) || numSamples<=0)
     {
         PyErr_SetString(PyExc_ValueError, "Incorrect arguments for sampleNdim");
@@ -5274,7 +5843,8 @@ PyObject* sampleNdim(PyObject* /*self*/, PyObject* args, PyObject* namedArgs)
         FncWrapper fnc(xlow.size(), callback);
         size_t numEval=0;
         math::Matrix<double> samples;
-        math::sampleNdim(fnc, &xlow[0], &xupp[0], numSamples, samples, &numEval, &result, &error);
+        math::sampleNdim(fnc, &xlow[0], &xupp[0], numSamples, samples, &numEval, &result, &error,
+            quasirandom_flag!=NULL && PyObject_IsTrue(quasirandom_flag));
         return Py_BuildValue("Nddi", toPyArray(samples), result, error, numEval);
     }
     catch(std::exception& e) {
@@ -5292,6 +5862,8 @@ static PyMethodDef module_methods[] = {
       METH_VARARGS | METH_KEYWORDS, docstringSetUnits },
     { "resetUnits",                          resetUnits,
       METH_NOARGS,                  docstringResetUnits },
+    { "setCacheDir",                         setCacheDir,
+      METH_O,                       docstringSetCacheDir },
     { "nonuniformGrid",         (PyCFunction)nonuniformGrid,
       METH_VARARGS | METH_KEYWORDS, docstringNonuniformGrid },
     { "symmetricGrid",          (PyCFunction)symmetricGrid,
@@ -5386,6 +5958,7 @@ initagama(void)
     PyModule_AddObject(mod, "CubicSpline", (PyObject*)&CubicSplineType);
 
     import_array();  // needed for NumPy to work properly
+    PyEval_InitThreads();  // needed for releasing and reacquiring the GIL in lengthy computations
 }
 // ifdef HAVE_PYTHON
 #endif
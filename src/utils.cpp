@@ -21,6 +21,48 @@ bool fileExists(const std::string& fileName)
     return infile.good();
 }
 
+/* -------- on-disk cache -------- */
+
+namespace{
+/// the cache directory, initialized from the environment variable AGAMA_CACHE_DIR
+std::string initCacheDirectory()
+{
+    const char* env = std::getenv("AGAMA_CACHE_DIR");
+    return env ? std::string(env) : std::string();
+}
+
+std::string cacheDirectory = initCacheDirectory();
+}  // internal namespace
+
+std::string getCacheDirectory()
+{
+    return cacheDirectory;
+}
+
+void setCacheDirectory(const std::string& dirName)
+{
+    cacheDirectory = dirName;
+}
+
+std::string getCacheFileName(const std::string& key, const std::string& extension)
+{
+    if(cacheDirectory.empty())
+        return "";
+    // 64-bit FNV-1a hash of the key, represented as a hexadecimal string
+    unsigned long long hash = 14695981039346656037ULL;
+    for(std::string::size_type i=0; i<key.size(); i++) {
+        hash ^= static_cast<unsigned char>(key[i]);
+        hash *= 1099511628211ULL;
+    }
+    std::string name(16, '0');
+    for(int i=15; i>=0; i--, hash >>= 4)
+        name[i] = "0123456789abcdef"[hash & 15];
+    std::string dir = cacheDirectory;
+    if(dir[dir.size()-1] != '/')
+        dir += '/';
+    return dir + name + extension;
+}
+
 /* -------- error reporting routines ------- */
 
 namespace{  // internal
@@ -150,4 +150,25 @@ std::string pp(double num, unsigned int width);
 /// check if a file with this name exists
 bool fileExists(const std::string& fileName);
 
+/*------- on-disk cache of expensive-to-construct objects -------*/
+
+/** Return the directory used to store the cached copies of potential expansions,
+    action-finder interpolation tables and other objects that are expensive to construct,
+    or an empty string if caching is disabled (default).
+    The cache is enabled by setting the environment variable AGAMA_CACHE_DIR
+    to an existing writable directory, or by calling `setCacheDirectory()`.
+*/
+std::string getCacheDirectory();
+
+/// set the cache directory (an empty string disables the cache)
+void setCacheDirectory(const std::string& dirName);
+
+/** Return the name of a file in the cache directory that corresponds to the given key,
+    or an empty string if caching is disabled.
+    \param[in]  key  is a string that describes all parameters used to construct the object
+    (it may contain arbitrary bytes, and is reduced to a 64-bit hash);
+    \param[in]  extension  is appended to the file name.
+*/
+std::string getCacheFileName(const std::string& key, const std::string& extension="");
+
 }  // namespace
@@ -0,0 +1,368 @@
+/** \file    benchmark.cpp
+    \date    2026
+
+    Performance benchmarks for the most computationally intensive parts of the library:
+    evaluation of potential expansions, action finders, integration of DF moments,
+    sampling, orbit integration, a Raga episode and a Fokker-Planck timestep.
+    Each benchmark performs a fixed number of operations, repeated until a minimum time
+    has elapsed; the timing is reported as wall-clock time per operation.
+    Benchmarks whose operations are independent are run with 1, 2, 4, ... threads
+    up to the maximum available number, to measure the scaling of throughput with thread count.
+    If the name of an output file is given as the command-line argument, the results are
+    also written to this file in JSON format, for tracking the performance between versions.
+    Invoked by `make bench`; it is not a part of the test suite.
+*/
+#include "potential_analytic.h"
+#include "potential_dehnen.h"
+#include "potential_multipole.h"
+#include "potential_cylspline.h"
+#include "potential_factory.h"
+#include "potential_utils.h"
+#include "actions_spherical.h"
+#include "actions_staeckel.h"
+#include "df_halo.h"
+#include "galaxymodel.h"
+#include "galaxymodel_spherical.h"
+#include "galaxymodel_fokkerplanck.h"
+#include "orbit.h"
+#include "particles_io.h"
+#include "raga_core.h"
+#include "math_core.h"
+#include "utils.h"
+#include "utils_config.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <stdexcept>
+#include <cstdio>
+#include <ctime>
+#include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/// minimum duration of each measurement in seconds
+const double MIN_TIME = 0.5;
+
+/// wall-clock time in seconds
+inline double wallTime()
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return std::clock() * 1.0 / CLOCKS_PER_SEC;
+#endif
+}
+
+/// maximum number of threads
+inline int maxThreads()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/// base class for all benchmarks: the expensive setup is done in the constructor,
+/// and the timed operations are performed by the method `op()`
+class BaseBenchmark {
+public:
+    virtual ~BaseBenchmark() {}
+    /// name of the benchmark
+    virtual std::string name() const = 0;
+    /// number of operations performed in one run
+    virtual unsigned int numOps() const = 0;
+    /// number of elementary operations accomplished by one call to op()
+    virtual double opsPerCall() const { return 1; }
+    /// whether different operations are independent and may be run in parallel
+    virtual bool parallel() const { return true; }
+    /// perform the operation with the given index
+    virtual void op(unsigned int index) const = 0;
+};
+
+/// results of one measurement
+struct BenchmarkResult {
+    std::string name;
+    int numThreads;
+    double numOps, seconds;
+    BenchmarkResult(const std::string& _name, int _numThreads, double _numOps, double _seconds) :
+        name(_name), numThreads(_numThreads), numOps(_numOps), seconds(_seconds) {}
+};
+
+/// array of points sampled from a density profile, used as input for various benchmarks
+std::vector<coord::PosVelCar> samplePoints(const potential::BasePotential& pot, unsigned int numPoints)
+{
+    math::randomize(42);
+    particles::ParticleArray<coord::PosCyl> pos = galaxymodel::generateDensitySamples(pot, numPoints);
+    std::vector<coord::PosVelCar> result(pos.size());
+    for(unsigned int i=0; i<pos.size(); i++) {
+        // assign a random velocity with magnitude between 0 and 0.7 of the escape velocity
+        double vesc = sqrt(-2 * pot.value(pos.point(i))), v[3];
+        math::getRandomUnitVector(v);
+        double vmag = 0.7 * vesc * math::random();
+        result[i] = coord::PosVelCar(toPosCar(pos.point(i)),
+            coord::VelCar(v[0] * vmag, v[1] * vmag, v[2] * vmag));
+    }
+    return result;
+}
+
+/// evaluation of potential and force
+class BenchmarkPotential: public BaseBenchmark {
+    const std::string title;
+    const potential::PtrPotential pot;
+    const std::vector<coord::PosVelCar> points;
+public:
+    BenchmarkPotential(const std::string& _title, const potential::PtrPotential& _pot) :
+        title(_title), pot(_pot), points(samplePoints(*pot, 10000)) {}
+    virtual std::string name() const { return "potential " + title; }
+    virtual unsigned int numOps() const { return points.size(); }
+    virtual void op(unsigned int index) const {
+        double Phi;
+        coord::GradCar grad;
+        pot->eval(points[index], &Phi, &grad);
+    }
+};
+
+/// computation of actions
+class BenchmarkActions: public BaseBenchmark {
+    const std::string title;
+    const actions::BaseActionFinder& af;
+    const std::vector<coord::PosVelCar> points;
+public:
+    BenchmarkActions(const std::string& _title, const actions::BaseActionFinder& _af,
+        const potential::BasePotential& pot, unsigned int numPoints) :
+        title(_title), af(_af), points(samplePoints(pot, numPoints)) {}
+    virtual std::string name() const { return "actions " + title; }
+    virtual unsigned int numOps() const { return points.size(); }
+    virtual void op(unsigned int index) const {
+        af.actions(coord::toPosVelCyl(points[index]));
+    }
+};
+
+/// integration of the DF over velocity at a given point
+class BenchmarkMoments: public BaseBenchmark {
+    const galaxymodel::GalaxyModel& model;
+    const std::vector<coord::PosVelCar> points;
+public:
+    BenchmarkMoments(const galaxymodel::GalaxyModel& _model) :
+        model(_model), points(samplePoints(model.potential, 16)) {}
+    virtual std::string name() const { return "DF moments"; }
+    virtual unsigned int numOps() const { return points.size(); }
+    virtual void op(unsigned int index) const {
+        double dens;
+        coord::Vel2Cyl vel2;
+        galaxymodel::computeMoments(model, coord::toPosCyl(points[index]), &dens, NULL, &vel2,
+            NULL, NULL, NULL, 1e-3, 1e4);
+    }
+};
+
+/// sampling of position/velocity from the DF (internally parallelized)
+class BenchmarkSampling: public BaseBenchmark {
+    const galaxymodel::GalaxyModel& model;
+    static const unsigned int NUM_SAMPLES = 1000;
+public:
+    BenchmarkSampling(const galaxymodel::GalaxyModel& _model) : model(_model) {}
+    virtual std::string name() const { return "DF sampling (per sample)"; }
+    virtual unsigned int numOps() const { return 1; }
+    virtual double opsPerCall() const { return NUM_SAMPLES; }
+    virtual bool parallel() const { return false; }
+    virtual void op(unsigned int) const {
+        galaxymodel::generatePosVelSamples(model, NUM_SAMPLES);
+    }
+};
+
+/// integration of orbits for a fixed time
+class BenchmarkOrbit: public BaseBenchmark {
+    const potential::PtrPotential pot;
+    const std::vector<coord::PosVelCar> points;
+public:
+    BenchmarkOrbit(const potential::PtrPotential& _pot) :
+        pot(_pot), points(samplePoints(*pot, 64)) {}
+    virtual std::string name() const { return "orbit integration (T=100)"; }
+    virtual unsigned int numOps() const { return points.size(); }
+    virtual void op(unsigned int index) const {
+        orbit::integrateTraj(points[index], 100., 100., *pot);
+    }
+};
+
+/// one episode of a Raga simulation (including the setup and the potential update)
+class BenchmarkRaga: public BaseBenchmark {
+    static const unsigned int NUM_PARTICLES = 10000;
+    const std::string fileInput, fileLog;
+public:
+    BenchmarkRaga() : fileInput("benchmark_raga.txt"), fileLog("benchmark_raga.log")
+    {
+        math::randomize(42);
+        potential::Plummer pot(1., 1.);
+        particles::ParticleArraySph bodies = galaxymodel::generatePosVelSamples(
+            potential::PotentialWrapper(pot),
+            galaxymodel::makeEddingtonDF(potential::DensityWrapper(pot), potential::PotentialWrapper(pot)),
+            NUM_PARTICLES);
+        particles::writeSnapshot(fileInput, particles::ParticleArrayCar(bodies));
+    }
+    ~BenchmarkRaga()
+    {
+        std::remove(fileInput.c_str());
+        std::remove(fileLog.c_str());
+    }
+    virtual std::string name() const { return "Raga episode (N=" + utils::toString(NUM_PARTICLES) + ")"; }
+    virtual unsigned int numOps() const { return 1; }
+    virtual bool parallel() const { return false; }
+    virtual void op(unsigned int) const {
+        raga::RagaCore(utils::KeyValueMap("fileInput=" + fileInput + ", fileLog=" + fileLog +
+            ", timeTotal=10, episodeLength=10, Symmetry=spherical, lmax=0, gridSizeR=20, "
+            "relaxationRate=0.001, numSamplesPerEpisode=10")).run();
+    }
+};
+
+/// one timestep of the Fokker-Planck solver
+class BenchmarkFokkerPlanck: public BaseBenchmark {
+    potential::Plummer dens;
+    mutable shared_ptr<galaxymodel::FokkerPlanckSolver> fp;
+    double deltat;
+public:
+    BenchmarkFokkerPlanck() : dens(1., 1.)
+    {
+        std::vector<galaxymodel::FokkerPlanckComponent> comps(1);
+        comps[0].initDensity.reset(new potential::DensityWrapper(dens));
+        comps[0].Mstar = 1e-4;
+        galaxymodel::FokkerPlanckParams params;
+        params.coulombLog = log(0.1 / comps[0].Mstar);
+        fp.reset(new galaxymodel::FokkerPlanckSolver(params, comps));
+        deltat = 1e-3 * fp->relaxationTime();
+    }
+    virtual std::string name() const { return "Fokker-Planck step"; }
+    virtual unsigned int numOps() const { return 10; }
+    virtual bool parallel() const { return false; }
+    virtual void op(unsigned int) const { fp->evolve(deltat); }
+};
+
+/// run one benchmark with the given number of threads, repeating it until the minimum time elapsed
+BenchmarkResult runBenchmark(const BaseBenchmark& bench, int numThreads)
+{
+    const int numOps = bench.numOps();
+    double numRuns = 0, time = 0;
+    std::string errorMessage;
+    do {
+        double tbegin = wallTime();
+        if(bench.parallel()) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+#endif
+            for(int i=0; i<numOps; i++) {
+                try{
+                    bench.op(i);
+                }
+                catch(std::exception& ex) {
+                    errorMessage = ex.what();
+                }
+            }
+        } else {
+            for(int i=0; i<numOps; i++)
+                bench.op(i);
+        }
+        time += wallTime() - tbegin;
+        numRuns++;
+    } while(time < MIN_TIME && errorMessage.empty());
+    if(!errorMessage.empty())
+        throw std::runtime_error(errorMessage);
+    return BenchmarkResult(bench.name(), numThreads, numRuns * numOps * bench.opsPerCall(), time);
+}
+
+/// run a benchmark for a sequence of thread counts and print the results
+void runAndReport(const BaseBenchmark& bench, std::vector<BenchmarkResult>& results)
+{
+    std::vector<int> threads;
+    if(bench.parallel()) {
+        for(int n=1; n<maxThreads(); n*=2)
+            threads.push_back(n);
+    }
+    threads.push_back(maxThreads());
+    for(unsigned int t=0; t<threads.size(); t++) {
+        try{
+            BenchmarkResult res = runBenchmark(bench, threads[t]);
+            results.push_back(res);
+            std::cout << std::left << std::setw(36) << res.name << "  threads=" <<
+                std::setw(4) << res.numThreads << "  " <<
+                utils::pp(res.seconds / res.numOps * 1e9, 10) << " ns/op, " <<
+                utils::pp(res.numOps / res.seconds, 10) << " op/s\n";
+        }
+        catch(std::exception& ex) {
+            std::cout << std::left << std::setw(36) << bench.name() << "  \033[1;31mFAILED\033[0m: " << ex.what() << "\n";
+        }
+    }
+}
+
+/// write the results in JSON format
+void writeJSON(const std::string& fileName, const std::vector<BenchmarkResult>& results)
+{
+    std::ofstream strm(fileName.c_str());
+    strm << "{\n  \"maxThreads\": " << maxThreads() << ",\n  \"benchmarks\": [\n";
+    for(unsigned int i=0; i<results.size(); i++) {
+        strm << "    {\"name\": \"" << results[i].name << "\", \"threads\": " << results[i].numThreads <<
+            ", \"ops\": " << results[i].numOps << ", \"seconds\": " << results[i].seconds <<
+            ", \"ns_per_op\": " << results[i].seconds / results[i].numOps * 1e9 << "}" <<
+            (i+1 < results.size() ? ",\n" : "\n");
+    }
+    strm << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<BenchmarkResult> results;
+    try{
+        // potentials
+        potential::PtrPotential potSph(new potential::Dehnen(1., 1., 1., 1., 1.));
+        potential::PtrPotential potMul = potential::Multipole::create(
+            potential::Dehnen(1., 1., 1.5, 0.8, 0.6), 8, 6, 25);
+        potential::PtrPotential potCyl = potential::CylSpline::create(
+            potential::MiyamotoNagai(1., 2., 0.3), 0, 25, 0.1, 50., 25, 0.02, 50.);
+        std::vector<utils::KeyValueMap> paramsGalPot(2);
+        paramsGalPot[0] = utils::KeyValueMap(
+            "type=DiskDensity, surfaceDensity=9e8, scaleRadius=3, scaleHeight=0.3");
+        paramsGalPot[1] = utils::KeyValueMap(
+            "type=SpheroidDensity, densityNorm=1e7, gamma=1, beta=3, scaleRadius=17, outerCutoffRadius=200");
+        potential::PtrPotential potGal = potential::createPotential(paramsGalPot);
+        potential::PtrPotential potAxi = potential::Multipole::create(
+            potential::Dehnen(1., 1., 1., 1., 0.7), 8, 0, 25);
+        runAndReport(BenchmarkPotential("Multipole", potMul), results);
+        runAndReport(BenchmarkPotential("CylSpline", potCyl), results);
+        runAndReport(BenchmarkPotential("GalPot", potGal), results);
+
+        // action finders
+        const actions::ActionFinderSpherical afSph(*potSph);
+        const actions::ActionFinderAxisymFudge afFudge(potAxi, false), afInterp(potAxi, true);
+        runAndReport(BenchmarkActions("spherical", afSph, *potSph, 10000), results);
+        runAndReport(BenchmarkActions("Fudge", afFudge, *potAxi, 1000), results);
+        runAndReport(BenchmarkActions("Fudge interpolated", afInterp, *potAxi, 10000), results);
+
+        // DF moments and sampling
+        df::DoublePowerLawParam paramDPL;
+        paramDPL.slopeIn   = 1.55;
+        paramDPL.slopeOut  = 5.25;
+        paramDPL.steepness = 1.24;
+        paramDPL.J0        = 1.53;
+        paramDPL.coefJrIn  = 1.56;
+        paramDPL.coefJzIn  = (3-paramDPL.coefJrIn)/2;
+        paramDPL.coefJrOut = 1.0;
+        paramDPL.coefJzOut = 1.0;
+        paramDPL.norm      = 2.7;
+        const actions::ActionFinderAxisymFudge afSphFudge(potSph, true);
+        const df::DoublePowerLaw dfDPL(paramDPL);
+        const galaxymodel::GalaxyModel model(*potSph, afSphFudge, dfDPL);
+        runAndReport(BenchmarkMoments(model), results);
+        runAndReport(BenchmarkSampling(model), results);
+
+        // orbit integration and evolutionary codes
+        runAndReport(BenchmarkOrbit(potMul), results);
+        runAndReport(BenchmarkRaga(), results);
+        runAndReport(BenchmarkFokkerPlanck(), results);
+    }
+    catch(std::exception& ex) {
+        std::cout << "Exception: " << ex.what() << "\n";
+    }
+    if(argc > 1)
+        writeJSON(argv[1], results);
+    return 0;
+}
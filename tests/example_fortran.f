@@ -6,7 +6,10 @@ C  (3)  providing a FORTRAN routine that returns a density at a given point,
 C       and using it to create a potential approximation with the parameters
 C       provided in a text string;
 C  (4)  providing a FORTRAN routine that returns potential and force at a given point,
-C       and creating a potential approximation for it in the same way as above.
+C       and creating a potential approximation for it in the same way as above;
+C  (5)  same as (3), but the FORTRAN routine computes the density at many points at once.
+C  Potential, force and density may be computed at a single point or at many points
+C  at once (the latter variant is parallelized internally and has lower overhead).
 C  Due to the absense of a native pointer type in FORTRAN, the pointer to the C++ object
 C  should be stored in a placeholder variable of type CHAR*8, which is passed
 C  as the first argument to all functions in this module.
@@ -14,17 +17,22 @@ C  as the first argument to all functions in this module.
       program example
       implicit none
 C  This is not an actual string, but a placeholder to keep the pointer to the C++ object
-      character*8 c_obj1, c_obj2, c_obj3, c_obj4, c_obj5
+      character*8 c_obj1, c_obj2, c_obj3, c_obj4, c_obj5, c_obj6
 C  Functions provided by the AGAMA library
       double precision agama_potential, agama_potforce,
      &    agama_potforcederiv, agama_density
 C  User-defined density and potential functions
       double precision user_density, user_potential
 C  It is necessary to declare them as functions, not variables
-      external user_density, user_potential
+      external user_density, user_potential, user_density_arr
 C  Local variables
       double precision xyz(3), pot0, pot1, pot2, den0, den1, den2,
      &    force0(3), force1(3), force2(3), deriv(6)
+C  Arrays for computing the potential and density at many points at once
+      integer npoints, i
+      parameter (npoints=100)
+      double precision xyzarr(3,npoints), potarr(npoints),
+     &    forcearr(3,npoints), denarr(npoints), denarr0(npoints)
       logical success
       success = .true.
 
@@ -103,6 +111,39 @@ C  check the accuracy
           success = .false.
       endif
 
+C  Example 5:  constructing a potential approximation from the user-provided
+C  density routine that computes the density at many points in a single call,
+C  and evaluating the potential, force and density at many points at once
+      print*, 'Create a potential from the user-provided density array'
+      call agama_initfromdensarr(c_obj6,
+     &    'type=Multipole symmetry=Axisymmetric',
+     &    user_density_arr)
+      do i=1, npoints
+          xyzarr(1,i) = 0.05d0 * i
+          xyzarr(2,i) = 0.02d0 * i
+          xyzarr(3,i) = 0.01d0 * i
+      enddo
+      call agama_potforcearr(c_obj6, npoints, xyzarr, potarr, forcearr)
+      call agama_densityarr (c_obj6, npoints, xyzarr, denarr)
+      call user_density_arr(npoints, xyzarr, denarr0)
+      print*, 'Position(x,y,z)=', xyzarr(:,npoints)
+      print*, 'Multipole potential=', potarr(npoints),
+     &    'force=', forcearr(:,npoints)
+      print*, 'Multipole   density=', denarr(npoints)
+      print*, 'original    density=', denarr0(npoints)
+
+C  check the accuracy and consistency with the single-point routines
+      do i=1, npoints
+          pot1 = agama_potforce(c_obj6, xyzarr(:,i), force1)
+          if(abs(denarr(i)-denarr0(i)) > denarr0(i) * 1.d-2
+     &        .or. pot1 .ne. potarr(i)
+     &        .or. force1(1) .ne. forcearr(1,i)
+     &        .or. force1(3) .ne. forcearr(3,i)) then
+              print*, '**FAILED** at point', i
+              success = .false.
+          endif
+      enddo
+
 C  Example 4:  constructing a potential from parameters stored in an INI file
       call agama_initfromfile(c_obj5, '../data/BT08.ini')
       print*, 'Potential=', agama_potential(c_obj5, xyz)
@@ -131,6 +172,19 @@ c     parameters of density profile
       end
 
 
+C  This is the routine that computes the same density profile at many points at once
+      subroutine user_density_arr(n, x, rho)
+      implicit none
+      integer n, i
+      double precision x(3,n), rho(n), user_density
+      external user_density
+
+      do i=1, n
+          rho(i) = user_density(x(:,i))
+      enddo
+      end
+
+
 C  This is the function that provides the user-defined potential profile;
 C  in this example it is a triaxial plummer-like potential
 C  with constant flattening of equipotential surface
@@ -0,0 +1,167 @@
+/** \file    test_actions_spherical.cpp
+    \date    2026
+
+    Test the lazily constructed interpolation tables in ActionFinderSpherical and
+    potential::Interpolator2d, which are split into tiles in energy:
+    the values interpolated from the tiles should agree with those from a single table covering
+    the entire range of energies (as constructed in earlier versions), should be continuous across
+    the boundaries between tiles, and should not depend on the order in which the tiles are
+    constructed when they are first accessed simultaneously from several threads.
+*/
+#include "potential_analytic.h"
+#include "potential_utils.h"
+#include "actions_spherical.h"
+#include "utils.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+const double M = 2.7;      // mass and
+const double b = 0.6;      // scale radius of Isochrone potential
+const unsigned int GLOBAL_TILE = 1000;  // tile size exceeding the grid size: a single table
+const double epsRel  = 0.05; // max difference between tiled and global tables, relative to
+                             // the max error of the global table w.r.t. the exact solution
+const double epsR    = 1e-7; // max difference in scaled peri/apocenter radii
+const double epsCont = 1e-14;// max relative discontinuity of Jr across the nodes of the energy grid
+const double epsFreq = 2e-4; // max relative discontinuity of frequencies across the tile boundaries
+
+/// a set of points in (E, L/Lcirc) covering the entire range of energies
+void makePoints(const potential::BasePotential& pot, std::vector<double>& E, std::vector<double>& Lrel)
+{
+    double Phi0 = pot.value(coord::PosCyl(0,0,0));
+    for(int i=0; i<500; i++) {
+        E.push_back(Phi0 * (1 - pow(0.5 + 0.5 * sin(i * 0.713), 2) * 0.999 - 0.0005));
+        Lrel.push_back(0.5 + 0.499 * sin(i * 1.37));
+    }
+}
+
+/// compare the radial action and frequencies computed with the tiled and the global tables
+/// with each other and with the exact expressions for the Isochrone potential
+bool testTiledVsGlobal(const potential::BasePotential& pot)
+{
+    actions::ActionFinderSpherical afTiled(pot), afGlobal(pot, GLOBAL_TILE);
+    potential::Interpolator2d intTiled(pot), intGlobal(pot, GLOBAL_TILE);
+    potential::Interpolator interp(pot);
+    std::vector<double> E, Lrel;
+    makePoints(pot, E, Lrel);
+    double maxdifJr = 0, maxdifOm = 0, maxdifR = 0, maxerrJr = 0, maxerrOm = 0, maxerrTiled = 0;
+    for(size_t i=0; i<E.size(); i++) {
+        double L = Lrel[i] * interp.L_circ(E[i]);
+        double Omr1, Omz1, Omr2, Omz2, R11, R21, R12, R22;
+        double Jr1 = afTiled .Jr(E[i], L, &Omr1, &Omz1);
+        double Jr2 = afGlobal.Jr(E[i], L, &Omr2, &Omz2);
+        intTiled .findScaledOrbitExtent(E[i], Lrel[i], R11, R21);
+        intGlobal.findScaledOrbitExtent(E[i], Lrel[i], R12, R22);
+        // exact expressions for the Isochrone potential
+        double Jr  = M / sqrt(-2*E[i]) - 0.5 * (L + sqrt(L*L + 4*M*b));
+        double Omr = pow(-2*E[i], 1.5) / M;
+        maxdifJr = fmax(maxdifJr, fabs(Jr1 - Jr2) / (Jr + L));
+        maxdifOm = fmax(maxdifOm, fabs(Omr1 - Omr2) / Omr);
+        maxdifR  = fmax(maxdifR,  fmax(fabs(R11 - R12), fabs(R21 - R22) / R22));
+        maxerrJr = fmax(maxerrJr, fabs(Jr2 - Jr) / (Jr + L));
+        maxerrOm = fmax(maxerrOm, fabs(Omr2 - Omr) / Omr);
+        maxerrTiled = fmax(maxerrTiled, fabs(Jr1 - Jr) / (Jr + L));
+    }
+    bool ok = maxdifJr < epsRel * maxerrJr && maxdifOm < epsRel * maxerrOm && maxdifR < epsR &&
+        maxerrTiled <= maxerrJr * (1 + epsRel);
+    std::cout << "Tiled vs global tables: max relative difference in Jr: " << maxdifJr <<
+        ", in Omega_r: " << maxdifOm << ", in peri/apocenter radii: " << maxdifR <<
+        "; error of the global table w.r.t. exact Jr: " << maxerrJr << ", Omega_r: " << maxerrOm <<
+        (ok ? "" : " \033[1;31m**\033[0m") << "\n";
+    return ok;
+}
+
+/// check that the radial action is continuous across the nodes of the energy grid,
+/// which include all boundaries between the tiles: the difference between the values on
+/// both sides of each node should be the same as for the global table (which is continuous
+/// by construction), while the frequencies (derivatives of the spline) may have small jumps
+bool testContinuity(const potential::BasePotential& pot)
+{
+    actions::ActionFinderSpherical afTiled(pot), afGlobal(pot, GLOBAL_TILE);
+    potential::Interpolator interp(pot);
+    // same grid in energy as used in the implementation
+    const unsigned int sizeE = 50;
+    double Phi0 = pot.value(coord::PosCyl(0,0,0)), maxjumpJr = 0, maxjumpOm = 0;
+    for(unsigned int i=1; i<sizeE-1; i++) {
+        double x = 1.*i/(sizeE-1);
+        double Enode = (1 - pow_3(x) * (10+x*(-15+x*6))) * Phi0;
+        double E1 = Enode * (1 + 1e-14), E2 = Enode * (1 - 1e-14);
+        for(int k=0; k<10; k++) {
+            double Lrel = 0.05 + 0.1 * k, L1 = Lrel * interp.L_circ(E1), L2 = Lrel * interp.L_circ(E2);
+            double Omt1, Omt2, Omg1, Omg2, Omz;
+            double Jrt1 = afTiled .Jr(E1, L1, &Omt1, &Omz), Jrt2 = afTiled .Jr(E2, L2, &Omt2, &Omz);
+            double Jrg1 = afGlobal.Jr(E1, L1, &Omg1, &Omz), Jrg2 = afGlobal.Jr(E2, L2, &Omg2, &Omz);
+            maxjumpJr = fmax(maxjumpJr, fabs((Jrt1 - Jrt2) - (Jrg1 - Jrg2)) / (Jrt1 + Jrt2));
+            maxjumpOm = fmax(maxjumpOm, fabs((Omt1 - Omt2) - (Omg1 - Omg2)) / (Omt1 + Omt2));
+        }
+    }
+    bool ok = maxjumpJr < epsCont && maxjumpOm < epsFreq;
+    std::cout << "Continuity across the nodes of the energy grid: max relative jump in Jr: " <<
+        maxjumpJr << ", in Omega_r: " << maxjumpOm << (ok ? "" : " \033[1;31m**\033[0m") << "\n";
+    return ok;
+}
+
+/// check that the tables constructed on first access from several threads simultaneously
+/// produce exactly the same results as those constructed sequentially
+bool testConcurrentAccess(const potential::BasePotential& pot)
+{
+    potential::Interpolator interp(pot);
+    std::vector<double> E, Lrel;
+    makePoints(pot, E, Lrel);
+    const int npoints = E.size();
+    std::vector<double> L(npoints), JrSerial(npoints), JrParallel(npoints);
+    std::vector<double> R1Serial(npoints), R2Serial(npoints), R1Parallel(npoints), R2Parallel(npoints);
+    for(int i=0; i<npoints; i++)
+        L[i] = Lrel[i] * interp.L_circ(E[i]);
+    {
+        actions::ActionFinderSpherical af(pot);
+        potential::Interpolator2d int2d(pot);
+        for(int i=0; i<npoints; i++) {
+            JrSerial[i] = af.Jr(E[i], L[i]);
+            int2d.findScaledOrbitExtent(E[i], Lrel[i], R1Serial[i], R2Serial[i]);
+        }
+    }
+    // repeat several times with fresh instances, since the outcome of a race is not deterministic
+    bool ok = true;
+    for(int iter=0; iter<5; iter++) {
+        actions::ActionFinderSpherical af(pot);
+        potential::Interpolator2d int2d(pot);
+        std::string error;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic,1)
+#endif
+        for(int i=0; i<npoints; i++) {
+            try{
+                JrParallel[i] = af.Jr(E[i], L[i]);
+                int2d.findScaledOrbitExtent(E[i], Lrel[i], R1Parallel[i], R2Parallel[i]);
+            }
+            catch(std::exception& e) {
+                error = e.what();
+            }
+        }
+        if(!error.empty()) {
+            std::cout << "Exception: " << error << "\n";
+            ok = false;
+        }
+        for(int i=0; i<npoints; i++)
+            ok &= JrParallel[i] == JrSerial[i] &&
+                R1Parallel[i] == R1Serial[i] && R2Parallel[i] == R2Serial[i];
+    }
+    std::cout << "Concurrent first access to the tables from several threads: results " <<
+        (ok ? "are identical to the sequential ones" : "differ \033[1;31m**\033[0m") << "\n";
+    return ok;
+}
+
+int main()
+{
+    potential::Isochrone pot(M, b);
+    bool allok = true;
+    allok &= testTiledVsGlobal(pot);
+    allok &= testContinuity(pot);
+    allok &= testConcurrentAccess(pot);
+    if(allok)
+        std::cout << "\033[1;32mALL TESTS PASSED\033[0m\n";
+    else
+        std::cout << "\033[1;31mSOME TESTS FAILED\033[0m\n";
+    return 0;
+}
@@ -0,0 +1,160 @@
+/** \file    test_cache.cpp
+    \date    2026
+
+    Test the on-disk cache of potential expansions and of the interpolation tables of
+    the Staeckel fudge action finder: objects loaded from the cache should produce the same
+    results as the freshly constructed ones (up to round-off errors), and different potentials
+    should not share the same cache entry.
+*/
+#include "potential_factory.h"
+#include "potential_analytic.h"
+#include "actions_staeckel.h"
+#include "utils.h"
+#include "utils_config.h"
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// axisymmetric potential that depends on the parameter c only in the lower half-space z<0
+/// (it declares itself z-reflection-symmetric, which is not true, but serves to check that
+/// the cache key of the action finder depends on the values of the potential at z<0)
+class AsymmetricPlummer: public potential::BasePotentialCyl {
+    const double c;
+public:
+    AsymmetricPlummer(double _c) : c(_c) {}
+    virtual coord::SymmetryType symmetry() const { return coord::ST_AXISYMMETRIC; }
+    virtual const char* name() const { return "AsymmetricPlummer"; }
+    virtual void evalCyl(const coord::PosCyl &pos,
+        double* potential, coord::GradCyl* deriv, coord::HessCyl* deriv2) const
+    {
+        double z2 = pos.z<0 ? pow_2(pos.z) : 0,
+        q = 1 + pow_2(pos.R) + pow_2(pos.z) + c * z2 * z2, s = 1 / sqrt(q);
+        if(potential)
+            *potential = -s;
+        if(deriv) {
+            deriv->dR   = pos.R * s / q;
+            deriv->dz   = (pos.z + 2 * c * z2 * pos.z) * s / q;
+            deriv->dphi = 0;
+        }
+        if(deriv2) {  // not needed, but must be assigned
+            deriv2->dR2 = deriv2->dz2 = deriv2->dRdz = deriv2->dRdphi = deriv2->dzdphi = deriv2->dphi2 = 0;
+        }
+    }
+    virtual double densityCyl(const coord::PosCyl&) const { return NAN; }
+};
+
+/// list the files with the given extension in the directory
+std::vector<std::string> listFiles(const std::string& dirName, const std::string& ext)
+{
+    std::vector<std::string> result;
+    DIR* dir = opendir(dirName.c_str());
+    if(!dir)
+        return result;
+    while(struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if(name.size() > ext.size() && name.substr(name.size() - ext.size()) == ext)
+            result.push_back(dirName + '/' + name);
+    }
+    closedir(dir);
+    return result;
+}
+
+/// max relative difference between the values and forces of two potentials at a set of points
+double comparePotentials(const potential::BasePotential& pot1, const potential::BasePotential& pot2)
+{
+    double maxdif = 0;
+    for(int i=0; i<200; i++) {
+        double r = pow(10., i * 0.03 - 3), theta = i * 0.37, phi = i * 0.61;
+        coord::PosCyl pos(r * sin(theta), r * cos(theta), phi);
+        double val1, val2;
+        coord::GradCyl grad1, grad2;
+        pot1.eval(pos, &val1, &grad1);
+        pot2.eval(pos, &val2, &grad2);
+        maxdif = fmax(maxdif, fabs(val1 - val2) / fabs(val1));
+        maxdif = fmax(maxdif, fabs(grad1.dR - grad2.dR) / (fabs(grad1.dR) + fabs(grad1.dz)));
+        maxdif = fmax(maxdif, fabs(grad1.dz - grad2.dz) / (fabs(grad1.dR) + fabs(grad1.dz)));
+    }
+    return maxdif;
+}
+
+bool testPotentialCache(const std::string& cacheDir, const char* params)
+{
+    utils::KeyValueMap kvmap(params);
+    utils::setCacheDirectory("");
+    potential::PtrPotential potFresh  = potential::createPotential(kvmap);
+    utils::setCacheDirectory(cacheDir);
+    potential::PtrPotential potStored = potential::createPotential(kvmap);  // cache miss
+    potential::PtrPotential potLoaded = potential::createPotential(kvmap);  // cache hit
+    utils::setCacheDirectory("");
+    double difStored = comparePotentials(*potFresh, *potStored),
+           difLoaded = comparePotentials(*potStored, *potLoaded);
+    // the cached copy is read back from the file on both the first and the subsequent calls,
+    // and should differ from the original one only by round-off errors
+    bool ok = difStored < 1e-10 && difLoaded == 0;
+    std::cout << params << ": deviation of cached from fresh: " << difStored <<
+        ", loaded from stored: " << difLoaded << (ok ? "" : " \033[1;31m**\033[0m") << "\n";
+    return ok;
+}
+
+bool testActionFinderCache(const std::string& cacheDir)
+{
+    potential::PtrPotential pot0(new AsymmetricPlummer(0.)), pot1(new AsymmetricPlummer(1.));
+    const coord::PosVelCyl points[3] = {
+        coord::PosVelCyl(0.5, 0.3, 0, 0.1, 0.2, 0.4),
+        coord::PosVelCyl(1.5,-0.4, 0, 0.3,-0.1, 0.2),
+        coord::PosVelCyl(0.1, 0.8, 0,-0.2, 0.1, 0.1) };
+    bool ok = true;
+    for(int interp=0; interp<=1; interp++) {
+        utils::setCacheDirectory("");
+        actions::ActionFinderAxisymFudge afFresh(pot0, interp);
+        utils::setCacheDirectory(cacheDir);
+        actions::ActionFinderAxisymFudge afStored(pot0, interp);  // cache miss
+        actions::ActionFinderAxisymFudge afLoaded(pot0, interp);  // cache hit
+        utils::setCacheDirectory("");
+        for(int p=0; p<3; p++) {
+            actions::Actions actFresh = afFresh.actions(points[p]),
+                actStored = afStored.actions(points[p]), actLoaded = afLoaded.actions(points[p]);
+            ok &= actFresh.Jr == actStored.Jr && actFresh.Jz == actStored.Jz &&
+                actFresh.Jr == actLoaded.Jr && actFresh.Jz == actLoaded.Jz;
+        }
+    }
+    // a potential that differs from the first one only at z<0 must not reuse its cache entry
+    unsigned int numFiles = listFiles(cacheDir, ".fudge").size();
+    utils::setCacheDirectory(cacheDir);
+    actions::ActionFinderAxisymFudge af1(pot1, false);
+    utils::setCacheDirectory("");
+    ok &= numFiles == 2 && listFiles(cacheDir, ".fudge").size() == 3;
+    std::cout << "ActionFinderAxisymFudge: cached and fresh tables " <<
+        (ok ? "are identical" : "differ, or the cache key is not unique \033[1;31m**\033[0m") << "\n";
+    return ok;
+}
+
+int main()
+{
+    std::string cacheDir = "test_cache_" + utils::toString((long)getpid());
+    if(mkdir(cacheDir.c_str(), 0755) != 0) {
+        std::cout << "Cannot create directory " << cacheDir << "\n";
+        return 1;
+    }
+    bool allok = true;
+    allok &= testPotentialCache(cacheDir,
+        "type=Multipole density=Dehnen gamma=1 axisRatioY=0.8 axisRatioZ=0.6 lmax=6");
+    allok &= testPotentialCache(cacheDir,
+        "type=CylSpline density=MiyamotoNagai scaleRadius=2 scaleHeight=0.3 mmax=0");
+    allok &= testActionFinderCache(cacheDir);
+
+    // clean up
+    std::vector<std::string> files = listFiles(cacheDir, "");
+    for(size_t i=0; i<files.size(); i++)
+        std::remove(files[i].c_str());
+    rmdir(cacheDir.c_str());
+
+    if(allok)
+        std::cout << "\033[1;32mALL TESTS PASSED\033[0m\n";
+    else
+        std::cout << "\033[1;31mSOME TESTS FAILED\033[0m\n";
+    return 0;
+}
@@ -145,6 +145,53 @@ bool testDFmoments(const galaxymodel::GalaxyModel& galmod, const coord::PosVelCy
     return dfok && densok && sigmaok && densvdfok && sigmavdfok;
 }
 
+/// check that the moments computed for an array of points agree with those computed separately
+bool testMomentsMap(const galaxymodel::GalaxyModel& galmod)
+{
+    std::vector<coord::PosCyl> points;
+    points.push_back(coord::PosCyl(1.0, 0.5, 0));
+    points.push_back(coord::PosCyl(1.0,-0.5, 2));  // mirror image of the first point, rotated in phi
+    points.push_back(coord::PosCyl(0.2, 0.0, 0));
+    points.push_back(coord::PosCyl(NAN, 0.3, 0));  // invalid point should produce NAN in the output
+    points.push_back(coord::PosCyl(0.2, 0.0, 1));  // same as the third point in the axisymmetric case
+    std::vector<double> dens(points.size());
+    std::vector<coord::VelCyl> vel(points.size());
+    std::vector<coord::Vel2Cyl> vel2(points.size());
+    computeMomentsMap(galmod, points, &dens[0], &vel[0], &vel2[0], NULL, NULL, NULL,
+        reqRelError, maxNumEval);
+    bool ok = true;
+    for(size_t i=0; i<points.size(); i++) {
+        if(!isFinite(points[i].R)) {
+            ok &= !isFinite(dens[i]) && !isFinite(vel[i].vz) && !isFinite(vel2[i].vR2);
+            continue;
+        }
+        double densPoint;
+        coord::VelCyl velPoint;
+        coord::Vel2Cyl vel2Point;
+        computeMoments(galmod, points[i], &densPoint, &velPoint, &vel2Point, NULL, NULL, NULL,
+            reqRelError, maxNumEval);
+        ok &= math::fcmp(dens[i], densPoint, 1e-10) == 0 &&
+            fabs(vel[i].vz - velPoint.vz) <= 1e-3 * sqrt(vel2Point.vz2) &&
+            math::fcmp(vel2[i].vR2, vel2Point.vR2, 1e-10) == 0 &&
+            math::fcmp(vel2[i].vphi2, vel2Point.vphi2, 1e-10) == 0;
+    }
+    // same for the projected moments
+    std::vector<double> radii(3), surfDens(3), losvdisp(3);
+    radii[0] = 0.5;  radii[1] = NAN;  radii[2] = 0.5;
+    computeProjectedMomentsMap(galmod, radii, &surfDens[0], &losvdisp[0], NULL, NULL,
+        reqRelError, maxNumEval);
+    double surfDensPoint, losvdispPoint;
+    computeProjectedMoments(galmod, radii[0], surfDensPoint, losvdispPoint, NULL, NULL,
+        reqRelError, maxNumEval);
+    ok &= surfDens[0] == surfDensPoint && surfDens[2] == surfDensPoint &&
+        losvdisp[0] == losvdispPoint && losvdisp[2] == losvdispPoint &&
+        !isFinite(surfDens[1]) && !isFinite(losvdisp[1]);
+    std::cout << "Moments map: density=" << dens[0] << ", " << dens[1] << ", " << dens[2] <<
+        ", " << dens[3] << "; surface density=" << surfDens[0] << ", " << surfDens[1] <<
+        (ok?"":errmsg) << "\n";
+    return ok;
+}
+
 /// analytic expression for the ergodic distribution function f(E)
 /// in a Hernquist model with mass m, scale radius a, at energy E.
 double dfHernquist(double m, double a, double E)
@@ -200,6 +247,7 @@ int main(){
         double sigmaExact = sigmaHernquist(1, 1, coord::toPosSph(point).r);  // analytical value of sigma^2
         ok &= testDFmoments(galmodH, point, dfExact, densExact, sigmaExact);
     }
+    ok &= testMomentsMap(galmodH);
 
     if(utils::verbosityLevel >= utils::VL_VERBOSE) {
         std::ofstream strm("test_df_halo.dat");
@@ -0,0 +1,101 @@
+/** \file    test_losvd_grid.cpp
+    \date    2026
+
+    Test the equivalence of two ways of recording the line-of-sight velocity distribution
+    in LOSVDGrid: accumulating the points in the full 3d datacube of B-spline amplitudes
+    (either one by one or in batches) and converting it to the LOSVDs in apertures at the end,
+    or distributing each point over the apertures right away (recordApertures=true).
+*/
+#include "galaxymodel_losvd.h"
+#include "math_core.h"
+#include <iostream>
+#include <cmath>
+
+const double eps = 1e-12;  // relative accuracy of comparison
+
+/// create a rectangular aperture polygon
+math::Polygon rectangle(double xmin, double xmax, double ymin, double ymax)
+{
+    math::Polygon poly(4);
+    poly[0].x = xmin;  poly[0].y = ymin;
+    poly[1].x = xmax;  poly[1].y = ymin;
+    poly[2].x = xmax;  poly[2].y = ymax;
+    poly[3].x = xmin;  poly[3].y = ymax;
+    return poly;
+}
+
+template<int N>
+bool testLOSVD(const galaxymodel::LOSVDGridParams& params, const char* title)
+{
+    galaxymodel::LOSVDGridParams paramsAp(params);
+    paramsAp.recordApertures = true;
+    galaxymodel::LOSVDGrid<N> gridCube(params), gridAp(paramsAp);
+
+    // a set of points along a smooth "trajectory", so that consecutive points
+    // often fall into the same grid cell, plus a few points outside the grid
+    const unsigned int numPoints = 1000;
+    std::vector<double> points(numPoints * 6), mults(numPoints);
+    for(unsigned int i=0; i<numPoints; i++) {
+        for(int k=0; k<6; k++)
+            points[i*6+k] = (k<3 ? 1.6 : 1.2) * sin(i * (0.011 + 0.003*k) + k);
+        mults[i] = 1 + 0.3 * cos(i * 0.07);
+    }
+    points[6*17] = 10.;  // outside the spatial grid
+    points[6*18+4] = 10.;  // outside the velocity grid
+
+    // dense datacube: first half of points added one by one, the second half in one batch
+    math::Matrix<double> cube = gridCube.newDatacube(), cubeAp = gridAp.newDatacube();
+    for(unsigned int i=0; i<numPoints/2; i++)
+        gridCube.addPoint(&points[i*6], mults[i], cube.data());
+    gridCube.addPoints(&points[numPoints/2*6], &mults[numPoints/2], numPoints/2, cube.data());
+    // direct recording into apertures: all points in several batches of different size
+    for(unsigned int i=0, batch=1; i<numPoints; i+=batch, batch=batch*2+1)
+        gridAp.addPoints(&points[i*6], &mults[i], std::min(batch, numPoints-i), cubeAp.data());
+
+    math::Matrix<double> amplCube = gridCube.getAmplitudes(cube), amplAp = gridAp.getAmplitudes(cubeAp);
+    bool ok = cubeAp.rows() == params.apertures.size() &&
+        amplCube.rows() == amplAp.rows() && amplCube.cols() == amplAp.cols();
+    double maxval = 0, maxdif = 0;
+    for(size_t r=0; ok && r<amplCube.rows(); r++)
+        for(size_t c=0; c<amplCube.cols(); c++) {
+            maxval = fmax(maxval, fabs(amplCube(r, c)));
+            maxdif = fmax(maxdif, fabs(amplCube(r, c) - amplAp(r, c)));
+        }
+    ok &= maxval > 0 && maxdif < eps * maxval;
+    std::cout << title << ", N=" << N << ": datacube " << cube.rows() << "x" << cube.cols() <<
+        ", apertures " << cubeAp.rows() << "x" << cubeAp.cols() << ", max deviation in amplitudes: " <<
+        maxdif << " (max value " << maxval << ")" << (ok ? "" : " \033[1;31m**\033[0m") << "\n";
+    return ok;
+}
+
+int main()
+{
+    galaxymodel::LOSVDGridParams params;
+    params.theta = 0.4;
+    params.phi   = 0.3;
+    params.chi   = 0.2;
+    params.gridx = math::createUniformGrid(13, -2, 2);
+    params.gridy = math::createUniformGrid(11, -1.8, 1.8);
+    params.gridv = math::createUniformGrid(9, -2, 2);
+    for(int i=0; i<5; i++)
+        params.apertures.push_back(rectangle(-1.6+i*0.65, -1.0+i*0.65, -1.2+i*0.1, 1.3-i*0.2));
+    params.apertures.push_back(rectangle(-1.9, 1.9, 1.3, 1.7));
+
+    bool allok = true;
+    allok &= testLOSVD<0>(params, "no PSF");
+    allok &= testLOSVD<1>(params, "no PSF");
+    allok &= testLOSVD<2>(params, "no PSF");
+    allok &= testLOSVD<3>(params, "no PSF");
+    params.spatialPSF.push_back(galaxymodel::GaussianPSF(0.3, 0.7));
+    params.spatialPSF.push_back(galaxymodel::GaussianPSF(0.8, 0.3));
+    params.velocityPSF = 0.25;
+    allok &= testLOSVD<0>(params, "with PSF");
+    allok &= testLOSVD<1>(params, "with PSF");
+    allok &= testLOSVD<2>(params, "with PSF");
+    allok &= testLOSVD<3>(params, "with PSF");
+    if(allok)
+        std::cout << "\033[1;32mALL TESTS PASSED\033[0m\n";
+    else
+        std::cout << "\033[1;31mSOME TESTS FAILED\033[0m\n";
+    return 0;
+}
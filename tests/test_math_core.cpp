@@ -149,6 +149,21 @@ public:
 };
 #endif
 
+// same function with a batched evaluation interface, counting the number of calls
+class test8NdimMany: public test8Ndim{
+public:
+    mutable int numCalls;
+    test8NdimMany() : numCalls(0) {}
+    virtual void evalmany(const size_t npoints, const double x[], double val[]) const{
+        for(size_t p=0; p<npoints; p++)
+            test8Ndim::eval(x + p*3, val + p);
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        ++numCalls;
+    }
+};
+
 // test functions for estimating the accuracy of Gauss-Legendre integration
 class test_GL_powerlaw: public math::IFunctionNoDeriv{
 public:
@@ -410,6 +425,15 @@ int main()
         " (delta="<<(result-fnc8.exact)<<"; neval="<<numEval<<")\n";
     ok &= (fabs(result-fnc8.exact)<error) || err();
 
+    // same integral with the batched evaluation: the result must be identical
+    numEval=0;
+    test8NdimMany fnc8many;
+    double resultMany;
+    integrateNdim(fnc8many, fnc8.ymin, fnc8.ymax, toler, 1000000, &resultMany, &error);
+    std::cout << "Batched evaluation: "<<resultMany<<" (neval="<<numEval<<
+        " in "<<fnc8many.numCalls<<" calls)\n";
+    ok &= (resultMany == result && fnc8many.numCalls > 0 && fnc8many.numCalls * 10 < numEval) || err();
+
     numEval=0;
     math::Matrix<double> points;
     sampleNdim(fnc8, fnc8.ymin, fnc8.ymax, 100000, points, NULL, &result, &error);
@@ -422,6 +446,30 @@ int main()
             fout << points(i,0) << "\t" << points(i,1) << "\t" << points(i,2) << "\n";
     }
 
+    numEval=0;
+    sampleNdim(fnc8, fnc8.ymin, fnc8.ymax, 100000, points, NULL, &result, &error, /*quasiRandom*/true);
+    std::cout << "Quasi-random Monte Carlo Volume of a 3d torus = "<<result<<" +- "<<error<<
+        " (delta="<<(result-fnc8.exact)<<"; neval="<<numEval<<")\n";
+    ok &= (fabs(result-fnc8.exact)<error) || err();  // the error estimate is conservative in this case
+
+    // equidistribution property of the Sobol sequence: each block of 2^k points has exactly
+    // one point in each of 2^k equal intervals in every dimension, with or without scrambling
+    {
+        const unsigned int numPoints = 1024;
+        bool equidistr = true;
+        for(unsigned int d=0; d<math::MAX_SOBOL_DIM; d++) {
+            std::vector<int> count0(numPoints), count1(numPoints);
+            for(unsigned int i=0; i<numPoints; i++) {
+                count0[static_cast<int>(math::quasiRandomSobol(i, d) * numPoints)]++;
+                count1[static_cast<int>(math::quasiRandomSobol(i+numPoints, d, 42) * numPoints)]++;
+            }
+            for(unsigned int i=0; i<numPoints; i++)
+                equidistr &= count0[i] == 1 && count1[i] == 1;
+        }
+        std::cout << "Sobol sequence equidistribution: " << (equidistr ? "OK" : "FAILED") << "\n";
+        ok &= equidistr || err();
+    }
+
 #if 0
     // test the accuracy of fixed-order (n) Gauss-Legendre quadrature in integrating a power-law function in radius
     for(double p=-40; p<=40; p+=1.77) {
@@ -124,6 +124,34 @@ int main()
     math::blas_dgemm(math::CblasNoTrans, math::CblasTrans, 1, mat, mat, 0, dmat);
     std::cout << "Dense  MM: " << ((std::clock()-tbegin)*1.0/CLOCKS_PER_SEC) << " s\n";
 
+    {   // mixed sparse-dense products with all combinations of transposition flags
+        const unsigned int NC=7;
+        math::Matrix<double> rect(NR, NC), rectT(NC, NR);
+        for(unsigned int i=0; i<NR; i++)
+            for(unsigned int j=0; j<NC; j++)
+                rect(i, j) = rectT(j, i) = math::random();
+        double maxdif = 0;
+        for(int tS=0; tS<2; tS++)
+            for(int tD=0; tD<2; tD++) {
+                math::CBLAS_TRANSPOSE TransS = tS ? math::CblasTrans : math::CblasNoTrans;
+                math::CBLAS_TRANSPOSE TransD = tD ? math::CblasTrans : math::CblasNoTrans;
+                // C = op(S) * op(D), where op(D) has NR rows and NC columns
+                math::Matrix<double> res(NR, NC, 1.), ref(NR, NC, 1.);
+                math::blas_dgemm(TransS, TransD, 2., spmat, tD ? rectT : rect, -1., res);
+                math::blas_dgemm(TransS, TransD, 2., mat,   tD ? rectT : rect, -1., ref);
+                // C = op(D) * op(S), where op(D) has NC rows and NR columns
+                math::Matrix<double> resT(NC, NR, 1.), refT(NC, NR, 1.);
+                math::blas_dgemm(TransD, TransS, 2., tD ? rect : rectT, spmat, -1., resT);
+                math::blas_dgemm(TransD, TransS, 2., tD ? rect : rectT, mat,   -1., refT);
+                for(unsigned int i=0; i<NR; i++)
+                    for(unsigned int j=0; j<NC; j++)
+                        maxdif = fmax(maxdif,
+                            fmax(fabs(res(i, j) - ref(i, j)), fabs(resT(j, i) - refT(j, i))));
+            }
+        std::cout << "Sparse-dense MM: max deviation=" << maxdif;
+        ok &= test(maxdif < 1e-12);
+    }
+
     {   // sparse LU
         tbegin=std::clock();
         sol = math::LUDecomp(spdmat).solve(rhs);
@@ -0,0 +1,100 @@
+/** \file    test_math_optimization.cpp
+    \date    2026
+
+    Test the built-in iterative solver for linear and quadratic optimization problems
+*/
+#include "math_optimization.h"
+#include "math_linalg.h"
+#include "math_core.h"
+#include <iostream>
+#include <cmath>
+
+const double EPS = 1e-4;
+
+bool compare(const std::vector<double>& x, const double expected[], const char* name)
+{
+    bool ok = true;
+    for(size_t i=0; i<x.size(); i++)
+        ok &= fabs(x[i] - expected[i]) < EPS;
+    std::cout << name << ": x=";
+    for(size_t i=0; i<x.size(); i++)
+        std::cout << x[i] << ' ';
+    if(!ok)
+        std::cout << "\033[1;31m **\033[0m";
+    std::cout << '\n';
+    return ok;
+}
+
+// linear program: minimize x0 + 2 x1 + 3 x2 subject to x0 + x1 + x2 = 1, x1 - x2 = 0.2, x >= 0;
+// the solution is x = (0.8, 0.2, 0)
+bool test_linear()
+{
+    math::Matrix<double> mat(2, 3, 1.);
+    mat(1, 0) = 0; mat(1, 2) = -1;
+    std::vector<double> rhs(2), L(3);
+    rhs[0] = 1; rhs[1] = 0.2;
+    L[0] = 1; L[1] = 2; L[2] = 3;
+    math::IterativeSolverParams params;
+    params.tolerance = 1e-8;
+    math::IterativeSolverResult result = math::quadraticOptimizationSolveIterative(
+        mat, rhs, L, math::BandMatrix<double>(),
+        std::vector<double>(), std::vector<double>(), std::vector<double>(), std::vector<double>(), params);
+    const double expected[3] = {0.8, 0.2, 0};
+    return result.converged && compare(result.x, expected, "Linear program");
+}
+
+// non-negative least-squares problem: minimize |A x - b|^2 subject to x >= 0,
+// expressed as a problem with quadratic penalties for constraint violation;
+// A = diag(1, 2, 1), b = (1, -1, 3)  =>  x = (1, 0, 3)
+bool test_nnls()
+{
+    std::vector<math::Triplet> values;
+    values.push_back(math::Triplet(0, 0, 1.));
+    values.push_back(math::Triplet(1, 1, 2.));
+    values.push_back(math::Triplet(2, 2, 1.));
+    std::vector<double> rhs(3), penQuad(3, 2.);
+    rhs[0] = 1; rhs[1] = -1; rhs[2] = 3;
+    math::IterativeSolverParams params;
+    params.tolerance = 1e-8;
+    math::IterativeSolverResult result = math::quadraticOptimizationSolveIterative(
+        math::SparseMatrix<double>(3, 3, values), rhs, std::vector<double>(),
+        math::BandMatrix<double>(), std::vector<double>(), penQuad,
+        std::vector<double>(), std::vector<double>(), params);
+    const double expected[3] = {1, 0, 3};
+    bool ok = result.converged && compare(result.x, expected, "NNLS problem");
+    // restarting from the solution should converge immediately
+    params.initPrimal = result.x;
+    params.initDual   = result.dual;
+    result = math::quadraticOptimizationSolveIterative(
+        math::SparseMatrix<double>(3, 3, values), rhs, std::vector<double>(),
+        math::BandMatrix<double>(), std::vector<double>(), penQuad,
+        std::vector<double>(), std::vector<double>(), params);
+    std::cout << "Warm start: " << result.numIter << " iterations\n";
+    return ok && result.converged && result.numIter <= 64;
+}
+
+// quadratic program with a diagonal Q and box constraints:
+// minimize  x0^2 + x1^2 - x0  subject to  x0 + x1 = 1,  0 <= x <= 0.6;
+// the unconstrained minimum along the line is x = (0.75, 0.25), clipped to x = (0.6, 0.4)
+bool test_quadratic()
+{
+    std::vector<double> rhs(1, 1.), L(2, 0.), Q(2, 2.), xmin(2, 0.), xmax(2, 0.6);
+    L[0] = -1;
+    std::vector<double> x = math::quadraticOptimizationSolve(
+        math::Matrix<double>(1, 2, 1.), rhs, L, math::BandMatrix<double>(Q), xmin, xmax);
+    const double expected[2] = {0.6, 0.4};
+    return compare(x, expected, "Quadratic program");
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= test_linear();
+    ok &= test_nnls();
+    ok &= test_quadratic();
+    if(ok)
+        std::cout << "\033[1;32mALL TESTS PASSED\033[0m\n";
+    else
+        std::cout << "\033[1;31mSOME TESTS FAILED\033[0m\n";
+    return 0;
+}
@@ -959,6 +959,9 @@ bool test2dSpline()
     math::CubicSpline2d cub2d(xval, yval, fval);
     // 2d quintic spline with prescribed derivatives at all nodes
     math::QuinticSpline2d qui2d(xval, yval, fval, fderx, fdery);
+    // same splines with coefficients stored in single precision
+    math::CubicSpline2d cub2f(xval, yval, fval, NAN, NAN, NAN, NAN, /*compact*/ true);
+    math::QuinticSpline2d qui2f(xval, yval, fval, fderx, fdery, /*compact*/ true);
 
     // check the values (for both cubic and quintic splines) and derivatives (for quintic spline only)
     // at all nodes of 2d grid -- should exactly equal the input values (with machine precision)
@@ -981,7 +984,8 @@ bool test2dSpline()
         strm << "x y\tfunc fx fy fxx fxy fyy\tcubic cx cy cxx cxy cyy\tquintic qx qy qxx qxy qyy\n";
     }
     double sumerrl = 0, sumerrc = 0, sumerrq = 0,
-        sumerrcder = 0, sumerrqder = 0, sumerrcder2 = 0, sumerrqder2 = 0;
+        sumerrcder = 0, sumerrqder = 0, sumerrcder2 = 0, sumerrqder2 = 0,
+        maxdifcf = 0, maxdifqf = 0;  // max relative difference between single- and double-precision
     for(int i=0; i<=NN; i++) {
         double x = (XMAX-XMIN)*(i*1./NN)+XMIN;
         for(int j=0; j<=NN; j++) {
@@ -992,6 +996,12 @@ bool test2dSpline()
             l =  lin2d.value(x, y);
             cub2d.evalDeriv(x, y, &c, &cx, &cy, &cxx, &cxy, &cyy);
             qui2d.evalDeriv(x, y, &q, &qx, &qy, &qxx, &qxy, &qyy);
+            double cf, cfx, cfy, qf, qfx, qfy;
+            cub2f.evalDeriv(x, y, &cf, &cfx, &cfy);
+            qui2f.evalDeriv(x, y, &qf, &qfx, &qfy);
+            double norm = fabs(f) + fabs(d[0]) + fabs(d[1]);
+            maxdifcf = fmax(maxdifcf, (fabs(cf-c) + fabs(cfx-cx) + fabs(cfy-cy)) / norm);
+            maxdifqf = fmax(maxdifqf, (fabs(qf-q) + fabs(qfx-qx) + fabs(qfy-qy)) / norm);
 
             sumerrl     += pow_2(l-f);
             sumerrc     += pow_2(c-f);
@@ -1026,9 +1036,12 @@ bool test2dSpline()
         "\ncubic   2d spline value:  " + utils::pp(sumerrc, 8) +
         ", deriv: " + utils::pp(sumerrcder, 8) + ", 2nd deriv: " + utils::pp(sumerrcder2, 8) +
         "\nquintic 2d spline value:  " + utils::pp(sumerrq, 8) +
-        ", deriv: " + utils::pp(sumerrqder, 8) + ", 2nd deriv: " + utils::pp(sumerrqder2, 8) +"\n";
+        ", deriv: " + utils::pp(sumerrqder, 8) + ", 2nd deriv: " + utils::pp(sumerrqder2, 8) +
+        "\nmax relative difference with single-precision storage: cubic " + utils::pp(maxdifcf, 8) +
+        ", quintic " + utils::pp(maxdifqf, 8) + "\n";
     ok &= sumerrc < 0.003 && sumerrcder < 0.012 && sumerrcder2 < 0.075 &&
-          sumerrq < 1.e-4 && sumerrqder < 7.e-4 && sumerrqder2 < 0.006;
+          sumerrq < 1.e-4 && sumerrqder < 7.e-4 && sumerrqder2 < 0.006 &&
+          maxdifcf < 2e-7 && maxdifqf < 2e-7;
 
     //----------- test the performance of 2d spline calculation -------------//
     std::cout <<"Linear interpolator:      " + evalSpline2d<0>(lin2d) + " eval/s\n";
@@ -1036,6 +1049,8 @@ bool test2dSpline()
     evalSpline2d<1>(cub2d) + ", 2nd deriv: " + evalSpline2d<2>(cub2d) + " eval/s\n";
     std::cout <<"Quintic spline w/o deriv: " + evalSpline2d<0>(qui2d) + ", 1st deriv: " +
     evalSpline2d<1>(qui2d) + ", 2nd deriv: " + evalSpline2d<2>(qui2d) + " eval/s\n";
+    std::cout <<"Quintic spline, single-precision storage: " + evalSpline2d<0>(qui2f) + ", 1st deriv: " +
+    evalSpline2d<1>(qui2f) + ", 2nd deriv: " + evalSpline2d<2>(qui2f) + " eval/s\n";
     return ok;
 }
 
@@ -1192,6 +1207,38 @@ bool test3dSpline()
     return ok;
 }
 
+// check that the O(1) lookup of grid segments gives the same result as the binary search
+bool testGridIndexer()
+{
+    bool ok = true;
+    const int NNODES = 50, NPOINTS = 10000;
+    for(int type=0; type<4; type++) {
+        std::vector<double> grid;
+        switch(type) {
+            case 0: grid = math::createUniformGrid(NNODES, -1., 3.); break;
+            case 1: grid = math::createExpGrid(NNODES, 1e-3, 1e3);
+                std::transform(grid.begin(), grid.end(), grid.begin(), log);
+                break;
+            case 2: grid = math::createUniformGrid(NNODES, 0., 1.);  // slightly perturbed
+                for(int i=1; i<NNODES-1; i++)
+                    grid[i] += 0.2 / (NNODES-1) * sin(i);
+                break;
+            default: grid = math::createNonuniformGrid(NNODES, 1e-3, 1e3, true);
+        }
+        math::GridIndexer indexer(grid);
+        ok &= indexer.isUniform() == (type<3);
+        for(int p=0; p<=NPOINTS+NNODES; p++) {
+            // random points slightly beyond the grid ends, and also exactly at grid nodes
+            double x = p<=NPOINTS ?
+                grid[0] + (grid.back()-grid[0]) * (1.2 * math::random() - 0.1) :
+                grid[p-NPOINTS-1];
+            ok &= indexer(x, &grid[0]) == math::binSearch(x, &grid[0], NNODES);
+        }
+        ok &= indexer(NAN, &grid[0]) == -1;
+    }
+    return ok;
+}
+
 bool printFail(const char* msg)
 {
     std::cout << "\033[1;31m " << msg << " failed\033[0m\n";
@@ -1203,6 +1250,7 @@ int main()
     bool ok=true;
     ok &= testPenalizedSplineFit() || printFail("Penalized spline fit");
     ok &= testPenalizedSplineDensity() || printFail("Penalized spline density estimator");
+    ok &= testGridIndexer() || printFail("Grid indexer");
     ok &= test1dSpline() || printFail("1d spline");
     ok &= test2dSpline() || printFail("2d spline");
     ok &= test3dSpline() || printFail("3d spline");
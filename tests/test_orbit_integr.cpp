@@ -9,8 +9,10 @@
 #include "potential_analytic.h"
 #include "potential_composite.h"
 #include "potential_dehnen.h"
+#include "potential_evolving.h"
 #include "potential_factory.h"
 #include "potential_ferrers.h"
+#include "potential_multipole.h"
 #include "units.h"
 #include "utils.h"
 #include "debug_utils.h"
@@ -18,6 +20,7 @@
 #include <iomanip>
 #include <fstream>
 #include <cmath>
+#include <cstdio>
 
 const double eps=1e-6;     // accuracy of conservation
 const double epsrot=1e-4;  // accuracy of comparison between inertial and rotating frames
@@ -178,6 +181,89 @@ const double posvel_sph[numtestpoints][6] = {   // order: R, theta, phi
     {0, 2,-1, 0.5, 0,   0  }};  // point at origin with nonzero velocity in R
 
 
+// test the time-dependent potential interpolated between two snapshots
+bool test_evolving()
+{
+    std::vector<double> times(2);
+    times[0] = 0; times[1] = 10;
+    std::vector<potential::PtrPotential> snapshots(2);
+    snapshots[0] = potential::PtrPotential(new potential::Plummer(10., 5.));
+    snapshots[1] = potential::PtrPotential(new potential::Plummer(20., 5.));
+    potential::Evolving evol(times, snapshots);
+    // the Plummer potential is linear in mass, so the interpolated potential at t=5 is exact
+    potential::Plummer mid(15., 5.);
+    coord::PosCar point(1., 2., 3.);
+    double Phi, PhiMid;
+    coord::GradCar grad, gradMid;
+    evol.eval(5., point, &Phi, &grad);
+    mid.eval(point, &PhiMid, &gradMid);
+    bool ok = fabs(Phi - PhiMid) < 1e-12 * fabs(PhiMid) && fabs(grad.dz - gradMid.dz) < 1e-12 &&
+        fabs(evol.snapshot(5.)->value(point) - PhiMid) < 1e-12 * fabs(PhiMid);
+    // the orbit in a time-dependent potential with identical snapshots coincides with the static one
+    snapshots[1] = snapshots[0];
+    potential::Evolving evolConst(times, snapshots);
+    coord::PosVelCar ic(posvel_car[0]);
+    std::vector<coord::PosVelCar> traj =
+        orbit::integrateTraj<coord::Car>(ic, 20., 20., *snapshots[0]), trajEvol;
+    orbit::integrate(ic, 20., orbit::OrbitIntegratorEvolving(evolConst, 3.),
+        orbit::RuntimeFncArray(1, orbit::PtrRuntimeFnc(
+        new orbit::RuntimeTrajectory<coord::Car>(trajEvol, 20.))));
+    ok &= traj.size() == trajEvol.size() && equalPosVel(traj.back(), trajEvol.back(), 1e-10);
+    std::cout << "Evolving potential: Phi=" << Phi << " (expected " << PhiMid << ")" <<
+        (ok? "" : " \033[1;31m**\033[0m") << "\n";
+    return ok;
+}
+
+// test the lazy loading of snapshots from files, keeping fewer of them in memory than their total
+// number, against the same snapshots loaded in advance; the evaluation is performed in parallel,
+// so that snapshots are loaded and discarded while other threads are using the remaining ones
+bool test_evolving_lazy()
+{
+    const int numSnapshots = 6, numPoints = 2000;
+    std::vector<double> times(numSnapshots);
+    std::vector<std::string> fileNames(numSnapshots);
+    std::vector<potential::PtrPotential> snapshots(numSnapshots);
+    for(int i=0; i<numSnapshots; i++) {
+        times[i] = i * 1.5;
+        fileNames[i] = "test_evolving_" + utils::toString(i) + ".ini";
+        potential::Dehnen dens(1. + 0.2*i, 1. + 0.1*i, 1., 1., 0.8);
+        potential::writePotential(fileNames[i], *potential::Multipole::create(
+            static_cast<const potential::BaseDensity&>(dens), 4, 0, 20));
+        snapshots[i] = potential::readPotential(fileNames[i]);
+    }
+    potential::Evolving evolEager(times, snapshots);
+    potential::Evolving evolLazy (times, fileNames, /*interpLinear*/ true, /*maxLoaded*/ 2);
+    int numFailed = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+:numFailed)
+#endif
+    for(int i=0; i<numPoints; i++) {
+        // times jump back and forth across all snapshots (and outside the covered interval)
+        double time = fmod(i * 0.731, numSnapshots * 1.5 + 1) - 0.5;
+        coord::PosCar point(0.1 + 0.003*i, 0.5 - 0.0004*i, 0.3);
+        double Phi1, Phi2;
+        coord::GradCar grad1, grad2;
+        try{
+            evolEager.eval(time, point, &Phi1, &grad1);
+            evolLazy .eval(time, point, &Phi2, &grad2);
+            if(Phi1 != Phi2 || grad1.dx != grad2.dx || grad1.dy != grad2.dy || grad1.dz != grad2.dz)
+                numFailed++;
+        }
+        catch(std::exception&) {
+            numFailed++;
+        }
+    }
+    bool ok = numFailed == 0 &&
+        evolLazy.snapshot(2.)->value(coord::PosCar(1,1,1)) ==
+        evolEager.snapshot(2.)->value(coord::PosCar(1,1,1));
+    for(int i=0; i<numSnapshots; i++)
+        std::remove(fileNames[i].c_str());
+    std::cout << "Evolving potential with lazy loading of " << numSnapshots << " snapshots: " <<
+        numFailed << " of " << numPoints << " points differ from preloaded snapshots" <<
+        (ok? "" : " \033[1;31m**\033[0m") << "\n";
+    return ok;
+}
+
 int main() {
     std::vector<potential::PtrPotential> pots;
     pots.push_back(potential::PtrPotential(new potential::Plummer(10.,5.)));
@@ -201,6 +287,8 @@ int main() {
             allok &= test_potential(*pots[ip], coord::PosVelSph(posvel_sph[ic]), total_time, timestep);
         }
     }
+    allok &= test_evolving();
+    allok &= test_evolving_lazy();
     if(allok)
         std::cout << "\033[1;32mALL TESTS PASSED\033[0m\n";
     else
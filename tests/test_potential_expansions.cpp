@@ -1,5 +1,6 @@
 #include "potential_analytic.h"
 #include "potential_dehnen.h"
+#include "potential_composite.h"
 #include "potential_cylspline.h"
 #include "potential_multipole.h"
 #include "potential_sphharm.h"
@@ -82,7 +83,8 @@ PtrPotential createFromFile(
 }
 
 // test the accuracy of potential, force and density approximation at different radii
-bool testAverageError(const potential::BasePotential& p1, const potential::BasePotential& p2, double eps)
+bool testAverageError(const potential::BasePotential& p1, const potential::BasePotential& p2, double eps,
+    double epsDens=0)
 {
     double gamma = getInnerDensitySlope(p2);
     std::string fileName = std::string("test_potential_") + p1.name() + "_" + p2.name() + 
@@ -125,7 +127,8 @@ bool testAverageError(const potential::BasePotential& p1, const potential::BaseP
     totWeightedDifP = sqrt(totWeightedDifP / totWeight);
     totWeightedDifF = sqrt(totWeightedDifF / totWeight);
     totWeightedDifD = sqrt(totWeightedDifD / totWeight);
-    bool ok = totWeightedDifD<eps && totWeightedDifF<eps*0.1 && totWeightedDifP<eps*0.01;
+    // tolerance in density is eps unless specified separately
+    bool ok = totWeightedDifD<(epsDens>0 ? epsDens : eps) && totWeightedDifF<eps*0.1 && totWeightedDifP<eps*0.01;
     std::cout << p1.name() << " vs. " << p2.name() << 
         ": rmserror in potential=" << totWeightedDifP << 
         ", force=" << totWeightedDifF <<
@@ -218,6 +221,32 @@ bool testDensSH()
     return ok;
 }
 
+// test that the binned computation of sph-harm coefs from a large N-body snapshot
+// (normally used when N * (number of harmonic terms) exceeds ~16M) agrees with the direct one
+bool testBinnedDensSH(const particles::ParticleArray<coord::PosCyl>& points)
+{
+    std::vector<double> radii = math::createExpGrid(20, 0.01, 100);
+    math::SphHarmIndices ind(6, 6, coord::ST_TRIAXIAL);
+    std::vector<std::vector<double> > coefsDirect, coefsBinned;
+    potential::computeDensityCoefsSph(points, ind, radii, coefsDirect);
+    potential::computeDensityCoefsSph(points, ind, radii, coefsBinned, /*smoothing*/ 1.0, /*forceBinned*/ true);
+    potential::DensitySphericalHarmonic densDirect(radii, coefsDirect), densBinned(radii, coefsBinned);
+    double maxdif = 0;
+    for(unsigned int k=1; k<radii.size()-1; k++)
+        for(double theta=0.1; theta<M_PI/2; theta+=0.3)
+            for(double phi=0.1; phi<M_PI; phi+=0.3) {
+                coord::PosSph point(radii[k], theta, phi);
+                double d1 = densDirect.density(point), d2 = densBinned.density(point);
+                maxdif = fmax(maxdif, fabs(d1-d2) / fabs(d1));
+            }
+    // the binned estimate differs from the direct one by much less than the Poisson noise (~few %)
+    bool ok = maxdif < 0.02;
+    std::cout << "Binned vs direct sph-harm expansion of " << points.size() <<
+        " particles: max relative difference in density " << maxdif <<
+        (ok ? "" : " \033[1;31m**\033[0m") << "\n";
+    return ok;
+}
+
 // definition of a single spherical-harmonic term with indices (l,m)
 template<int l, int m>
 double myfnc(double theta, double phi);
@@ -461,6 +490,11 @@ int main() {
     std::cout << (std::clock()-clock)*1.0/CLOCKS_PER_SEC << " seconds to create CylSpline\n";
     PtrPotential test2d = potential::CylSpline::create(  // directly from potential
         test2_Dehnen0Tri, 6, 20, 0., 0., 20, 0., 0.);
+    clock = std::clock();
+    PtrPotential test2f = potential::CylSpline::create(  // from density via Hankel transform
+        static_cast<const potential::BaseDensity&>(test2_Dehnen0Tri), 6, 20, 0., 0., 20, 0., 0.,
+        /*useDerivs*/ true, /*useFFT*/ true);
+    std::cout << (std::clock()-clock)*1.0/CLOCKS_PER_SEC << " seconds to create CylSpline with FFT\n";
     PtrPotential test2c_clone = writeRead(*test2c);
 //    ok &= testAverageError( test2b, test2_Dehnen0Tri, 0.5);
     ok &= testAverageError( test2s, test2_Dehnen0Tri, 0.02);
@@ -468,6 +502,14 @@ int main() {
     ok &= testAverageError(*test2d, test2_Dehnen0Tri, 0.02);
     ok &= testAverageError(*test2c, test2_Dehnen0Tri, 0.02);
     ok &= testAverageError(*test2c, *test2c_clone, 3e-4);
+    // the Hankel-transform solver should agree with the direct integration to ~5e-6 in potential
+    // and ~5e-5 in force; the density (from second derivatives) is less accurate
+    ok &= testAverageError(*test2f, *test2c, 5e-4, /*epsDens*/ 1e-2);
+    // same potentials with interpolation tables stored in single precision:
+    // potential and force should be nearly unaffected (~1e-9 and ~1e-7)
+    ok &= testAverageError(*potential::compilePotential(test2c, /*compact*/ true), *test2c, 1e-5,
+        /*epsDens*/ 3e-3);
+    ok &= testAverageError(*potential::compilePotential(test2m, /*compact*/ true), *test2m, 1e-5);
 
     // mildly triaxial, cuspy
     std::cout << "--- Triaxial Dehnen gamma=1.5 ---\n";
@@ -487,6 +529,30 @@ int main() {
     PtrPotential test5c = potential::CylSpline::create(
         test5_ExpdiskAxi, 0, 20, 5e-2, 50., 20, 1e-2, 10.);
     ok &= testAverageError(*test5c, *test5_Galpot, 0.05);
+    PtrPotential test5f = potential::CylSpline::create(  // same with the Hankel-transform solver
+        static_cast<const potential::BaseDensity&>(test5_ExpdiskAxi), 0, 20, 5e-2, 50., 20, 1e-2, 10.,
+        /*useDerivs*/ true, /*useFFT*/ true);
+    ok &= testAverageError(*test5f, *test5c, 5e-4, /*epsDens*/ 1e-2);
+    // compiling a composite potential should reduce the number of components without changing it
+    // (beyond interpolation errors): here the DiskAnsatz parts of two GalPot disks are fused,
+    // and two Multipole expansions created on the same radial grid are merged
+    std::vector<utils::KeyValueMap> test5_paramsTwoDisks(2);
+    test5_paramsTwoDisks[0] = utils::KeyValueMap("type=DiskDensity surfaceDensity=1 scaleRadius=5 scaleHeight=0.5");
+    test5_paramsTwoDisks[1] = utils::KeyValueMap("type=DiskDensity surfaceDensity=2 scaleRadius=2 scaleHeight=-0.2");
+    std::vector<PtrPotential> test5_components(3);
+    test5_components[0] = potential::createPotential(test5_paramsTwoDisks);  // DiskAnsatz x2 + Multipole
+    test5_components[1] = potential::Multipole::create(test4_MNAxi, 6, 0, 30, 1e-2, 1e3);
+    test5_components[2] = potential::Multipole::create(test1_NFWSph, 0, 0, 30, 1e-2, 1e3);
+    PtrPotential test5_composite(new potential::CompositeCyl(test5_components));
+    PtrPotential test5_compiled = potential::compilePotential(test5_composite);
+    const potential::CompositeCyl* test5_compiledComposite =
+        dynamic_cast<const potential::CompositeCyl*>(test5_compiled.get());
+    // originally 5 components (after flattening the nested composite potential), now 3:
+    // the fused DiskAnsatz, the Multipole of the GalPot model and the merged Multipole
+    std::cout << "compilePotential: " << test5_compiled->name() << " with " <<
+        (test5_compiledComposite ? test5_compiledComposite->size() : 1) << " components\n";
+    ok &= test5_compiledComposite != NULL && test5_compiledComposite->size() == 3;
+    ok &= testAverageError(*test5_compiled, *test5_composite, 1e-3);
 
     // mildly triaxial, created from N-body samples
     std::cout << "--- Triaxial Dehnen gamma=0.5 from N-body samples ---\n";
@@ -503,6 +569,7 @@ int main() {
     ok &= testAverageError(*test6s, test6_Dehnen05Tri, 1.0);
     ok &= testAverageError(*test6m, test6_Dehnen05Tri, 1.0);
     ok &= testAverageError(*test6c, test6_Dehnen05Tri, 1.5);
+    ok &= testBinnedDensSH(test6_points);
 
     std::cout << "--- Testing the accuracy of representation of an off-centered constant-density sphere ---"
         "\n--- Ideally all mass should be contained within the sphere radius, <r>=3/4, <r^2>=3/5 ---\n";
@@ -289,6 +289,8 @@ int main() {
     pots.push_back(potential::PtrPotential(new potential::Logarithmic(1.,0.01,.8,.5)));
     pots.push_back(potential::PtrPotential(new potential::Ferrers(1.,0.9,.7,.5)));
     pots.push_back(potential::PtrPotential(new potential::Dehnen(2.,1.,1.5,1.,1.)));
+    pots.push_back(potential::PtrPotential(new potential::Dehnen(2.,1.,1.,.8,.5)));
+    pots.push_back(potential::PtrPotential(new potential::Dehnen(1.,2.,0.5,1.,.6,true)));
     pots.push_back(potential::CylSpline::create(potential::DiskDensity(
         potential::DiskParam(1., 2., -0.2, 0, 0)), 0, 20, 0.1, 500, 20, 0.01, 50));
     pots.push_back(make_galpot(test_galpot_params[0]));
@@ -0,0 +1,169 @@
+/** \file    test_staeckel_triaxial.cpp
+    \date    2026
+
+    This example shows the correctness of action/angle determination by the triaxial
+    Staeckel fudge.
+
+    We create an instance of a triaxial Staeckel potential, defined by a single function U(tau)
+    of one variable in confocal ellipsoidal coordinates (the potential is given by the second
+    divided difference of U at the three coordinates of a point: Phi = U[lambda,mu,nu]),
+    perform numerical orbit integration in this potential, and for each point on the trajectory,
+    compute the values of actions and angles using the fudge approximation,
+    which is exact for this potential if the parameters of the coordinate system are the same.
+    We test that the values of actions are nearly constant (to the limit of orbit integration
+    accuracy), that angles increase linearly with time with the rate given by the frequencies,
+    and that the focal distances estimated by the action finder class are correct.
+    We use several initial conditions corresponding to various orbit families
+    (box, short-axis tube, long-axis tube, and planar orbits).
+*/
+#include "actions_triaxial.h"
+#include "potential_base.h"
+#include "orbit.h"
+#include "math_core.h"
+#include "debug_utils.h"
+#include "utils.h"
+#include <iostream>
+#include <cmath>
+
+const double eps=1e-6;               // accuracy of comparison for actions
+const double epsang=1e-4;            // accuracy of comparison for angles and frequencies
+const double epsfd=1e-3;             // accuracy of focal distance estimate
+const double DELTA_YZ=1.0, DELTA_XZ=2.0;  // focal distances of the coordinate system
+
+/// Triaxial Staeckel potential with U(tau) = -tau^2 / sqrt(tau+1),
+/// derivatives are computed by finite differences
+class TriaxialStaeckel: public potential::BasePotentialCar {
+    const double a, b;
+public:
+    TriaxialStaeckel(double Dyz, double Dxz) : a(Dyz*Dyz), b(Dxz*Dxz) {}
+    virtual coord::SymmetryType symmetry() const { return coord::ST_TRIAXIAL; }
+    virtual const char* name() const { return "TriaxialStaeckel"; }
+
+    static double U(double t) { return -t*t / sqrt(t+1); }
+    static double dU(double t) { return (-2*t + 0.5*t*t / (t+1)) / sqrt(t+1); }
+    // first divided difference
+    static double U1(double t1, double t2) {
+        return fabs(t1-t2) > 1e-8 * (1+t1) ? (U(t1) - U(t2)) / (t1-t2) : dU(0.5*(t1+t2)); }
+
+    double value(double x, double y, double z) const {
+        // ellipsoidal coordinates are the roots of the cubic  t^3 - c2 t^2 + c1 t - c0
+        double x2 = x*x, y2 = y*y, z2 = z*z,
+        c2 = a + b + x2 + y2 + z2,
+        c1 = a * b + a * x2 + b * y2 + (a+b) * z2,
+        c0 = a * b * z2,
+        p  = c1 - c2 * c2 / 3,
+        q  = -2 * pow_3(c2) / 27 + c2 * c1 / 3 - c0,
+        amp= 2 * sqrt(-p / 3),
+        phi= acos(fmax(-1, fmin(1, 3 * q / (p * amp)))) / 3,
+        tau[3];
+        for(int k=0; k<3; k++) {
+            double t = c2 / 3 + amp * cos(phi - 2*M_PI/3 * (2-k));
+            for(int iter=0; iter<3; iter++) {  // Newton refinement
+                double f = t * (t-a) * (t-b) - x2 * t * (t-a) - y2 * t * (t-b) - z2 * (t-a) * (t-b);
+                double df = (3 * t - 2 * c2) * t + c1;
+                if(df != 0) t -= f / df;
+            }
+            tau[k] = t;
+        }
+        return (U1(tau[2], tau[1]) - U1(tau[1], tau[0])) / (tau[2] - tau[0]);
+    }
+
+    virtual void evalCar(const coord::PosCar &pos,
+        double* potential, coord::GradCar* deriv, coord::HessCar* deriv2) const
+    {
+        if(potential)
+            *potential = value(pos.x, pos.y, pos.z);
+        const double h = 1e-5;
+        if(deriv) {
+            deriv->dx = (value(pos.x+h, pos.y, pos.z) - value(pos.x-h, pos.y, pos.z)) / (2*h);
+            deriv->dy = (value(pos.x, pos.y+h, pos.z) - value(pos.x, pos.y-h, pos.z)) / (2*h);
+            deriv->dz = (value(pos.x, pos.y, pos.z+h) - value(pos.x, pos.y, pos.z-h)) / (2*h);
+        }
+        if(deriv2) {
+            const double H = 1e-3;
+            coord::GradCar gxp, gxm, gyp, gym, gzp, gzm;
+            evalCar(coord::PosCar(pos.x+H, pos.y, pos.z), NULL, &gxp, NULL);
+            evalCar(coord::PosCar(pos.x-H, pos.y, pos.z), NULL, &gxm, NULL);
+            evalCar(coord::PosCar(pos.x, pos.y+H, pos.z), NULL, &gyp, NULL);
+            evalCar(coord::PosCar(pos.x, pos.y-H, pos.z), NULL, &gym, NULL);
+            evalCar(coord::PosCar(pos.x, pos.y, pos.z+H), NULL, &gzp, NULL);
+            evalCar(coord::PosCar(pos.x, pos.y, pos.z-H), NULL, &gzm, NULL);
+            deriv2->dx2  = (gxp.dx - gxm.dx) / (2*H);
+            deriv2->dy2  = (gyp.dy - gym.dy) / (2*H);
+            deriv2->dz2  = (gzp.dz - gzm.dz) / (2*H);
+            deriv2->dxdy = (gxp.dy - gxm.dy) / (2*H);
+            deriv2->dydz = (gyp.dz - gym.dz) / (2*H);
+            deriv2->dxdz = (gzp.dx - gzm.dx) / (2*H);
+        }
+    }
+};
+
+bool test_orbit(const potential::BasePotential& potential,
+    const actions::ActionFinderTriaxialFudge& actfinder,
+    const coord::PosVelCar& initcond, const char* title)
+{
+    const double total_time = 100., timestep = 1./8;
+    orbit::OrbitIntParams params;
+    params.accuracy = 1e-10;
+    std::vector<coord::PosVelCar> traj = orbit::integrateTraj(
+        initcond, total_time, timestep, potential, params);
+    actions::ActionStat stat;
+    actions::AngleStat angstat;
+    math::Averager avgOmegar, avgOmegaz, avgOmegaphi;
+    bool ex = false;
+    for(size_t i=0; i<traj.size(); i++) {
+        try {
+            actions::Frequencies freq;
+            actions::ActionAngles a = actions::actionAnglesTriaxialFudge(
+                potential, coord::toPosVelCyl(traj[i]), DELTA_YZ, DELTA_XZ, &freq);
+            stat.add(a);
+            angstat.add(i*timestep, a);
+            avgOmegar.add(freq.Omegar);
+            avgOmegaz.add(freq.Omegaz);
+            avgOmegaphi.add(freq.Omegaphi);
+        }
+        catch(std::exception &e) {
+            if(!ex) std::cout << "Exception at i="<<i<<": "<<e.what()<<"\n";
+            ex = true;
+        }
+    }
+    stat.finish();
+    angstat.finish();
+    double fdYZ, fdXZ;
+    actfinder.focalDistances(totalEnergy(potential, initcond), fdYZ, fdXZ);
+    actions::Actions acti = actfinder.actions(coord::toPosVelCyl(initcond));
+    bool ok = !ex &&
+        stat.rms.Jr < eps && stat.rms.Jz < eps && stat.rms.Jphi < eps &&
+        fabs(fdYZ - DELTA_YZ) < epsfd && fabs(fdXZ - DELTA_XZ) < epsfd &&
+        fabs(acti.Jr - stat.avg.Jr) < epsfd && fabs(acti.Jz - stat.avg.Jz) < epsfd &&
+        fabs(acti.Jphi - stat.avg.Jphi) < epsfd &&
+        (stat.avg.Jr  ==0 || (fabs(angstat.freqr  -avgOmegar.mean()  ) < epsang && angstat.dispr  <epsang)) &&
+        (stat.avg.Jz  ==0 || (fabs(angstat.freqz  -avgOmegaz.mean()  ) < epsang && angstat.dispz  <epsang)) &&
+        (stat.avg.Jphi==0 || (fabs(angstat.freqphi-avgOmegaphi.mean()) < epsang && angstat.dispphi<epsang));
+    std::cout << "\033[1;37m" << title << "\033[0m"
+    ":  Jr="  <<stat.avg.Jr  <<" +- "<<stat.rms.Jr<<
+    ",  Jz="  <<stat.avg.Jz  <<" +- "<<stat.rms.Jz<<
+    ",  Jphi="<<stat.avg.Jphi<<" +- "<<stat.rms.Jphi<<
+    ",  Omega=" << avgOmegar.mean() <<"," << avgOmegaz.mean() << "," << avgOmegaphi.mean() <<
+    " (fit: " << angstat.freqr << "," << angstat.freqz << "," << angstat.freqphi <<
+    "; rms: " << sqrt(angstat.dispr) << "," << sqrt(angstat.dispz) << "," << sqrt(angstat.dispphi) <<
+    "),  focal distances=" << fdYZ << "," << fdXZ <<
+    (ok ? "" : " \033[1;31m**\033[0m") << "\n";
+    return ok;
+}
+
+int main() {
+    potential::PtrPotential pot(new TriaxialStaeckel(DELTA_YZ, DELTA_XZ));
+    const actions::ActionFinderTriaxialFudge af(pot);
+    bool allok=true;
+    allok &= test_orbit(*pot, af, coord::PosVelCar(1.0, 0.5, 0.3, 0.2, 0.1, 0.1), "box orbit");
+    allok &= test_orbit(*pot, af, coord::PosVelCar(2.0, 0. , 0.2, 0. , 0.4, 0.1), "short-axis tube");
+    allok &= test_orbit(*pot, af, coord::PosVelCar(2.0, 0. , 0.2, 0. ,-0.4, 0.1), "counter-rotating tube");
+    allok &= test_orbit(*pot, af, coord::PosVelCar(0.5, 0. ,-2.0,0.05,-0.4, 0. ), "long-axis tube");
+    allok &= test_orbit(*pot, af, coord::PosVelCar(1.5, 0.2, 0. , 0.1, 0.3, 0. ), "planar orbit");
+    if(allok)
+        std::cout << "\033[1;32mALL TESTS PASSED\033[0m\n";
+    else
+        std::cout << "\033[1;31mSOME TESTS FAILED\033[0m\n";
+    return 0;
+}
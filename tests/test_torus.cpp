@@ -72,6 +72,81 @@ bool test_actions(const potential::BasePotential& poten,
     return tolerable;
 }
 
+/// compare two position/velocity points with a relative tolerance
+bool equalPoints(const coord::PosVelCyl& a, const coord::PosVelCyl& b, double eps)
+{
+    double scale = fabs(a.R) + fabs(a.z) + fabs(a.vR) + fabs(a.vz) + fabs(a.vphi);
+    return fabs(a.R-b.R) + fabs(a.z-b.z) + fabs(a.vR-b.vR) + fabs(a.vz-b.vz) + fabs(a.vphi-b.vphi)
+        < eps * scale && fabs(math::wrapAngle(a.phi-b.phi+M_PI) - M_PI) < eps;
+}
+
+/// check that the actions recovered by the action finder from the points on the torus
+/// obtained from the interpolated grid are close to the requested ones
+bool test_grid_actions(const actions::BaseActionFinder& finder,
+    const actions::BaseActionMapper& mapper, const actions::Actions acts)
+{
+    actions::ActionStat stat;
+    for(unsigned int i=0; i<NUM_ANGLE_SAMPLES; i++) {
+        actions::Angles angles;
+        angles.thetar   = math::wrapAngle(i * 1.0);
+        angles.thetaz   = math::wrapAngle(i * 2.1);
+        angles.thetaphi = math::wrapAngle(i * 0.7);
+        stat.add(finder.actions(mapper.map(actions::ActionAngles(acts, angles))));
+    }
+    stat.finish();
+    double dev = (fabs(stat.avg.Jr-acts.Jr) + fabs(stat.avg.Jz-acts.Jz) + fabs(stat.avg.Jphi-acts.Jphi))
+        / (acts.Jr + acts.Jz + fabs(acts.Jphi));
+    bool ok = dev < 0.02;
+    std::cout << "Grid of tori, actions " << acts << "recovered " << stat.avg <<
+        "relative deviation " << dev << (ok ? "" : " \033[1;31m**\033[0m") << "\n";
+    return ok;
+}
+
+/// test the interpolated grid of tori: at a grid node it should reproduce the individually
+/// fitted torus, between the nodes it should produce tori with the requested actions,
+/// below the first node in Jr and Jz it should still produce tori with approximately
+/// the requested actions, and after saving to a file and loading back it should give
+/// identical results
+bool test_torus_grid(const potential::BasePotential& poten,
+    const actions::BaseActionFinder& finder, const actions::BaseActionMapper& torus,
+    const actions::Actions acts)
+{
+    std::vector<double> gridJr(2), gridJz(2), gridJphi(2);
+    gridJr  [0] = acts.Jr;   gridJr  [1] = acts.Jr   * 1.3;
+    gridJz  [0] = acts.Jz;   gridJz  [1] = acts.Jz   * 1.3;
+    gridJphi[0] = acts.Jphi; gridJphi[1] = acts.Jphi * 1.2;
+    actions::ActionMapperTorusGrid grid(poten, gridJr, gridJz, gridJphi);
+    const char* fileName = "test_torus_grid.txt";
+    bool ok = grid.save(fileName);
+    actions::ActionMapperTorusGrid gridLoaded(fileName);
+    std::remove(fileName);
+    actions::Actions mid = acts;
+    mid.Jr *= 1.15;  mid.Jz *= 1.1;  mid.Jphi *= 1.05;
+    bool okNode = true, okLoad = true;
+    for(unsigned int i=0; i<NUM_ANGLE_SAMPLES; i++) {
+        actions::Angles angles;
+        angles.thetar   = math::wrapAngle(i * 1.0);
+        angles.thetaz   = math::wrapAngle(i * 2.1);
+        angles.thetaphi = math::wrapAngle(i * 0.7);
+        okNode &= equalPoints(torus.map(actions::ActionAngles(acts, angles)),
+            grid.map(actions::ActionAngles(acts, angles)), 1e-10);
+        okLoad &= equalPoints(grid.map(actions::ActionAngles(mid, angles)),
+            gridLoaded.map(actions::ActionAngles(mid, angles)), 1e-10);
+    }
+    std::cout << "Grid of tori: " <<
+        (okNode ? "" : "\033[1;31mnode values differ from the individual torus\033[0m ") <<
+        (okLoad ? "" : "\033[1;31mloaded grid differs from the original one\033[0m ") <<
+        (ok ? "" : "\033[1;31mcannot save the grid\033[0m") << "\n";
+    ok &= okNode && okLoad;
+    ok &= test_grid_actions(finder, grid, mid);
+    mid.Jphi *= -1;  // counter-rotating orbit
+    ok &= test_grid_actions(finder, grid, mid);
+    actions::Actions below = acts;  // below the first node in Jr and Jz
+    below.Jr *= 0.7;  below.Jz *= 0.5;
+    ok &= grid.contains(below) && test_grid_actions(finder, grid, below);
+    return ok;
+}
+
 potential::PtrPotential make_galpot(const char* params)
 {
     const char* params_file="test_galpot_params.pot";
@@ -117,6 +192,7 @@ int main(int argc, const char* argv[]) {
     actions::ActionMapperTorus mapper(*pot, acts);
     actions::ActionFinderAxisymFudge finder(pot, false);
     allok &= test_actions(*pot, finder, mapper, acts);
+    allok &= test_torus_grid(*pot, finder, mapper, acts);
     if(allok)
         std::cout << "\033[1;32mALL TESTS PASSED\033[0m\n";
     else
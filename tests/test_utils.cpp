@@ -192,10 +192,25 @@ bool test_ini_file()
     return ok;
 }
 
+bool test_cache_file_name()
+{
+    std::string prevDir = utils::getCacheDirectory();
+    utils::setCacheDirectory("");
+    bool ok = utils::getCacheFileName("key").empty();  // cache disabled
+    utils::setCacheDirectory("/tmp");
+    std::string name1 = utils::getCacheFileName("key1", ".ext"), name2 = utils::getCacheFileName("key2");
+    // file name consists of the directory, 16 hex digits of the hash, and the extension
+    ok &= name1.size() == 5+16+4 && name1.substr(0, 5) == "/tmp/" &&
+        name1.substr(21) == ".ext" && name1 == utils::getCacheFileName("key1", ".ext") &&
+        name2.size() == 5+16 && name1.substr(0, 21) != name2;
+    utils::setCacheDirectory(prevDir);
+    return ok;
+}
+
 int main()
 {
-    std::cout << "Test string formatting and INI file routines\n";
-    if(test_number_conversion() && test_ini_file())
+    std::cout << "Test string formatting, INI file and cache file name routines\n";
+    if(test_number_conversion() && test_ini_file() && test_cache_file_name())
         std::cout << "\033[1;32mALL TESTS PASSED\033[0m\n";
     else
         std::cout << "\033[1;31mSOME TESTS FAILED\033[0m\n";
@@ -0,0 +1,163 @@
+/** \file    test_velocity_sampler.cpp
+    \date    2026
+
+    Test the parallel assignment of velocities to particles (galaxymodel_velocitysampler.h):
+    the particles should keep their positions, masses and order in the output array;
+    with a single OpenMP thread the result should be identical to assigning velocities
+    to the particles one by one in a serial loop (as done in earlier versions);
+    and with a fixed number of threads the result should be reproducible for a fixed seed.
+*/
+#include "galaxymodel_velocitysampler.h"
+#include "potential_analytic.h"
+#include "math_core.h"
+#include <iostream>
+#include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+const double eps = 1e-14;  // relative accuracy of comparison of particle positions
+
+/// a trivial "Jeans model" with a velocity dispersion profile of a Plummer sphere with isotropic
+/// velocities, sigma^2(r) = M / (6 sqrt(r^2+b^2)) (in units with G=1)
+class PlummerDispersion: public math::IFunction {
+    const double mass, scaleRadius;
+public:
+    PlummerDispersion(double _mass, double _scaleRadius) : mass(_mass), scaleRadius(_scaleRadius) {}
+    virtual void evalDeriv(const double r, double* val, double* der, double* der2) const {
+        if(val)
+            *val = sqrt(mass / 6 / sqrt(r*r + pow_2(scaleRadius)));
+        if(der)
+            *der = NAN;
+        if(der2)
+            *der2 = NAN;
+    }
+    virtual unsigned int numDerivs() const { return 0; }
+};
+
+/// get the default number of OpenMP threads (1 without OpenMP)
+int getNumThreads()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/// set the number of OpenMP threads (no-op without OpenMP)
+void setNumThreads(int numThreads)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(numThreads);
+#else
+    (void)numThreads;
+#endif
+}
+
+/// create a set of particles at pseudo-random positions and with different masses
+particles::ParticleArray<coord::PosCyl> makeParticles(int numPoints)
+{
+    particles::ParticleArray<coord::PosCyl> points;
+    for(int i=0; i<numPoints; i++)
+        points.add(coord::PosCyl(
+            0.1 + 2 * fabs(sin(i * 0.71)), 1.5 * sin(i * 1.37), 2*M_PI * fabs(sin(i * 0.53))),
+            1. / (i+1));
+    return points;
+}
+
+/// check that the output particles have the same positions, masses and order as the input ones
+bool checkOrderAndMasses(const particles::ParticleArray<coord::PosCyl>& input,
+    const particles::ParticleArrayCar& output)
+{
+    if(input.size() != output.size())
+        return false;
+    bool ok = true;
+    for(size_t i=0; i<input.size(); i++) {
+        const coord::PosCyl point = coord::toPosCyl(output.point(i));
+        ok &= fabs(point.R - input.point(i).R) < eps * (1 + input.point(i).R) &&
+            fabs(point.z - input.point(i).z) < eps * (1 + fabs(input.point(i).z)) &&
+            fabs(coord::toPosCar(point).x - coord::toPosCar(input.point(i)).x) < eps * (1 + point.R) &&
+            fabs(coord::toPosCar(point).y - coord::toPosCar(input.point(i)).y) < eps * (1 + point.R) &&
+            output.mass(i) == input.mass(i);
+    }
+    return ok;
+}
+
+/// check that two arrays of particles are exactly identical
+bool identical(const particles::ParticleArrayCar& a, const particles::ParticleArrayCar& b)
+{
+    if(a.size() != b.size())
+        return false;
+    for(size_t i=0; i<a.size(); i++) {
+        const coord::PosVelCar &pa = a.point(i), &pb = b.point(i);
+        if(pa.x != pb.x || pa.y != pb.y || pa.z != pb.z ||
+            pa.vx != pb.vx || pa.vy != pb.vy || pa.vz != pb.vz || a.mass(i) != b.mass(i))
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    const double mass = 1.3, scaleRadius = 0.7, beta = 0.2;
+    const unsigned int seed = 42;
+    const int numPoints = 5000;
+    potential::Plummer pot(mass, scaleRadius);
+    PlummerDispersion sigma(mass, scaleRadius);
+    particles::ParticleArray<coord::PosCyl> points = makeParticles(numPoints);
+    bool allok = true;
+    // the random number generator has one independent stream for each of the threads available
+    // at startup, so the multi-threaded runs use this default number of threads
+    const int numThreads = getNumThreads();
+
+    // reference result: particles processed one at a time in a serial loop
+    math::randomize(seed);
+    particles::ParticleArrayCar serial;
+    for(int i=0; i<numPoints; i++) {
+        particles::ParticleArray<coord::PosCyl> single;
+        single.add(points.point(i), points.mass(i));
+        particles::ParticleArrayCar result = galaxymodel::assignVelocityJeansSph(single, pot, sigma, beta);
+        serial.add(result.point(0), result.mass(0));
+    }
+
+    // single-threaded run of the parallel routine
+    setNumThreads(1);
+    math::randomize(seed);
+    particles::ParticleArrayCar oneThread = galaxymodel::assignVelocityJeansSph(points, pot, sigma, beta);
+    bool ok = checkOrderAndMasses(points, oneThread) && identical(oneThread, serial);
+    std::cout << "Single thread: " << (ok ? "identical to the serial loop" :
+        "differs from the serial loop \033[1;31m**\033[0m") << "\n";
+    allok &= ok;
+
+    // two multi-threaded runs with the same seed and number of threads
+    setNumThreads(numThreads);
+    math::randomize(seed);
+    particles::ParticleArrayCar run1 = galaxymodel::assignVelocityJeansSph(points, pot, sigma, beta);
+    math::randomize(seed);
+    particles::ParticleArrayCar run2 = galaxymodel::assignVelocityJeansSph(points, pot, sigma, beta);
+    ok = checkOrderAndMasses(points, run1) && checkOrderAndMasses(points, run2) && identical(run1, run2);
+    std::cout << numThreads << " threads: particle order and masses are " <<
+        (checkOrderAndMasses(points, run1) ? "preserved" : "not preserved") <<
+        ", two runs with the same seed are " << (identical(run1, run2) ? "identical" : "different") <<
+        (ok ? "" : " \033[1;31m**\033[0m") << "\n";
+    allok &= ok;
+
+    // sanity check of the velocity distribution: the mean squared velocity should match (3-2 beta) sigma^2
+    double sumv2 = 0, sumsigma2 = 0;
+    for(int i=0; i<numPoints; i++) {
+        const coord::PosVelCar& p = run1.point(i);
+        sumv2 += pow_2(p.vx) + pow_2(p.vy) + pow_2(p.vz);
+        sumsigma2 += pow_2(sigma(sqrt(pow_2(p.x) + pow_2(p.y) + pow_2(p.z)))) * (3 - 2*beta);
+    }
+    ok = fabs(sumv2 / sumsigma2 - 1) < 0.1;  // some velocities are truncated at escape speed
+    std::cout << "Mean squared velocity relative to the Jeans model: " << sumv2 / sumsigma2 <<
+        (ok ? "" : " \033[1;31m**\033[0m") << "\n";
+    allok &= ok;
+
+    if(allok)
+        std::cout << "\033[1;32mALL TESTS PASSED\033[0m\n";
+    else
+        std::cout << "\033[1;31mSOME TESTS FAILED\033[0m\n";
+    return 0;
+}